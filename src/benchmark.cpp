@@ -0,0 +1,310 @@
+//======================================================================
+//  benchmark.cpp - Render a model headless along a fixed camera path
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "benchmark.h"
+#include "myapp.h"
+#include "modelloader.h"
+#include "offscreen.h"
+#include "picker.h"
+#include "pipelinecache.h"
+#include "viewpoints.h"
+#include "wireframe.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <fmt/core.h>
+
+using namespace std;
+
+static double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, std::milli>(chrono::steady_clock::now() - start).count();
+}
+
+// The camera at t in [0,1] of an orbit that passes through the
+// viewpoints of autoScale, while zooming in to half the distance
+// half way through.
+static void cameraOnPath(double t,
+                         const vsg::dvec3& center,
+                         double radius,
+                         vsg::LookAt& lookAt)
+{
+    static const Viewpoint path[] = { Viewpoint::DIAG, Viewpoint::FRONT,
+                                      Viewpoint::RIGHT, Viewpoint::TOP,
+                                      Viewpoint::DIAG };
+    const int numSegments = int(sizeof(path)/sizeof(path[0])) - 1;
+
+    double s = std::clamp(t, 0.0, 1.0) * numSegments;
+    int segment = std::min(int(s), numSegments-1);
+    double u = s - segment;
+
+    auto from = createViewpoint(path[segment], center, radius);
+    auto to = createViewpoint(path[segment+1], center, radius);
+    vsg::dvec3 fromDir = from->eye - center;
+    vsg::dvec3 toDir = to->eye - center;
+
+    vsg::dvec3 dir = vsg::normalize(vsg::mix(vsg::normalize(fromDir), vsg::normalize(toDir), u));
+    double distance = vsg::mix(vsg::length(fromDir), vsg::length(toDir), u);
+    distance *= 1.0 - 0.5 * sin(vsg::PI * t);
+
+    lookAt.eye = center + dir * distance;
+    lookAt.center = center;
+    lookAt.up = vsg::normalize(vsg::mix(from->up, to->up, u));
+}
+
+static string jsonEscape(const string& s)
+{
+    string ret;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            ret += '\\';
+        if ((unsigned char)c < 0x20)
+            ret += fmt::format("\\u{:04x}", int(c));
+        else
+            ret += c;
+    }
+    return ret;
+}
+
+static double percentile(const vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = size_t(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size()-1)];
+}
+
+struct PickBenchmark
+{
+    size_t numTriangles = 0;
+    size_t numNodes = 0;
+    double buildTime = 0;
+    double raysPerSec = 0;
+    double hitFraction = 0;
+};
+
+// Build the picking BVH of model and shoot numRays rays at it from
+// the camera path, towards random points around its center. The
+// rays are the same in every run.
+static PickBenchmark benchmarkPicking(vsg::Node& model,
+                                      const vsg::dvec3& center,
+                                      double radius,
+                                      int numRays)
+{
+    PickBenchmark result;
+    TriangleBVH bvh;
+    auto start = chrono::steady_clock::now();
+    buildPickBVH(collectPickMeshes(model), bvh);
+    result.buildTime = msSince(start);
+    result.numTriangles = bvh.numTriangles();
+    result.numNodes = bvh.numNodes();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0), signedUnit(-1.0, 1.0);
+    vector<pair<vsg::dvec3, vsg::dvec3>> rays(numRays);
+    vsg::LookAt lookAt;
+    for (auto& [origin, direction] : rays)
+    {
+        cameraOnPath(unit(random), center, radius, lookAt);
+        vsg::dvec3 target = center + vsg::dvec3(signedUnit(random), signedUnit(random), signedUnit(random)) * (0.5 * radius);
+        origin = lookAt.eye;
+        direction = target - origin;
+    }
+
+    size_t numHits = 0;
+    TriangleBVH::Hit hit;
+    start = chrono::steady_clock::now();
+    for (auto& [origin, direction] : rays)
+        numHits += bvh.intersect(origin, direction, hit);
+    double rayTime = msSince(start);
+
+    if (rayTime > 0)
+        result.raysPerSec = numRays / (rayTime / 1000.0);
+    if (numRays > 0)
+        result.hitFraction = double(numHits) / numRays;
+    return result;
+}
+
+int runBenchmark(int argc, char *argv[])
+{
+    vsg::CommandLine arguments(&argc, argv);
+    arguments.read("--benchmark");
+    arguments.read("--debug");
+
+    int numFrames = 300;
+    arguments.read("--frames", numFrames);
+    int numPickRays = 100000;
+    arguments.read("--pick-rays", numPickRays);
+    uint32_t width = 1280, height = 720;
+    arguments.read({"--window", "-w"}, width, height);
+    bool debugLayer = arguments.read({"--debug-layer", "-d"});
+    ReadSettings readSettings;
+    readSettings.optimize.enabled = arguments.read("--optimize");
+    std::string optimizePasses;
+    if (arguments.read("--optimize-passes", optimizePasses)
+        && !readSettings.optimize.parsePasses(optimizePasses))
+        return -1;
+    readSettings.cullHierarchy.enabled = arguments.read("--cull-hierarchy");
+    readSettings.quantizeVertices = arguments.read("--quantize");
+    bool wireframe = arguments.read("--wireframe");
+    readSettings.wireframeOverlay = arguments.read("--wireframe-overlay");
+    auto options = createReaderOptions(arguments);
+
+    if (arguments.errors())
+    {
+        arguments.writeErrorMessages(std::cerr);
+        return -1;
+    }
+    if (arguments.argc() <= 1)
+    {
+        std::cerr << "Please specify a 3d model to benchmark." << std::endl;
+        return -1;
+    }
+    std::string filename = arguments[1];
+
+    OffscreenRenderer renderer(width, height, debugLayer);
+    if (!renderer.valid())
+        return -1;
+
+    auto start = chrono::steady_clock::now();
+    auto model = ModelLoader::readModel(filename, options, readSettings);
+    double loadTime = msSince(start);
+    if (!model)
+    {
+        std::cerr << "Failed loading " << filename << std::endl;
+        return -1;
+    }
+    auto stats = collectMeshStats(*model);
+
+    // The wireframe is drawn either by the line mode pipelines of the
+    // switches, or from the barycentrics by the shaded pipelines
+    std::string wireframeMode = "off";
+    if (readSettings.wireframeOverlay)
+    {
+        bindWireframeOverlay(*model);
+        setWireframeOverlay(wireframe ? WireframeOverlay::WIRE : WireframeOverlay::SHADED_WIRE);
+        wireframeMode = wireframe ? "wire" : "overlay";
+    }
+    else if (wireframe)
+    {
+        insertWireframeSwitch(*model);
+        renderer.view()->mask = WIREFRAME_MASK_LINE;
+        wireframeMode = "lines";
+    }
+    renderer.sceneRoot()->addChild(model);
+
+    // Only counts the pipelines, without the cache of the previous runs
+    auto& pipelineCache = PipelineCache::instance();
+    pipelineCache.open(renderer.device(), "");
+    size_t numPipelines = pipelineCache.numCreated();
+    double pipelineTime = pipelineCache.createTime();
+    start = chrono::steady_clock::now();
+    renderer.viewer()->compile();
+    double compileTime = msSince(start);
+    numPipelines = pipelineCache.numCreated() - numPipelines;
+    pipelineTime = pipelineCache.createTime() - pipelineTime;
+    pipelineCache.close();
+
+    vsg::dvec3 center;
+    double radius;
+    computeFraming(*model, center, radius);
+
+    vector<double> frameTimes;
+    frameTimes.reserve(numFrames);
+    CullCounts cullTotals;
+    vsg::LookAt lookAt;
+    for (int i=0; i<numFrames; i++)
+    {
+        cameraOnPath(numFrames > 1 ? double(i)/(numFrames-1) : 0.0,
+                     center, radius, lookAt);
+        renderer.setCamera(lookAt, radius);
+
+        start = chrono::steady_clock::now();
+        if (!renderer.renderFrame())
+            break;
+        frameTimes.push_back(msSince(start));
+
+        auto camera = renderer.camera();
+        auto counts = countCulling(*model, camera->projectionMatrix->transform()
+                                   * camera->viewMatrix->transform());
+        cullTotals.tests += counts.tests;
+        cullTotals.culled += counts.culled;
+        cullTotals.drawn += counts.drawn;
+    }
+    size_t numCounted = std::max(size_t(1), frameTimes.size());
+
+    auto picking = benchmarkPicking(*model, center, radius, numPickRays);
+
+    vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (double t : sorted)
+        sum += t;
+
+    fmt::print("{{\n"
+               "  \"model\": \"{}\",\n"
+               "  \"device\": \"{}\",\n"
+               "  \"width\": {},\n"
+               "  \"height\": {},\n"
+               "  \"frames\": {},\n"
+               "  \"triangles\": {},\n"
+               "  \"mesh_bytes\": {},\n"
+               "  \"wireframe\": \"{}\",\n"
+               "  \"pipelines\": {},\n"
+               "  \"pipeline_ms\": {:.3f},\n"
+               "  \"load_ms\": {:.3f},\n"
+               "  \"compile_ms\": {:.3f},\n"
+               "  \"frame_ms\": {{\n"
+               "    \"mean\": {:.3f},\n"
+               "    \"min\": {:.3f},\n"
+               "    \"max\": {:.3f},\n"
+               "    \"p50\": {:.3f},\n"
+               "    \"p95\": {:.3f},\n"
+               "    \"p99\": {:.3f}\n"
+               "  }},\n"
+               "  \"cull_per_frame\": {{\n"
+               "    \"tests\": {:.1f},\n"
+               "    \"culled\": {:.1f},\n"
+               "    \"drawn\": {:.1f}\n"
+               "  }},\n"
+               "  \"bvh\": {{\n"
+               "    \"triangles\": {},\n"
+               "    \"nodes\": {},\n"
+               "    \"build_ms\": {:.3f},\n"
+               "    \"rays_per_sec\": {:.0f},\n"
+               "    \"hit_fraction\": {:.3f}\n"
+               "  }}\n"
+               "}}\n",
+               jsonEscape(filename),
+               jsonEscape(renderer.deviceName()),
+               width, height,
+               sorted.size(),
+               stats.numTriangles,
+               stats.numBytes,
+               wireframeMode,
+               numPipelines,
+               pipelineTime,
+               loadTime, compileTime,
+               sorted.empty() ? 0.0 : sum / sorted.size(),
+               sorted.empty() ? 0.0 : sorted.front(),
+               sorted.empty() ? 0.0 : sorted.back(),
+               percentile(sorted, 50),
+               percentile(sorted, 95),
+               percentile(sorted, 99),
+               double(cullTotals.tests) / numCounted,
+               double(cullTotals.culled) / numCounted,
+               double(cullTotals.drawn) / numCounted,
+               picking.numTriangles,
+               picking.numNodes,
+               picking.buildTime,
+               picking.raysPerSec,
+               picking.hitFraction);
+    return 0;
+}
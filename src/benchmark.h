@@ -0,0 +1,15 @@
+//======================================================================
+//  benchmark.h - Render a model headless along a fixed camera path
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Load the model given on the command line, render it offscreen
+// along an orbit through the standard viewpoints and print the
+// timings as JSON on stdout. Returns the exit code.
+int runBenchmark(int argc, char *argv[]);
+
+#endif /* BENCHMARK */
@@ -0,0 +1,165 @@
+//======================================================================
+//  bounds.cpp - Bounds of subgraphs that are stored on their nodes
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "bounds.h"
+#include <algorithm>
+#include <future>
+#include <thread>
+
+using namespace std;
+
+static const char *BOUNDS_KEY = "bounds";
+
+static bool storedBounds(const vsg::Node& node, vsg::dbox& bounds)
+{
+    auto value = node.getObject<vsg::dboxValue>(BOUNDS_KEY);
+    if (!value)
+        return false;
+    bounds = value->value();
+    return true;
+}
+
+static vsg::dbox storeBounds(vsg::Node& node, const vsg::dbox& bounds)
+{
+    node.setObject(BOUNDS_KEY, vsg::dboxValue::create(bounds));
+    return bounds;
+}
+
+// The bounds of box after it has been transformed by matrix
+static vsg::dbox transformBounds(const vsg::dmat4& matrix, const vsg::dbox& box)
+{
+    vsg::dbox result;
+    if (!box.valid())
+        return result;
+    for (int i = 0; i < 8; i++)
+        result.add(matrix * vsg::dvec3((i & 1) ? box.max.x : box.min.x,
+                                       (i & 2) ? box.max.y : box.min.y,
+                                       (i & 4) ? box.max.z : box.min.z));
+    return result;
+}
+
+// Takes the bounds stored on the transforms, e.g. on those above the
+// quantized meshes
+class StoredComputeBounds : public vsg::ComputeBounds
+{
+public:
+    using vsg::ComputeBounds::apply;
+
+    void apply(const vsg::MatrixTransform& transform) override
+    {
+        vsg::dbox stored;
+        if (!storedBounds(transform, stored))
+        {
+            vsg::ComputeBounds::apply(transform);
+            return;
+        }
+        bounds.add(matrixStack.empty() ? stored : transformBounds(matrixStack.back(), stored));
+    }
+};
+
+vsg::dbox computeBounds(vsg::Node& node)
+{
+    StoredComputeBounds computeBounds;
+    node.accept(computeBounds);
+    return computeBounds.bounds;
+}
+
+// The children of a plain group or a transform, or nullptr for the
+// nodes whose bounds aren't simply those of all of their children
+static vsg::Group *boundsGroup(vsg::Node& node, vsg::dmat4& matrix)
+{
+    matrix = vsg::dmat4();
+    if (auto transform = node.cast<vsg::MatrixTransform>())
+    {
+        matrix = transform->matrix;
+        return transform;
+    }
+    if (node.type_info() == typeid(vsg::Group))
+        return static_cast<vsg::Group *>(&node);
+    return nullptr;
+}
+
+vsg::dbox cacheBounds(vsg::Node& node)
+{
+    vsg::dbox bounds;
+    if (storedBounds(node, bounds))
+        return bounds;
+
+    vsg::dmat4 matrix;
+    auto group = boundsGroup(node, matrix);
+    if (!group || group->children.empty())
+        return storeBounds(node, computeBounds(node));
+
+    // Follow a chain of single children down to where it fans out
+    if (group->children.size() == 1)
+        return storeBounds(node, transformBounds(matrix, cacheBounds(*group->children[0])));
+
+    auto& children = group->children;
+    size_t numThreads = std::min(children.size(),
+                                 size_t(std::max(1u, std::thread::hardware_concurrency())));
+    vector<future<vsg::dbox>> results;
+    for (size_t t = 0; t < numThreads; t++)
+    {
+        results.push_back(std::async(std::launch::async, [&children, t, numThreads]() {
+            vsg::dbox bounds;
+            for (size_t i = t; i < children.size(); i += numThreads)
+            {
+                vsg::dbox childBounds;
+                if (!storedBounds(*children[i], childBounds))
+                    childBounds = storeBounds(*children[i], computeBounds(*children[i]));
+                bounds.add(childBounds);
+            }
+            return bounds;
+        }));
+    }
+    for (auto& result : results)
+        bounds.add(result.get());
+
+    return storeBounds(node, transformBounds(matrix, bounds));
+}
+
+vsg::dbox getBounds(vsg::Node& node)
+{
+    vsg::dbox bounds;
+    if (storedBounds(node, bounds))
+        return bounds;
+
+    // Only the models that are switched on
+    if (auto modelSwitch = node.cast<vsg::Switch>())
+    {
+        for (auto& child : modelSwitch->children)
+            if (child.mask != vsg::MASK_OFF)
+                bounds.add(getBounds(*child.node));
+        return bounds;
+    }
+
+    vsg::dmat4 matrix;
+    auto group = boundsGroup(node, matrix);
+    if (!group)
+        return storeBounds(node, computeBounds(node));
+
+    // The containers above the models are changed by the viewer, so
+    // their bounds are combined each time instead of being stored
+    for (auto& child : group->children)
+        bounds.add(getBounds(*child));
+    return transformBounds(matrix, bounds);
+}
+
+bool findBounds(const vsg::Node& node, vsg::dbox& bounds)
+{
+    return storedBounds(node, bounds);
+}
+
+void setBounds(vsg::Node& node, const vsg::dbox& bounds)
+{
+    storeBounds(node, bounds);
+}
+
+void clearBounds(vsg::Node& node)
+{
+    node.removeObject(BOUNDS_KEY);
+}
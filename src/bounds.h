@@ -0,0 +1,41 @@
+//======================================================================
+//  bounds.h - Bounds of subgraphs that are stored on their nodes
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <vsg/all.h>
+
+// Compute the bounds of node and store them on it, unless they are
+// already stored. The subgraphs below the first group with several
+// children are computed in parallel and get their bounds stored too.
+// Meant to be called once when a model has been loaded.
+vsg::dbox cacheBounds(vsg::Node& node);
+
+// The bounds of node in its own coordinates. The stored bounds are
+// used where they are available, so only the groups and transforms
+// above them are traversed, e.g. those that hold the loaded models.
+// The children of a switch that are switched off are skipped.
+// Subgraphs without stored bounds are computed and stored.
+vsg::dbox getBounds(vsg::Node& node);
+
+// Compute the bounds of node without storing them. Unlike
+// vsg::ComputeBounds it takes the bounds stored on the transforms
+// below node, which is what the quantized meshes rely on.
+vsg::dbox computeBounds(vsg::Node& node);
+
+// The bounds stored on node, if there are any
+bool findBounds(const vsg::Node& node, vsg::dbox& bounds);
+
+// Store bounds that are already known, e.g. of nodes that were
+// inserted above subgraphs with stored bounds
+void setBounds(vsg::Node& node, const vsg::dbox& bounds);
+
+// Remove the stored bounds of node, e.g. after its geometry has been
+// modified
+void clearBounds(vsg::Node& node);
+
+#endif /* BOUNDS */
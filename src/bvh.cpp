@@ -0,0 +1,431 @@
+//======================================================================
+//  bvh.cpp - Bounding volume hierarchy of triangles for ray picking
+//
+//  Each split evaluates the surface area heuristic over a fixed
+//  number of bins of the triangle centers along all three axes.
+//  The subtrees of the top levels are built on their own threads
+//  into arrays of their own, that are then concatenated.
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "bvh.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+using namespace std;
+
+static const int NUM_BINS = 12;
+static const uint32_t MAX_LEAF = 4;      // Always split larger leaves
+static const uint32_t MAX_SAH_LEAF = 16; // Unless the SAH says otherwise
+static const int MAX_DEPTH = 64;
+static const uint32_t PARALLEL_MIN = 1 << 15;
+
+// Half the surface area
+static float halfArea(const vsg::box& b)
+{
+    if (!b.valid())
+        return 0;
+    vsg::vec3 d = b.max - b.min;
+    return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+// The bounds of a triangle. The builder partitions these instead of
+// triangle indices so that it reads memory sequentially.
+struct PrimRef
+{
+    vsg::vec3 min;
+    uint32_t triangle;
+    vsg::vec3 max;
+
+    float center(int axis) const { return (min[axis] + max[axis]) * 0.5f; }
+};
+
+struct TriangleBVH::Builder
+{
+    const atomic<bool> *canceled;
+    vector<PrimRef> prims;
+    int parallelDepth = 0;
+
+    Builder(const atomic<bool> *canceled_) : canceled(canceled_) {}
+
+    bool isCanceled() const
+    {
+        return canceled && canceled->load(std::memory_order_relaxed);
+    }
+
+    // Set the bounds of node to those of the triangles in [begin,end)
+    // and decide whether to split them. If so, the triangles are
+    // partitioned at mid.
+    bool split(uint32_t begin, uint32_t end, int depth, Node& node, uint32_t& mid)
+    {
+        vsg::box bounds, centerBounds;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            auto& prim = prims[i];
+            bounds.add(prim.min);
+            bounds.add(prim.max);
+            centerBounds.add((prim.min + prim.max) * 0.5f);
+        }
+        node.min = bounds.min;
+        node.max = bounds.max;
+
+        uint32_t count = end - begin;
+        if (count <= MAX_LEAF || depth >= MAX_DEPTH || isCanceled())
+            return false;
+
+        // All the triangles are binned once for all the axes
+        struct Bin
+        {
+            vsg::box bounds;
+            uint32_t count = 0;
+        };
+        Bin bins[3][NUM_BINS];
+        float scale[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float extent = centerBounds.max[axis] - centerBounds.min[axis];
+            scale[axis] = extent > 0 ? NUM_BINS / extent : 0;
+        }
+        auto binOf = [&](const PrimRef& prim, int axis) {
+            int b = int((prim.center(axis) - centerBounds.min[axis]) * scale[axis]);
+            return std::min(b, NUM_BINS - 1);
+        };
+        for (uint32_t i = begin; i < end; i++)
+        {
+            auto& prim = prims[i];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                auto& bin = bins[axis][binOf(prim, axis)];
+                bin.bounds.add(prim.min);
+                bin.bounds.add(prim.max);
+                bin.count++;
+            }
+        }
+        float bestCost = std::numeric_limits<float>::max();
+        int bestAxis = -1, bestBin = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (scale[axis] == 0)
+                continue;
+
+            // The cost of the right side of each split plane
+            float rightCost[NUM_BINS];
+            vsg::box rightBounds;
+            uint32_t rightCount = 0;
+            for (int b = NUM_BINS - 1; b > 0; b--)
+            {
+                rightBounds.add(bins[axis][b].bounds);
+                rightCount += bins[axis][b].count;
+                rightCost[b] = rightCount * halfArea(rightBounds);
+            }
+
+            vsg::box leftBounds;
+            uint32_t leftCount = 0;
+            for (int b = 0; b < NUM_BINS - 1; b++)
+            {
+                leftBounds.add(bins[axis][b].bounds);
+                leftCount += bins[axis][b].count;
+                if (leftCount == 0 || leftCount == count)
+                    continue;
+                float cost = leftCount * halfArea(leftBounds) + rightCost[b+1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        // The cost of a leaf relative to the traversal of a node
+        float leafCost = count * halfArea(bounds);
+        if (bestAxis >= 0 && bestCost >= leafCost && count <= MAX_SAH_LEAF)
+            return false;
+
+        if (bestAxis >= 0)
+        {
+            auto it = std::partition(prims.begin() + begin, prims.begin() + end,
+                                     [&](const PrimRef& prim) { return binOf(prim, bestAxis) <= bestBin; });
+            mid = uint32_t(it - prims.begin());
+            return true;
+        }
+
+        // The centroids coincide, so split by count
+        mid = begin + count / 2;
+        return true;
+    }
+
+    // Append the subtree of [begin,end) depth first to nodes
+    void buildSerial(vector<Node>& nodes, uint32_t begin, uint32_t end, int depth)
+    {
+        size_t index = nodes.size();
+        nodes.emplace_back();
+
+        Node node;
+        uint32_t mid;
+        if (!split(begin, end, depth, node, mid))
+        {
+            node.index = begin;
+            node.count = end - begin;
+            nodes[index] = node;
+            return;
+        }
+
+        buildSerial(nodes, begin, mid, depth + 1);
+        node.index = uint32_t(nodes.size());
+        node.count = 0;
+        nodes[index] = node;
+        buildSerial(nodes, mid, end, depth + 1);
+    }
+
+    // The subtree of [begin,end) with the node indices relative to
+    // its own root
+    vector<Node> buildParallel(uint32_t begin, uint32_t end, int depth)
+    {
+        vector<Node> nodes;
+        if (depth >= parallelDepth || end - begin < PARALLEL_MIN)
+        {
+            buildSerial(nodes, begin, end, depth);
+            return nodes;
+        }
+
+        Node node;
+        uint32_t mid;
+        if (!split(begin, end, depth, node, mid))
+        {
+            node.index = begin;
+            node.count = end - begin;
+            nodes.push_back(node);
+            return nodes;
+        }
+
+        auto leftFuture = std::async(std::launch::async,
+                                     [this, begin, mid, depth]() { return buildParallel(begin, mid, depth + 1); });
+        auto right = buildParallel(mid, end, depth + 1);
+        auto left = leftFuture.get();
+
+        uint32_t leftOffset = 1;
+        uint32_t rightOffset = uint32_t(1 + left.size());
+        node.index = rightOffset;
+        node.count = 0;
+        nodes.reserve(1 + left.size() + right.size());
+        nodes.push_back(node);
+        for (auto n : left)
+        {
+            if (n.count == 0)
+                n.index += leftOffset;
+            nodes.push_back(n);
+        }
+        for (auto n : right)
+        {
+            if (n.count == 0)
+                n.index += rightOffset;
+            nodes.push_back(n);
+        }
+        return nodes;
+    }
+};
+
+bool TriangleBVH::build(std::vector<vsg::vec3>&& vertices,
+                        std::vector<uint32_t>&& indices,
+                        const std::atomic<bool> *canceled)
+{
+    m_nodes.clear();
+    m_vertices = std::move(vertices);
+    m_indices.clear();
+
+    size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0)
+        return true;
+
+    Builder builder(canceled);
+    builder.prims.resize(numTriangles);
+    parallelFor(numTriangles, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++)
+        {
+            vsg::box bounds;
+            for (int k = 0; k < 3; k++)
+                bounds.add(m_vertices[indices[3*t + k]]);
+            builder.prims[t] = {bounds.min, uint32_t(t), bounds.max};
+        }
+    });
+
+    // Enough levels for a few subtrees per core
+    size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    while ((size_t(1) << builder.parallelDepth) < numThreads * 4)
+        builder.parallelDepth++;
+
+    m_nodes = builder.buildParallel(0, uint32_t(numTriangles), 0);
+    if (builder.isCanceled())
+    {
+        m_nodes.clear();
+        return false;
+    }
+
+    // Store the triangles in the order of the leaves
+    m_indices.resize(numTriangles * 3);
+    parallelFor(numTriangles, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            uint32_t t = builder.prims[i].triangle;
+            m_indices[3*i] = indices[3*t];
+            m_indices[3*i+1] = indices[3*t+1];
+            m_indices[3*i+2] = indices[3*t+2];
+        }
+    });
+    return true;
+}
+
+vsg::dbox TriangleBVH::bounds() const
+{
+    vsg::dbox result;
+    if (!m_nodes.empty())
+    {
+        result.add(vsg::dvec3(m_nodes[0].min));
+        result.add(vsg::dvec3(m_nodes[0].max));
+    }
+    return result;
+}
+
+// The distance along the ray to the box of node, if it is hit before maxT
+static inline bool hitNode(const vsg::vec3& nodeMin, const vsg::vec3& nodeMax,
+                           const vsg::vec3& origin, const vsg::vec3& invDir,
+                           float maxT, float& tNear)
+{
+    float tx1 = (nodeMin.x - origin.x) * invDir.x;
+    float tx2 = (nodeMax.x - origin.x) * invDir.x;
+    float tmin = std::min(tx1, tx2), tmax = std::max(tx1, tx2);
+    float ty1 = (nodeMin.y - origin.y) * invDir.y;
+    float ty2 = (nodeMax.y - origin.y) * invDir.y;
+    tmin = std::max(tmin, std::min(ty1, ty2));
+    tmax = std::min(tmax, std::max(ty1, ty2));
+    float tz1 = (nodeMin.z - origin.z) * invDir.z;
+    float tz2 = (nodeMax.z - origin.z) * invDir.z;
+    tmin = std::max(tmin, std::min(tz1, tz2));
+    tmax = std::min(tmax, std::max(tz1, tz2));
+    tNear = tmin;
+    return tmax >= std::max(tmin, 0.0f) && tmin < maxT;
+}
+
+bool TriangleBVH::intersect(const vsg::dvec3& origin,
+                            const vsg::dvec3& direction,
+                            Hit& hit,
+                            double maxT) const
+{
+    double length = vsg::length(direction);
+    if (m_nodes.empty() || length == 0)
+        return false;
+
+    // The traversal is done in float with a normalized direction
+    vsg::vec3 o(origin);
+    vsg::vec3 d(direction / length);
+    vsg::vec3 invDir;
+    for (int i = 0; i < 3; i++)
+    {
+        float di = std::fabs(d[i]) < 1e-20f ? std::copysign(1e-20f, d[i]) : d[i];
+        invDir[i] = 1.0f / di;
+    }
+
+    float bestT = float(std::min(maxT * length, double(std::numeric_limits<float>::max())));
+    int64_t bestTriangle = -1;
+    float tNear;
+    if (!hitNode(m_nodes[0].min, m_nodes[0].max, o, invDir, bestT, tNear))
+        return false;
+
+    struct Entry
+    {
+        uint32_t index;
+        float tNear;
+    };
+    Entry stack[MAX_DEPTH + 2];
+    int stackSize = 0;
+    uint32_t index = 0;
+    while (true)
+    {
+        const Node& node = m_nodes[index];
+        if (node.count > 0)
+        {
+            for (uint32_t t = node.index; t < node.index + node.count; t++)
+            {
+                const vsg::vec3& v0 = m_vertices[m_indices[3*t]];
+                vsg::vec3 e1 = m_vertices[m_indices[3*t+1]] - v0;
+                vsg::vec3 e2 = m_vertices[m_indices[3*t+2]] - v0;
+                vsg::vec3 p = vsg::cross(d, e2);
+                float det = vsg::dot(e1, p);
+                if (det == 0)
+                    continue;
+                float invDet = 1.0f / det;
+                vsg::vec3 s = o - v0;
+                float u = vsg::dot(s, p) * invDet;
+                if (u < 0 || u > 1)
+                    continue;
+                vsg::vec3 q = vsg::cross(s, e1);
+                float v = vsg::dot(d, q) * invDet;
+                if (v < 0 || u + v > 1)
+                    continue;
+                float tHit = vsg::dot(e2, q) * invDet;
+                if (tHit > 0 && tHit < bestT)
+                {
+                    bestT = tHit;
+                    bestTriangle = t;
+                }
+            }
+        }
+        else
+        {
+            // Visit the nearer child first and skip the ones that are
+            // beyond the nearest hit so far
+            uint32_t left = index + 1, right = node.index;
+            float tLeft, tRight;
+            bool hitLeft = hitNode(m_nodes[left].min, m_nodes[left].max, o, invDir, bestT, tLeft);
+            bool hitRight = hitNode(m_nodes[right].min, m_nodes[right].max, o, invDir, bestT, tRight);
+            if (hitLeft && hitRight)
+            {
+                if (tRight < tLeft)
+                {
+                    std::swap(left, right);
+                    std::swap(tLeft, tRight);
+                }
+                stack[stackSize++] = {right, tRight};
+                index = left;
+                continue;
+            }
+            if (hitLeft || hitRight)
+            {
+                index = hitLeft ? left : right;
+                continue;
+            }
+        }
+
+        // Pop the next subtree that may still have a nearer hit
+        while (stackSize > 0 && stack[stackSize-1].tNear >= bestT)
+            stackSize--;
+        if (stackSize == 0)
+            break;
+        index = stack[--stackSize].index;
+    }
+
+    if (bestTriangle < 0)
+        return false;
+
+    uint32_t t = uint32_t(bestTriangle);
+    vsg::dvec3 v0(m_vertices[m_indices[3*t]]);
+    vsg::dvec3 v1(m_vertices[m_indices[3*t+1]]);
+    vsg::dvec3 v2(m_vertices[m_indices[3*t+2]]);
+    vsg::dvec3 normal = vsg::cross(v1 - v0, v2 - v0);
+    double normalLength = vsg::length(normal);
+    if (normalLength > 0)
+        normal /= normalLength;
+    if (vsg::dot(normal, direction) > 0)
+        normal = -normal;
+
+    hit.t = bestT / length;
+    hit.triangle = t;
+    hit.point = origin + direction * hit.t;
+    hit.normal = normal;
+    return true;
+}
@@ -0,0 +1,69 @@
+//======================================================================
+//  bvh.h - Bounding volume hierarchy of triangles for ray picking
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef BVH_H
+#define BVH_H
+
+#include <vsg/all.h>
+#include <atomic>
+#include <limits>
+#include <vector>
+
+// A BVH that is built with the surface area heuristic over binned
+// centroids. The nodes are stored depth first in a flat array, so
+// that the left child of a node directly follows it, and the
+// triangles are reordered so that each leaf refers to a consecutive
+// range of them.
+class TriangleBVH
+{
+public:
+    struct Hit
+    {
+        double t = 0;          // Along the ray direction
+        uint32_t triangle = 0; // In the order of the leaves
+        vsg::dvec3 point;
+        vsg::dvec3 normal;     // Of the triangle, facing the ray
+    };
+
+    // Build the hierarchy of the triangles in indices, three per
+    // triangle, of vertices. The top levels are built in parallel.
+    // Returns false if canceled.
+    bool build(std::vector<vsg::vec3>&& vertices,
+               std::vector<uint32_t>&& indices,
+               const std::atomic<bool> *canceled = nullptr);
+
+    // Find the nearest triangle that the ray from origin in direction
+    // hits within maxT. direction doesn't have to be normalized.
+    bool intersect(const vsg::dvec3& origin,
+                   const vsg::dvec3& direction,
+                   Hit& hit,
+                   double maxT = std::numeric_limits<double>::max()) const;
+
+    bool empty() const { return m_nodes.empty(); }
+    size_t numTriangles() const { return m_indices.size() / 3; }
+    size_t numNodes() const { return m_nodes.size(); }
+    vsg::dbox bounds() const;
+
+private:
+    // 32 bytes, so that two nodes fit in a cache line. A leaf has a
+    // count of triangles starting at index. An inner node has a zero
+    // count and its right child at index.
+    struct Node
+    {
+        vsg::vec3 min;
+        uint32_t index;
+        vsg::vec3 max;
+        uint32_t count;
+    };
+
+    struct Builder;
+
+    std::vector<Node> m_nodes;
+    std::vector<vsg::vec3> m_vertices;
+    std::vector<uint32_t> m_indices;
+};
+
+#endif /* BVH */
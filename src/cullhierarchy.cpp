@@ -0,0 +1,274 @@
+//======================================================================
+//  cullhierarchy.cpp - Spatial hierarchy of cull groups above the parts
+//                      of a model
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "cullhierarchy.h"
+#include "bounds.h"
+#include "parallel.h"
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <set>
+
+using namespace std;
+
+static double elapsedMs(vsg::clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count();
+}
+
+std::string CullHierarchySettings::key() const
+{
+    if (!enabled)
+        return "";
+    return fmt::format("cull{}_{}", minChildren, leafSize);
+}
+
+static vsg::dsphere boundingSphere(const vsg::dbox& box)
+{
+    return vsg::dsphere((box.min + box.max) * 0.5, vsg::length(box.max - box.min) * 0.5);
+}
+
+struct CullItem
+{
+    vsg::ref_ptr<vsg::Node> node;
+    vsg::dbox bounds;
+    vsg::dvec3 center;
+};
+
+// Split items at the median of their centers along the longest axis
+// until there are at most leafSize of them in each cull group
+static vsg::ref_ptr<vsg::Node> buildCullNode(vector<CullItem>& items,
+                                             size_t begin, size_t end,
+                                             size_t leafSize)
+{
+    vsg::dbox bounds, centers;
+    for (size_t i = begin; i < end; i++)
+    {
+        bounds.add(items[i].bounds);
+        centers.add(items[i].center);
+    }
+
+    auto group = vsg::CullGroup::create(boundingSphere(bounds));
+    setBounds(*group, bounds);
+    if (end - begin <= leafSize)
+    {
+        for (size_t i = begin; i < end; i++)
+            group->addChild(items[i].node);
+        return group;
+    }
+
+    vsg::dvec3 extent = centers.max - centers.min;
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0
+        : extent.y >= extent.z ? 1 : 2;
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                     [axis](const CullItem& a, const CullItem& b) {
+                         return a.center[axis] < b.center[axis];
+                     });
+    group->addChild(buildCullNode(items, begin, mid, leafSize));
+    group->addChild(buildCullNode(items, mid, end, leafSize));
+    return group;
+}
+
+class BuildCullHierarchy : public vsg::Visitor
+{
+public:
+    BuildCullHierarchy(const CullHierarchySettings& settings_) : settings(settings_) {}
+
+    const CullHierarchySettings& settings;
+    std::set<vsg::Object*> visited;
+    size_t numRebuilt = 0;
+
+    // Only the nodes whose children are all treated alike
+    static bool isRebuildable(const vsg::Group& group)
+    {
+        auto& type = group.type_info();
+        return type == typeid(vsg::Group)
+            || type == typeid(vsg::StateGroup)
+            || type == typeid(vsg::MatrixTransform);
+    }
+
+    void rebuild(vsg::Group& group)
+    {
+        auto& children = group.children;
+        if (children.size() < settings.minChildren)
+            return;
+
+        // The bounds that aren't stored yet are computed in parallel
+        // and stored afterwards, as the children may be shared.
+        vector<vsg::dbox> bounds(children.size());
+        vector<char> computed(children.size(), 0);
+        parallelFor(children.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                if (findBounds(*children[i], bounds[i]))
+                    continue;
+                bounds[i] = computeBounds(*children[i]);
+                computed[i] = 1;
+            }
+        }, 64);
+
+        // Children without bounds, e.g. lights, stay where they are
+        vector<CullItem> items;
+        vsg::Group::Children unbounded;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            if (computed[i])
+                setBounds(*children[i], bounds[i]);
+            if (bounds[i].valid())
+                items.push_back({children[i], bounds[i], (bounds[i].min + bounds[i].max) * 0.5});
+            else
+                unbounded.push_back(children[i]);
+        }
+        if (items.size() < settings.minChildren)
+            return;
+
+        children = unbounded;
+        children.push_back(buildCullNode(items, 0, items.size(), std::max(size_t(1), settings.leafSize)));
+        numRebuilt++;
+    }
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::Group& group) override
+    {
+        if (!visited.insert(&group).second)
+            return;
+        if (isRebuildable(group))
+            rebuild(group);
+        group.traverse(*this);
+    }
+};
+
+size_t buildCullHierarchy(vsg::Node& node, const CullHierarchySettings& settings)
+{
+    auto t0 = vsg::clock::now();
+    BuildCullHierarchy builder(settings);
+    node.accept(builder);
+    if (builder.numRebuilt)
+        spdlog::info("Built the cull hierarchies of {} groups in {:.0f} ms",
+                     builder.numRebuilt, elapsedMs(t0));
+    return builder.numRebuilt;
+}
+
+// The planes of the frustum of matrix, facing inwards. The planes
+// are the same for the reversed depth range.
+static std::array<vsg::dvec4, 6> frustumPlanes(const vsg::dmat4& m)
+{
+    auto row = [&m](int i) { return vsg::dvec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    std::array<vsg::dvec4, 6> planes = {
+        row(3) + row(0), row(3) - row(0),
+        row(3) + row(1), row(3) - row(1),
+        row(2), row(3) - row(2)
+    };
+    for (auto& plane : planes)
+    {
+        double length = vsg::length(vsg::dvec3(plane.x, plane.y, plane.z));
+        if (length > 0)
+            plane = plane / length;
+    }
+    return planes;
+}
+
+class CountCulling : public vsg::Visitor
+{
+public:
+    CountCulling(const vsg::dmat4& projectionView)
+    {
+        matrixStack.push_back(projectionView);
+        planeStack.push_back(frustumPlanes(projectionView));
+    }
+
+    CullCounts counts;
+    vector<vsg::dmat4> matrixStack;
+    vector<std::array<vsg::dvec4, 6>> planeStack;
+
+    bool visible(const vsg::dsphere& bound)
+    {
+        counts.tests++;
+        for (auto& plane : planeStack.back())
+        {
+            if (vsg::dot(vsg::dvec3(plane.x, plane.y, plane.z), bound.center) + plane.w < -bound.radius)
+            {
+                counts.culled++;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::MatrixTransform& transform) override
+    {
+        matrixStack.push_back(matrixStack.back() * transform.matrix);
+        planeStack.push_back(frustumPlanes(matrixStack.back()));
+        transform.traverse(*this);
+        planeStack.pop_back();
+        matrixStack.pop_back();
+    }
+
+    void apply(vsg::Switch& sw) override
+    {
+        for (auto& child : sw.children)
+            if (child.mask != vsg::MASK_OFF && child.node)
+                child.node->accept(*this);
+    }
+
+    void apply(vsg::CullGroup& group) override
+    {
+        if (visible(group.bound))
+            group.traverse(*this);
+    }
+
+    void apply(vsg::CullNode& node) override
+    {
+        if (visible(node.bound) && node.child)
+            node.child->accept(*this);
+    }
+
+    void apply(vsg::LOD& lod) override
+    {
+        if (visible(lod.bound) && !lod.children.empty() && lod.children[0].node)
+            lod.children[0].node->accept(*this);
+    }
+
+    void apply(vsg::PagedLOD& plod) override
+    {
+        if (!visible(plod.bound))
+            return;
+        for (auto& child : plod.children)
+        {
+            if (child.node)
+            {
+                child.node->accept(*this);
+                break;
+            }
+        }
+    }
+
+    void apply(vsg::VertexIndexDraw&) override { counts.drawn++; }
+    void apply(vsg::VertexDraw&) override { counts.drawn++; }
+    void apply(vsg::Geometry&) override { counts.drawn++; }
+    void apply(vsg::Draw&) override { counts.drawn++; }
+    void apply(vsg::DrawIndexed&) override { counts.drawn++; }
+};
+
+CullCounts countCulling(vsg::Node& scene, const vsg::dmat4& projectionView)
+{
+    CountCulling counter(projectionView);
+    scene.accept(counter);
+    return counter.counts;
+}
@@ -0,0 +1,44 @@
+//======================================================================
+//  cullhierarchy.h - Spatial hierarchy of cull groups above the parts
+//                    of a model
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef CULLHIERARCHY_H
+#define CULLHIERARCHY_H
+
+#include <vsg/all.h>
+#include <string>
+
+struct CullHierarchySettings
+{
+    bool enabled = false;
+    size_t minChildren = 16; // Groups with fewer children are left flat
+    size_t leafSize = 4;     // Children of the lowest cull groups
+
+    // A short string that identifies the settings, e.g. for cache keys
+    std::string key() const;
+};
+
+// Rebuild the children of the groups, state groups and transforms of
+// node that have many children into a bounding volume hierarchy of
+// vsg::CullGroups, so that the parts outside of the view are culled
+// a branch at a time. The children themselves, and so their state
+// groups and the state switches in them, are kept as they are.
+// Returns the number of groups that were rebuilt.
+size_t buildCullHierarchy(vsg::Node& node, const CullHierarchySettings& settings);
+
+struct CullCounts
+{
+    size_t tests = 0;  // Bounds tested against the view frustum
+    size_t culled = 0; // Bounds outside of the frustum
+    size_t drawn = 0;  // Draw commands inside of it
+};
+
+// Count what the culling of the record traversal does in the view
+// of projectionView, the projection matrix times the view matrix.
+// The levels of detail are counted at their finest level.
+CullCounts countCulling(vsg::Node& scene, const vsg::dmat4& projectionView);
+
+#endif /* CULLHIERARCHY */
@@ -0,0 +1,22 @@
+//======================================================================
+//  filehash.h - Fast content hashing of files
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef FILEHASH_H
+#define FILEHASH_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// A 64-bit non cryptographic hash (the XXH64 algorithm). It is stable
+// between runs and machines so it may be used for on-disk keys.
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0);
+
+// Hash the contents of filename through a memory map of the
+// file. Returns false if the file can't be read.
+bool hashFile(const std::string& filename, uint64_t& hash);
+
+#endif /* FILEHASH */
@@ -0,0 +1,220 @@
+//======================================================================
+//  filewatcher.cpp - Event driven watching of the model file
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "filewatcher.h"
+#include "filehash.h"
+#include <QFileInfo>
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// constructor
+FileWatcher::FileWatcher(QObject *parent)
+  : QObject(parent)
+{
+    m_debounceTimer = new QTimer(this);
+    m_debounceTimer->setSingleShot(true);
+    connect(m_debounceTimer, SIGNAL(timeout()), this, SLOT(checkFile()));
+
+    // A single thread keeps the hashes in the order they were requested
+    m_hashPool = new QThreadPool(this);
+    m_hashPool->setMaxThreadCount(1);
+
+#ifdef __linux__
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd >= 0)
+    {
+        m_inotifyNotifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+        connect(m_inotifyNotifier, &QSocketNotifier::activated,
+                this, &FileWatcher::readInotifyEvents);
+
+        // A close or a rename is the end of a write, so there is only
+        // need to wait for a burst of rewrites.
+        m_debounceTimer->setInterval(20);
+        return;
+    }
+    spdlog::warn("inotify not available, falling back to QFileSystemWatcher");
+#endif
+
+    m_fsWatcher = new QFileSystemWatcher(this);
+    connect(m_fsWatcher, SIGNAL(fileChanged(const QString&)),
+            this, SLOT(pathChanged(const QString&)));
+    connect(m_fsWatcher, SIGNAL(directoryChanged(const QString&)),
+            this, SLOT(pathChanged(const QString&)));
+
+    // Modification events arrive while the file is being written
+    // so wait for it to settle.
+    m_debounceTimer->setInterval(100);
+}
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+    m_hashPool->waitForDone();
+#ifdef __linux__
+    if (m_inotifyFd >= 0)
+        close(m_inotifyFd);
+#endif
+}
+
+void FileWatcher::watch(const QString& filename)
+{
+    QFileInfo fi(filename);
+    QString absFilename = fi.absoluteFilePath();
+    if (absFilename == m_filename)
+        return;
+
+    stop();
+    m_filename = absFilename;
+    m_basename = fi.fileName();
+    m_size = fi.size();
+    m_lastModified = fi.lastModified();
+    hashInBackground(false);
+
+    // Watch the directory and not the file, as many writers replace
+    // the file through a rename.
+    QString dir = fi.absolutePath();
+#ifdef __linux__
+    if (m_inotifyFd >= 0)
+    {
+        m_inotifyWatch = inotify_add_watch(m_inotifyFd,
+                                           dir.toLocal8Bit().constData(),
+                                           IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (m_inotifyWatch < 0)
+            spdlog::error("Failed watching {}", dir.toStdString());
+        return;
+    }
+#endif
+    m_fsWatcher->addPath(dir);
+    m_fsWatcher->addPath(m_filename);
+}
+
+void FileWatcher::stop()
+{
+    m_debounceTimer->stop();
+#ifdef __linux__
+    if (m_inotifyWatch >= 0)
+        inotify_rm_watch(m_inotifyFd, m_inotifyWatch);
+    m_inotifyWatch = -1;
+#endif
+    if (m_fsWatcher && !m_fsWatcher->files().isEmpty())
+        m_fsWatcher->removePaths(m_fsWatcher->files());
+    if (m_fsWatcher && !m_fsWatcher->directories().isEmpty())
+        m_fsWatcher->removePaths(m_fsWatcher->directories());
+
+    m_filename.clear();
+    m_basename.clear();
+    m_hasHash = false;
+    m_generation++;
+}
+
+void FileWatcher::readInotifyEvents()
+{
+#ifdef __linux__
+    alignas(struct inotify_event) char buf[4096];
+    bool matched = false;
+
+    for (;;)
+    {
+        ssize_t len = read(m_inotifyFd, buf, sizeof(buf));
+        if (len <= 0)
+            break;
+
+        for (char *p = buf; p < buf + len; )
+        {
+            auto event = (const struct inotify_event*)p;
+            if (event->wd == m_inotifyWatch
+                && event->len > 0
+                && m_basename == QString::fromLocal8Bit(event->name))
+                matched = true;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    if (matched)
+        scheduleCheck();
+#endif
+}
+
+void FileWatcher::pathChanged(const QString& path)
+{
+    // A replaced file drops out of the watcher, so add it again
+    if (!m_filename.isEmpty()
+        && !m_fsWatcher->files().contains(m_filename)
+        && QFileInfo::exists(m_filename))
+        m_fsWatcher->addPath(m_filename);
+
+    if (path == m_filename || QFileInfo(m_filename).absolutePath() == path)
+        scheduleCheck();
+}
+
+// Coalesce a burst of events by restarting the timer
+void FileWatcher::scheduleCheck()
+{
+    m_debounceTimer->start();
+}
+
+void FileWatcher::checkFile()
+{
+    if (m_filename.isEmpty())
+        return;
+
+    QFileInfo fi(m_filename);
+    if (!fi.isFile())
+        return; // Removed, wait for the new version to arrive
+
+    // inotify only reports the file after a write, which may keep
+    // the size and, within its granularity, the modification time.
+    // The polling fallback doesn't read the file unless it looks like
+    // it was rewritten.
+    bool written = m_inotifyWatch >= 0;
+    if (!written && fi.size() == m_size && fi.lastModified() == m_lastModified)
+    {
+        spdlog::debug("{} was touched but its size and time are unchanged", m_filename.toStdString());
+        return;
+    }
+    m_size = fi.size();
+    m_lastModified = fi.lastModified();
+
+    hashInBackground(true);
+}
+
+// Hash the watched file without blocking the gui. The result is
+// passed to hashDone() in the gui thread, which emits fileChanged()
+// if notify is set and the contents changed.
+void FileWatcher::hashInBackground(bool notify)
+{
+    QString filename = m_filename;
+    int generation = m_generation;
+    m_hashPool->start([this, filename, generation, notify]() {
+        uint64_t hash = 0;
+        bool ok = hashFile(filename.toStdString(), hash);
+        QMetaObject::invokeMethod(this, [this, generation, ok, hash, notify]() {
+            hashDone(generation, ok, hash, notify);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileWatcher::hashDone(int generation, bool ok, uint64_t hash, bool notify)
+{
+    if (generation != m_generation || !ok)
+        return;
+
+    if (notify && m_hasHash && hash == m_hash)
+    {
+        spdlog::debug("{} was rewritten but its contents is unchanged", m_filename.toStdString());
+        return;
+    }
+
+    m_hash = hash;
+    m_hasHash = true;
+    if (notify)
+        emit fileChanged(m_filename);
+}
@@ -0,0 +1,74 @@
+//======================================================================
+//  filewatcher.h - Event driven watching of the model file
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QDateTime>
+#include <QThreadPool>
+
+// Watches a single file and emits fileChanged() once a writer is done
+// with it. On linux inotify is used to react on the writer closing the
+// file or renaming a new version into place. Elsewhere it falls back
+// to QFileSystemWatcher. A burst of rewrites is coalesced into a
+// single signal, and a rewrite with unchanged contents is ignored.
+// The contents are hashed in a thread of its own. When polling, only
+// if the size or the modification time of the file changed.
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    FileWatcher(QObject *parent = nullptr);
+    ~FileWatcher();
+
+    // Start watching filename. Its current content is taken as
+    // the unchanged reference.
+    void watch(const QString& filename);
+    void stop();
+    bool isActive() const { return !m_filename.isEmpty(); }
+
+    // The time to wait for more events before checking the file
+    void setDebounce(int ms) { m_debounceTimer->setInterval(ms); }
+
+signals:
+    void fileChanged(const QString& filename);
+
+private slots:
+    void readInotifyEvents();
+    void pathChanged(const QString& path);
+    void checkFile();
+
+private:
+    void scheduleCheck();
+    void hashInBackground(bool notify);
+    void hashDone(int generation, bool ok, uint64_t hash, bool notify);
+
+    QString m_filename;
+    QString m_basename;
+    qint64 m_size = -1;
+    QDateTime m_lastModified;
+    uint64_t m_hash = 0;
+    bool m_hasHash = false;
+    int m_generation = 0; // Of the watched file, to drop stale hashes
+    QThreadPool *m_hashPool = nullptr;
+    QTimer *m_debounceTimer = nullptr;
+
+    // linux inotify
+    int m_inotifyFd = -1;
+    int m_inotifyWatch = -1;
+    QSocketNotifier *m_inotifyNotifier = nullptr;
+
+    // Fallback
+    QFileSystemWatcher *m_fsWatcher = nullptr;
+};
+
+#endif /* FILEWATCHER */
@@ -0,0 +1,397 @@
+//======================================================================
+//  frameprofiler.cpp - CPU and GPU timings of the frames of a viewer
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "frameprofiler.h"
+#include "gpuresources.h"
+#include "tracing.h"
+#include <vsgImGui/imgui.h>
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+
+using namespace std;
+
+static const char *phaseNames[FrameTimes::NUM_PHASES] = {
+    "advance", "events", "update", "record_submit", "present"
+};
+static const char *gpuSectionNames[FrameTimes::NUM_GPU_SECTIONS] = {
+    "gpu_main_view", "gpu_gizmo"
+};
+
+static double elapsedMs(vsg::clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count();
+}
+
+class ResetTimestamps : public vsg::Inherit<vsg::Command, ResetTimestamps>
+{
+public:
+    ResetTimestamps(vsg::ref_ptr<FrameProfiler> profiler_) : profiler(profiler_) {}
+
+    vsg::ref_ptr<FrameProfiler> profiler;
+
+    void record(vsg::CommandBuffer& commandBuffer) const override
+    {
+        profiler->resetTimestamps(commandBuffer);
+    }
+};
+
+class WriteTimestamp : public vsg::Inherit<vsg::Command, WriteTimestamp>
+{
+public:
+    WriteTimestamp(vsg::ref_ptr<FrameProfiler> profiler_, uint32_t index_) :
+        profiler(profiler_), index(index_) {}
+
+    vsg::ref_ptr<FrameProfiler> profiler;
+    uint32_t index;
+
+    void record(vsg::CommandBuffer& commandBuffer) const override
+    {
+        profiler->writeTimestamp(commandBuffer, index);
+    }
+};
+
+class ProfilerOverlay : public vsg::Inherit<vsg::Command, ProfilerOverlay>
+{
+public:
+    ProfilerOverlay(vsg::ref_ptr<FrameProfiler> profiler_) : profiler(profiler_) {}
+
+    vsg::ref_ptr<FrameProfiler> profiler;
+
+    void row(const char *name, std::function<double(const FrameTimes&)> get) const
+    {
+        double p50 = profiler->percentile(0.5, get);
+        if (p50 < 0)
+            ImGui::Text("%-14s %8s %8s %8s", name, "-", "-", "-");
+        else
+            ImGui::Text("%-14s %8.2f %8.2f %8.2f", name, p50,
+                        profiler->percentile(0.95, get),
+                        profiler->percentile(0.99, get));
+    }
+
+    void record(vsg::CommandBuffer&) const override
+    {
+        if (!profiler->showOverlay)
+            return;
+
+        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowBgAlpha(0.75f);
+        if (ImGui::Begin("Frame profiler", &profiler->showOverlay,
+                         ImGuiWindowFlags_AlwaysAutoResize))
+        {
+            ImGui::Text("%-14s %8s %8s %8s", "ms", "p50", "p95", "p99");
+            for (int i = 0; i < FrameTimes::NUM_PHASES; i++)
+                row(phaseNames[i], [i](const FrameTimes& f) { return f.cpu[i]; });
+            row("cpu_total", [](const FrameTimes& f) { return f.cpuTotal; });
+            for (int i = 0; i < FrameTimes::NUM_GPU_SECTIONS; i++)
+                row(gpuSectionNames[i], [i](const FrameTimes& f) { return f.gpu[i]; });
+            row("input_latency", [](const FrameTimes& f) { return f.inputLatency; });
+
+            auto history = profiler->history();
+            if (!history.empty() && history.back().cullTests >= 0)
+                ImGui::Text("%-14s %lld tests, %lld culled, %lld drawn", "cull",
+                            (long long)history.back().cullTests,
+                            (long long)history.back().culled,
+                            (long long)history.back().drawn);
+
+            ImGui::Text("%-14s %s", "gpu", liveGpuResources().toString().c_str());
+
+            vector<float> totals;
+            for (auto& f : history)
+                totals.push_back(float(f.cpuTotal));
+            if (!totals.empty())
+                ImGui::PlotLines("##cpu_total", totals.data(), int(totals.size()), 0,
+                                 "cpu total", 0.0f, FLT_MAX, ImVec2(300, 60));
+        }
+        ImGui::End();
+    }
+};
+
+// constructor
+FrameProfiler::FrameProfiler(size_t historySize)
+  : m_historySize(std::max(historySize, size_t(1)))
+{
+    m_history.reserve(m_historySize);
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    if (m_queryPool)
+        vkDestroyQueryPool(*m_device, m_queryPool, m_device->getAllocationCallbacks());
+}
+
+bool FrameProfiler::setupTimestamps(vsg::ref_ptr<vsg::Device> device,
+                                    vsg::ref_ptr<vsg::PhysicalDevice> physicalDevice)
+{
+    int family = physicalDevice->getQueueFamily(VK_QUEUE_GRAPHICS_BIT);
+    auto& families = physicalDevice->getQueueFamilyProperties();
+    if (family < 0 || size_t(family) >= families.size()
+        || families[family].timestampValidBits == 0)
+    {
+        spdlog::info("The graphics queue doesn't support timestamps, no GPU timings");
+        return false;
+    }
+    uint32_t validBits = families[family].timestampValidBits;
+    m_timestampMask = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+    m_timestampPeriod = physicalDevice->getProperties().limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    createInfo.queryCount = NUM_SLOTS * NUM_TIMESTAMPS;
+    if (vkCreateQueryPool(*device, &createInfo, device->getAllocationCallbacks(), &m_queryPool) != VK_SUCCESS)
+    {
+        m_queryPool = VK_NULL_HANDLE;
+        return false;
+    }
+    m_device = device;
+    return true;
+}
+
+vsg::ref_ptr<vsg::Command> FrameProfiler::createResetCommand()
+{
+    return ResetTimestamps::create(vsg::ref_ptr<FrameProfiler>(this));
+}
+
+vsg::ref_ptr<vsg::Command> FrameProfiler::createTimestampCommand(uint32_t index)
+{
+    return WriteTimestamp::create(vsg::ref_ptr<FrameProfiler>(this), index);
+}
+
+vsg::ref_ptr<vsg::Command> FrameProfiler::createOverlay()
+{
+    return ProfilerOverlay::create(vsg::ref_ptr<FrameProfiler>(this));
+}
+
+void FrameProfiler::beginFrame(uint64_t frame)
+{
+    m_current = FrameTimes();
+    m_current.frame = frame;
+    readTimestamps();
+}
+
+void FrameProfiler::addPhase(FrameTimes::Phase phase, double ms)
+{
+    m_current.cpu[phase] += ms;
+}
+
+void FrameProfiler::addInput(vsg::time_point eventTime)
+{
+    if (!m_hasInput || eventTime < m_inputTime)
+        m_inputTime = eventTime;
+    m_hasInput = true;
+}
+
+void FrameProfiler::setCullCounts(int64_t tests, int64_t culled, int64_t drawn)
+{
+    m_current.cullTests = tests;
+    m_current.culled = culled;
+    m_current.drawn = drawn;
+}
+
+void FrameProfiler::endFrame()
+{
+    for (int i = 0; i < FrameTimes::NUM_PHASES; i++)
+        m_current.cpuTotal += m_current.cpu[i];
+    if (m_hasInput)
+    {
+        m_current.inputLatency = elapsedMs(m_inputTime);
+        m_hasInput = false;
+    }
+
+    if (m_history.size() < m_historySize)
+        m_history.push_back(m_current);
+    else
+        m_history[m_next] = m_current;
+    m_next = (m_next + 1) % m_historySize;
+}
+
+FrameTimes *FrameProfiler::findFrame(uint64_t frame)
+{
+    for (auto& f : m_history)
+        if (f.frame == frame)
+            return &f;
+    return nullptr;
+}
+
+// Fetch the results of the earlier frames that the GPU has finished
+void FrameProfiler::readTimestamps()
+{
+    if (!m_queryPool)
+        return;
+
+    for (uint32_t slot = 0; slot < NUM_SLOTS; slot++)
+    {
+        if (m_slotFrame[slot] < 0)
+            continue;
+
+        uint64_t timestamps[NUM_TIMESTAMPS];
+        VkResult result = vkGetQueryPoolResults(*m_device, m_queryPool,
+                                                slot*NUM_TIMESTAMPS, NUM_TIMESTAMPS,
+                                                sizeof(timestamps), timestamps, sizeof(uint64_t),
+                                                VK_QUERY_RESULT_64_BIT);
+        if (result != VK_SUCCESS)
+            continue;
+
+        if (auto f = findFrame(uint64_t(m_slotFrame[slot])))
+            for (uint32_t i = 0; i < FrameTimes::NUM_GPU_SECTIONS; i++)
+            {
+                uint64_t ticks = (timestamps[i+1] - timestamps[i]) & m_timestampMask;
+                f->gpu[i] = ticks * m_timestampPeriod * 1e-6;
+            }
+        m_slotFrame[slot] = -1;
+    }
+}
+
+void FrameProfiler::resetTimestamps(VkCommandBuffer commandBuffer)
+{
+    if (!m_queryPool)
+        return;
+
+    // A slot whose results weren't ready in time is dropped
+    uint32_t slot = m_current.frame % NUM_SLOTS;
+    vkCmdResetQueryPool(commandBuffer, m_queryPool, slot*NUM_TIMESTAMPS, NUM_TIMESTAMPS);
+    m_slotFrame[slot] = int64_t(m_current.frame);
+}
+
+void FrameProfiler::writeTimestamp(VkCommandBuffer commandBuffer, uint32_t index)
+{
+    if (!m_queryPool || index >= NUM_TIMESTAMPS)
+        return;
+
+    uint32_t slot = m_current.frame % NUM_SLOTS;
+    vkCmdWriteTimestamp(commandBuffer,
+                        index == 0 ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        m_queryPool, slot*NUM_TIMESTAMPS + index);
+}
+
+std::vector<FrameTimes> FrameProfiler::history() const
+{
+    if (m_history.size() < m_historySize)
+        return m_history;
+
+    vector<FrameTimes> result(m_history.begin() + m_next, m_history.end());
+    result.insert(result.end(), m_history.begin(), m_history.begin() + m_next);
+    return result;
+}
+
+double FrameProfiler::percentile(double p, std::function<double(const FrameTimes&)> get) const
+{
+    vector<double> values;
+    values.reserve(m_history.size());
+    for (auto& f : m_history)
+    {
+        double v = get(f);
+        if (v >= 0)
+            values.push_back(v);
+    }
+    if (values.empty())
+        return -1;
+
+    size_t n = std::min(values.size()-1, size_t(p * values.size()));
+    std::nth_element(values.begin(), values.begin()+n, values.end());
+    return values[n];
+}
+
+bool FrameProfiler::writeCSV(const std::string& filename) const
+{
+    FILE *fh = fopen(filename.c_str(), "w");
+    if (!fh)
+    {
+        spdlog::error("Failed opening {} for writing", filename);
+        return false;
+    }
+
+    fmt::print(fh, "frame");
+    for (auto name : phaseNames)
+        fmt::print(fh, ",{}_ms", name);
+    fmt::print(fh, ",cpu_total_ms");
+    for (auto name : gpuSectionNames)
+        fmt::print(fh, ",{}_ms", name);
+    fmt::print(fh, ",input_latency_ms,cull_tests,culled,drawn\n");
+
+    for (auto& f : history())
+    {
+        fmt::print(fh, "{}", f.frame);
+        for (double ms : f.cpu)
+            fmt::print(fh, ",{:.3f}", ms);
+        fmt::print(fh, ",{:.3f}", f.cpuTotal);
+        for (double ms : f.gpu)
+        {
+            if (ms < 0)
+                fmt::print(fh, ",");
+            else
+                fmt::print(fh, ",{:.3f}", ms);
+        }
+        if (f.inputLatency < 0)
+            fmt::print(fh, ",");
+        else
+            fmt::print(fh, ",{:.3f}", f.inputLatency);
+        if (f.cullTests < 0)
+            fmt::print(fh, ",,,\n");
+        else
+            fmt::print(fh, ",{},{},{}\n", f.cullTests, f.culled, f.drawn);
+    }
+
+    fclose(fh);
+    spdlog::info("Wrote frame profile to {}", filename);
+    return true;
+}
+
+bool ProfilingViewer::advanceToNextFrame(double simulationTime)
+{
+    TRACE_ZONE("advance", "frame");
+    auto t0 = vsg::clock::now();
+    bool active = Inherit::advanceToNextFrame(simulationTime);
+    if (active && profiler)
+    {
+        profiler->beginFrame(getFrameStamp()->frameCount);
+        profiler->addPhase(FrameTimes::ADVANCE, elapsedMs(t0));
+    }
+    return active;
+}
+
+void ProfilingViewer::handleEvents()
+{
+    TRACE_ZONE("events", "frame");
+    auto t0 = vsg::clock::now();
+    Inherit::handleEvents();
+    if (profiler)
+        profiler->addPhase(FrameTimes::EVENTS, elapsedMs(t0));
+}
+
+void ProfilingViewer::update()
+{
+    TRACE_ZONE("update", "frame");
+    auto t0 = vsg::clock::now();
+    Inherit::update();
+    if (profiler)
+        profiler->addPhase(FrameTimes::UPDATE, elapsedMs(t0));
+}
+
+void ProfilingViewer::recordAndSubmit()
+{
+    TRACE_ZONE("record and submit", "frame");
+    auto t0 = vsg::clock::now();
+    Inherit::recordAndSubmit();
+    if (profiler)
+        profiler->addPhase(FrameTimes::RECORD_SUBMIT, elapsedMs(t0));
+}
+
+void ProfilingViewer::present()
+{
+    TRACE_ZONE("present", "frame");
+    auto t0 = vsg::clock::now();
+    Inherit::present();
+    if (profiler)
+    {
+        profiler->addPhase(FrameTimes::PRESENT, elapsedMs(t0));
+        profiler->endFrame();
+    }
+}
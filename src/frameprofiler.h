@@ -0,0 +1,116 @@
+//======================================================================
+//  frameprofiler.h - CPU and GPU timings of the frames of a viewer
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <vsg/all.h>
+#include <vsgQt/Viewer.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// The timings of a single frame in ms. The GPU timings, the input
+// latency and the culling counts are negative if they aren't available.
+struct FrameTimes
+{
+    enum Phase { ADVANCE, EVENTS, UPDATE, RECORD_SUBMIT, PRESENT, NUM_PHASES };
+    enum GpuSection { GPU_MAIN_VIEW, GPU_GIZMO, NUM_GPU_SECTIONS };
+
+    uint64_t frame = 0;
+    double cpu[NUM_PHASES] = {0,0,0,0,0};
+    double cpuTotal = 0;
+    double gpu[NUM_GPU_SECTIONS] = {-1,-1};
+    double inputLatency = -1; // From the input of the frame to its present
+    int64_t cullTests = -1;   // See CullCounts
+    int64_t culled = -1;
+    int64_t drawn = -1;
+};
+
+class FrameProfiler : public vsg::Inherit<vsg::Object, FrameProfiler>
+{
+public:
+    FrameProfiler(size_t historySize = 1000);
+    ~FrameProfiler();
+
+    // Called by ProfilingViewer
+    void beginFrame(uint64_t frame);
+    void addPhase(FrameTimes::Phase phase, double ms);
+    void endFrame();
+
+    // An input that arrived at eventTime was applied in the current
+    // frame. The latency is measured from the earliest one.
+    void addInput(vsg::time_point eventTime);
+
+    // The culling of the current frame
+    void setCullCounts(int64_t tests, int64_t culled, int64_t drawn);
+
+    // Create the timestamp queries of the graphics queue of device.
+    // Returns false if the queue doesn't support timestamps.
+    bool setupTimestamps(vsg::ref_ptr<vsg::Device> device,
+                         vsg::ref_ptr<vsg::PhysicalDevice> physicalDevice);
+
+    // Resets the queries of the current frame. Must be recorded
+    // outside of a render pass before the timestamps.
+    vsg::ref_ptr<vsg::Command> createResetCommand();
+
+    // Writes timestamp index of the current frame. GPU section i is
+    // the time between the timestamps i and i+1.
+    vsg::ref_ptr<vsg::Command> createTimestampCommand(uint32_t index);
+
+    // An ImGui window with the statistics, for vsgImGui::RenderImGui
+    vsg::ref_ptr<vsg::Command> createOverlay();
+    bool showOverlay = false;
+
+    // The frames of the history, oldest first
+    std::vector<FrameTimes> history() const;
+
+    // Percentile p, between 0 and 1, of the values that get() returns
+    // for the frames of the history. Negative values are skipped.
+    double percentile(double p, std::function<double(const FrameTimes&)> get) const;
+
+    bool writeCSV(const std::string& filename) const;
+
+    // For the commands
+    void resetTimestamps(VkCommandBuffer commandBuffer);
+    void writeTimestamp(VkCommandBuffer commandBuffer, uint32_t index);
+
+private:
+    FrameTimes *findFrame(uint64_t frame);
+    void readTimestamps();
+
+    std::vector<FrameTimes> m_history;
+    size_t m_historySize;
+    size_t m_next = 0;   // Ring buffer position
+    FrameTimes m_current;
+    bool m_hasInput = false;
+    vsg::time_point m_inputTime;
+
+    // One slot of queries per frame in flight
+    static const uint32_t NUM_SLOTS = 4;
+    static const uint32_t NUM_TIMESTAMPS = FrameTimes::NUM_GPU_SECTIONS + 1;
+    vsg::ref_ptr<vsg::Device> m_device;
+    VkQueryPool m_queryPool = VK_NULL_HANDLE;
+    double m_timestampPeriod = 1; // ns
+    uint64_t m_timestampMask = ~uint64_t(0);
+    int64_t m_slotFrame[NUM_SLOTS] = {-1,-1,-1,-1};  // Not yet read back
+};
+
+// A vsgQt viewer that reports the time of each phase of its frames
+// to a profiler
+class ProfilingViewer : public vsg::Inherit<vsgQt::Viewer, ProfilingViewer>
+{
+public:
+    vsg::ref_ptr<FrameProfiler> profiler;
+
+    bool advanceToNextFrame(double simulationTime) override;
+    void handleEvents() override;
+    void update() override;
+    void recordAndSubmit() override;
+    void present() override;
+};
+
+#endif /* FRAMEPROFILER */
@@ -0,0 +1,29 @@
+//======================================================================
+//  framerequest.h - Request frames of a viewer that renders on demand
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef FRAMEREQUEST_H
+#define FRAMEREQUEST_H
+
+#include <vsg/all.h>
+#include <vsgQt/Viewer.h>
+#include <QCoreApplication>
+#include <QMetaObject>
+
+// Ask the viewer to render a frame even if it only renders on demand.
+// Update operations are only run as part of a frame, so this must
+// follow addUpdateOperation(). May be called from any thread, as the
+// request is passed on to the gui thread.
+inline void requestFrame(vsg::ref_ptr<vsg::Viewer> viewer)
+{
+    vsg::ref_ptr<vsgQt::Viewer> qtViewer = viewer.cast<vsgQt::Viewer>();
+    if (!qtViewer)
+        return;
+    QMetaObject::invokeMethod(QCoreApplication::instance(),
+                              [qtViewer]() { qtViewer->request(); },
+                              Qt::QueuedConnection);
+}
+
+#endif /* FRAMEREQUEST */
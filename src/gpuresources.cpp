@@ -0,0 +1,140 @@
+//======================================================================
+//  gpuresources.cpp - The GPU memory in use and the release of resources
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "gpuresources.h"
+#include "framerequest.h"
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <deque>
+#include <set>
+
+using namespace std;
+
+GpuResources GpuResources::operator-(const GpuResources& other) const
+{
+    GpuResources diff;
+    diff.allocations = allocations - other.allocations;
+    diff.memoryBytes = memoryBytes - other.memoryBytes;
+    diff.reservedBytes = reservedBytes - other.reservedBytes;
+    return diff;
+}
+
+std::string GpuResources::toString() const
+{
+    return fmt::format("{:.1f} MB reserved of {:.1f} MB in {} allocations",
+                       reservedBytes / (1024.0 * 1024.0), memoryBytes / (1024.0 * 1024.0),
+                       allocations);
+}
+
+GpuResources liveGpuResources()
+{
+    // The device local blocks and the host visible ones of the staging
+    // buffers, where a block that is both is counted once
+    std::set<const vsg::DeviceMemory*> seen;
+    GpuResources resources;
+    for (auto flags : {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT})
+    {
+        for (auto& entry : vsg::getActiveDeviceMemoryList(flags))
+        {
+            vsg::ref_ptr<vsg::DeviceMemory> memory = entry;
+            if (!memory || !seen.insert(memory.get()).second)
+                continue;
+            resources.allocations++;
+            resources.memoryBytes += int64_t(memory->getMemoryRequirements().size);
+            resources.reservedBytes += int64_t(memory->totalReservedSize());
+        }
+    }
+    return resources;
+}
+
+// The number of frames that may be recorded but not yet finished
+static uint64_t framesInFlight(vsg::Viewer& viewer)
+{
+    size_t numFrames = 0;
+    for (auto& window : viewer.windows())
+        numFrames = std::max(numFrames, window->numFrames());
+    return numFrames > 0 ? numFrames : 3;
+}
+
+// Holds the removed nodes of a viewer until the frames that may have
+// recorded them are done. It runs as a one time update operation of
+// each frame while there are nodes left, and is kept by the viewer,
+// so that the nodes don't outlive it.
+class ReleaseOperation : public vsg::Inherit<vsg::Operation, ReleaseOperation>
+{
+public:
+    ReleaseOperation(vsg::Viewer& viewer_) : viewer(&viewer_) {}
+
+    struct Removed
+    {
+        uint64_t frameCount;
+        vsg::Group::Children nodes;
+    };
+
+    vsg::observer_ptr<vsg::Viewer> viewer;
+    std::deque<Removed> removed;
+    bool scheduled = false;
+
+    void add(vsg::Viewer& ref_viewer, uint64_t frameCount, vsg::Group::Children& nodes)
+    {
+        removed.push_back({frameCount, std::move(nodes)});
+        nodes.clear();
+        schedule(ref_viewer);
+    }
+
+    // Run again in the next frame, which is requested in case the
+    // viewer renders on demand
+    void schedule(vsg::Viewer& ref_viewer)
+    {
+        if (scheduled)
+            return;
+        scheduled = true;
+        ref_viewer.addUpdateOperation(vsg::ref_ptr<vsg::Operation>(this));
+        requestFrame(vsg::ref_ptr<vsg::Viewer>(&ref_viewer));
+    }
+
+    void run() override
+    {
+        scheduled = false;
+        vsg::ref_ptr<vsg::Viewer> ref_viewer = viewer;
+        if (!ref_viewer || !ref_viewer->getFrameStamp())
+            return;
+
+        // The frame of the update phase isn't recorded yet, so the
+        // nodes were last recorded by the frame before their removal
+        uint64_t frameCount = ref_viewer->getFrameStamp()->frameCount;
+        uint64_t numFrames = framesInFlight(*ref_viewer);
+        auto before = liveGpuResources();
+        bool releasedAny = false;
+        while (!removed.empty() && frameCount >= removed.front().frameCount + numFrames)
+        {
+            removed.pop_front();
+            releasedAny = true;
+        }
+        if (releasedAny)
+            spdlog::debug("Released {}", (before - liveGpuResources()).toString());
+
+        if (!removed.empty())
+            schedule(*ref_viewer);
+    }
+};
+
+void releaseNodes(vsg::Viewer& viewer, vsg::Group::Children& nodes)
+{
+    if (nodes.empty())
+        return;
+
+    auto releaser = viewer.getRefObject<ReleaseOperation>("ReleaseOperation");
+    if (!releaser)
+    {
+        releaser = ReleaseOperation::create(viewer);
+        viewer.setObject("ReleaseOperation", releaser);
+    }
+
+    auto frameStamp = viewer.getFrameStamp();
+    releaser->add(viewer, frameStamp ? frameStamp->frameCount : 0, nodes);
+}
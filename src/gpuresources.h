@@ -0,0 +1,38 @@
+//======================================================================
+//  gpuresources.h - The GPU memory in use and the release of resources
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef GPURESOURCES_H
+#define GPURESOURCES_H
+
+#include <vsg/all.h>
+#include <string>
+
+// The device memory that vsg has allocated for all devices, from its
+// list of the live vsg::DeviceMemory blocks. The buffers and images
+// are suballocated from the blocks, which vsg keeps when they are
+// released, so released resources show as fewer reserved bytes.
+struct GpuResources
+{
+    int64_t allocations = 0;   // vsg::DeviceMemory blocks
+    int64_t memoryBytes = 0;   // Allocated by the blocks
+    int64_t reservedBytes = 0; // Of the blocks, by buffers and images
+
+    GpuResources operator-(const GpuResources& other) const;
+
+    // E.g. "12.5 MB reserved of 64.0 MB in 3 allocations"
+    std::string toString() const;
+};
+
+GpuResources liveGpuResources();
+
+// Drop the nodes that have been removed from the scene of viewer
+// once the frames in flight that may still draw them have finished,
+// so that their buffers, images and pipelines are destroyed then.
+// Must be called between two frames, e.g. from an update operation.
+// nodes is left empty.
+void releaseNodes(vsg::Viewer& viewer, vsg::Group::Children& nodes);
+
+#endif /* GPURESOURCES */
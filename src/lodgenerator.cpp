@@ -0,0 +1,432 @@
+//======================================================================
+//  lodgenerator.cpp - Generate levels of detail of large meshes
+//
+//  The levels are simplified with half edge collapses, so they only
+//  need a new index buffer. A mesh is replaced by a group that binds
+//  the original vertex buffers, followed by a LOD whose children
+//  each bind their own indices and draw them. The group is built and
+//  compiled on the thread of the generator before it is swapped in.
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "lodgenerator.h"
+#include "simplify.h"
+#include "framerequest.h"
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+
+using namespace std;
+
+bool LODSettings::parseLevels(const std::string& levelsString)
+{
+    levels.clear();
+
+    std::stringstream ss(levelsString);
+    std::string level;
+    double previous = 1.0;
+    while (std::getline(ss, level, ','))
+    {
+        double fraction = atof(level.c_str());
+        if (fraction <= 0 || fraction >= previous)
+        {
+            spdlog::error("LOD levels must be decreasing fractions between 0 and 1, got {}", level);
+            return false;
+        }
+        levels.push_back(fraction);
+        previous = fraction;
+    }
+    return true;
+}
+
+// A mesh that gets levels of detail
+struct LODMesh
+{
+    vsg::ref_ptr<vsg::LOD> lod;
+    vsg::ref_ptr<vsg::vec3Array> positions;
+    vector<uint32_t> indices;
+    bool shortIndices = false;
+};
+
+static bool isTriangleList(const vsg::GraphicsPipeline *pipeline)
+{
+    if (!pipeline)
+        return false;
+    for (auto& state : pipeline->pipelineStates)
+        if (auto ias = state->cast<vsg::InputAssemblyState>())
+            return ias->topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    return false;
+}
+
+// Commands that draw indices with the vertex buffers that are
+// already bound.
+static vsg::ref_ptr<vsg::Node> createLevel(vsg::ref_ptr<vsg::BindIndexBuffer> bindIndices,
+                                           uint32_t indexCount)
+{
+    auto commands = vsg::Commands::create();
+    commands->addChild(bindIndices);
+    commands->addChild(vsg::DrawIndexed::create(indexCount, 1, 0, 0, 0));
+    return commands;
+}
+
+// Find the meshes that are large enough to get levels of detail
+class LODMeshCollector : public vsg::Visitor
+{
+public:
+    LODMeshCollector(const LODSettings& settings_) : settings(settings_) {}
+
+    const LODSettings& settings;
+    vector<const vsg::GraphicsPipeline*> pipelineStack{nullptr};
+    vector<pair<vsg::Group*, size_t>> candidates;
+    map<const vsg::Object*, int> useCount;
+
+    static const vsg::GraphicsPipeline *getPipeline(const vsg::StateGroup& sg)
+    {
+        for (auto& sc : sg.stateCommands)
+            if (auto bgp = sc->cast<vsg::BindGraphicsPipeline>())
+                return bgp->pipeline;
+        return nullptr;
+    }
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::Group& group) override
+    {
+        for (size_t i = 0; i < group.children.size(); i++)
+        {
+            auto vid = group.children[i]->cast<vsg::VertexIndexDraw>();
+            if (vid && useCount[vid]++ == 0 && isCandidate(*vid))
+                candidates.push_back({&group, i});
+        }
+        group.traverse(*this);
+    }
+
+    void apply(vsg::StateGroup& sg) override
+    {
+        auto pipeline = getPipeline(sg);
+        pipelineStack.push_back(pipeline ? pipeline : pipelineStack.back());
+        apply(static_cast<vsg::Group&>(sg));
+        pipelineStack.pop_back();
+    }
+
+    bool isCandidate(const vsg::VertexIndexDraw& vid)
+    {
+        if (!isTriangleList(pipelineStack.back())
+            || vid.indexCount/3 < settings.minTriangles
+            || vid.instanceCount != 1 || vid.firstIndex != 0
+            || vid.vertexOffset != 0 || vid.firstInstance != 0
+            || vid.arrays.empty() || !vid.indices || !vid.indices->data)
+            return false;
+
+        // The positions are the first array by convention
+        auto positions = vid.arrays[0]->data.cast<vsg::vec3Array>();
+        return positions && positions->stride() == sizeof(vsg::vec3);
+    }
+};
+
+// Create the LOD that replaces vid, which initially only holds the
+// original mesh. Returns null if the mesh can't be simplified.
+static vsg::ref_ptr<vsg::Node> createLOD(const vsg::VertexIndexDraw& vid, LODMesh& mesh)
+{
+    auto data = vid.indices->data;
+    if (auto ui = data->cast<vsg::uintArray>())
+        mesh.indices.assign(ui->begin(), ui->begin()+vid.indexCount);
+    else if (auto us = data->cast<vsg::ushortArray>())
+    {
+        mesh.indices.assign(us->begin(), us->begin()+vid.indexCount);
+        mesh.shortIndices = true;
+    }
+    else
+        return {};
+
+    mesh.positions = vid.arrays[0]->data.cast<vsg::vec3Array>();
+    size_t numVertices = mesh.positions->size();
+    vsg::box bounds;
+    for (auto i : mesh.indices)
+    {
+        if (i >= numVertices)
+            return {};
+        bounds.add(mesh.positions->at(i));
+    }
+
+    // Reuse the buffer infos of the draw so that nothing needs to be
+    // uploaded again. The commands still have to be compiled.
+    auto bindVertices = vsg::BindVertexBuffers::create();
+    bindVertices->firstBinding = vid.firstBinding;
+    bindVertices->arrays = vid.arrays;
+
+    mesh.lod = vsg::LOD::create();
+    mesh.lod->bound.center = vsg::dvec3((bounds.min+bounds.max)*0.5f);
+    mesh.lod->bound.radius = vsg::length(bounds.max-bounds.min)*0.5;
+    mesh.lod->addChild(vsg::LOD::Child{0.0, createLevel(vsg::BindIndexBuffer::create(vid.indices),
+                                                        vid.indexCount)});
+
+    auto lodGroup = vsg::Group::create();
+    lodGroup->addChild(bindVertices);
+    lodGroup->addChild(mesh.lod);
+    return lodGroup;
+}
+
+vsg::ref_ptr<vsg::Node> createLODNode(const vsg::VertexIndexDraw& vid)
+{
+    LODMesh mesh;
+    return createLOD(vid, mesh);
+}
+
+// Replaces a mesh with its compiled LOD on the viewer thread, unless
+// the mesh has been removed from group in the meantime
+class InsertLODOperation : public vsg::Inherit<vsg::Operation, InsertLODOperation>
+{
+public:
+    InsertLODOperation(vsg::observer_ptr<vsg::Viewer> viewer_,
+                       vsg::ref_ptr<LODJob> job_,
+                       vsg::observer_ptr<vsg::Group> group_,
+                       vsg::ref_ptr<vsg::Node> mesh_,
+                       vsg::ref_ptr<vsg::Node> lodGroup_,
+                       const vsg::CompileResult& compileResult_) :
+        viewer(viewer_),
+        job(job_),
+        group(group_),
+        mesh(mesh_),
+        lodGroup(lodGroup_),
+        compileResult(compileResult_) {}
+
+    vsg::observer_ptr<vsg::Viewer> viewer;
+    vsg::ref_ptr<LODJob> job;
+    vsg::observer_ptr<vsg::Group> group; // Doesn't keep the model alive
+    vsg::ref_ptr<vsg::Node> mesh;
+    vsg::ref_ptr<vsg::Node> lodGroup;
+    vsg::CompileResult compileResult;
+
+    void run() override
+    {
+        vsg::ref_ptr<vsg::Viewer> ref_viewer = viewer;
+        if (job->isCanceled() || !ref_viewer)
+            return;
+
+        vsg::ref_ptr<vsg::Group> ref_group = group;
+        if (!ref_group)
+            return;
+        auto it = std::find(ref_group->children.begin(), ref_group->children.end(), mesh);
+        if (it == ref_group->children.end())
+            return;
+
+        vsg::updateViewer(*ref_viewer, compileResult);
+        *it = lodGroup;
+    }
+};
+
+// Adds a compiled level to its LOD on the viewer thread
+class AddLevelOperation : public vsg::Inherit<vsg::Operation, AddLevelOperation>
+{
+public:
+    AddLevelOperation(vsg::observer_ptr<vsg::Viewer> viewer_,
+                      vsg::ref_ptr<LODJob> job_,
+                      vsg::ref_ptr<vsg::LOD> lod_,
+                      vsg::ref_ptr<vsg::Node> level_,
+                      const vsg::CompileResult& compileResult_,
+                      double switchRatio_) :
+        viewer(viewer_),
+        job(job_),
+        lod(lod_),
+        level(level_),
+        compileResult(compileResult_),
+        switchRatio(switchRatio_) {}
+
+    vsg::observer_ptr<vsg::Viewer> viewer;
+    vsg::ref_ptr<LODJob> job;
+    vsg::ref_ptr<vsg::LOD> lod;
+    vsg::ref_ptr<vsg::Node> level;
+    vsg::CompileResult compileResult;
+    double switchRatio;
+
+    void run() override
+    {
+        vsg::ref_ptr<vsg::Viewer> ref_viewer = viewer;
+        if (job->isCanceled() || !ref_viewer)
+            return;
+
+        vsg::updateViewer(*ref_viewer, compileResult);
+
+        // The previously coarsest level is now only used down to
+        // switchRatio, and the new level is used below it.
+        lod->children.back().minimumScreenHeightRatio = switchRatio;
+        lod->addChild(vsg::LOD::Child{0.0, level});
+    }
+};
+
+// Builds and compiles the LOD of a mesh, which is swapped into the
+// scene between two frames, and then adds its levels one by one
+class SimplifyOperation : public vsg::Inherit<vsg::Operation, SimplifyOperation>
+{
+public:
+    SimplifyOperation(vsg::observer_ptr<vsg::Viewer> viewer_,
+                      vsg::ref_ptr<LODJob> job_,
+                      vsg::observer_ptr<vsg::Group> group_,
+                      vsg::ref_ptr<vsg::VertexIndexDraw> vid_,
+                      const std::vector<double>& levels_,
+                      double ratioPerRadius_) :
+        viewer(viewer_),
+        job(job_),
+        group(group_),
+        vid(vid_),
+        levels(levels_),
+        ratioPerRadius(ratioPerRadius_) {}
+
+    vsg::observer_ptr<vsg::Viewer> viewer;
+    vsg::ref_ptr<LODJob> job;
+    vsg::observer_ptr<vsg::Group> group;
+    vsg::ref_ptr<vsg::VertexIndexDraw> vid;
+    LODMesh mesh;
+    std::vector<double> levels;
+    double ratioPerRadius;
+
+    bool insertLOD()
+    {
+        auto lodGroup = createLOD(*vid, mesh);
+        vsg::ref_ptr<vsg::Viewer> ref_viewer = viewer;
+        if (!lodGroup || !ref_viewer || job->isCanceled())
+            return false;
+
+        auto compileResult = ref_viewer->compileManager->compile(lodGroup);
+        if (!compileResult)
+        {
+            spdlog::warn("Failed compiling LOD: {}", compileResult.message);
+            return false;
+        }
+        ref_viewer->addUpdateOperation(
+            InsertLODOperation::create(viewer, job, group, vid, lodGroup, compileResult));
+        requestFrame(ref_viewer);
+        return true;
+    }
+
+    void run() override
+    {
+        if (job->isCanceled() || !insertLOD())
+            return;
+
+        size_t numTriangles = mesh.indices.size()/3;
+        size_t numVertices = mesh.positions->size();
+
+        // The screen height ratio of the mesh in the home view. A level
+        // with a fraction f of the triangles keeps the triangle density
+        // of the home view down to sqrt(f) of that size.
+        double homeRatio = mesh.lod->bound.radius * ratioPerRadius;
+
+        // Each level is simplified from the previous one, which is
+        // much faster than starting from the original every time.
+        vector<uint32_t> indices = std::move(mesh.indices);
+        for (double fraction : levels)
+        {
+            auto t0 = vsg::clock::now();
+            size_t previousTriangles = indices.size()/3;
+            vector<uint32_t> result;
+            if (!simplifyMesh(mesh.positions->data(), numVertices, indices,
+                              size_t(numTriangles*fraction), result, &job->canceled))
+                return;
+
+            // Stop when the mesh can't be simplified any further,
+            // e.g. when it is all borders.
+            if (result.empty() || result.size()/3 > previousTriangles*0.9)
+                return;
+
+            vsg::ref_ptr<vsg::Data> data;
+            if (mesh.shortIndices)
+            {
+                auto us = vsg::ushortArray::create(uint32_t(result.size()));
+                std::copy(result.begin(), result.end(), us->begin());
+                data = us;
+            }
+            else
+            {
+                auto ui = vsg::uintArray::create(uint32_t(result.size()));
+                std::copy(result.begin(), result.end(), ui->begin());
+                data = ui;
+            }
+
+            vsg::ref_ptr<vsg::Viewer> ref_viewer = viewer;
+            if (!ref_viewer || job->isCanceled())
+                return;
+
+            auto level = createLevel(vsg::BindIndexBuffer::create(data), uint32_t(result.size()));
+            auto compileResult = ref_viewer->compileManager->compile(level);
+            if (!compileResult)
+            {
+                spdlog::warn("Failed compiling LOD level: {}", compileResult.message);
+                return;
+            }
+
+            spdlog::info("LOD level {} -> {} triangles took {:.0f} ms",
+                         previousTriangles, result.size()/3,
+                         std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count());
+
+            ref_viewer->addUpdateOperation(
+                AddLevelOperation::create(viewer, job, mesh.lod, level, compileResult,
+                                          homeRatio*sqrt(fraction)));
+            requestFrame(ref_viewer);
+            indices = std::move(result);
+        }
+    }
+};
+
+// constructor
+LODGenerator::LODGenerator(vsg::ref_ptr<vsg::Viewer> viewer)
+  : m_viewer(viewer)
+{
+    // A single thread limits the memory that the simplification of
+    // very large meshes needs.
+    m_threads = vsg::OperationThreads::create(1);
+}
+
+LODGenerator::~LODGenerator()
+{
+    cancel();
+    m_threads->stop();
+}
+
+void LODGenerator::cancel()
+{
+    for (auto& job : m_jobs)
+        job->canceled = true;
+    m_jobs.clear();
+}
+
+void LODGenerator::generate(vsg::ref_ptr<vsg::Node> node, double ratioPerRadius)
+{
+    // Forget the jobs of the models that are gone
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+                                [](vsg::ref_ptr<LODJob>& job) { return job->isCanceled(); }),
+                 m_jobs.end());
+
+    if (!m_settings.enabled || m_settings.levels.empty())
+        return;
+
+    LODMeshCollector collector(m_settings);
+    node->accept(collector);
+    if (collector.candidates.empty())
+        return;
+
+    auto job = LODJob::create(node);
+    m_jobs.push_back(job);
+    size_t numMeshes = 0;
+    for (auto& [group, index] : collector.candidates)
+    {
+        // Shared meshes are left alone
+        if (collector.useCount[group->children[index].get()] != 1)
+            continue;
+
+        numMeshes++;
+        vsg::ref_ptr<vsg::VertexIndexDraw> vid(group->children[index]->cast<vsg::VertexIndexDraw>());
+        m_threads->add(SimplifyOperation::create(m_viewer, job, vsg::observer_ptr<vsg::Group>(group), vid,
+                                                 m_settings.levels, ratioPerRadius));
+    }
+    spdlog::info("Generating levels of detail for {} meshes", numMeshes);
+}
@@ -0,0 +1,82 @@
+//======================================================================
+//  lodgenerator.h - Generate levels of detail of large meshes
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef LODGENERATOR_H
+#define LODGENERATOR_H
+
+#include <vsg/all.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+struct LODSettings
+{
+    bool enabled = false;
+    size_t minTriangles = 100000;  // Smaller meshes are drawn as they are
+
+    // The fraction of the triangles of the original mesh that each
+    // level keeps, from the finest to the coarsest.
+    std::vector<double> levels{0.5, 0.125, 0.03};
+
+    // Parse a comma separated list of the levels, e.g. "0.5,0.1"
+    bool parseLevels(const std::string& levels);
+};
+
+// The state of the generation of the levels of one model, which
+// ends when the model is released
+class LODJob : public vsg::Inherit<vsg::Object, LODJob>
+{
+public:
+    LODJob(vsg::ref_ptr<vsg::Node> node_) : node(node_) {}
+
+    vsg::observer_ptr<vsg::Node> node;
+    std::atomic<bool> canceled{false};
+
+    bool isCanceled()
+    {
+        return canceled || !vsg::ref_ptr<vsg::Node>(node);
+    }
+};
+
+// The node that LODGenerator replaces the mesh vid with, before any
+// simplified levels are added. It draws the original mesh with the
+// same buffers, through bind commands and a vsg::DrawIndexed below a
+// vsg::LOD. Returns null if the mesh can't be simplified.
+vsg::ref_ptr<vsg::Node> createLODNode(const vsg::VertexIndexDraw& vid);
+
+class LODGenerator
+{
+public:
+    LODGenerator(vsg::ref_ptr<vsg::Viewer> viewer);
+    ~LODGenerator();
+
+    // Replace the large meshes in the model node with vsg::LOD nodes
+    // that initially only hold the original mesh, and then simplify
+    // the meshes in the background. The LOD nodes, and then each of
+    // their levels, are swapped in between two frames as soon as
+    // they have been compiled. ratioPerRadius is the screen height
+    // ratio of a unit sphere in the home view, from which the switch
+    // distances are set.
+    //
+    // Must be called on the viewer thread between frames, e.g. from
+    // the done callback of ModelLoader. The generation for node is
+    // canceled when node is released, e.g. when its model is reloaded,
+    // while that of the other models goes on.
+    void generate(vsg::ref_ptr<vsg::Node> node, double ratioPerRadius);
+
+    // Cancel the generation for all of the models
+    void cancel();
+
+    LODSettings& settings() { return m_settings; }
+
+private:
+    vsg::observer_ptr<vsg::Viewer> m_viewer;
+    vsg::ref_ptr<vsg::OperationThreads> m_threads;
+    LODSettings m_settings;
+    std::vector<vsg::ref_ptr<LODJob>> m_jobs;
+};
+
+#endif /* LODGENERATOR */
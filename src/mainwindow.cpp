@@ -7,6 +7,8 @@
 
 #include <vsg/all.h>
 #include "mainwindow.h"
+#include "pipelinecache.h"
+#include "pointcloud.h"
 #include <vsgXchange/all.h>
 #include <QTimer>
 #include <QApplication>
@@ -21,19 +23,15 @@
 #include <QFileInfo>
 #include <spdlog/spdlog.h>
 #include <QFileDialog>
+#include <algorithm>
 
 
 using namespace std;
 using fmt::print;
 
-// Returns a timestamp as milliseconds since the epoch. Note this time may jump
-// around subject to adjustments by the system, to measure elapsed time use
-// Timer instead.
-static int64_t GetTimeInMillis() {
-  return std::chrono::duration_cast<std::chrono::milliseconds>(
-             std::chrono::system_clock::now() -
-             std::chrono::system_clock::from_time_t(0))
-      .count();
+static double elapsedMs(vsg::clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count();
 }
 
 // constructor
@@ -51,9 +49,81 @@ MainWindow::MainWindow(vsg::CommandLine& arguments,
     windowTraits->debugLayer = arguments.read({"--debug", "-d"});
     windowTraits->apiDumpLayer = arguments.read({"--api", "-a"});
     windowTraits->samples = 8;
+    // The point clouds are drawn with points larger than a pixel
+    windowTraits->deviceFeatures = vsg::DeviceFeatures::create();
+    windowTraits->deviceFeatures->get().largePoints = VK_TRUE;
     arguments.read("--samples", windowTraits->samples);
     arguments.read({"--window", "-w"}, windowTraits->width, windowTraits->height);
     if (arguments.read({"--fullscreen", "--fs"})) windowTraits->fullscreen = true;
+    bool useCache = !arguments.read("--no-cache");
+    bool usePipelineCache = !arguments.read("--no-pipeline-cache");
+    bool renderOnDemand = !arguments.read("--continuous");
+    double maxFrameRate = 60;
+    arguments.read("--max-fps", maxFrameRate);
+    bool showProfiler = arguments.read("--profile");
+    uint64_t cacheSizeMB = m_settings->value("cacheSizeMB", 4096).toULongLong();
+    arguments.read("--cache-size", cacheSizeMB);
+    MeshOptimizeSettings optimizeSettings;
+    optimizeSettings.enabled = m_settings->value("optimizeMeshes", false).toBool();
+    if (arguments.read("--optimize"))
+        optimizeSettings.enabled = true;
+    if (arguments.read("--no-optimize"))
+        optimizeSettings.enabled = false;
+    std::string optimizePasses;
+    if (arguments.read("--optimize-passes", optimizePasses)
+        && !optimizeSettings.parsePasses(optimizePasses))
+        exit(-1);
+    size_t streamChunkTriangles = 0;
+    if (arguments.read("--stream"))
+        streamChunkTriangles = 1000000;
+    arguments.read("--stream-chunk", streamChunkTriangles);
+    CullHierarchySettings cullSettings;
+    cullSettings.enabled = m_settings->value("cullHierarchy", false).toBool();
+    if (arguments.read("--cull-hierarchy"))
+        cullSettings.enabled = true;
+    if (arguments.read("--no-cull-hierarchy"))
+        cullSettings.enabled = false;
+    bool quantizeVertices = m_settings->value("quantizeVertices", false).toBool();
+    if (arguments.read("--quantize"))
+        quantizeVertices = true;
+    if (arguments.read("--no-quantize"))
+        quantizeVertices = false;
+    m_wireframeOverlay = m_settings->value("wireframeOverlay", false).toBool();
+    if (arguments.read("--wireframe-overlay"))
+        m_wireframeOverlay = true;
+    if (arguments.read("--no-wireframe-overlay"))
+        m_wireframeOverlay = false;
+    TileSettings tileSettings;
+    tileSettings.enabled = m_settings->value("pagedTiles", false).toBool();
+    if (arguments.read("--tiles"))
+        tileSettings.enabled = true;
+    if (arguments.read("--no-tiles"))
+        tileSettings.enabled = false;
+    arguments.read("--tile-triangles", tileSettings.maxTriangles);
+    uint64_t tileBudgetMB = m_settings->value("tileBudgetMB", 2048).toULongLong();
+    arguments.read("--tile-budget", tileBudgetMB);
+    m_tileBudget = tileBudgetMB*1024*1024;
+    double pointBudgetM = m_settings->value("pointBudgetM", 30.0).toDouble();
+    arguments.read("--point-budget", pointBudgetM);
+    m_pointBudget = uint64_t(pointBudgetM*1e6);
+    float pointSize = m_settings->value("pointSize", 1.0).toFloat();
+    arguments.read("--point-size", pointSize);
+    setPointSize(pointSize);
+    bool quadView = m_settings->value("quadView", false).toBool();
+    if (arguments.read("--quad-view"))
+        quadView = true;
+    arguments.read("--reload-test", m_reloadTest);
+    LODSettings lodSettings;
+    lodSettings.enabled = m_settings->value("generateLODs", false).toBool();
+    if (arguments.read("--lod"))
+        lodSettings.enabled = true;
+    if (arguments.read("--no-lod"))
+        lodSettings.enabled = false;
+    arguments.read("--lod-min-triangles", lodSettings.minTriangles);
+    std::string lodLevels;
+    if (arguments.read("--lod-levels", lodLevels)
+        && !lodSettings.parseLevels(lodLevels))
+        exit(-1);
 
     if (arguments.errors())
     {
@@ -67,29 +137,55 @@ MainWindow::MainWindow(vsg::CommandLine& arguments,
                   << std::endl;
         exit(-1);
     }
-    std::string filename = arguments[1];
+    std::vector<std::string> filenames;
+    for (int i = 1; i < arguments.argc(); i++)
+        filenames.push_back(arguments[i]);
 
+    // Each model gets a transform of its own below the switch
     this->modelContainer = vsg::MatrixTransform::create();
+    m_modelSwitch = vsg::Switch::create();
+    this->modelContainer->addChild(m_modelSwitch);
+    m_lodPending = vsg::Group::create();
 
     auto vsg_scene = vsg::Group::create();
     vsg_scene->addChild(this->modelContainer);
 
     this->resize(800, 600);
 
-    // Create a timer but don't start it
-    this->autoloadTimer = new QTimer(this);
-    connect(this->autoloadTimer, SIGNAL(timeout()), this, SLOT(reload(void)));
-
-    // Why do Ιneed to add a node to the child even if I later do
-    // loadfile()?
-    //    auto node = vsg::read_cast<vsg::Node>(filename, options);
-    //this->modelContainer->addChild(node);
+    // Create a file watcher but don't start it
+    this->autoloadWatcher = new FileWatcher(this);
+    connect(this->autoloadWatcher, SIGNAL(fileChanged(const QString&)), this, SLOT(reload(void)));
 
-    loadfile(filename);
-    m_widget3d = new Widget3D(this, vsg_scene, windowTraits);
+    // The model is loaded in the background and is merged into the
+    // scene once it has been compiled.
+    std::string pipelineCachePath;
+    if (usePipelineCache)
+        pipelineCachePath = PipelineCache::defaultPath(m_settings->fileName().toStdString());
+    m_widget3d = new Widget3D(this, vsg_scene, windowTraits, pipelineCachePath);
     m_widget3d->show();
+    m_widget3d->setRenderOnDemand(renderOnDemand, maxFrameRate);
+    m_loader = std::make_unique<ModelLoader>(m_widget3d->viewer(), options);
+    if (useCache)
+        m_loader->readSettings().cache = ModelCache::create(ModelCache::defaultDirectory(),
+                                                            cacheSizeMB*1024*1024);
+    m_loader->readSettings().optimize = optimizeSettings;
+    m_loader->readSettings().cullHierarchy = cullSettings;
+    m_loader->readSettings().streamChunkTriangles = streamChunkTriangles;
+    m_loader->readSettings().quantizeVertices = quantizeVertices;
+    m_loader->readSettings().wireframeOverlay = m_wireframeOverlay;
+    m_loader->readSettings().tiles = tileSettings;
+    m_lodGenerator = std::make_unique<LODGenerator>(m_widget3d->viewer());
+    m_lodGenerator->settings() = lodSettings;
+
+    // Clicking on the model shows the point and its distance to the
+    // previously clicked one
+    m_picker = std::make_unique<Picker>();
+    m_widget3d->insertEventHandler(PickHandler::create(
+        [this](int32_t x, int32_t y) { return m_widget3d->cameraAt(x, y); },
+        [this](const vsg::dvec3& start, const vsg::dvec3& end) { pick(start, end); }));
 
     this->setCentralWidget(m_widget3d);
+    connect(m_widget3d, &Widget3D::filesDropped, this, &MainWindow::openDropped);
 
     auto viewAutoloadAct = new QAction(tr("Auto load"), this);
     viewAutoloadAct->setCheckable(true);
@@ -103,24 +199,58 @@ MainWindow::MainWindow(vsg::CommandLine& arguments,
     connect(viewWireframeAct, SIGNAL(toggled(bool)), this, SLOT(toggleWireframe(bool)));
     viewWireframeAct->setChecked(m_settings->value("wireframe").toBool());
 
+    auto viewShadedWireframeAct = new QAction(tr("View shaded with wireframe"), this);
+    viewShadedWireframeAct->setCheckable(true);
+    viewShadedWireframeAct->setStatusTip(tr("Draw the edges on top of the shading. Needs --wireframe-overlay."));
+    viewShadedWireframeAct->setEnabled(m_wireframeOverlay);
+    connect(viewShadedWireframeAct, SIGNAL(toggled(bool)), this, SLOT(toggleShadedWireframe(bool)));
+    viewShadedWireframeAct->setChecked(m_wireframeOverlay && m_settings->value("shadedWireframe").toBool());
+
+    auto viewQuadAct = new QAction(tr("Quad view"), this);
+    viewQuadAct->setCheckable(true);
+    viewQuadAct->setStatusTip(tr("Show the top, front and right views next to the perspective one"));
+    connect(viewQuadAct, SIGNAL(toggled(bool)), this, SLOT(toggleQuadView(bool)));
+    viewQuadAct->setChecked(quadView);
+
+    auto viewProfilerAct = new QAction(tr("Frame profiler"), this);
+    viewProfilerAct->setCheckable(true);
+    viewProfilerAct->setStatusTip(tr("Show the CPU and GPU timings of the frames"));
+    connect(viewProfilerAct, SIGNAL(toggled(bool)), this, SLOT(toggleProfiler(bool)));
+    viewProfilerAct->setChecked(showProfiler);
+
+    auto saveProfileAct = new QAction(tr("Save frame profile..."), this);
+    saveProfileAct->setStatusTip(tr("Save the recent frame timings as CSV"));
+    connect(saveProfileAct, SIGNAL(triggered()), this, SLOT(saveProfile()));
 
     auto openAct = new QAction(tr("&Open..."), this);
     openAct->setShortcuts(QKeySequence::Open);
     openAct->setStatusTip(tr("Open an existing file"));
     connect(openAct, SIGNAL(triggered()), this, SLOT(open()));
 
+    auto addAct = new QAction(tr("&Add..."), this);
+    addAct->setStatusTip(tr("Add files to the current models"));
+    connect(addAct, SIGNAL(triggered()), this, SLOT(add()));
+
 
     // Build the gui
 
     QMenuBar *menuBar = this->menuBar();
     QMenu *fileMenu = menuBar->addMenu("&File");
     fileMenu->addAction(openAct);
+    fileMenu->addAction(addAct);
+    fileMenu->addAction(saveProfileAct);
     fileMenu->addSeparator();
     QAction *quitAction = fileMenu->addAction("&Quit");
 
     QMenu *viewMenu = menuBar->addMenu(tr("&View"));
     viewMenu->addAction(viewAutoloadAct);
     viewMenu->addAction(viewWireframeAct);
+    viewMenu->addAction(viewShadedWireframeAct);
+    viewMenu->addAction(viewQuadAct);
+    viewMenu->addAction(viewProfilerAct);
+
+    // A check box for each model that switches it on and off
+    m_modelsMenu = menuBar->addMenu(tr("&Models"));
 
 
     QObject::connect(quitAction, &QAction::triggered, &app, &QApplication::quit);
@@ -128,114 +258,507 @@ MainWindow::MainWindow(vsg::CommandLine& arguments,
     this->statusBar = new QStatusBar(this);
     this->setStatusBar(this->statusBar);
 
-    // Read the filename
-    m_widget3d->compile();
+    // Progress and cancelling of a background load. Hidden when idle.
+    this->loadProgressBar = new QProgressBar(this);
+    this->loadProgressBar->setMaximumWidth(150);
+    this->loadProgressBar->setTextVisible(false);
+    this->loadProgressBar->hide();
+    this->statusBar->addPermanentWidget(this->loadProgressBar);
+
+    this->loadCancelButton = new QToolButton(this);
+    this->loadCancelButton->setText(tr("Cancel"));
+    this->loadCancelButton->setToolTip(tr("Cancel loading"));
+    this->loadCancelButton->hide();
+    connect(this->loadCancelButton, SIGNAL(clicked()), this, SLOT(cancelLoad()));
+    this->statusBar->addPermanentWidget(this->loadCancelButton);
+
+    this->loadProgressTimer = new QTimer(this);
+    connect(this->loadProgressTimer, SIGNAL(timeout()), this, SLOT(updateLoadProgress()));
+
+    // Read the files
+    loadfiles(filenames);
 
-    setStatusMessage("Ready");
     m_widget3d->setFocus();
 }
 
-// Update the trackball with the new values, e.g. from a spnav device
-void MainWindow::updateTrackball(double dx, double dy, double dz,
-                                 double xrot, double yrot, double zrot)
+void MainWindow::setSpaceMouse(SpaceMouse *spaceMouse)
 {
-    m_widget3d->updateTrackball(dx, dy, dz, xrot, yrot, zrot);
+    m_widget3d->setSpaceMouse(spaceMouse);
 }
 
 void MainWindow::toggleAutoload(bool doAutoload)
 {
-  if (doAutoload)
-    this->autoloadTimer->start(200);
+  if (doAutoload && this->currentFilename.size())
+    this->autoloadWatcher->watch(QString::fromStdString(this->currentFilename));
   else
-    this->autoloadTimer->stop();
+    this->autoloadWatcher->stop();
   m_settings->setValue("autoload", doAutoload);
 }
 
 void MainWindow::toggleWireframe(bool doWireframe)
 {
-  m_widget3d->setWireframeMode(doWireframe);
+  m_wireframe = doWireframe;
+  updateWireframe();
 
   m_settings->setValue("wireframe", doWireframe);
 }
 
+void MainWindow::toggleShadedWireframe(bool doShadedWireframe)
+{
+  m_shadedWireframe = doShadedWireframe;
+  updateWireframe();
+
+  m_settings->setValue("shadedWireframe", doShadedWireframe);
+}
+
+// The models that were loaded with barycentrics draw both kinds of
+// wireframe with the pipelines that they are shaded with
+void MainWindow::updateWireframe()
+{
+  if (!m_wireframeOverlay)
+  {
+    m_widget3d->setWireframeMode(m_wireframe);
+    return;
+  }
+
+  if (m_wireframe)
+    m_widget3d->setWireframeOverlay(WireframeOverlay::WIRE);
+  else if (m_shadedWireframe)
+    m_widget3d->setWireframeOverlay(WireframeOverlay::SHADED_WIRE);
+  else
+    m_widget3d->setWireframeOverlay(WireframeOverlay::OFF);
+}
+
+void MainWindow::toggleQuadView(bool doQuadView)
+{
+  m_widget3d->setQuadView(doQuadView);
+
+  m_settings->setValue("quadView", doQuadView);
+}
+
+void MainWindow::toggleProfiler(bool doShow)
+{
+  m_widget3d->profiler()->showOverlay = doShow;
+  m_widget3d->requestRender();
+}
+
+void MainWindow::saveProfile()
+{
+    QString filename = QFileDialog::getSaveFileName(this,
+                                                    tr("Save Frame Profile"),
+                                                    "frameprofile.csv",
+                                                    tr("CSV Files (*.csv)"));
+    if (filename.isEmpty())
+        return;
+
+    if (m_widget3d->profiler()->writeCSV(filename.toStdString()))
+        setStatusMessage(fmt::format("Saved frame profile to {}", filename.toStdString()));
+}
+
+// Called by the file watcher when the contents of the current file
+// has changed.
 void MainWindow::reload()
 {
-    // Check if the modified date changed
-    QDateTime last_modified = QFileInfo(QString::fromStdString(this->currentFilename)).lastModified();
-    bool wasmodified = (last_modified != this->currentFilenameLastModified);
+    for (size_t i = 0; i < m_models.size(); i++)
+    {
+        if (m_models[i].filename == this->currentFilename && !m_models[i].replaced)
+        {
+            loadModel(i, false);
+            return;
+        }
+    }
+}
+
+void MainWindow::loadfiles(const std::vector<std::string>& filenames,
+                           bool add)
+{
+    if (filenames.empty())
+        return;
+
+    // The current models are shown until the new ones are ready
+    if (!add)
+    {
+        m_loader->cancel();
+        m_loadStatuses.clear();
+        for (auto& model : m_models)
+            model.replaced = true;
+    }
 
-    // Make sure that the modification was at least 100ms ago so that
-    // we don't try to read a file that is in the middle of being written.
-    wasmodified &= (last_modified < QDateTime::currentDateTime().addMSecs(-100));
+    // Keep the view direction when adding to the models
+    bool changeRotation = !add || m_models.empty();
+    for (auto& filename : filenames)
+    {
+        Model model;
+        model.filename = filename;
+        model.transform = vsg::MatrixTransform::create();
+        model.visibleAction = m_modelsMenu->addAction(
+            QFileInfo(QString::fromStdString(filename)).fileName());
+        model.visibleAction->setCheckable(true);
+        model.visibleAction->setChecked(true);
+        model.visibleAction->setStatusTip(QString::fromStdString(filename));
+        auto transform = model.transform;
+        connect(model.visibleAction, &QAction::toggled, this, [this, transform](bool visible) {
+            setModelVisible(transform, visible);
+        });
+
+        m_modelSwitch->addChild(true, model.transform);
+        m_models.push_back(model);
+        loadModel(m_models.size() - 1, changeRotation);
+    }
 
-    if (wasmodified)
-        this->loadfile(this->currentFilename, false);
+    // Auto load follows the last file
+    this->currentFilename = filenames.back();
+    if (m_settings->value("autoload").toBool())
+        this->autoloadWatcher->watch(QString::fromStdString(this->currentFilename));
 }
 
-void MainWindow::loadfile(const std::string& filename,
+void MainWindow::loadModel(size_t index, bool changeRotation)
+{
+    auto& model = m_models[index];
+    spdlog::info("Loading file {}", model.filename);
+    setStatusMessage(fmt::format("Loading {}", model.filename));
+
+    if (m_loadStatuses.empty())
+        this->loadStartTime = vsg::clock::now();
+
+    // The done callback is run by the viewer in its update phase,
+    // which for vsgQt is on the gui thread.
+    m_loadStatuses.push_back(m_loader->load(
+        model.filename,
+        model.transform,
+        [this, changeRotation](vsg::ref_ptr<LoadStatus> status,
+                               vsg::ref_ptr<vsg::Node> node) {
+            loadDone(status, node, changeRotation);
+        },
+        [this, changeRotation](vsg::ref_ptr<LoadStatus> status, bool first) {
+            chunkLoaded(status, first, changeRotation);
+        }));
+
+    this->loadProgressBar->setRange(0, 0);
+    this->loadProgressBar->show();
+    this->loadCancelButton->show();
+    this->loadProgressTimer->start(100);
+}
+
+void MainWindow::loadDone(vsg::ref_ptr<LoadStatus> status,
+                          vsg::ref_ptr<vsg::Node> node,
                           bool changeRotation)
 {
-    int64_t lf_t0 = GetTimeInMillis();
-    // convert a std string to a qString:
-    QFile Fout(QString::fromStdString(filename));
+    // The requests that were canceled are no longer listed
+    auto it = std::find(m_loadStatuses.begin(), m_loadStatuses.end(), status);
+    if (it == m_loadStatuses.end())
+    {
+        spdlog::info("Canceled loading {}", status->filename);
+        return;
+    }
+    m_loadStatuses.erase(it);
 
-    spdlog::info("Loading file {}", filename);
-    setStatusMessage(fmt::format("Loading {}", filename));
+    if (status->canceled)
+        spdlog::info("Canceled loading {}", status->filename);
+    else if (!node)
+    {
+        // Keep showing the previous version of the model, if any
+        spdlog::error("{}", status->error);
+        setStatusMessage(status->error);
+    }
+    else
+    {
+        spdlog::info("Read {}{}. Duration = {:.0f} ms", status->filename,
+                     status->fromCache ? " from cache" : "", status->readTime);
+        spdlog::info("Compiled {}. Duration = {:.0f} ms, of which {:.0f} ms creating {} pipelines",
+                     status->filename, status->compileTime, status->pipelineTime, status->numPipelines);
+
+        // The paged tiles and point clouds already are levels of detail
+        double tileBytes = 0, tilePoints = 0;
+        if (node->getValue("tileBytes", tileBytes))
+        {
+            m_maxTileBytes = std::max(m_maxTileBytes, tileBytes);
+            updateTileBudget();
+        }
+        else if (node->getValue("tilePoints", tilePoints))
+        {
+            m_maxTilePoints = std::max(m_maxTilePoints, tilePoints);
+            updateTileBudget();
+        }
+        else
+            m_lodPending->addChild(node);
+    }
+
+    // The models are set up together once all of them are in place.
+    // A streamed model was already framed by its first part.
+    if (status->numChunks > 0)
+        changeRotation = false;
+    if (m_loadStatuses.empty())
+        finishLoads(changeRotation);
+}
+
+// A part of a streamed model has been added to the scene
+void MainWindow::chunkLoaded(vsg::ref_ptr<LoadStatus> status,
+                             bool first,
+                             bool changeRotation)
+{
+    if (std::find(m_loadStatuses.begin(), m_loadStatuses.end(), status) == m_loadStatuses.end())
+        return;
 
-    auto node = vsg::read_cast<vsg::Node>(filename, options);
-    if (!node)
+    // The models that are being replaced are hidden as soon as the
+    // new ones show up
+    if (first)
     {
-        std::cout << "Failed to load a valid file"
-                  << std::endl;
-        exit(-1);
+        for (size_t i = 0; i < m_models.size(); i++)
+            if (m_models[i].replaced)
+                m_modelSwitch->children[i].mask = vsg::MASK_OFF;
     }
 
-    // I don't know why, but read swaps the y and the z-axis. This transform node
-    // transforms it back
-    if (filename.find(".stl") != string::npos
-        || filename.find(".3mf") != string::npos)
-        this->modelContainer->matrix = 
-            vsg::dmat4 {{ 1.0f, 0.0f, 0.0f, 0.0f },
-                        { 0.0f, 0.0f, -1.0f, 0.0f },
-                        { 0.0f, 1.0f, 0.0f, 0.0f },
-                        { 0.0f, 0.0f, 0.0f, 1.0f }};
-    else
-        this->modelContainer->matrix = vsg::dmat4(1.0);
-      
-    this->modelContainer->children.clear();
-    this->modelContainer->addChild(node);
+    // Only the first part turns the view, so that the user may start
+    // orbiting while the rest arrives
+    m_widget3d->autoScale(changeRotation && first);
+}
 
-    int64_t time0 = GetTimeInMillis();
-    spdlog::info("Loaded xjsf. Duration = {} ms", GetTimeInMillis()-time0);
+// The pager only limits the number of its tiles, so with both tiled
+// models and point clouds the smaller of their limits is kept
+void MainWindow::updateTileBudget()
+{
+    auto& pager = *m_widget3d->databasePager();
+    uint32_t limit = UINT32_MAX;
+    if (m_maxTileBytes > 0)
+    {
+        setTileBudget(pager, m_tileBudget, m_maxTileBytes);
+        limit = std::min(limit, pager.targetMaxNumPagedLODWithHighResSubgraphs);
+    }
+    if (m_maxTilePoints > 0)
+    {
+        setTileBudget(pager, m_pointBudget, m_maxTilePoints);
+        limit = std::min(limit, pager.targetMaxNumPagedLODWithHighResSubgraphs);
+    }
+    if (limit != UINT32_MAX)
+        pager.targetMaxNumPagedLODWithHighResSubgraphs = limit;
+}
+
+// Called when there are no more loads in progress
+void MainWindow::finishLoads(bool changeRotation)
+{
+    this->loadProgressTimer->stop();
+    this->loadProgressBar->hide();
+    this->loadCancelButton->hide();
+
+    bool loadedAny = false;
+    for (auto& model : m_models)
+        if (!model.replaced && !model.transform->children.empty())
+            loadedAny = true;
+
+    // Drop the models that failed to load, and the replaced models
+    // unless none of their replacements could be loaded
+    vsg::Group::Children removed;
+    for (size_t i = m_models.size(); i-- > 0;)
+    {
+        auto& model = m_models[i];
+        if (model.replaced ? loadedAny : model.transform->children.empty())
+        {
+            m_modelsMenu->removeAction(model.visibleAction);
+            model.visibleAction->deleteLater();
+            m_models.erase(m_models.begin() + i);
+            removed.push_back(m_modelSwitch->children[i].node);
+            m_modelSwitch->children.erase(m_modelSwitch->children.begin() + i);
+        }
+        else
+            model.replaced = false;
+    }
+
+    // Release the textures and pipelines that only the removed models
+    // were using
+    releaseNodes(*m_widget3d->viewer(), removed);
+    if (options->sharedObjects)
+        options->sharedObjects->prune();
+
+    if (!loadedAny)
+        return;
+
+    QFileInfo fi(QString::fromStdString(this->currentFilename));
+    QString title = "qtvsgviewer: " + fi.fileName();
+    if (m_models.size() > 1)
+        title += QString(" (+%1)").arg(m_models.size() - 1);
+    setWindowTitle(title);
+
+    spdlog::info("Total load file duration = {:.0f} ms", elapsedMs(this->loadStartTime));
+    setStatusMessage("Ready");
+    modelsChanged(changeRotation);
+
+    // The switch distances of the levels are relative to the home
+    // view, so this must follow autoScale()
+    if (!m_lodPending->children.empty())
+    {
+        for (auto& node : m_lodPending->children)
+            m_lodGenerator->generate(node, m_widget3d->homeScreenHeightRatio(1.0));
+        m_lodPending = vsg::Group::create();
+    }
+
+    spdlog::info("Live GPU resources: {}", liveGpuResources().toString());
+    if (m_reloadTest > 0)
+        continueReloadTest();
+}
+
+// Reload all of the models m_reloadTest times, and check that the GPU
+// resources of the replaced ones were released
+void MainWindow::continueReloadTest()
+{
+    // The first reload fills the memory pools of vsg, so the resources
+    // are compared with those after it
+    auto live = liveGpuResources();
+    if (m_reloadsDone == 1)
+        m_reloadBaseline = live;
+    if (m_reloadsDone > 0 && m_reloadsDone % 100 == 0)
+        spdlog::info("Reload test {}/{}: {}", m_reloadsDone, m_reloadTest, live.toString());
+
+    if (m_reloadsDone < m_reloadTest)
+    {
+        m_reloadsDone++;
+        QTimer::singleShot(0, this, [this]() {
+            for (size_t i = 0; i < m_models.size(); i++)
+                loadModel(i, false);
+        });
+        return;
+    }
+
+    auto growth = live - m_reloadBaseline;
+    bool leaked = growth.allocations > 0 || growth.reservedBytes > 0;
+    spdlog::info("Growth of the GPU resources over the last {} reloads: {}",
+                 m_reloadTest - 1, growth.toString());
+    if (leaked)
+        spdlog::error("GPU resources were leaked by the reloads");
+    m_reloadTest = 0;
+    QCoreApplication::exit(leaked ? 1 : 0);
+}
+
+void MainWindow::setModelVisible(vsg::ref_ptr<vsg::MatrixTransform> transform, bool visible)
+{
+    for (size_t i = 0; i < m_models.size(); i++)
+    {
+        if (m_models[i].transform == transform)
+        {
+            m_modelSwitch->children[i].mask = visible ? vsg::MASK_ALL : vsg::MASK_OFF;
+            modelsChanged(false);
+            return;
+        }
+    }
+}
+
+// Fit the view to the models that are switched on, and pick on them
+void MainWindow::modelsChanged(bool changeRotation)
+{
+    m_widget3d->autoScale(changeRotation);
 
-    this->currentFilename = filename;
-    this->currentFilenameLastModified = QFileInfo(QString::fromStdString(filename)).lastModified();
+    m_hasLastPick = false;
+    m_picker->build(this->modelContainer);
+}
 
-    QFileInfo fi(QString::fromStdString(filename));
-    setWindowTitle("qtvsgviewer: " + fi.fileName());
+void MainWindow::updateLoadProgress()
+{
+    if (m_loadStatuses.empty())
+        return;
 
-    spdlog::info("Total load file duration = {} ms", GetTimeInMillis()-lf_t0);
-    if (m_widget3d) {
-        m_widget3d->compile();
-        m_widget3d->autoScale(changeRotation); // TBD: make this conditional
+    // The average of the loads whose progress is known
+    double sum = 0;
+    int count = 0;
+    for (auto& status : m_loadStatuses)
+    {
+        double progress = status->progress;
+        if (progress >= 0)
+        {
+            sum += progress;
+            count++;
+        }
+    }
+    if (count == 0)
+        this->loadProgressBar->setRange(0, 0);
+    else
+    {
+        this->loadProgressBar->setRange(0, 100);
+        this->loadProgressBar->setValue(int(sum / count * 100));
     }
 }
 
-void MainWindow::setStatusMessage(const std::string& message)
+void MainWindow::cancelLoad()
+{
+    if (m_loadStatuses.empty())
+        return;
+
+    setStatusMessage(m_loadStatuses.size() == 1
+                     ? fmt::format("Canceled loading {}", m_loadStatuses[0]->filename)
+                     : fmt::format("Canceled loading {} files", m_loadStatuses.size()));
+    m_loader->cancel();
+    m_loadStatuses.clear();
+    finishLoads(false);
+}
+
+void MainWindow::pick(const vsg::dvec3& start, const vsg::dvec3& end)
+{
+    if (!m_picker->isReady())
+    {
+        setStatusMessage("The model is still being prepared for picking");
+        return;
+    }
+
+    auto t0 = vsg::clock::now();
+    TriangleBVH::Hit hit;
+    bool found = m_picker->pick(start, end, hit);
+    spdlog::debug("Pick took {:.3f} ms",
+                  std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count());
+    if (!found)
+    {
+        setStatusMessage("No surface under the mouse");
+        return;
+    }
+
+    std::string message = fmt::format("Point ({:.4g}, {:.4g}, {:.4g})  Normal ({:.3f}, {:.3f}, {:.3f})",
+                                      hit.point.x, hit.point.y, hit.point.z,
+                                      hit.normal.x, hit.normal.y, hit.normal.z);
+    if (m_hasLastPick)
+        message += fmt::format("  Distance to previous {:.4g}", vsg::length(hit.point - m_lastPick));
+    spdlog::info("{}", message);
+    setStatusMessage(message, 0);
+
+    m_lastPick = hit.point;
+    m_hasLastPick = true;
+}
+
+void MainWindow::setStatusMessage(const std::string& message, int timeout)
 {
     spdlog::debug("setStatusMessage(message=\"{}\")", message);
     if (this->statusBar)
-        this->statusBar->showMessage(QString::fromStdString(message), 2500);
+        this->statusBar->showMessage(QString::fromStdString(message), timeout);
     
 }
 
+static const char *MODEL_FILE_FILTER = "Model Files (*.stl *.fern *.xjsf *.obj *.3mf *.ply *.las *.xyz *.pts)";
+
+static std::vector<std::string> toStdStrings(const QStringList& strings)
+{
+    std::vector<std::string> ret;
+    for (auto& s : strings)
+        ret.push_back(s.toStdString());
+    return ret;
+}
+
 void MainWindow::open()
 {
-   QString filename = QFileDialog::getOpenFileName(this,
-                                                  tr("Open Image"),
-                                                  nullptr,
-                                                  tr("Model Files (*.stl *.fern *.xjsf *.obj)"));
+    QStringList filenames = QFileDialog::getOpenFileNames(this,
+                                                          tr("Open Models"),
+                                                          nullptr,
+                                                          tr(MODEL_FILE_FILTER));
+    loadfiles(toStdStrings(filenames));
+}
 
-   // convert a qstring to a stdstring
-   loadfile(filename.toStdString());
+void MainWindow::add()
+{
+    QStringList filenames = QFileDialog::getOpenFileNames(this,
+                                                          tr("Add Models"),
+                                                          nullptr,
+                                                          tr(MODEL_FILE_FILTER));
+    loadfiles(toStdStrings(filenames), true);
+}
+
+// Dropped files are added to the models
+void MainWindow::openDropped(const QStringList& filenames)
+{
+    loadfiles(toStdStrings(filenames), true);
 }
@@ -12,8 +12,18 @@
 #include <QMainWindow>
 #include <QSettings>
 #include "widget3d.h"
+#include "modelloader.h"
+#include "filewatcher.h"
+#include "lodgenerator.h"
+#include "picker.h"
+#include "gpuresources.h"
 #include <QDateTime>
 #include <QTimer>
+#include <QProgressBar>
+#include <QToolButton>
+#include <QMenu>
+#include <QStringList>
+#include <vector>
 
 
 class MainWindow : public QMainWindow
@@ -26,33 +36,102 @@ public:
                std::shared_ptr<QSettings> settings,
                QApplication& app);
 
-    void updateTrackball(double dx, double dy, double dz,
-                         double xrot, double yrot, double zrot);
+    void setSpaceMouse(SpaceMouse *spaceMouse);
 
-    void setStatusMessage(const std::string& message);
+    // A timeout of 0 keeps the message until the next one
+    void setStatusMessage(const std::string& message, int timeout = 2500);
 
 private:
     vsgQt::Window* createWindow(vsg::ref_ptr<vsg::WindowTraits> traits,
                                 vsg::ref_ptr<vsg::Node> vsg_scene,
                                 QWindow* parent, const QString& title = {});
 
-  void loadfile(const std::string& filename,
-                bool changeRotation=true);
+  // Load filenames side by side in parallel, each below a transform
+  // of its own that can be switched off. Unless add is set, the
+  // current models are replaced once the new ones have been loaded.
+  void loadfiles(const std::vector<std::string>& filenames,
+                 bool add = false);
+  void loadModel(size_t index, bool changeRotation);
+  void loadDone(vsg::ref_ptr<LoadStatus> status,
+                vsg::ref_ptr<vsg::Node> node,
+                bool changeRotation);
+  void chunkLoaded(vsg::ref_ptr<LoadStatus> status,
+                   bool first,
+                   bool changeRotation);
+  void finishLoads(bool changeRotation);
+  void updateTileBudget();
+  void continueReloadTest();
+  void setModelVisible(vsg::ref_ptr<vsg::MatrixTransform> transform, bool visible);
+  void modelsChanged(bool changeRotation);
+  void pick(const vsg::dvec3& start, const vsg::dvec3& end);
+  void updateWireframe();
 
     Widget3D* m_widget3d = nullptr;
-    QTimer *autoloadTimer = nullptr;
+    FileWatcher *autoloadWatcher = nullptr;
     std::string currentFilename;
-    QDateTime currentFilenameLastModified;
+    vsg::clock::time_point loadStartTime;
     QStatusBar *statusBar =  nullptr;
+    QProgressBar *loadProgressBar = nullptr;
+    QToolButton *loadCancelButton = nullptr;
+    QTimer *loadProgressTimer = nullptr;
+    std::unique_ptr<ModelLoader> m_loader;
+    std::unique_ptr<LODGenerator> m_lodGenerator;
+    std::unique_ptr<Picker> m_picker;
+    bool m_hasLastPick = false;
+    vsg::dvec3 m_lastPick;
+    std::vector<vsg::ref_ptr<LoadStatus>> m_loadStatuses;
+
+    // The models are loaded with barycentrics for the overlay instead
+    // of with line mode switches
+    bool m_wireframeOverlay = false;
+    bool m_wireframe = false;
+    bool m_shadedWireframe = false;
+
+    // The pager keeps about m_tileBudget bytes of the tiles of the
+    // largest tile files that were loaded, and about m_pointBudget
+    // points of the point clouds
+    uint64_t m_tileBudget = 0;
+    double m_maxTileBytes = 0;
+    uint64_t m_pointBudget = 0;
+    double m_maxTilePoints = 0;
+
+    // Reloads of --reload-test
+    int m_reloadTest = 0;
+    int m_reloadsDone = 0;
+    GpuResources m_reloadBaseline;
+
+    struct Model
+    {
+        std::string filename;
+        vsg::ref_ptr<vsg::MatrixTransform> transform;
+        QAction *visibleAction = nullptr;
+        bool replaced = false; // Removed when the current loads are done
+    };
+
+    // In the order of the children of m_modelSwitch
+    std::vector<Model> m_models;
+    vsg::ref_ptr<vsg::Switch> m_modelSwitch;
+    QMenu *m_modelsMenu = nullptr;
+
+    // The loaded models that still need their levels of detail
+    vsg::ref_ptr<vsg::Group> m_lodPending;
     vsg::ref_ptr<vsg::MatrixTransform> modelContainer;
     vsg::ref_ptr<vsg::Options> options;
     std::shared_ptr<QSettings> m_settings;
 
 private slots:
     void open();
+    void add();
+    void openDropped(const QStringList& filenames);
     void reload();
     void toggleAutoload(bool DoAutoload);
     void toggleWireframe(bool DoWireframe);
+    void toggleShadedWireframe(bool DoShadedWireframe);
+    void toggleQuadView(bool DoQuadView);
+    void toggleProfiler(bool DoShow);
+    void saveProfile();
+    void updateLoadProgress();
+    void cancelLoad();
 
 };
 
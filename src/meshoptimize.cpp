@@ -0,0 +1,846 @@
+//======================================================================
+//  meshoptimize.cpp - Post load optimization of the meshes of a scene
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "meshoptimize.h"
+#include "filehash.h"
+#include "parallel.h"
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+bool MeshOptimizeSettings::parsePasses(const std::string& passes)
+{
+    merge = weld = vertexCache = vertexFetch = share = false;
+
+    std::stringstream ss(passes);
+    std::string pass;
+    while (std::getline(ss, pass, ','))
+    {
+        if (pass == "merge")
+            merge = true;
+        else if (pass == "weld")
+            weld = true;
+        else if (pass == "vcache")
+            vertexCache = true;
+        else if (pass == "vfetch")
+            vertexFetch = true;
+        else if (pass == "share")
+            share = true;
+        else
+        {
+            spdlog::error("Unknown mesh optimization pass {}", pass);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string MeshOptimizeSettings::key() const
+{
+    if (!enabled)
+        return "";
+    return fmt::format("opt{}{}{}{}{}", int(merge), int(weld), int(vertexCache), int(vertexFetch),
+                       int(share));
+}
+
+// Create an empty array of the same type as data. Returns null for
+// types that aren't supported.
+template<class A>
+static bool createIf(const vsg::Data& data, size_t count, vsg::ref_ptr<vsg::Data>& result)
+{
+    if (!data.is_compatible(typeid(A)))
+        return false;
+    result = A::create(uint32_t(count));
+    result->properties.format = data.properties.format;
+    result->properties.dataVariance = data.properties.dataVariance;
+    return true;
+}
+
+static vsg::ref_ptr<vsg::Data> createArrayLike(const vsg::Data& data, size_t count)
+{
+    vsg::ref_ptr<vsg::Data> result;
+    createIf<vsg::vec3Array>(data, count, result)
+        || createIf<vsg::vec2Array>(data, count, result)
+        || createIf<vsg::vec4Array>(data, count, result)
+        || createIf<vsg::floatArray>(data, count, result)
+        || createIf<vsg::ubvec4Array>(data, count, result)
+        || createIf<vsg::usvec2Array>(data, count, result)
+        || createIf<vsg::usvec4Array>(data, count, result)
+        || createIf<vsg::uintArray>(data, count, result)
+        || createIf<vsg::ivec4Array>(data, count, result);
+    return result;
+}
+
+// The vertex input state and topology that a draw is recorded with
+static const vsg::VertexInputState *getVertexInputState(const vsg::GraphicsPipeline *pipeline)
+{
+    if (!pipeline)
+        return nullptr;
+    for (auto& state : pipeline->pipelineStates)
+        if (auto vis = state->cast<vsg::VertexInputState>())
+            return vis;
+    return nullptr;
+}
+
+static bool isTriangleList(const vsg::GraphicsPipeline *pipeline)
+{
+    if (!pipeline)
+        return false;
+    for (auto& state : pipeline->pipelineStates)
+        if (auto ias = state->cast<vsg::InputAssemblyState>())
+            return ias->topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    return false;
+}
+
+// A working copy of an indexed triangle mesh
+struct Mesh
+{
+    vsg::ref_ptr<vsg::VertexIndexDraw> draw;
+    vector<vsg::ref_ptr<vsg::Data>> arrays;
+    vector<bool> perVertex;
+    vector<uint32_t> indices;
+    size_t numVertices = 0;
+    bool shortIndices = false;
+};
+
+static bool readIndices(const vsg::Data *data, vector<uint32_t>& indices, bool& shortIndices)
+{
+    shortIndices = false;
+    if (auto ui = data->cast<vsg::uintArray>())
+        indices.assign(ui->begin(), ui->end());
+    else if (auto us = data->cast<vsg::ushortArray>())
+    {
+        indices.assign(us->begin(), us->end());
+        shortIndices = true;
+    }
+    else if (auto ub = data->cast<vsg::ubyteArray>())
+        indices.assign(ub->begin(), ub->end());
+    else
+        return false;
+    return true;
+}
+
+static vsg::ref_ptr<vsg::Data> createIndices(const vector<uint32_t>& indices,
+                                             size_t numVertices, bool shortIndices)
+{
+    if (shortIndices && numVertices <= 0xffff)
+    {
+        auto us = vsg::ushortArray::create(uint32_t(indices.size()));
+        for (size_t i = 0; i < indices.size(); i++)
+            (*us)[i] = uint16_t(indices[i]);
+        return us;
+    }
+    auto ui = vsg::uintArray::create(uint32_t(indices.size()));
+    std::copy(indices.begin(), indices.end(), ui->begin());
+    return ui;
+}
+
+// Get a working copy of draw, or false if it isn't a plain triangle
+// list with tightly packed arrays.
+static bool readMesh(vsg::ref_ptr<vsg::VertexIndexDraw> draw,
+                     const vsg::GraphicsPipeline *pipeline,
+                     Mesh& mesh)
+{
+    auto vis = getVertexInputState(pipeline);
+    if (!vis || !isTriangleList(pipeline) || !draw->indices || !draw->indices->data)
+        return false;
+    if (draw->instanceCount != 1 || draw->firstIndex != 0
+        || draw->vertexOffset != 0 || draw->firstInstance != 0)
+        return false;
+
+    mesh.draw = draw;
+    mesh.numVertices = 0;
+    for (size_t i = 0; i < draw->arrays.size(); i++)
+    {
+        auto& data = draw->arrays[i]->data;
+        if (!data || data->stride() != data->valueSize()
+            || !createArrayLike(*data, 0))
+            return false;
+
+        uint32_t binding = draw->firstBinding + uint32_t(i);
+        bool perVertex = true;
+        for (auto& desc : vis->vertexBindingDescriptions)
+            if (desc.binding == binding)
+                perVertex = desc.inputRate == VK_VERTEX_INPUT_RATE_VERTEX;
+
+        if (perVertex)
+        {
+            if (mesh.numVertices && mesh.numVertices != data->valueCount())
+                return false;
+            mesh.numVertices = data->valueCount();
+        }
+        mesh.arrays.push_back(data);
+        mesh.perVertex.push_back(perVertex);
+    }
+
+    if (mesh.numVertices == 0
+        || !readIndices(draw->indices->data, mesh.indices, mesh.shortIndices)
+        || mesh.indices.size() != draw->indexCount
+        || mesh.indices.size() % 3 != 0)
+        return false;
+
+    for (auto i : mesh.indices)
+        if (i >= mesh.numVertices)
+            return false;
+
+    return true;
+}
+
+static void writeMesh(Mesh& mesh)
+{
+    vsg::DataList arrays(mesh.arrays.begin(), mesh.arrays.end());
+    mesh.draw->assignArrays(arrays);
+    mesh.draw->assignIndices(createIndices(mesh.indices, mesh.numVertices, mesh.shortIndices));
+    mesh.draw->indexCount = uint32_t(mesh.indices.size());
+}
+
+// Reorder the vertices so that vertex i is the old vertex order[i]
+static void reorderVertices(Mesh& mesh, const vector<uint32_t>& order)
+{
+    for (size_t a = 0; a < mesh.arrays.size(); a++)
+    {
+        if (!mesh.perVertex[a])
+            continue;
+        auto& src = mesh.arrays[a];
+        auto dst = createArrayLike(*src, order.size());
+        size_t valueSize = src->valueSize();
+        for (size_t i = 0; i < order.size(); i++)
+            memcpy(dst->dataPointer(i), src->dataPointer(order[i]), valueSize);
+        mesh.arrays[a] = dst;
+    }
+    mesh.numVertices = order.size();
+}
+
+static bool vertexEqual(const Mesh& mesh, uint32_t v0, uint32_t v1)
+{
+    for (size_t a = 0; a < mesh.arrays.size(); a++)
+        if (mesh.perVertex[a]
+            && memcmp(mesh.arrays[a]->dataPointer(v0),
+                      mesh.arrays[a]->dataPointer(v1),
+                      mesh.arrays[a]->valueSize()) != 0)
+            return false;
+    return true;
+}
+
+// Share vertices whose attributes are all identical
+static void weldVertices(Mesh& mesh)
+{
+    const uint32_t EMPTY = 0xffffffff;
+    size_t mask = 16;
+    while (mask < 2*mesh.numVertices)
+        mask <<= 1;
+    mask--;
+
+    vector<uint32_t> table(mask+1, EMPTY);
+    vector<uint32_t> remap(mesh.numVertices);
+    vector<uint32_t> uniques;
+    for (uint32_t v = 0; v < mesh.numVertices; v++)
+    {
+        uint64_t h = 0;
+        for (size_t a = 0; a < mesh.arrays.size(); a++)
+            if (mesh.perVertex[a])
+                h = hashBytes(mesh.arrays[a]->dataPointer(v), mesh.arrays[a]->valueSize(), h);
+
+        for (size_t slot = h & mask; ; slot = (slot+1) & mask)
+        {
+            if (table[slot] == EMPTY)
+            {
+                table[slot] = v;
+                remap[v] = uint32_t(uniques.size());
+                uniques.push_back(v);
+                break;
+            }
+            if (vertexEqual(mesh, table[slot], v))
+            {
+                remap[v] = remap[table[slot]];
+                break;
+            }
+        }
+    }
+
+    if (uniques.size() == mesh.numVertices)
+        return;
+
+    for (auto& i : mesh.indices)
+        i = remap[i];
+    reorderVertices(mesh, uniques);
+}
+
+// Order the triangles for the post transform vertex cache with the
+// Tipsify algorithm by Sander, Nehab and Barczak.
+static void optimizeVertexCache(Mesh& mesh, int cacheSize = 16)
+{
+    const size_t numVertices = mesh.numVertices;
+    const size_t numTriangles = mesh.indices.size() / 3;
+    const auto& indices = mesh.indices;
+
+    // The triangles of each vertex
+    vector<uint32_t> start(numVertices + 1, 0);
+    for (auto i : indices)
+        start[i+1]++;
+    for (size_t v = 0; v < numVertices; v++)
+        start[v+1] += start[v];
+    vector<uint32_t> vertexTriangles(indices.size());
+    {
+        vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            vertexTriangles[fill[indices[i]]++] = uint32_t(i / 3);
+    }
+
+    vector<uint32_t> live(numVertices);
+    for (size_t v = 0; v < numVertices; v++)
+        live[v] = start[v+1] - start[v];
+
+    vector<int64_t> cacheTime(numVertices, 0);
+    vector<bool> emitted(numTriangles, false);
+    vector<uint32_t> deadEnd;
+    vector<uint32_t> candidates;
+    vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    int64_t time = cacheSize + 1;
+    size_t cursor = 0;
+    int64_t fanning = numVertices ? 0 : -1;
+
+    while (fanning >= 0)
+    {
+        candidates.clear();
+        for (uint32_t k = start[fanning]; k < start[fanning+1]; k++)
+        {
+            uint32_t t = vertexTriangles[k];
+            if (emitted[t])
+                continue;
+            for (int c = 0; c < 3; c++)
+            {
+                uint32_t v = indices[3*t + c];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - cacheTime[v] > cacheSize)
+                    cacheTime[v] = time++;
+            }
+            emitted[t] = true;
+        }
+
+        // Prefer a candidate that is still in the cache
+        int64_t next = -1;
+        int64_t best = -1;
+        for (auto v : candidates)
+        {
+            if (live[v] == 0)
+                continue;
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2*int64_t(live[v]) <= cacheSize)
+                priority = time - cacheTime[v];
+            if (priority > best)
+            {
+                best = priority;
+                next = v;
+            }
+        }
+
+        // Otherwise go back through the recently used vertices, and
+        // finally take the next vertex in order.
+        while (next < 0 && !deadEnd.empty())
+        {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0)
+                next = v;
+        }
+        while (next < 0 && cursor < numVertices)
+        {
+            if (live[cursor] > 0)
+                next = int64_t(cursor);
+            cursor++;
+        }
+        fanning = next;
+    }
+
+    mesh.indices.swap(output);
+}
+
+// Number the vertices in the order of their first use. This also
+// drops unused vertices.
+static void optimizeVertexFetch(Mesh& mesh)
+{
+    const uint32_t UNUSED = 0xffffffff;
+    vector<uint32_t> remap(mesh.numVertices, UNUSED);
+    vector<uint32_t> order;
+    for (auto& i : mesh.indices)
+    {
+        if (remap[i] == UNUSED)
+        {
+            remap[i] = uint32_t(order.size());
+            order.push_back(i);
+        }
+        i = remap[i];
+    }
+    reorderVertices(mesh, order);
+}
+
+// Merge meshes into a single mesh. They must have the same layout,
+// which is checked by canMerge().
+static void mergeMeshes(vector<Mesh>& meshes, Mesh& merged)
+{
+    merged = meshes[0];
+    size_t numVertices = 0;
+    size_t numIndices = 0;
+    for (auto& mesh : meshes)
+    {
+        numVertices += mesh.numVertices;
+        numIndices += mesh.indices.size();
+    }
+
+    merged.indices.clear();
+    merged.indices.reserve(numIndices);
+    for (size_t a = 0; a < merged.arrays.size(); a++)
+        if (merged.perVertex[a])
+            merged.arrays[a] = createArrayLike(*meshes[0].arrays[a], numVertices);
+
+    size_t vertexBase = 0;
+    for (auto& mesh : meshes)
+    {
+        for (size_t a = 0; a < mesh.arrays.size(); a++)
+            if (mesh.perVertex[a])
+                memcpy(merged.arrays[a]->dataPointer(vertexBase),
+                       mesh.arrays[a]->dataPointer(0),
+                       mesh.arrays[a]->dataSize());
+        for (auto i : mesh.indices)
+            merged.indices.push_back(uint32_t(vertexBase + i));
+        merged.shortIndices &= mesh.shortIndices;
+        vertexBase += mesh.numVertices;
+    }
+    merged.numVertices = numVertices;
+}
+
+static bool canMerge(const Mesh& a, const Mesh& b)
+{
+    if (a.arrays.size() != b.arrays.size()
+        || a.draw->firstBinding != b.draw->firstBinding)
+        return false;
+
+    for (size_t i = 0; i < a.arrays.size(); i++)
+    {
+        auto& da = a.arrays[i];
+        auto& db = b.arrays[i];
+        if (a.perVertex[i] != b.perVertex[i]
+            || typeid(*da) != typeid(*db)
+            || da->properties.format != db->properties.format)
+            return false;
+
+        // Per instance values, e.g. a single color, must be equal
+        if (!a.perVertex[i]
+            && (da->dataSize() != db->dataSize()
+                || memcmp(da->dataPointer(), db->dataPointer(), da->dataSize()) != 0))
+            return false;
+    }
+    return true;
+}
+
+// Collects the meshes of a scene, and merges meshes that are
+// siblings with the same state.
+class MeshCollector : public vsg::Visitor
+{
+public:
+    MeshCollector(const MeshOptimizeSettings& settings_) : settings(settings_) {}
+
+    const MeshOptimizeSettings& settings;
+    vector<const vsg::GraphicsPipeline*> pipelineStack{nullptr};
+    vector<vsg::ref_ptr<vsg::VertexIndexDraw>> draws;
+    vector<const vsg::GraphicsPipeline*> drawPipelines;
+    map<const vsg::Object*, int> useCount;
+    set<const vsg::VertexIndexDraw*> mergedAway;
+
+    static const vsg::GraphicsPipeline *getPipeline(const vsg::StateGroup& sg)
+    {
+        for (auto& sc : sg.stateCommands)
+            if (auto bgp = sc->cast<vsg::BindGraphicsPipeline>())
+                return bgp->pipeline;
+        return nullptr;
+    }
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::Group& group) override
+    {
+        group.traverse(*this);
+        if (settings.merge)
+            mergeChildren(group);
+    }
+
+    void apply(vsg::StateGroup& sg) override
+    {
+        auto pipeline = getPipeline(sg);
+        pipelineStack.push_back(pipeline ? pipeline : pipelineStack.back());
+        apply(static_cast<vsg::Group&>(sg));
+        pipelineStack.pop_back();
+    }
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        // A draw or an array that is used several times is left alone
+        if (useCount[&vid]++ == 0)
+        {
+            draws.push_back(vsg::ref_ptr<vsg::VertexIndexDraw>(&vid));
+            drawPipelines.push_back(pipelineStack.back());
+            for (auto& array : vid.arrays)
+                useCount[array->data.get()]++;
+            if (vid.indices)
+                useCount[vid.indices->data.get()]++;
+        }
+    }
+
+    // Merge the children that are state groups with the same state
+    // commands and a single mesh each.
+    void mergeChildren(vsg::Group& group)
+    {
+        struct Candidate
+        {
+            vsg::ref_ptr<vsg::StateGroup> stateGroup;
+            const vsg::GraphicsPipeline *pipeline;
+            Mesh mesh;
+        };
+        vector<vector<Candidate>> batches;
+
+        for (auto& child : group.children)
+        {
+            auto sg = child->cast<vsg::StateGroup>();
+            if (!sg || sg->referenceCount() != 1 || sg->children.size() != 1)
+                continue;
+            auto vid = sg->children[0]->cast<vsg::VertexIndexDraw>();
+            if (!vid || useCount[vid] != 1)
+                continue;
+            auto pipeline = getPipeline(*sg);
+            Candidate candidate{vsg::ref_ptr<vsg::StateGroup>(sg),
+                                pipeline ? pipeline : pipelineStack.back(),
+                                {}};
+            if (!readMesh(vsg::ref_ptr<vsg::VertexIndexDraw>(vid),
+                          candidate.pipeline,
+                          candidate.mesh))
+                continue;
+
+            bool added = false;
+            for (auto& batch : batches)
+            {
+                auto& first = batch.front();
+                size_t numVertices = 0;
+                for (auto& c : batch)
+                    numVertices += c.mesh.numVertices;
+                if (first.stateGroup->stateCommands == sg->stateCommands
+                    && numVertices + candidate.mesh.numVertices <= settings.maxMergedVertices
+                    && canMerge(first.mesh, candidate.mesh))
+                {
+                    batch.push_back(std::move(candidate));
+                    added = true;
+                    break;
+                }
+            }
+            if (!added)
+                batches.push_back({std::move(candidate)});
+        }
+
+        set<vsg::Node*> removed;
+        for (auto& batch : batches)
+        {
+            if (batch.size() < 2)
+                continue;
+
+            vector<Mesh> meshes;
+            for (auto& c : batch)
+                meshes.push_back(c.mesh);
+            Mesh merged;
+            mergeMeshes(meshes, merged);
+
+            auto vid = vsg::VertexIndexDraw::create();
+            vid->firstBinding = merged.draw->firstBinding;
+            vid->instanceCount = 1;
+            merged.draw = vid;
+            writeMesh(merged);
+
+            batch[0].stateGroup->children[0] = vid;
+            for (size_t i = 1; i < batch.size(); i++)
+                removed.insert(batch[i].stateGroup.get());
+
+            // Optimize the merged mesh instead of its parts
+            for (auto& c : batch)
+                mergedAway.insert(c.mesh.draw.get());
+            draws.push_back(vid);
+            drawPipelines.push_back(batch[0].pipeline);
+            useCount[vid.get()] = 1;
+            for (auto& array : vid->arrays)
+                useCount[array->data.get()] = 1;
+            useCount[vid->indices->data.get()] = 1;
+        }
+
+        if (!removed.empty())
+        {
+            auto& children = group.children;
+            children.erase(std::remove_if(children.begin(), children.end(),
+                                          [&](const vsg::ref_ptr<vsg::Node>& c) {
+                                              return removed.count(c.get()) > 0;
+                                          }),
+                           children.end());
+        }
+    }
+};
+
+class MeshStatsCollector : public vsg::Visitor
+{
+public:
+    MeshStats stats;
+    set<const vsg::Data*> data;
+
+    void addData(const vsg::Data *d)
+    {
+        if (d && data.insert(d).second)
+            stats.numBytes += d->dataSize();
+    }
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        stats.numDraws++;
+        stats.numTriangles += size_t(vid.indexCount / 3) * vid.instanceCount;
+        if (!vid.arrays.empty() && vid.arrays[0]->data)
+            stats.numVertices += vid.arrays[0]->data->valueCount();
+        for (auto& array : vid.arrays)
+            addData(array->data);
+        if (vid.indices)
+            addData(vid.indices->data);
+    }
+
+    void apply(vsg::VertexDraw& vd) override
+    {
+        stats.numDraws++;
+        stats.numTriangles += size_t(vd.vertexCount / 3) * vd.instanceCount;
+        stats.numVertices += vd.vertexCount;
+        for (auto& array : vd.arrays)
+            addData(array->data);
+    }
+
+    void apply(vsg::Geometry& geometry) override
+    {
+        stats.numDraws++;
+        if (!geometry.arrays.empty() && geometry.arrays[0]->data)
+            stats.numVertices += geometry.arrays[0]->data->valueCount();
+        for (auto& array : geometry.arrays)
+            addData(array->data);
+        if (geometry.indices)
+            addData(geometry.indices->data);
+    }
+};
+
+// Finds where each draw is used, so that it can be replaced
+class DrawUseCollector : public vsg::Visitor
+{
+public:
+    struct Use
+    {
+        vsg::Group *group;
+        size_t index;
+    };
+
+    vector<vsg::ref_ptr<vsg::VertexIndexDraw>> draws;
+    map<const vsg::VertexIndexDraw*, vector<Use>> uses;
+    set<const vsg::Group*> visited;
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::Group& group) override
+    {
+        if (!visited.insert(&group).second)
+            return;
+
+        for (size_t i = 0; i < group.children.size(); i++)
+        {
+            auto vid = group.children[i]->cast<vsg::VertexIndexDraw>();
+            if (!vid)
+                continue;
+            auto& drawUses = uses[vid];
+            if (drawUses.empty())
+                draws.push_back(vsg::ref_ptr<vsg::VertexIndexDraw>(vid));
+            drawUses.push_back({&group, i});
+        }
+        group.traverse(*this);
+    }
+};
+
+static uint64_t hashData(const vsg::Data *data, uint64_t seed)
+{
+    if (!data)
+        return seed;
+    return hashBytes(data->dataPointer(), data->dataSize(), seed ^ data->valueCount());
+}
+
+static uint64_t hashDraw(const vsg::VertexIndexDraw& vid)
+{
+    uint32_t params[] = { vid.indexCount, vid.instanceCount, vid.firstIndex,
+                          uint32_t(vid.vertexOffset), vid.firstInstance,
+                          vid.firstBinding, uint32_t(vid.arrays.size()) };
+    uint64_t hash = hashBytes(params, sizeof(params));
+    for (auto& array : vid.arrays)
+        hash = hashData(array ? array->data.get() : nullptr, hash);
+    return hashData(vid.indices ? vid.indices->data.get() : nullptr, hash);
+}
+
+static bool dataEqual(const vsg::Data *a, const vsg::Data *b)
+{
+    if (a == b)
+        return true;
+    return a && b
+        && a->type_info() == b->type_info()
+        && a->valueCount() == b->valueCount()
+        && a->properties.format == b->properties.format
+        && a->properties.stride == b->properties.stride
+        && a->dataSize() == b->dataSize()
+        && memcmp(a->dataPointer(), b->dataPointer(), a->dataSize()) == 0;
+}
+
+static bool drawEqual(const vsg::VertexIndexDraw& a, const vsg::VertexIndexDraw& b)
+{
+    if (a.indexCount != b.indexCount
+        || a.instanceCount != b.instanceCount
+        || a.firstIndex != b.firstIndex
+        || a.vertexOffset != b.vertexOffset
+        || a.firstInstance != b.firstInstance
+        || a.firstBinding != b.firstBinding
+        || a.arrays.size() != b.arrays.size()
+        || bool(a.indices) != bool(b.indices))
+        return false;
+    for (size_t i = 0; i < a.arrays.size(); i++)
+        if (bool(a.arrays[i]) != bool(b.arrays[i])
+            || (a.arrays[i] && !dataEqual(a.arrays[i]->data, b.arrays[i]->data)))
+            return false;
+    return !a.indices || dataEqual(a.indices->data, b.indices->data);
+}
+
+// Replace the draws that are identical to an earlier draw by that
+// draw, so that the mesh is only stored and uploaded once. Each copy
+// still has its own transform above it. Returns the number of draws
+// that were replaced.
+static size_t shareIdenticalMeshes(vsg::Node& node)
+{
+    DrawUseCollector collector;
+    node.accept(collector);
+    auto& draws = collector.draws;
+
+    // Hashing reads all of the data, so it is done in parallel
+    vector<uint64_t> hashes(draws.size());
+    parallelFor(draws.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            hashes[i] = hashDraw(*draws[i]);
+    }, 1);
+
+    // Equal hashes are only candidates, as they may collide
+    map<uint64_t, vector<vsg::VertexIndexDraw*>> originals;
+    size_t numReplaced = 0;
+    for (size_t i = 0; i < draws.size(); i++)
+    {
+        auto& candidates = originals[hashes[i]];
+        vsg::VertexIndexDraw *original = nullptr;
+        for (auto candidate : candidates)
+        {
+            if (drawEqual(*candidate, *draws[i]))
+            {
+                original = candidate;
+                break;
+            }
+        }
+        if (!original)
+        {
+            candidates.push_back(draws[i]);
+            continue;
+        }
+
+        for (auto& use : collector.uses[draws[i]])
+            use.group->children[use.index] = vsg::ref_ptr<vsg::Node>(original);
+        numReplaced++;
+    }
+    return numReplaced;
+}
+
+MeshStats collectMeshStats(vsg::Node& node)
+{
+    MeshStatsCollector collector;
+    node.accept(collector);
+    return collector.stats;
+}
+
+void optimizeMeshes(vsg::Node& node, const MeshOptimizeSettings& settings)
+{
+    auto t0 = vsg::clock::now();
+    auto before = collectMeshStats(node);
+
+    MeshCollector collector(settings);
+    node.accept(collector);
+
+    // The meshes are independent so optimize them in parallel
+    auto& draws = collector.draws;
+    parallelFor(draws.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            auto& draw = draws[i];
+            if (collector.mergedAway.count(draw.get()))
+                continue;
+
+            bool shared = collector.useCount.at(draw.get()) > 1;
+            for (auto& array : draw->arrays)
+                shared |= collector.useCount.at(array->data.get()) > 1;
+            if (draw->indices)
+                shared |= collector.useCount.at(draw->indices->data.get()) > 1;
+
+            Mesh mesh;
+            if (shared || !readMesh(draw, collector.drawPipelines[i], mesh))
+                continue;
+
+            if (settings.weld)
+                weldVertices(mesh);
+            if (settings.vertexCache)
+                optimizeVertexCache(mesh);
+            if (settings.vertexFetch)
+                optimizeVertexFetch(mesh);
+            writeMesh(mesh);
+        }
+    }, 1);
+
+    // After the other passes, which give identical meshes identical
+    // results, and which leave the shared meshes alone
+    if (settings.share)
+    {
+        auto beforeSharing = collectMeshStats(node);
+        size_t numShared = shareIdenticalMeshes(node);
+        auto afterSharing = collectMeshStats(node);
+        spdlog::info("Shared {} copies of identical meshes, saving {:.1f} MB", numShared,
+                     (beforeSharing.numBytes - afterSharing.numBytes) / (1024.0 * 1024.0));
+    }
+
+    auto after = collectMeshStats(node);
+    spdlog::info("Mesh optimization took {:.0f} ms",
+                 std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count());
+    spdlog::info("  draws:     {} -> {}", before.numDraws, after.numDraws);
+    spdlog::info("  vertices:  {} -> {}", before.numVertices, after.numVertices);
+    spdlog::info("  triangles: {} -> {}", before.numTriangles, after.numTriangles);
+    spdlog::info("  bytes:     {} -> {}", before.numBytes, after.numBytes);
+}
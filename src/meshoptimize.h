@@ -0,0 +1,44 @@
+//======================================================================
+//  meshoptimize.h - Post load optimization of the meshes of a scene
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef MESHOPTIMIZE_H
+#define MESHOPTIMIZE_H
+
+#include <vsg/all.h>
+#include <string>
+
+struct MeshOptimizeSettings
+{
+    bool enabled = false;
+    bool merge = true;       // Merge sibling meshes with the same state
+    bool weld = true;        // Share identical vertices
+    bool vertexCache = true; // Order triangles for the post transform cache
+    bool vertexFetch = true; // Order vertices by their first use
+    bool share = true;       // Share a single copy of identical meshes
+    size_t maxMergedVertices = 1 << 20;
+
+    // Parse a comma separated list of the passes, e.g. "weld,merge"
+    bool parsePasses(const std::string& passes);
+
+    // A short string that identifies the settings, e.g. for cache keys
+    std::string key() const;
+};
+
+struct MeshStats
+{
+    size_t numDraws = 0;
+    size_t numVertices = 0;
+    size_t numTriangles = 0;
+    size_t numBytes = 0;
+};
+
+MeshStats collectMeshStats(vsg::Node& node);
+
+// Optimize the indexed triangle meshes in node in place. Meshes
+// that are shared between several draws are left alone.
+void optimizeMeshes(vsg::Node& node, const MeshOptimizeSettings& settings);
+
+#endif /* MESHOPTIMIZE */
@@ -0,0 +1,143 @@
+//======================================================================
+//  modelcache.cpp - A persistent cache of loaded models in .vsgb format
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "modelcache.h"
+#include "filehash.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <cstdio>
+#include <thread>
+
+// constructor
+ModelCache::ModelCache(const std::string& directory, uint64_t maxSize)
+  : m_directory(directory),
+    m_maxSize(maxSize)
+{
+    QDir().mkpath(QString::fromStdString(m_directory));
+
+    m_options = vsg::Options::create();
+    m_options->extensionHint = ".vsgb";
+}
+
+std::string ModelCache::defaultDirectory()
+{
+    return (QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + "/qtvsgviewer/models").toStdString();
+}
+
+bool ModelCache::makeKey(const std::string& filename, const std::string& variant,
+                         std::string& key)
+{
+    // There is nothing to gain by caching the native format
+    auto ext = vsg::lowerCaseFileExtension(filename);
+    if (ext == ".vsgb" || ext == ".vsgt")
+        return false;
+
+    QFileInfo fi(QString::fromStdString(filename));
+    if (!fi.isFile())
+        return false;
+
+    uint64_t hash;
+    if (!hashFile(filename, hash))
+        return false;
+
+    key = fmt::format("{:016x}-{:x}-{:x}",
+                      hash,
+                      (uint64_t)fi.size(),
+                      (uint64_t)fi.lastModified().toMSecsSinceEpoch());
+    if (variant.size())
+        key += "-" + variant;
+    return true;
+}
+
+std::string ModelCache::entryPath(const std::string& key) const
+{
+    return m_directory + "/" + key + ".vsgb";
+}
+
+vsg::ref_ptr<vsg::Node> ModelCache::read(const std::string& key) const
+{
+    QFile file(QString::fromStdString(entryPath(key)));
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    qint64 size = file.size();
+    uchar *data = file.map(0, size);
+    if (!data)
+        return {};
+
+    vsg::VSG vsgReader;
+    auto node = vsgReader.read_cast<vsg::Node>(data, size_t(size), m_options);
+    file.unmap(data);
+
+    if (!node)
+    {
+        spdlog::warn("Failed reading cache entry {}, removing it", key);
+        file.remove();
+        return {};
+    }
+
+    // Mark the entry as recently used
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    return node;
+}
+
+bool ModelCache::write(const std::string& key, vsg::ref_ptr<vsg::Node> node)
+{
+    // Write to a temporary file and rename it into place so that a
+    // concurrent reader never sees a partial entry.
+    std::string path = entryPath(key);
+    std::string tmpPath = fmt::format("{}/{}.{}.tmp.vsgb",
+                                      m_directory, key,
+                                      std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    vsg::VSG vsgWriter;
+    if (!vsgWriter.write(node, tmpPath, m_options)
+        || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        spdlog::warn("Failed writing cache entry {}", path);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+// Remove the least recently used entries until the cache fits in
+// m_maxSize.
+void ModelCache::evict()
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+
+    QDir dir(QString::fromStdString(m_directory));
+    auto entries = dir.entryInfoList({"*.vsgb"}, QDir::Files, QDir::Time);
+
+    // Entries that are being written by write() aren't in the cache yet
+    entries.removeIf([](const QFileInfo& entry) {
+        return entry.fileName().endsWith(".tmp.vsgb");
+    });
+
+    uint64_t totalSize = 0;
+    for (auto& entry : entries)
+        totalSize += entry.size();
+
+    // Oldest entries are last
+    while (totalSize > m_maxSize && !entries.isEmpty())
+    {
+        auto entry = entries.takeLast();
+        spdlog::debug("Evicting cache entry {}", entry.fileName().toStdString());
+        if (QFile::remove(entry.absoluteFilePath()))
+            totalSize -= entry.size();
+    }
+}
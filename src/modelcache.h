@@ -0,0 +1,55 @@
+//======================================================================
+//  modelcache.h - A persistent cache of loaded models in .vsgb format
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include <vsg/all.h>
+#include <mutex>
+#include <string>
+
+// Part of the keys of the cached models and tiles. Bump it when a
+// change of the readers or of the post processing changes the scene
+// that is made of the same file.
+static const int CACHE_FORMAT_VERSION = 1;
+
+// Stores the post processed scene of a model file in the native
+// binary vsg format, so that opening the same file again does not
+// need to go through the importer. The entries are keyed by the
+// content hash, the size and the modification time of the source
+// file. The least recently used entries are removed when the total
+// size of the cache exceeds maxSize.
+class ModelCache : public vsg::Inherit<vsg::Object, ModelCache>
+{
+public:
+    ModelCache(const std::string& directory, uint64_t maxSize);
+
+    // Default location of the cache directory
+    static std::string defaultDirectory();
+
+    // Get the cache key of filename. The variant distinguishes
+    // between different post processing of the same file. Returns
+    // false if the file can't be read or shouldn't be cached.
+    static bool makeKey(const std::string& filename, const std::string& variant,
+                        std::string& key);
+
+    // Returns null if key isn't in the cache
+    vsg::ref_ptr<vsg::Node> read(const std::string& key) const;
+    bool write(const std::string& key, vsg::ref_ptr<vsg::Node> node);
+
+    const std::string& directory() const { return m_directory; }
+
+private:
+    std::string entryPath(const std::string& key) const;
+    void evict();
+
+    std::string m_directory;
+    uint64_t m_maxSize;
+    vsg::ref_ptr<vsg::Options> m_options;
+    std::mutex m_mutex;
+};
+
+#endif /* MODELCACHE */
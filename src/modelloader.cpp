@@ -0,0 +1,530 @@
+//======================================================================
+//  modelloader.cpp - Load models on a pool of worker threads
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "modelloader.h"
+#include "wireframe.h"
+#include "pipelinecache.h"
+#include "framerequest.h"
+#include "bounds.h"
+#include "gpuresources.h"
+#include "quantize.h"
+#include "tracing.h"
+#include "pointcloud.h"
+#include "stlreader.h"
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+static double elapsedMs(vsg::clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count();
+}
+
+// Runs on the viewer thread in the update phase, i.e. between two
+// frames, so the old model stays in place until the new one has been
+// compiled. The old model is then released right away, instead of
+// whenever its last reference happens to be dropped. The parts of a
+// streamed model that was canceled or failed are removed.
+class MergeOperation : public vsg::Inherit<vsg::Operation, MergeOperation>
+{
+public:
+    MergeOperation(vsg::observer_ptr<vsg::Viewer> viewer_,
+                   vsg::ref_ptr<vsg::Group> attachmentPoint_,
+                   vsg::ref_ptr<vsg::Group> streamGroup_,
+                   vsg::ref_ptr<vsg::Node> node_,
+                   const vsg::CompileResult& compileResult_,
+                   vsg::ref_ptr<LoadStatus> status_,
+                   ModelLoader::DoneCallback onDone_) :
+        viewer(viewer_),
+        attachmentPoint(attachmentPoint_),
+        streamGroup(streamGroup_),
+        node(node_),
+        compileResult(compileResult_),
+        status(status_),
+        onDone(onDone_) {}
+
+    vsg::observer_ptr<vsg::Viewer> viewer;
+    vsg::ref_ptr<vsg::Group> attachmentPoint;
+    vsg::ref_ptr<vsg::Group> streamGroup;
+    vsg::ref_ptr<vsg::Node> node;
+    vsg::CompileResult compileResult;
+    vsg::ref_ptr<LoadStatus> status;
+    ModelLoader::DoneCallback onDone;
+
+    void run() override
+    {
+        TRACE_ZONE("merge", "load", status->filename);
+        vsg::ref_ptr<vsg::Viewer> ref_viewer = viewer;
+        if (status->canceled)
+            node = nullptr;
+
+        if (node && ref_viewer)
+        {
+            vsg::updateViewer(*ref_viewer, compileResult);
+            auto replaced = std::move(attachmentPoint->children);
+            attachmentPoint->children.clear();
+            attachmentPoint->addChild(node);
+            releaseNodes(*ref_viewer, replaced);
+        }
+        else if (ref_viewer && !streamGroup->children.empty())
+        {
+            // Unless a later request has already replaced them
+            auto& children = attachmentPoint->children;
+            auto it = std::find(children.begin(), children.end(), streamGroup);
+            if (it != children.end())
+            {
+                vsg::Group::Children removed{*it};
+                children.erase(it);
+                releaseNodes(*ref_viewer, removed);
+            }
+        }
+
+        status->done = true;
+        if (onDone)
+            onDone(status, node);
+    }
+};
+
+// Attaches a part of a streamed model between two frames. The parts
+// are collected in streamGroup, which replaces the previous model
+// when the first part arrives.
+class ChunkMergeOperation : public vsg::Inherit<vsg::Operation, ChunkMergeOperation>
+{
+public:
+    ChunkMergeOperation(vsg::observer_ptr<vsg::Viewer> viewer_,
+                        vsg::ref_ptr<vsg::Group> attachmentPoint_,
+                        vsg::ref_ptr<vsg::Group> streamGroup_,
+                        vsg::ref_ptr<vsg::Node> chunk_,
+                        const vsg::CompileResult& compileResult_,
+                        vsg::ref_ptr<LoadStatus> status_,
+                        ModelLoader::ChunkCallback onChunk_) :
+        viewer(viewer_),
+        attachmentPoint(attachmentPoint_),
+        streamGroup(streamGroup_),
+        chunk(chunk_),
+        compileResult(compileResult_),
+        status(status_),
+        onChunk(onChunk_) {}
+
+    vsg::observer_ptr<vsg::Viewer> viewer;
+    vsg::ref_ptr<vsg::Group> attachmentPoint;
+    vsg::ref_ptr<vsg::Group> streamGroup;
+    vsg::ref_ptr<vsg::Node> chunk;
+    vsg::CompileResult compileResult;
+    vsg::ref_ptr<LoadStatus> status;
+    ModelLoader::ChunkCallback onChunk;
+
+    void run() override
+    {
+        TRACE_ZONE("merge chunk", "load", status->filename);
+        vsg::ref_ptr<vsg::Viewer> ref_viewer = viewer;
+        if (status->canceled || !ref_viewer)
+            return;
+
+        vsg::updateViewer(*ref_viewer, compileResult);
+        bool first = streamGroup->children.empty();
+        if (first)
+        {
+            auto replaced = std::move(attachmentPoint->children);
+            attachmentPoint->children.clear();
+            attachmentPoint->addChild(streamGroup);
+            releaseNodes(*ref_viewer, replaced);
+        }
+        streamGroup->addChild(chunk);
+
+        if (onChunk)
+            onChunk(status, first);
+    }
+};
+
+class LoadOperation : public vsg::Inherit<vsg::Operation, LoadOperation>
+{
+public:
+    LoadOperation(vsg::observer_ptr<vsg::Viewer> viewer_,
+                  vsg::ref_ptr<vsg::Options> options_,
+                  const ReadSettings& settings_,
+                  vsg::ref_ptr<vsg::Group> attachmentPoint_,
+                  vsg::ref_ptr<LoadStatus> status_,
+                  ModelLoader::DoneCallback onDone_,
+                  ModelLoader::ChunkCallback onChunk_) :
+        viewer(viewer_),
+        options(options_),
+        settings(settings_),
+        attachmentPoint(attachmentPoint_),
+        status(status_),
+        onDone(onDone_),
+        onChunk(onChunk_) {}
+
+    vsg::observer_ptr<vsg::Viewer> viewer;
+    vsg::ref_ptr<vsg::Options> options;
+    ReadSettings settings;
+    vsg::ref_ptr<vsg::Group> attachmentPoint;
+    vsg::ref_ptr<LoadStatus> status;
+    ModelLoader::DoneCallback onDone;
+    ModelLoader::ChunkCallback onChunk;
+
+    // The models that were read with barycentrics draw their wireframe
+    // through the overlay, and the others through a switch
+    void prepareWireframe(vsg::Node& node)
+    {
+        if (settings.wireframeOverlay)
+            bindWireframeOverlay(node);
+        else
+            insertWireframeSwitch(node);
+    }
+
+    void run() override
+    {
+        Tracer::instance().setThreadName("loader");
+        TRACE_ZONE("load", "load", status->filename);
+        vsg::ref_ptr<vsg::Viewer> ref_viewer = viewer;
+        if (!ref_viewer)
+        {
+            // There is no update phase to report the load in, so it
+            // is reported as canceled on the gui thread instead
+            status->canceled = true;
+            status->done = true;
+            auto ref_status = status;
+            auto done = onDone;
+            if (done)
+                QMetaObject::invokeMethod(QCoreApplication::instance(),
+                                          [ref_status, done]() { done(ref_status, {}); },
+                                          Qt::QueuedConnection);
+            return;
+        }
+
+        // Each part of a streamed model is compiled on this thread as
+        // soon as the reader has made it
+        auto streamGroup = vsg::Group::create();
+        if (settings.streamChunkTriangles > 0)
+        {
+            status->chunkTriangles = settings.streamChunkTriangles;
+            status->onChunk = [&](vsg::ref_ptr<vsg::Node> chunk) {
+                status->numChunks++;
+                cacheBounds(*chunk);
+                prepareWireframe(*chunk);
+                vsg::CompileResult chunkResult;
+                {
+                    TRACE_ZONE("compile chunk", "load");
+                    chunkResult = ref_viewer->compileManager->compile(chunk);
+                }
+                if (!chunkResult)
+                    return;
+                ref_viewer->addUpdateOperation(
+                    ChunkMergeOperation::create(viewer, attachmentPoint, streamGroup, chunk,
+                                                chunkResult, status, onChunk));
+                requestFrame(ref_viewer);
+            };
+        }
+
+        vsg::ref_ptr<vsg::Node> node;
+        vsg::CompileResult result;
+        if (!status->canceled)
+            node = ModelLoader::readModel(status->filename, options, settings, status);
+        status->onChunk = nullptr;
+
+        if (node && !status->canceled)
+        {
+            auto t0 = vsg::clock::now();
+            auto& pipelineCache = PipelineCache::instance();
+            size_t numPipelines = pipelineCache.numCreated();
+            double pipelineTime = pipelineCache.createTime();
+            prepareWireframe(*node);
+            {
+                TRACE_ZONE("compile", "load", status->filename);
+                result = ref_viewer->compileManager->compile(node);
+            }
+            status->compileTime = elapsedMs(t0);
+            status->numPipelines = pipelineCache.numCreated() - numPipelines;
+            status->pipelineTime = pipelineCache.createTime() - pipelineTime;
+            if (!result)
+            {
+                status->error = result.message;
+                node = nullptr;
+            }
+        }
+
+        ref_viewer->addUpdateOperation(
+            MergeOperation::create(viewer, attachmentPoint, streamGroup, node, result, status, onDone));
+        requestFrame(ref_viewer);
+    }
+};
+
+// constructor
+ModelLoader::ModelLoader(vsg::ref_ptr<vsg::Viewer> viewer,
+                         vsg::ref_ptr<vsg::Options> options,
+                         uint32_t numThreads)
+  : m_viewer(viewer),
+    m_options(options)
+{
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency()/2);
+    m_loadThreads = vsg::OperationThreads::create(numThreads);
+}
+
+ModelLoader::~ModelLoader()
+{
+    cancel();
+    m_loadThreads->stop();
+}
+
+vsg::ref_ptr<LoadStatus>
+ModelLoader::load(const std::string& filename,
+                  vsg::ref_ptr<vsg::Group> attachmentPoint,
+                  DoneCallback onDone,
+                  ChunkCallback onChunk)
+{
+    // Forget the finished requests and cancel the one that this
+    // request replaces
+    auto replaced = [&](const std::pair<vsg::ref_ptr<vsg::Group>, vsg::ref_ptr<LoadStatus>>& pending) {
+        if (pending.first == attachmentPoint)
+            pending.second->canceled = true;
+        return pending.second->done || pending.second->canceled;
+    };
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), replaced),
+                    m_pending.end());
+
+    auto status = LoadStatus::create(filename);
+    m_pending.push_back({attachmentPoint, status});
+    m_loadThreads->add(LoadOperation::create(m_viewer, m_options, m_readSettings, attachmentPoint,
+                                             status, onDone, onChunk));
+    return status;
+}
+
+void ModelLoader::cancel()
+{
+    for (auto& pending : m_pending)
+        pending.second->canceled = true;
+    m_pending.clear();
+}
+
+std::string ReadSettings::cacheVariant() const
+{
+    std::string variant = optimize.key() + cullHierarchy.key();
+    if (quantizeVertices)
+        variant += "quant";
+    if (wireframeOverlay)
+        variant += "wire";
+    if (streamChunkTriangles > 0)
+        variant += fmt::format("stream{}", streamChunkTriangles);
+    return variant;
+}
+
+// The version of the cached scenes and the settings of the reader of
+// filename, which the cached scenes of the file depend on as well
+static std::string readerVariant(const std::string& filename, const vsg::Options *options)
+{
+    std::string variant = fmt::format("v{}", CACHE_FORMAT_VERSION);
+    if (options && vsg::lowerCaseFileExtension(filename) == ".stl")
+    {
+        for (auto& readerWriter : options->readerWriters)
+        {
+            if (auto stlReader = readerWriter.cast<STLReader>())
+            {
+                variant += stlReader->key();
+                break;
+            }
+        }
+    }
+    return variant;
+}
+
+vsg::ref_ptr<vsg::Node>
+ModelLoader::readModel(const std::string& filename,
+                       vsg::ref_ptr<const vsg::Options> options,
+                       const ReadSettings& settings,
+                       LoadStatus* status)
+{
+    auto t0 = vsg::clock::now();
+
+    // The file is only hashed once for the cache and the tiles
+    std::string fileKey;
+    bool hasKey = (settings.cache || settings.tiles.enabled)
+        && !isPointCloudFile(filename)
+        && ModelCache::makeKey(filename, "", fileKey);
+
+    ModelCache *cache = hasKey ? settings.cache.get() : nullptr;
+    std::string variant = readerVariant(filename, options.get());
+    std::string cacheKey = fileKey + "-" + variant + settings.cacheVariant();
+
+    // A model that has been converted to tiles is paged in from its
+    // database instead of the cache
+    std::string tilesKey;
+    if (hasKey && settings.tiles.enabled)
+    {
+        tilesKey = fileKey + "-" + variant + "-" + settings.tiles.key();
+        vsg::ref_ptr<vsg::Node> node;
+        {
+            TRACE_ZONE("read tiles", "load", filename);
+            node = readTiles(tilesKey, settings.tiles, options);
+        }
+        if (node)
+        {
+            cacheBounds(*node);
+            if (status)
+            {
+                status->readTime = elapsedMs(t0);
+                status->fromCache = true;
+            }
+            return node;
+        }
+    }
+
+    if (cache)
+    {
+        vsg::ref_ptr<vsg::Node> node;
+        {
+            TRACE_ZONE("read cache", "load", filename);
+            node = cache->read(cacheKey);
+        }
+        if (node)
+        {
+            cacheBounds(*node);
+            if (status)
+            {
+                status->readTime = elapsedMs(t0);
+                status->fromCache = true;
+            }
+            return node;
+        }
+    }
+
+    // Give the readers that support it access to the progress and
+    // to the cancel flag. The tiles are read by the pager, and don't
+    // get them.
+    auto tileOptions = options;
+    if (status)
+    {
+        auto readOptions = vsg::Options::create(*options);
+        readOptions->setObject("LoadStatus", vsg::ref_ptr<vsg::Object>(status));
+        options = readOptions;
+    }
+
+    vsg::ref_ptr<vsg::Node> node;
+    {
+        TRACE_ZONE("read", "load", filename);
+        node = vsg::read_cast<vsg::Node>(filename, options);
+    }
+    if (!node)
+    {
+        if (status)
+            status->error = fmt::format("Failed to load {}", filename);
+        return {};
+    }
+
+    // I don't know why, but read swaps the y and the z-axis. This transform node
+    // transforms it back. The native readers keep the z-up orientation.
+    bool zUp = false;
+    node->getValue("z_up", zUp);
+    auto ext = vsg::lowerCaseFileExtension(filename);
+    if (!zUp && (ext == ".stl" || ext == ".3mf"))
+    {
+        auto transform = vsg::MatrixTransform::create(
+            vsg::dmat4 {{ 1.0f, 0.0f, 0.0f, 0.0f },
+                        { 0.0f, 0.0f, -1.0f, 0.0f },
+                        { 0.0f, 1.0f, 0.0f, 0.0f },
+                        { 0.0f, 0.0f, 0.0f, 1.0f }});
+        transform->addChild(node);
+        node = transform;
+    }
+
+    // The point clouds are already streamed from the octree that
+    // their reader has built, and have no meshes to process
+    if (node->getObject("tilePoints"))
+    {
+        cacheBounds(*node);
+        if (status)
+            status->readTime = elapsedMs(t0);
+        return node;
+    }
+
+    // The parts of a streamed model are already being drawn, so their
+    // meshes must not be modified
+    bool streamed = status && status->numChunks > 0;
+    if (settings.optimize.enabled && !streamed && !(status && status->canceled))
+    {
+        TRACE_ZONE("optimize", "load");
+        optimizeMeshes(*node, settings.optimize);
+    }
+
+    // After the merging of the meshes, and before the quantization,
+    // since the tiles are split by the float positions. The tiles
+    // replace the post processing and the cache entry of the model.
+    if (tilesKey.size() && !streamed && !(status && status->canceled))
+    {
+        bool converted;
+        {
+            TRACE_ZONE("tiles", "load", filename);
+            converted = convertToTiles(*node, tilesKey, settings.tiles,
+                                       status ? &status->canceled : nullptr);
+        }
+        vsg::ref_ptr<vsg::Node> tiles;
+        if (converted)
+            tiles = readTiles(tilesKey, settings.tiles, tileOptions);
+        if (tiles)
+        {
+            cacheBounds(*tiles);
+            if (status)
+                status->readTime = elapsedMs(t0);
+            return tiles;
+        }
+        if (converted)
+        {
+            if (status)
+                status->error = fmt::format("Failed to read the tiles of {}", filename);
+            return {};
+        }
+    }
+
+    // After the optimization, which only handles float vertices
+    if (settings.quantizeVertices && !streamed && !(status && status->canceled))
+    {
+        TRACE_ZONE("quantize", "load");
+        auto stats = quantizeVertices(*node);
+        spdlog::info("Quantized the vertices of {} meshes of {}, {:.1f} MB -> {:.1f} MB ({} meshes left as they were)",
+                     stats.numDraws, filename, stats.bytesBefore / (1024.0 * 1024.0),
+                     stats.bytesAfter / (1024.0 * 1024.0), stats.numSkipped);
+    }
+
+    // After the quantization, whose pipeline variants get variants of
+    // their own
+    if (settings.wireframeOverlay && !streamed && !(status && status->canceled))
+    {
+        TRACE_ZONE("barycentrics", "load");
+        size_t numDraws = addWireframeBarycentrics(*node);
+        spdlog::info("Added barycentrics for the wireframe overlay to {} meshes of {}", numDraws, filename);
+    }
+
+    // After the merging of the meshes, which leaves fewer parts
+    if (settings.cullHierarchy.enabled && !streamed && !(status && status->canceled))
+    {
+        TRACE_ZONE("cull hierarchy", "load");
+        buildCullHierarchy(*node, settings.cullHierarchy);
+    }
+
+    // While the model is still only seen by this thread
+    {
+        TRACE_ZONE("bounds", "load");
+        cacheBounds(*node);
+    }
+
+    // Store the scene before the viewer modifies it, e.g. by the
+    // wireframe switches.
+    if (cache)
+    {
+        TRACE_ZONE("write cache", "load");
+        cache->write(cacheKey, node);
+    }
+
+    if (status)
+        status->readTime = elapsedMs(t0);
+
+    return node;
+}
@@ -0,0 +1,124 @@
+//======================================================================
+//  modelloader.h - Load models on a pool of worker threads
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <vsg/all.h>
+#include "modelcache.h"
+#include "meshoptimize.h"
+#include "cullhierarchy.h"
+#include "pagedtiles.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The state of a single load request. It is shared between the
+// thread that does the loading and the gui that shows the progress.
+class LoadStatus : public vsg::Inherit<vsg::Object, LoadStatus>
+{
+public:
+    LoadStatus(const std::string& filename_) : filename(filename_) {}
+
+    std::string filename;
+
+    // Between 0 and 1, or negative if the progress is unknown. These
+    // are mutable as the readers get the status through the const
+    // vsg::Options.
+    mutable std::atomic<double> progress{-1.0};
+    mutable std::atomic<bool> canceled{false};
+    std::atomic<bool> done{false}; // Set before the done callback is called
+
+    // Readers that support streaming hand over the parts of the model
+    // to onChunk as soon as they have been read, each of about
+    // chunkTriangles triangles, and return a model that is made of
+    // the same parts. It is called on the thread of the reader.
+    size_t chunkTriangles = 0;
+    std::function<void(vsg::ref_ptr<vsg::Node> chunk)> onChunk;
+    std::atomic<size_t> numChunks{0};
+
+    // Only valid once the load has finished
+    std::string error;
+    double readTime = 0;    // ms
+    bool fromCache = false;
+    double compileTime = 0; // ms
+    size_t numPipelines = 0; // Created during the compile
+    double pipelineTime = 0; // ms
+};
+
+// Settings of the synchronous part of a load
+struct ReadSettings
+{
+    vsg::ref_ptr<ModelCache> cache;
+    MeshOptimizeSettings optimize;
+    size_t streamChunkTriangles = 0; // Don't stream if 0
+    CullHierarchySettings cullHierarchy;
+    bool quantizeVertices = false;
+    bool wireframeOverlay = false; // Barycentrics instead of line-mode switches
+    TileSettings tiles;            // Convert the large models to paged tiles
+
+    // Identifies the settings that change the resulting scene, so
+    // that they get different cache entries.
+    std::string cacheVariant() const;
+};
+
+class ModelLoader
+{
+public:
+    // Called on the viewer thread when a load request is done, once
+    // for every request, or on the gui thread if the viewer is gone.
+    // On success node has already been merged into the scene.
+    using DoneCallback = std::function<void(vsg::ref_ptr<LoadStatus> status,
+                                            vsg::ref_ptr<vsg::Node> node)>;
+
+    // Called on the viewer thread when a part of a streamed model has
+    // been merged into the scene. The first part replaces the previous
+    // model, and if the load is canceled or fails the parts are removed
+    // again.
+    using ChunkCallback = std::function<void(vsg::ref_ptr<LoadStatus> status,
+                                             bool first)>;
+
+    ModelLoader(vsg::ref_ptr<vsg::Viewer> viewer,
+                vsg::ref_ptr<vsg::Options> options,
+                uint32_t numThreads = 0);
+    ~ModelLoader();
+
+    // Read and compile filename in the background, and then replace
+    // the children of attachmentPoint with it between two frames.
+    // Requests for different attachment points are loaded in
+    // parallel, while an earlier request for the same attachment
+    // point that is still in progress is canceled.
+    vsg::ref_ptr<LoadStatus> load(const std::string& filename,
+                                  vsg::ref_ptr<vsg::Group> attachmentPoint,
+                                  DoneCallback onDone,
+                                  ChunkCallback onChunk = {});
+
+    // Cancel the requests in progress. The previous models are kept,
+    // unless a streamed model has already replaced them.
+    void cancel();
+
+    // Must only be changed while there are no loads in progress
+    ReadSettings& readSettings() { return m_readSettings; }
+
+    // Read filename and bring it to the viewer's z-up convention.
+    // This is the synchronous part of a load and may be called from
+    // any thread.
+    static vsg::ref_ptr<vsg::Node> readModel(const std::string& filename,
+                                             vsg::ref_ptr<const vsg::Options> options,
+                                             const ReadSettings& settings,
+                                             LoadStatus* status = nullptr);
+
+private:
+    vsg::observer_ptr<vsg::Viewer> m_viewer;
+    vsg::ref_ptr<vsg::Options> m_options;
+    vsg::ref_ptr<vsg::OperationThreads> m_loadThreads;
+    ReadSettings m_readSettings;
+    std::vector<std::pair<vsg::ref_ptr<vsg::Group>, vsg::ref_ptr<LoadStatus>>> m_pending;
+};
+
+#endif /* MODELLOADER */
@@ -16,75 +16,60 @@
 #include <QLabel>
 #include <vsgQt/Window.h>
 #include <QObject>
-#include <spnav.h>
 #include <fmt/core.h>
 #include "myapp.h"
+#include "stlreader.h"
+#include "pointcloud.h"
+#include "spacemouse.h"
 
 using namespace std;
 
-// Constructor
-MyApp::MyApp(int argc, char *argv[])
-  : QApplication(argc, argv)
+// Set up vsg::Options to pass in filepaths, ReaderWriters and other IO
+// related options to use when reading and writing files.
+vsg::ref_ptr<vsg::Options> createReaderOptions(vsg::CommandLine& arguments)
 {
-    bool hasSpnav = true;
-    if(spnav_open() == -1)
-        hasSpnav = false;
-
-    vsg::CommandLine arguments(&argc, argv);
-
-    // set up vsg::Options to pass in filepaths, ReaderWriters and other IO
-    // related options to use when reading and writing files.
     auto options = vsg::Options::create();
     options->fileCache = vsg::getEnv("VSG_FILE_CACHE");
     options->paths = vsg::getEnvPaths("VSG_FILE_PATH");
+
+    // The models that are loaded side by side share their equal
+    // textures, pipelines and state
+    options->sharedObjects = vsg::SharedObjects::create();
+
+    // The native STL reader takes precedence over the one in vsgXchange
+    auto stlReader = STLReader::create();
+    arguments.read("--crease-angle", stlReader->creaseAngle);
+    options->add(stlReader);
+
+    // Before vsgXchange, which would read the PLY files of points as
+    // meshes without faces
+    auto pointCloudReader = PointCloudReader::create();
+    arguments.read("--point-error", pointCloudReader->errorPixels);
+    arguments.read("--point-node-size", pointCloudReader->maxNodePoints);
+    options->add(pointCloudReader);
     options->add(vsgXchange::all::create());
 
     arguments.read(options);
+    return options;
+}
+
+// Constructor
+MyApp::MyApp(int argc, char *argv[])
+  : QApplication(argc, argv)
+{
+    vsg::CommandLine arguments(&argc, argv);
+    auto options = createReaderOptions(arguments);
     auto settings = make_shared<QSettings>("qtvsgviewer", "qtvsgviewer");
 
     auto mainWindow = new MainWindow(arguments, options, settings, *this);
 
     mainWindow->show();
 
-    if (hasSpnav)
-    {
-        // Poll for spnav events and forward them to the trackball
-        QTimer *timer = new QTimer();
-        QObject::connect(timer, &QTimer::timeout, [mainWindow]() {
-            double dx = 0, dy = 0, dz = 0, xrot = 0, yrot = 0, zrot = 0;
-      
-            spnav_event event;
-            if ( spnav_poll_event(&event) > 0)
-            {
-                if (event.type == SPNAV_EVENT_MOTION)
-                {
-                    dx = 0.0005* event.motion.x;
-                    dy = -0.0005* event.motion.y;
-                    dz = -0.0005* event.motion.z;
-                    xrot = -0.0005* event.motion.rx;
-                    yrot = -0.0005* event.motion.ry;
-                    zrot = 0.0005* event.motion.rz;
-                }
-#if 0
-                if (swapyz)
-                {
-                    std::swap(dy, dz);
-                    dy = -dy;
-                    std::swap(yrot, zrot);
-                }
-#endif
-      
-                // Don't accumulate events
-                spnav_remove_events(SPNAV_EVENT_MOTION);
-
-                mainWindow->updateTrackball(
-                  dx,dy,dz,xrot,yrot,zrot);
-            }
-      
-        });
-        timer->start(20);
-    }
-
+    // The spacemouse events are read as soon as they arrive and are
+    // applied by the viewer once per frame
+    auto spaceMouse = new SpaceMouse(this);
+    if (spaceMouse->isOpen())
+        mainWindow->setSpaceMouse(spaceMouse);
 
 }
 
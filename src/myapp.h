@@ -10,6 +10,10 @@
 #include <QApplication>
 #include "mainwindow.h"
 
+// The options with the model readers. Also used by the modes that
+// run without a window.
+vsg::ref_ptr<vsg::Options> createReaderOptions(vsg::CommandLine& arguments);
+
 class MyApp : public QApplication
 {
   Q_OBJECT
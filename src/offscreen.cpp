@@ -0,0 +1,262 @@
+//======================================================================
+//  offscreen.cpp - Render a scene without a window
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "offscreen.h"
+#include "viewpoints.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+using namespace std;
+
+static const VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+static const VkFormat DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+
+static vsg::ref_ptr<vsg::ImageView> createAttachment(vsg::Device *device,
+                                                     uint32_t width, uint32_t height,
+                                                     VkFormat format,
+                                                     VkImageUsageFlags usage,
+                                                     VkImageAspectFlags aspect)
+{
+    auto image = vsg::Image::create();
+    image->imageType = VK_IMAGE_TYPE_2D;
+    image->format = format;
+    image->extent = VkExtent3D{width, height, 1};
+    image->mipLevels = 1;
+    image->arrayLayers = 1;
+    image->samples = VK_SAMPLE_COUNT_1_BIT;
+    image->tiling = VK_IMAGE_TILING_OPTIMAL;
+    image->usage = usage;
+    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    return vsg::createImageView(device, image, aspect);
+}
+
+// Unlike vsg::createRenderPass() the color attachment ends up ready
+// to be copied from, as there is no swapchain to present it to.
+static vsg::ref_ptr<vsg::RenderPass> createRenderPass(vsg::Device *device)
+{
+    auto colorAttachment = vsg::defaultColorAttachment(COLOR_FORMAT);
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    auto depthAttachment = vsg::defaultDepthAttachment(DEPTH_FORMAT);
+    vsg::RenderPass::Attachments attachments{colorAttachment, depthAttachment};
+
+    vsg::AttachmentReference colorReference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    vsg::AttachmentReference depthReference = {1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+    vsg::RenderPass::Subpasses subpasses(1);
+    subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[0].colorAttachments.emplace_back(colorReference);
+    subpasses[0].depthStencilAttachments.emplace_back(depthReference);
+
+    vsg::RenderPass::Dependencies dependencies(2);
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+        | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dependencyFlags = 0;
+
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    dependencies[1].dependencyFlags = 0;
+
+    return vsg::RenderPass::create(device, attachments, subpasses, dependencies);
+}
+
+// constructor
+OffscreenRenderer::OffscreenRenderer(uint32_t width, uint32_t height, bool debugLayer)
+  : m_width(width),
+    m_height(height)
+{
+    vsg::Names instanceExtensions;
+    vsg::Names requestedLayers;
+    if (debugLayer)
+    {
+        instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        requestedLayers.push_back("VK_LAYER_KHRONOS_validation");
+    }
+    auto layers = vsg::validateInstancelayerNames(requestedLayers);
+
+    try
+    {
+        m_instance = vsg::Instance::create(instanceExtensions, layers);
+
+        // Prefer real GPUs, but fall back to software drivers
+        auto [physicalDevice, queueFamily] = m_instance->getPhysicalDeviceAndQueueFamily(
+            VK_QUEUE_GRAPHICS_BIT,
+            {VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU,
+             VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU,
+             VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU,
+             VK_PHYSICAL_DEVICE_TYPE_CPU});
+        if (!physicalDevice || queueFamily < 0)
+        {
+            spdlog::error("No Vulkan device with graphics support");
+            return;
+        }
+        m_physicalDevice = physicalDevice;
+        m_queueFamily = queueFamily;
+
+        vsg::QueueSettings queueSettings{vsg::QueueSetting{queueFamily, {1.0}}};
+        m_device = vsg::Device::create(physicalDevice, queueSettings, layers, vsg::Names{});
+    }
+    catch (const vsg::Exception& e)
+    {
+        spdlog::error("Failed creating a Vulkan device: {}", e.message);
+        m_device = nullptr;
+        return;
+    }
+
+    m_colorImageView = createAttachment(m_device, width, height, COLOR_FORMAT,
+                                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                                        VK_IMAGE_ASPECT_COLOR_BIT);
+    m_depthImageView = createAttachment(m_device, width, height, DEPTH_FORMAT,
+                                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                                        VK_IMAGE_ASPECT_DEPTH_BIT);
+    m_framebuffer = vsg::Framebuffer::create(createRenderPass(m_device),
+                                             vsg::ImageViews{m_colorImageView, m_depthImageView},
+                                             width, height, 1);
+
+    m_lookAt = vsg::LookAt::create();
+    m_perspective = vsg::Perspective::create(30.0, double(width)/height,
+                                             framingNear(1.0), framingFar(1.0));
+    m_camera = vsg::Camera::create(m_perspective, m_lookAt,
+                                   vsg::ViewportState::create(0, 0, width, height));
+
+    m_sceneRoot = vsg::Group::create();
+    m_view = vsg::View::create(m_camera);
+    m_view->addChild(vsg::createHeadlight());
+    m_view->addChild(m_sceneRoot);
+
+    m_renderGraph = vsg::RenderGraph::create();
+    m_renderGraph->framebuffer = m_framebuffer;
+    m_renderGraph->renderArea.offset = {0, 0};
+    m_renderGraph->renderArea.extent = {width, height};
+    m_renderGraph->setClearValues({{0.2f, 0.2f, 0.4f, 1.0f}}, VkClearDepthStencilValue{0.0f, 0});
+    m_renderGraph->addChild(m_view);
+
+    // The copy to a readback buffer, that is only recorded for the
+    // frames that ask for it. The render pass leaves the image in
+    // the transfer source layout.
+    VkBufferImageCopy region = {};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {width, height, 1};
+    m_copyImage = vsg::CopyImageToBuffer::create();
+    m_copyImage->srcImage = m_colorImageView->image;
+    m_copyImage->srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    m_copyImage->regions.push_back(region);
+
+    auto hostBarrier = vsg::MemoryBarrier::create();
+    hostBarrier->srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    hostBarrier->dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    m_readbackBarrier = vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                     VK_PIPELINE_STAGE_HOST_BIT,
+                                                     0, hostBarrier);
+
+    m_commandGraph = vsg::CommandGraph::create(m_device, m_queueFamily);
+    m_commandGraph->addChild(m_renderGraph);
+
+    m_viewer = vsg::Viewer::create();
+    m_viewer->addRecordAndSubmitTaskAndPresentation({m_commandGraph});
+}
+
+std::string OffscreenRenderer::deviceName() const
+{
+    if (!m_physicalDevice)
+        return "";
+    return m_physicalDevice->getProperties().deviceName;
+}
+
+void OffscreenRenderer::setCamera(const vsg::LookAt& lookAt, double radius)
+{
+    m_lookAt->eye = lookAt.eye;
+    m_lookAt->center = lookAt.center;
+    m_lookAt->up = lookAt.up;
+    m_perspective->nearDistance = framingNear(radius);
+    m_perspective->farDistance = framingFar(radius);
+}
+
+bool OffscreenRenderer::renderFrame(vsg::ref_ptr<vsg::Buffer> readback)
+{
+    if (!m_viewer->advanceToNextFrame())
+        return false;
+
+    m_commandGraph->children = {m_renderGraph};
+    if (readback)
+    {
+        m_copyImage->dstBuffer = readback;
+        m_commandGraph->addChild(m_copyImage);
+        m_commandGraph->addChild(m_readbackBarrier);
+    }
+
+    m_viewer->handleEvents();
+    m_viewer->update();
+    m_viewer->recordAndSubmit();
+
+    // There is no presentation, so wait for the frame here
+    m_viewer->deviceWaitIdle();
+    return true;
+}
+
+vsg::ref_ptr<vsg::Data> OffscreenRenderer::mapImage(vsg::ref_ptr<vsg::Buffer> readback)
+{
+    auto memory = readback->getDeviceMemory(m_device->deviceID);
+    return vsg::MappedData<vsg::ubvec4Array2D>::create(memory,
+                                                       readback->getMemoryOffset(m_device->deviceID),
+                                                       0,
+                                                       vsg::Data::Properties{COLOR_FORMAT},
+                                                       m_width, m_height);
+}
+
+// constructor
+ReadbackPool::ReadbackPool(vsg::ref_ptr<vsg::Device> device, VkDeviceSize size, size_t maxBuffers)
+  : m_device(device),
+    m_size(size),
+    m_maxBuffers(std::max(size_t(1), maxBuffers))
+{
+}
+
+vsg::ref_ptr<vsg::Buffer> ReadbackPool::acquire()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_released.wait(lock, [&] { return !m_free.empty() || m_numCreated < m_maxBuffers; });
+
+    if (!m_free.empty())
+    {
+        auto buffer = m_free.back();
+        m_free.pop_back();
+        return buffer;
+    }
+
+    m_numCreated++;
+    return vsg::createBufferAndMemory(m_device, m_size,
+                                      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_SHARING_MODE_EXCLUSIVE,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+void ReadbackPool::release(vsg::ref_ptr<vsg::Buffer> buffer)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(buffer);
+    }
+    m_released.notify_all();
+}
+
+void ReadbackPool::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_released.wait(lock, [&] { return m_free.size() == m_numCreated; });
+}
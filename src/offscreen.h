@@ -0,0 +1,98 @@
+//======================================================================
+//  offscreen.h - Render a scene without a window
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+#include <vsg/all.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Renders to an image of its own with a device that doesn't need a
+// surface, so it works with software drivers like lavapipe and on
+// machines without a display.
+class OffscreenRenderer
+{
+public:
+    OffscreenRenderer(uint32_t width, uint32_t height, bool debugLayer = false);
+
+    // False if no Vulkan device with graphics support was found
+    bool valid() const { return m_device.valid(); }
+    std::string deviceName() const;
+
+    vsg::ref_ptr<vsg::Device> device() { return m_device; }
+    vsg::ref_ptr<vsg::Viewer> viewer() { return m_viewer; }
+    vsg::ref_ptr<vsg::Camera> camera() { return m_camera; }
+    vsg::ref_ptr<vsg::Perspective> perspective() { return m_perspective; }
+    vsg::ref_ptr<vsg::View> view() { return m_view; }
+
+    // The models are rendered below a headlight
+    vsg::ref_ptr<vsg::Group> sceneRoot() { return m_sceneRoot; }
+
+    // Look at a model framed by radius from lookAt
+    void setCamera(const vsg::LookAt& lookAt, double radius);
+
+    // Render a frame and wait until the GPU has finished it. If
+    // readback is given the image is copied to it. Returns false if
+    // the viewer is no longer active.
+    bool renderFrame(vsg::ref_ptr<vsg::Buffer> readback = {});
+
+    // The size of a readback buffer, and a view of the image in one.
+    // The view keeps the buffer mapped while it is alive.
+    VkDeviceSize imageSize() const { return VkDeviceSize(m_width) * m_height * 4; }
+    vsg::ref_ptr<vsg::Data> mapImage(vsg::ref_ptr<vsg::Buffer> readback);
+
+private:
+    uint32_t m_width, m_height;
+    vsg::ref_ptr<vsg::Instance> m_instance;
+    vsg::ref_ptr<vsg::PhysicalDevice> m_physicalDevice;
+    vsg::ref_ptr<vsg::Device> m_device;
+    int m_queueFamily = -1;
+    vsg::ref_ptr<vsg::ImageView> m_colorImageView;
+    vsg::ref_ptr<vsg::ImageView> m_depthImageView;
+    vsg::ref_ptr<vsg::Framebuffer> m_framebuffer;
+    vsg::ref_ptr<vsg::RenderGraph> m_renderGraph;
+    vsg::ref_ptr<vsg::CommandGraph> m_commandGraph;
+    vsg::ref_ptr<vsg::CopyImageToBuffer> m_copyImage;
+    vsg::ref_ptr<vsg::PipelineBarrier> m_readbackBarrier;
+    vsg::ref_ptr<vsg::Viewer> m_viewer;
+    vsg::ref_ptr<vsg::Camera> m_camera;
+    vsg::ref_ptr<vsg::View> m_view;
+    vsg::ref_ptr<vsg::Perspective> m_perspective;
+    vsg::ref_ptr<vsg::LookAt> m_lookAt;
+    vsg::ref_ptr<vsg::Group> m_sceneRoot;
+};
+
+// Host visible buffers that the rendered images are copied to. They
+// are recycled instead of allocated for every image, and their
+// number is bounded so that a slow consumer holds up the rendering.
+class ReadbackPool
+{
+public:
+    ReadbackPool(vsg::ref_ptr<vsg::Device> device, VkDeviceSize size, size_t maxBuffers);
+
+    // Blocks while all the buffers are in use
+    vsg::ref_ptr<vsg::Buffer> acquire();
+    void release(vsg::ref_ptr<vsg::Buffer> buffer);
+
+    // Wait until all the buffers have been released
+    void waitIdle();
+
+    size_t numCreated() const { return m_numCreated; }
+
+private:
+    vsg::ref_ptr<vsg::Device> m_device;
+    VkDeviceSize m_size;
+    size_t m_maxBuffers;
+    size_t m_numCreated = 0;
+    std::vector<vsg::ref_ptr<vsg::Buffer>> m_free;
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+};
+
+#endif /* OFFSCREEN */
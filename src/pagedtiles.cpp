@@ -0,0 +1,717 @@
+//======================================================================
+//  pagedtiles.cpp - Paged databases of spatial tiles of large models
+//
+//  The triangles are split at the medians of their centroids into a
+//  tree with up to eight children per tile. The tree is written
+//  bottom up, so that only the simplified geometry of the children of
+//  the tiles on the current path is kept in memory besides the model.
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "pagedtiles.h"
+#include "simplify.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <unordered_map>
+
+using namespace std;
+
+std::string TileSettings::defaultDirectory()
+{
+    return (QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + "/qtvsgviewer/tiles").toStdString();
+}
+
+std::string TileSettings::key() const
+{
+    if (!enabled)
+        return "";
+    return fmt::format("tiles{}_{}", maxTriangles, switchRatio);
+}
+
+static std::string databaseDirectory(const TileSettings& settings, const std::string& key)
+{
+    return (settings.directory.empty() ? TileSettings::defaultDirectory() : settings.directory)
+        + "/" + key;
+}
+
+// A mesh of the model that is tiled
+struct SourceMesh
+{
+    std::vector<vsg::ref_ptr<vsg::StateCommand>> stateCommands; // Of all the state groups above it
+    vsg::dmat4 matrix;
+    vsg::ref_ptr<vsg::VertexIndexDraw> draw;
+    vsg::ref_ptr<vsg::vec3Array> positions;
+    vector<uint32_t> indices;
+};
+
+// The vertex arrays of the readers that the tiles copy their
+// vertices from
+template<class A>
+static vsg::ref_ptr<vsg::Data> copyAs(const vsg::Data& data, const vector<uint32_t>& sources)
+{
+    auto array = data.cast<A>();
+    if (!array || array->stride() != sizeof(typename A::value_type))
+        return {};
+    auto copy = A::create(uint32_t(sources.size()));
+    copy->properties.format = array->properties.format;
+    for (size_t i = 0; i < sources.size(); i++)
+        (*copy)[i] = (*array)[sources[i]];
+    return copy;
+}
+
+static vsg::ref_ptr<vsg::Data> copyVertices(const vsg::Data& data, const vector<uint32_t>& sources)
+{
+    vsg::ref_ptr<vsg::Data> copy;
+    if (!copy) copy = copyAs<vsg::vec2Array>(data, sources);
+    if (!copy) copy = copyAs<vsg::vec3Array>(data, sources);
+    if (!copy) copy = copyAs<vsg::vec4Array>(data, sources);
+    if (!copy) copy = copyAs<vsg::ubvec4Array>(data, sources);
+    return copy;
+}
+
+static bool isTriangleList(const vsg::GraphicsPipeline& pipeline)
+{
+    for (auto& state : pipeline.pipelineStates)
+        if (auto ias = state->cast<vsg::InputAssemblyState>())
+            return ias->topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    return false;
+}
+
+// Find the triangle meshes that can be tiled, with the state and the
+// transform that they are drawn with
+class TileMeshCollector : public vsg::Visitor
+{
+public:
+    vector<vsg::dmat4> matrixStack{vsg::dmat4()};
+    vector<vsg::StateGroup*> stateStack;
+    vector<SourceMesh> meshes;
+    std::set<vsg::Node*> tiled;
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::MatrixTransform& transform) override
+    {
+        matrixStack.push_back(matrixStack.back() * transform.matrix);
+        transform.traverse(*this);
+        matrixStack.pop_back();
+    }
+
+    void apply(vsg::StateGroup& sg) override
+    {
+        stateStack.push_back(&sg);
+        sg.traverse(*this);
+        stateStack.pop_back();
+    }
+
+    // The meshes below nodes that choose between their children stay
+    // in the model. They also aren't below a vsg::Group, from which
+    // RemoveTiled removes the tiled ones.
+    void apply(vsg::Switch&) override {}
+    void apply(vsg::LOD&) override {}
+    void apply(vsg::PagedLOD&) override {}
+    void apply(vsg::CullNode&) override {}
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        SourceMesh mesh;
+        const vsg::GraphicsPipeline *pipeline = nullptr;
+        for (auto sg : stateStack)
+        {
+            for (auto& sc : sg->stateCommands)
+            {
+                if (auto bgp = sc->cast<vsg::BindGraphicsPipeline>())
+                    pipeline = bgp->pipeline;
+                mesh.stateCommands.push_back(sc);
+            }
+        }
+        if (!pipeline || !isTriangleList(*pipeline)
+            || vid.instanceCount != 1 || vid.firstIndex != 0 || vid.vertexOffset != 0
+            || vid.arrays.empty() || !vid.indices || !vid.indices->data)
+            return;
+
+        // The positions are the first array by convention
+        mesh.positions = vid.arrays[0]->data.cast<vsg::vec3Array>();
+        if (!mesh.positions || mesh.positions->stride() != sizeof(vsg::vec3))
+            return;
+        size_t numVertices = mesh.positions->size();
+        for (auto& info : vid.arrays)
+            if (!info || !info->data
+                || (info->data->valueCount() == numVertices && !copyVertices(*info->data, {})))
+                return;
+
+        auto data = vid.indices->data;
+        if (auto ui = data->cast<vsg::uintArray>())
+            mesh.indices.assign(ui->begin(), ui->begin() + std::min<size_t>(vid.indexCount, ui->size()));
+        else if (auto us = data->cast<vsg::ushortArray>())
+            mesh.indices.assign(us->begin(), us->begin() + std::min<size_t>(vid.indexCount, us->size()));
+        else
+            return;
+        mesh.indices.resize(mesh.indices.size() / 3 * 3);
+        if (mesh.indices.empty()
+            || !std::all_of(mesh.indices.begin(), mesh.indices.end(),
+                            [&](uint32_t i) { return i < numVertices; }))
+            return;
+
+        mesh.matrix = matrixStack.back();
+        mesh.draw = &vid;
+        meshes.push_back(std::move(mesh));
+        tiled.insert(&vid);
+    }
+};
+
+// Remove the tiled meshes from the model, which leaves the parts that
+// stay in the root
+class RemoveTiled : public vsg::Visitor
+{
+public:
+    const std::set<vsg::Node*>& tiled;
+    size_t numLeft = 0; // Draws that are left
+
+    RemoveTiled(const std::set<vsg::Node*>& tiled_) : tiled(tiled_) {}
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::Group& group) override
+    {
+        auto& children = group.children;
+        children.erase(std::remove_if(children.begin(), children.end(),
+                                      [&](const vsg::ref_ptr<vsg::Node>& child) { return tiled.count(child.get()) > 0; }),
+                       children.end());
+        group.traverse(*this);
+    }
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        if (!tiled.count(&vid))
+            numLeft++;
+    }
+
+    void apply(vsg::VertexDraw&) override { numLeft++; }
+    void apply(vsg::Geometry&) override { numLeft++; }
+};
+
+struct TileTriangle
+{
+    uint32_t mesh;
+    uint32_t triangle;
+    vsg::vec3 centroid;
+};
+
+// The triangles of one source mesh in a tile, with vertices of their own
+struct TilePart
+{
+    uint32_t mesh;
+    vector<uint32_t> vertices; // Of the source mesh
+    vector<uint32_t> indices;  // Into vertices
+};
+using TileGeometry = vector<TilePart>;
+
+static size_t numTriangles(const TileGeometry& geometry)
+{
+    size_t count = 0;
+    for (auto& part : geometry)
+        count += part.indices.size() / 3;
+    return count;
+}
+
+// Renumber the vertices of part in the order they are used, and drop
+// those that aren't
+static void compactPart(TilePart& part)
+{
+    vector<uint32_t> remap(part.vertices.size(), UINT32_MAX);
+    vector<uint32_t> vertices;
+    for (auto& i : part.indices)
+    {
+        if (remap[i] == UINT32_MAX)
+        {
+            remap[i] = uint32_t(vertices.size());
+            vertices.push_back(part.vertices[i]);
+        }
+        i = remap[i];
+    }
+    part.vertices = std::move(vertices);
+}
+
+class TileBuilder
+{
+public:
+    TileBuilder(const TileSettings& settings_,
+                const std::string& directory_,
+                vector<SourceMesh>& meshes_,
+                vector<TileTriangle>& triangles_,
+                const std::atomic<bool> *canceled_) :
+        settings(settings_),
+        directory(directory_),
+        meshes(meshes_),
+        triangles(triangles_),
+        canceled(canceled_) {}
+
+    const TileSettings& settings;
+    std::string directory;
+    vector<SourceMesh>& meshes;
+    vector<TileTriangle>& triangles;
+    const std::atomic<bool> *canceled;
+    size_t numFiles = 0;
+    double maxFileBytes = 0;
+    bool failed = false;
+
+    struct Tile
+    {
+        vsg::ref_ptr<vsg::Node> entry; // CullGroup or PagedLOD
+        TileGeometry lowres;           // Full resolution in the finest tiles
+        vsg::dbox bounds;
+    };
+
+    // The tile of the triangles between begin and end
+    Tile build(size_t begin, size_t end)
+    {
+        Tile tile;
+        if (failed || (canceled && *canceled))
+        {
+            failed = true;
+            return tile;
+        }
+
+        if (end - begin <= settings.maxTriangles)
+        {
+            tile.lowres = leafGeometry(begin, end);
+            tile.bounds = geometryBounds(tile.lowres);
+            auto cullGroup = vsg::CullGroup::create(sphere(tile.bounds));
+            cullGroup->addChild(createNode(tile.lowres));
+            tile.entry = cullGroup;
+            return tile;
+        }
+
+        // Up to three levels of median splits at once
+        int levels = int(std::ceil(std::log2(double(end - begin) / settings.maxTriangles)));
+        vector<pair<size_t, size_t>> ranges;
+        split(begin, end, std::clamp(levels, 1, 3), ranges);
+
+        auto highres = vsg::Group::create();
+        TileGeometry merged;
+        for (auto& [childBegin, childEnd] : ranges)
+        {
+            auto child = build(childBegin, childEnd);
+            if (failed)
+                return tile;
+            highres->addChild(child.entry);
+            tile.bounds.add(child.bounds);
+            merge(merged, child.lowres);
+        }
+
+        auto filename = fmt::format("{}/tile_{}.vsgb", directory, numFiles++);
+        if (!write(highres, filename))
+            return tile;
+
+        tile.lowres = simplify(merged);
+        auto plod = vsg::PagedLOD::create();
+        plod->bound = sphere(tile.bounds);
+        plod->filename = filename;
+        plod->children[0] = vsg::PagedLOD::Child{settings.switchRatio, {}};
+        plod->children[1] = vsg::PagedLOD::Child{0.0, createNode(tile.lowres)};
+        tile.entry = plod;
+        return tile;
+    }
+
+    bool write(vsg::ref_ptr<vsg::Node> node, const std::string& filename)
+    {
+        auto options = vsg::Options::create();
+        options->extensionHint = ".vsgb";
+        vsg::VSG vsgWriter;
+        if (!vsgWriter.write(node, filename, options))
+        {
+            spdlog::error("Failed writing tile {}", filename);
+            failed = true;
+            return false;
+        }
+        maxFileBytes = std::max(maxFileBytes, double(QFileInfo(QString::fromStdString(filename)).size()));
+        return true;
+    }
+
+private:
+    static vsg::dsphere sphere(const vsg::dbox& box)
+    {
+        return vsg::dsphere((box.min + box.max) * 0.5, vsg::length(box.max - box.min) * 0.5);
+    }
+
+    void split(size_t begin, size_t end, int levels, vector<pair<size_t, size_t>>& ranges)
+    {
+        if (levels == 0 || end - begin < 2)
+        {
+            ranges.push_back({begin, end});
+            return;
+        }
+        vsg::box box;
+        for (size_t i = begin; i < end; i++)
+            box.add(triangles[i].centroid);
+        vsg::vec3 extent = box.max - box.min;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+        size_t mid = begin + (end - begin) / 2;
+        std::nth_element(triangles.begin() + begin, triangles.begin() + mid, triangles.begin() + end,
+                         [axis](const TileTriangle& a, const TileTriangle& b) {
+                             return a.centroid[axis] < b.centroid[axis];
+                         });
+        split(begin, mid, levels - 1, ranges);
+        split(mid, end, levels - 1, ranges);
+    }
+
+    TileGeometry leafGeometry(size_t begin, size_t end)
+    {
+        std::sort(triangles.begin() + begin, triangles.begin() + end,
+                  [](const TileTriangle& a, const TileTriangle& b) {
+                      return a.mesh < b.mesh || (a.mesh == b.mesh && a.triangle < b.triangle);
+                  });
+        TileGeometry geometry;
+        std::unordered_map<uint32_t, uint32_t> local;
+        for (size_t i = begin; i < end; i++)
+        {
+            auto& t = triangles[i];
+            if (geometry.empty() || geometry.back().mesh != t.mesh)
+            {
+                geometry.push_back({t.mesh, {}, {}});
+                local.clear();
+            }
+            auto& part = geometry.back();
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t v = meshes[t.mesh].indices[size_t(t.triangle) * 3 + k];
+                auto [it, inserted] = local.try_emplace(v, uint32_t(part.vertices.size()));
+                if (inserted)
+                    part.vertices.push_back(v);
+                part.indices.push_back(it->second);
+            }
+        }
+        return geometry;
+    }
+
+    // Add the parts of geometry to merged, sharing the vertices that
+    // the parts of the same mesh have in common
+    void merge(TileGeometry& merged, const TileGeometry& geometry)
+    {
+        for (auto& part : geometry)
+        {
+            auto it = std::find_if(merged.begin(), merged.end(),
+                                   [&](const TilePart& p) { return p.mesh == part.mesh; });
+            if (it == merged.end())
+            {
+                merged.push_back(part);
+                continue;
+            }
+            std::unordered_map<uint32_t, uint32_t> local;
+            for (size_t i = 0; i < it->vertices.size(); i++)
+                local[it->vertices[i]] = uint32_t(i);
+            for (auto i : part.indices)
+            {
+                uint32_t v = part.vertices[i];
+                auto [l, inserted] = local.try_emplace(v, uint32_t(it->vertices.size()));
+                if (inserted)
+                    it->vertices.push_back(v);
+                it->indices.push_back(l->second);
+            }
+        }
+    }
+
+    // Simplify the parts of geometry together to about maxTriangles,
+    // each by the same fraction
+    TileGeometry simplify(TileGeometry& geometry)
+    {
+        size_t total = numTriangles(geometry);
+        if (total <= settings.maxTriangles)
+            return std::move(geometry);
+
+        TileGeometry simplified;
+        for (auto& part : geometry)
+        {
+            size_t target = part.indices.size() / 3 * settings.maxTriangles / total;
+            if (target == 0)
+                continue;
+            auto& positions = *meshes[part.mesh].positions;
+            vector<vsg::vec3> partPositions(part.vertices.size());
+            for (size_t i = 0; i < part.vertices.size(); i++)
+                partPositions[i] = positions[part.vertices[i]];
+
+            TilePart result{part.mesh, std::move(part.vertices), {}};
+            if (!simplifyMesh(partPositions.data(), partPositions.size(), part.indices, target,
+                              result.indices, canceled))
+            {
+                failed = true;
+                return {};
+            }
+            if (result.indices.empty())
+                continue;
+            compactPart(result);
+            simplified.push_back(std::move(result));
+        }
+        return simplified;
+    }
+
+    vsg::dbox geometryBounds(const TileGeometry& geometry)
+    {
+        vsg::dbox bounds;
+        for (auto& part : geometry)
+        {
+            auto& mesh = meshes[part.mesh];
+            for (auto v : part.vertices)
+                bounds.add(mesh.matrix * vsg::dvec3((*mesh.positions)[v]));
+        }
+        return bounds;
+    }
+
+    // The scene graph of geometry, with the state and the transforms of
+    // the source meshes
+    vsg::ref_ptr<vsg::Node> createNode(const TileGeometry& geometry)
+    {
+        auto group = vsg::Group::create();
+        for (auto& part : geometry)
+        {
+            auto& mesh = meshes[part.mesh];
+            size_t numVertices = mesh.positions->size();
+
+            vsg::DataList arrays;
+            for (auto& info : mesh.draw->arrays)
+            {
+                if (info->data->valueCount() == numVertices)
+                    arrays.push_back(copyVertices(*info->data, part.vertices));
+                else
+                    arrays.push_back(info->data);
+            }
+            auto draw = vsg::VertexIndexDraw::create();
+            draw->firstBinding = mesh.draw->firstBinding;
+            draw->assignArrays(arrays);
+            if (part.vertices.size() <= 65536)
+            {
+                auto indices = vsg::ushortArray::create(uint32_t(part.indices.size()));
+                std::copy(part.indices.begin(), part.indices.end(), indices->begin());
+                draw->assignIndices(indices);
+            }
+            else
+            {
+                auto indices = vsg::uintArray::create(uint32_t(part.indices.size()));
+                std::copy(part.indices.begin(), part.indices.end(), indices->begin());
+                draw->assignIndices(indices);
+            }
+            draw->indexCount = uint32_t(part.indices.size());
+            draw->instanceCount = 1;
+
+            auto sg = vsg::StateGroup::create();
+            sg->stateCommands = mesh.stateCommands;
+            sg->addChild(draw);
+            if (mesh.matrix == vsg::dmat4())
+            {
+                group->addChild(sg);
+                continue;
+            }
+            auto transform = vsg::MatrixTransform::create(mesh.matrix);
+            transform->addChild(sg);
+            group->addChild(transform);
+        }
+        return group;
+    }
+};
+
+bool convertToTiles(vsg::Node& model,
+                    const std::string& key,
+                    const TileSettings& settings,
+                    const std::atomic<bool> *canceled)
+{
+    TileMeshCollector collector;
+    model.accept(collector);
+
+    size_t total = 0;
+    for (auto& mesh : collector.meshes)
+        total += mesh.indices.size() / 3;
+    if (total <= settings.maxTriangles || settings.maxTriangles == 0)
+        return false;
+
+    auto t0 = vsg::clock::now();
+    vector<TileTriangle> triangles;
+    triangles.reserve(total);
+    for (size_t m = 0; m < collector.meshes.size(); m++)
+    {
+        auto& mesh = collector.meshes[m];
+        auto& positions = *mesh.positions;
+        vsg::mat4 matrix(mesh.matrix);
+        for (size_t t = 0; t < mesh.indices.size() / 3; t++)
+        {
+            vsg::vec3 centroid = (positions[mesh.indices[t*3]] + positions[mesh.indices[t*3+1]]
+                                  + positions[mesh.indices[t*3+2]]) / 3.0f;
+            triangles.push_back({uint32_t(m), uint32_t(t), matrix * centroid});
+        }
+    }
+
+    auto directory = databaseDirectory(settings, key);
+    QDir().mkpath(QString::fromStdString(directory));
+    TileBuilder builder(settings, directory, collector.meshes, triangles, canceled);
+    auto rootTile = builder.build(0, triangles.size());
+    if (builder.failed)
+        return false;
+
+    auto root = vsg::Group::create();
+    root->addChild(rootTile.entry);
+    RemoveTiled remove(collector.tiled);
+    model.accept(remove);
+    if (remove.numLeft > 0)
+        root->addChild(vsg::ref_ptr<vsg::Node>(&model));
+    root->setValue("tileBytes", builder.maxFileBytes);
+
+    // The root is written last and renamed into place, so that a
+    // database with a root is complete
+    auto rootPath = directory + "/root.vsgb";
+    auto tmpPath = directory + "/root.tmp.vsgb";
+    if (!builder.write(root, tmpPath) || std::rename(tmpPath.c_str(), rootPath.c_str()) != 0)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    spdlog::info("Converted {} triangles into {} tile files of at most {:.1f} MB in {:.0f} ms",
+                 total, builder.numFiles, builder.maxFileBytes / (1024.0 * 1024.0),
+                 std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count());
+    return true;
+}
+
+// The pager reads the tiles with the options of their PagedLOD. Those
+// of the root get the reader options, and so their shared objects,
+// which share the state of the tiles between the files.
+class AssignTileOptions : public vsg::Visitor
+{
+public:
+    vsg::ref_ptr<vsg::Options> options;
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::PagedLOD& plod) override
+    {
+        plod.options = options;
+        plod.traverse(*this);
+    }
+};
+
+vsg::ref_ptr<vsg::Node> readTiles(const std::string& key,
+                                  const TileSettings& settings,
+                                  vsg::ref_ptr<const vsg::Options> options)
+{
+    auto rootPath = databaseDirectory(settings, key) + "/root.vsgb";
+    if (!QFileInfo::exists(QString::fromStdString(rootPath)))
+        return {};
+
+    auto root = vsg::read_cast<vsg::Node>(rootPath, options);
+    if (!root)
+    {
+        spdlog::warn("Failed reading the tiles {}", rootPath);
+        return {};
+    }
+
+    AssignTileOptions assignOptions;
+    assignOptions.options = options ? vsg::Options::create(*options) : vsg::Options::create();
+    root->accept(assignOptions);
+    return root;
+}
+
+void setTileBudget(vsg::DatabasePager& pager, uint64_t budget, double tileSize)
+{
+    if (tileSize <= 0)
+        return;
+    pager.targetMaxNumPagedLODWithHighResSubgraphs = uint32_t(std::clamp(double(budget) / tileSize, 1.0, 1e6));
+}
+
+// Request the high resolution children of the paged tiles that are
+// large on the screen as seen from eye
+class PrefetchTiles : public vsg::Visitor
+{
+public:
+    vsg::dvec3 eye;
+    double tanHalfFovy = 1.0;
+    vsg::DatabasePager *pager = nullptr;
+    vector<vsg::dmat4> matrixStack{vsg::dmat4()};
+    size_t numRequested = 0;
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::MatrixTransform& transform) override
+    {
+        matrixStack.push_back(matrixStack.back() * transform.matrix);
+        transform.traverse(*this);
+        matrixStack.pop_back();
+    }
+
+    // The draws and the state, that hold no tiles
+    void apply(vsg::Command&) override {}
+
+    void apply(vsg::PagedLOD& plod) override
+    {
+        auto& matrix = matrixStack.back();
+        vsg::dvec3 center = matrix * plod.bound.center;
+        double radius = plod.bound.radius * vsg::length(vsg::dvec3(matrix[0][0], matrix[0][1], matrix[0][2]));
+        double distance = vsg::length(center - eye);
+        double ratio = distance > radius ? radius / (distance * tanHalfFovy) : 1e6;
+        if (ratio <= plod.children[0].minimumScreenHeightRatio)
+            return;
+
+        if (plod.children[0].node)
+        {
+            plod.children[0].node->accept(*this);
+            return;
+        }
+
+        // Behind the tiles that the view needs now
+        plod.priority = ratio * 0.5;
+        pager->request(vsg::ref_ptr<vsg::PagedLOD>(&plod));
+        numRequested++;
+    }
+};
+
+void TilePrefetcher::apply(vsg::FrameEvent& frame)
+{
+    auto perspective = m_camera->projectionMatrix.cast<vsg::Perspective>();
+    if (!perspective)
+        return;
+    vsg::dvec3 eye = vsg::inverse(m_camera->viewMatrix->transform()) * vsg::dvec3(0.0, 0.0, 0.0);
+    auto time = frame.time;
+
+    // The velocity is smoothed over a few frames
+    if (m_hasLast)
+    {
+        double dt = std::chrono::duration<double>(time - m_lastTime).count();
+        if (dt > 0.0)
+            m_velocity = m_velocity * 0.5 + (eye - m_lastEye) * (0.5 / dt);
+    }
+    m_hasLast = true;
+    m_lastEye = eye;
+    m_lastTime = time;
+
+    vsg::dvec3 offset = m_velocity * lookahead;
+    if (vsg::length(offset) < 1e-9 * std::max(1.0, vsg::length(eye)))
+        return;
+
+    PrefetchTiles prefetch;
+    prefetch.eye = eye + offset;
+    prefetch.tanHalfFovy = std::tan(vsg::radians(perspective->fieldOfViewY) * 0.5);
+    prefetch.pager = m_pager.get();
+    m_scene->accept(prefetch);
+    if (prefetch.numRequested > 0)
+        spdlog::debug("Prefetching {} tiles", prefetch.numRequested);
+}
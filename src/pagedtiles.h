@@ -0,0 +1,81 @@
+//======================================================================
+//  pagedtiles.h - Paged databases of spatial tiles of large models
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef PAGEDTILES_H
+#define PAGEDTILES_H
+
+#include <vsg/all.h>
+#include <atomic>
+#include <string>
+
+struct TileSettings
+{
+    bool enabled = false;
+    size_t maxTriangles = 250000; // Of a tile, and of the simplified ones
+    double switchRatio = 0.3;     // Screen height ratio of a tile where its children are paged in
+    std::string directory;        // Of the databases, defaultDirectory() if empty
+
+    // Default location of the tile databases, next to the model cache
+    static std::string defaultDirectory();
+
+    // A short string that identifies the settings, e.g. for cache keys
+    std::string key() const;
+};
+
+// The root of the tile database with key, or null if the model hasn't
+// been converted yet. The key is that of ModelCache::makeKey().
+vsg::ref_ptr<vsg::Node> readTiles(const std::string& key,
+                                  const TileSettings& settings,
+                                  vsg::ref_ptr<const vsg::Options> options);
+
+// Split the triangle meshes of model spatially into a hierarchy of
+// tiles of at most settings.maxTriangles triangles, and write them to
+// the database with key, whose root readTiles() then reads. Each tile
+// above the finest ones is a vsg::PagedLOD with a simplified version
+// of its children, which the database pager loads from their file
+// when the tile is large on the screen. The parts of the model that
+// can't be tiled stay in the root. Returns false if the model has too
+// few triangles to be tiled, or if the conversion failed or was
+// canceled. The model is modified.
+//
+// The root holds the size in bytes of its largest tile file as the
+// double value "tileBytes", from which the pager gets its budget.
+bool convertToTiles(vsg::Node& model,
+                    const std::string& key,
+                    const TileSettings& settings,
+                    const std::atomic<bool> *canceled = nullptr);
+
+// Limit the tiles that the pager keeps loaded to about budget, in the
+// unit of tileSize, e.g. bytes or points
+void setTileBudget(vsg::DatabasePager& pager, uint64_t budget, double tileSize);
+
+// Requests the tiles that the camera will need soon, by extrapolating
+// its motion lookahead seconds ahead, so that they are paged in before
+// they are looked at. The pager loads the tiles that are in view by
+// itself.
+class TilePrefetcher : public vsg::Inherit<vsg::Visitor, TilePrefetcher>
+{
+public:
+    TilePrefetcher(vsg::ref_ptr<vsg::Camera> camera,
+                   vsg::ref_ptr<vsg::Node> scene,
+                   vsg::ref_ptr<vsg::DatabasePager> pager) :
+        m_camera(camera), m_scene(scene), m_pager(pager) {}
+
+    double lookahead = 0.5; // s
+
+    void apply(vsg::FrameEvent& frame) override;
+
+private:
+    vsg::ref_ptr<vsg::Camera> m_camera;
+    vsg::ref_ptr<vsg::Node> m_scene;
+    vsg::ref_ptr<vsg::DatabasePager> m_pager;
+    bool m_hasLast = false;
+    vsg::dvec3 m_lastEye;
+    vsg::time_point m_lastTime;
+    vsg::dvec3 m_velocity;
+};
+
+#endif /* PAGEDTILES */
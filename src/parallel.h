@@ -0,0 +1,55 @@
+//======================================================================
+//  parallel.h - Simple data parallel loops
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// The number of chunks to split a loop of count items into, so that
+// no chunk is smaller than minChunk.
+inline size_t parallelChunkCount(size_t count, size_t minChunk = 4096)
+{
+    size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(numThreads, count / std::max<size_t>(1, minChunk)));
+}
+
+// Call func(chunk, begin, end) for numChunks consecutive ranges
+// covering [0, count), each on its own thread.
+template<typename F>
+void parallelForChunks(size_t numChunks, size_t count, F func)
+{
+    if (numChunks <= 1)
+    {
+        func(size_t(0), size_t(0), count);
+        return;
+    }
+
+    size_t chunkSize = (count + numChunks - 1) / numChunks;
+    std::vector<std::thread> threads;
+    for (size_t chunk = 1; chunk < numChunks; chunk++)
+    {
+        size_t begin = std::min(count, chunk * chunkSize);
+        size_t end = std::min(count, begin + chunkSize);
+        threads.emplace_back([&func, chunk, begin, end]() { func(chunk, begin, end); });
+    }
+    func(size_t(0), size_t(0), std::min(count, chunkSize));
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+// Call func(begin, end) over [0, count) split on all cores
+template<typename F>
+void parallelFor(size_t count, F func, size_t minChunk = 4096)
+{
+    parallelForChunks(parallelChunkCount(count, minChunk), count,
+                      [&func](size_t, size_t begin, size_t end) { func(begin, end); });
+}
+
+#endif /* PARALLEL */
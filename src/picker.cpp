@@ -0,0 +1,349 @@
+//======================================================================
+//  picker.cpp - Picking of points on the surface of the model
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "picker.h"
+#include "parallel.h"
+#include <spdlog/spdlog.h>
+#include <map>
+
+using namespace std;
+
+// The largest motion in pixels between the press and the release of
+// a click. A larger motion is a drag of the trackball.
+static const int32_t CLICK_SLOP = 3;
+
+static double elapsedMs(vsg::clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count();
+}
+
+// Find the meshes that are drawn as triangle lists
+class PickMeshCollector : public vsg::Visitor
+{
+public:
+    vector<vsg::dmat4> matrixStack{vsg::dmat4()};
+    vector<const vsg::GraphicsPipeline*> pipelineStack{nullptr};
+    vector<PickMesh> meshes;
+    map<vsg::Data*, vsg::ref_ptr<vsg::vec3Array>> decodedPositions;
+
+    // Of the bind commands that are followed by a vsg::DrawIndexed,
+    // e.g. those of the meshes that got levels of detail
+    vsg::ref_ptr<vsg::Data> boundPositions;
+    vsg::ref_ptr<vsg::Data> boundIndices;
+
+    // The wireframe switches hold the original pipeline first
+    static const vsg::GraphicsPipeline *getPipeline(const vsg::StateGroup& sg)
+    {
+        for (auto& sc : sg.stateCommands)
+        {
+            if (auto bgp = sc->cast<vsg::BindGraphicsPipeline>())
+                return bgp->pipeline;
+            if (auto stateSwitch = sc->cast<vsg::StateSwitch>())
+                for (auto& child : stateSwitch->children)
+                    if (auto bgp = child.stateCommand.cast<vsg::BindGraphicsPipeline>())
+                        return bgp->pipeline;
+        }
+        return nullptr;
+    }
+
+    bool isTriangleList() const
+    {
+        auto pipeline = pipelineStack.back();
+        if (!pipeline)
+            return false;
+        for (auto& state : pipeline->pipelineStates)
+            if (auto ias = state->cast<vsg::InputAssemblyState>())
+                return ias->topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        return false;
+    }
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::MatrixTransform& transform) override
+    {
+        matrixStack.push_back(matrixStack.back() * transform.matrix);
+        transform.traverse(*this);
+        matrixStack.pop_back();
+    }
+
+    void apply(vsg::StateGroup& sg) override
+    {
+        auto pipeline = getPipeline(sg);
+        pipelineStack.push_back(pipeline ? pipeline : pipelineStack.back());
+        sg.traverse(*this);
+        pipelineStack.pop_back();
+        boundPositions = {};
+        boundIndices = {};
+    }
+
+    // Only the models that are switched on
+    void apply(vsg::Switch& sw) override
+    {
+        for (auto& child : sw.children)
+            if (child.mask != vsg::MASK_OFF && child.node)
+                child.node->accept(*this);
+    }
+
+    // Only the finest level of detail
+    void apply(vsg::LOD& lod) override
+    {
+        if (!lod.children.empty() && lod.children[0].node)
+            lod.children[0].node->accept(*this);
+    }
+
+    // The quantized positions are decoded into the unit cube, that the
+    // transform above them maps to the bounds of the mesh
+    vsg::ref_ptr<vsg::vec3Array> getPositions(vsg::ref_ptr<vsg::Data> data)
+    {
+        if (auto positions = data.cast<vsg::vec3Array>())
+            return positions;
+        auto quantized = data.cast<vsg::usvec4Array>();
+        if (!quantized || quantized->properties.format != VK_FORMAT_R16G16B16A16_UNORM)
+            return {};
+        auto& decoded = decodedPositions[quantized.get()];
+        if (!decoded)
+        {
+            decoded = vsg::vec3Array::create(quantized->size());
+            for (size_t i = 0; i < quantized->size(); i++)
+            {
+                auto& q = (*quantized)[i];
+                (*decoded)[i] = vsg::vec3(q.x, q.y, q.z) / 65535.0f;
+            }
+        }
+        return decoded;
+    }
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        if (!isTriangleList() || vid.arrays.empty() || !vid.indices || !vid.indices->data)
+            return;
+        auto positions = getPositions(vid.arrays[0]->data);
+        if (!positions)
+            return;
+        meshes.push_back({matrixStack.back(), positions, vid.indices->data,
+                          vid.firstIndex, vid.indexCount});
+    }
+
+    void apply(vsg::BindVertexBuffers& bvb) override
+    {
+        if (bvb.firstBinding == 0 && !bvb.arrays.empty())
+            boundPositions = bvb.arrays[0]->data;
+    }
+
+    void apply(vsg::BindIndexBuffer& bib) override
+    {
+        if (bib.indices)
+            boundIndices = bib.indices->data;
+    }
+
+    void apply(vsg::DrawIndexed& di) override
+    {
+        if (!isTriangleList() || !boundPositions || !boundIndices || di.vertexOffset != 0)
+            return;
+        auto positions = getPositions(boundPositions);
+        if (!positions)
+            return;
+        meshes.push_back({matrixStack.back(), positions, boundIndices,
+                          di.firstIndex, di.indexCount});
+    }
+
+    void apply(vsg::VertexDraw& vd) override
+    {
+        if (!isTriangleList() || vd.arrays.empty())
+            return;
+        auto positions = getPositions(vd.arrays[0]->data);
+        if (!positions)
+            return;
+        meshes.push_back({matrixStack.back(), positions, {},
+                          vd.firstVertex, vd.vertexCount});
+    }
+};
+
+std::vector<PickMesh> collectPickMeshes(vsg::Node& node)
+{
+    PickMeshCollector collector;
+    node.accept(collector);
+    return std::move(collector.meshes);
+}
+
+bool buildPickBVH(const std::vector<PickMesh>& meshes,
+                  TriangleBVH& bvh,
+                  const std::atomic<bool> *canceled)
+{
+    // The vertices of the position arrays that several draws share
+    // are only transformed once
+    map<pair<const vsg::vec3Array*, vsg::dmat4>, uint32_t> vertexOffsets;
+    vector<vsg::vec3> vertices;
+    vector<uint32_t> indices;
+    for (auto& mesh : meshes)
+    {
+        if (canceled && *canceled)
+            return false;
+
+        auto& positions = *mesh.positions;
+        uint32_t numVertices = positions.size();
+        auto [it, inserted] = vertexOffsets.insert({{&positions, mesh.matrix}, uint32_t(vertices.size())});
+        uint32_t base = it->second;
+        if (inserted)
+        {
+            vertices.resize(base + numVertices);
+            const vsg::dmat4& matrix = mesh.matrix;
+            parallelFor(numVertices, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                    vertices[base + i] = vsg::vec3(matrix * vsg::dvec3(positions.at(i)));
+            });
+        }
+
+        // Indices outside of the vertices give degenerate triangles
+        uint32_t numIndices = mesh.indexCount - mesh.indexCount % 3;
+        size_t first = indices.size();
+        indices.resize(first + numIndices);
+        auto add = [&](auto&& getIndex) {
+            for (uint32_t i = 0; i < numIndices; i++)
+            {
+                uint32_t index = getIndex(mesh.firstIndex + i);
+                indices[first + i] = base + (index < numVertices ? index : 0);
+            }
+        };
+        if (!mesh.indices)
+            add([](uint32_t i) { return i; });
+        else if (auto ui = mesh.indices->cast<vsg::uintArray>())
+            add([&](uint32_t i) { return i < ui->size() ? ui->at(i) : 0u; });
+        else if (auto us = mesh.indices->cast<vsg::ushortArray>())
+            add([&](uint32_t i) { return i < us->size() ? uint32_t(us->at(i)) : 0u; });
+        else
+            indices.resize(first);
+    }
+
+    return bvh.build(std::move(vertices), std::move(indices), canceled);
+}
+
+class BuildPickBVHOperation : public vsg::Inherit<vsg::Operation, BuildPickBVHOperation>
+{
+public:
+    BuildPickBVHOperation(Picker *picker_,
+                          vsg::ref_ptr<PickJob> job_,
+                          std::vector<PickMesh>&& meshes_) :
+        picker(picker_),
+        job(job_),
+        meshes(std::move(meshes_)) {}
+
+    Picker *picker;
+    vsg::ref_ptr<PickJob> job;
+    std::vector<PickMesh> meshes;
+
+    void run() override
+    {
+        if (job->canceled)
+            return;
+
+        auto t0 = vsg::clock::now();
+        auto bvh = std::make_shared<TriangleBVH>();
+        if (!buildPickBVH(meshes, *bvh, &job->canceled))
+            return;
+
+        spdlog::info("Built the picking BVH of {} triangles with {} nodes in {:.0f} ms",
+                     bvh->numTriangles(), bvh->numNodes(), elapsedMs(t0));
+        picker->setBVH(job, bvh);
+    }
+};
+
+// constructor
+Picker::Picker()
+{
+    m_threads = vsg::OperationThreads::create(1);
+}
+
+Picker::~Picker()
+{
+    cancel();
+    m_threads->stop();
+}
+
+void Picker::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_current)
+        m_current->canceled = true;
+    m_current = nullptr;
+    m_bvh = nullptr;
+}
+
+void Picker::build(vsg::ref_ptr<vsg::Node> node)
+{
+    cancel();
+
+    auto job = PickJob::create();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current = job;
+    }
+    m_threads->add(BuildPickBVHOperation::create(this, job, collectPickMeshes(*node)));
+}
+
+void Picker::setBVH(vsg::ref_ptr<PickJob> job, std::shared_ptr<const TriangleBVH> bvh)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (job == m_current && !job->canceled)
+        m_bvh = bvh;
+}
+
+bool Picker::isReady() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bvh != nullptr;
+}
+
+bool Picker::pick(const vsg::dvec3& start, const vsg::dvec3& end, TriangleBVH::Hit& hit) const
+{
+    std::shared_ptr<const TriangleBVH> bvh;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bvh = m_bvh;
+    }
+    return bvh && bvh->intersect(start, end - start, hit, 1.0);
+}
+
+void PickHandler::apply(vsg::ButtonPressEvent& buttonPress)
+{
+    if (buttonPress.handled || buttonPress.button != 1)
+        return;
+
+    m_pressed = true;
+    m_pressX = buttonPress.x;
+    m_pressY = buttonPress.y;
+}
+
+void PickHandler::apply(vsg::ButtonReleaseEvent& buttonRelease)
+{
+    if (!m_pressed || buttonRelease.button != 1)
+        return;
+    m_pressed = false;
+
+    if (buttonRelease.handled
+        || std::abs(buttonRelease.x - m_pressX) > CLICK_SLOP
+        || std::abs(buttonRelease.y - m_pressY) > CLICK_SLOP)
+        return;
+
+    auto camera = cameraAt(buttonRelease.x, buttonRelease.y);
+    if (!camera)
+        return;
+    auto viewport = camera->getViewport();
+    if (viewport.width <= 0 || viewport.height <= 0)
+        return;
+    double ndcX = (buttonRelease.x - viewport.x) / viewport.width * 2.0 - 1.0;
+    double ndcY = (buttonRelease.y - viewport.y) / viewport.height * 2.0 - 1.0;
+
+    // The depth is reversed, so the near plane is at 1
+    auto inverse = vsg::inverse(camera->projectionMatrix->transform()
+                                * camera->viewMatrix->transform());
+    onPick(inverse * vsg::dvec3(ndcX, ndcY, 1.0),
+           inverse * vsg::dvec3(ndcX, ndcY, 0.0));
+}
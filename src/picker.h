@@ -0,0 +1,100 @@
+//======================================================================
+//  picker.h - Picking of points on the surface of the model
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef PICKER_H
+#define PICKER_H
+
+#include <vsg/all.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "bvh.h"
+
+// A triangle mesh of a scene with the transform to the scene root
+struct PickMesh
+{
+    vsg::dmat4 matrix;
+    vsg::ref_ptr<const vsg::vec3Array> positions;
+    vsg::ref_ptr<const vsg::Data> indices; // Sequential if null
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+// Collect the triangle lists of node, of the finest levels of detail.
+// Only references to the arrays are kept, so this is cheap, but node
+// must not be modified meanwhile.
+std::vector<PickMesh> collectPickMeshes(vsg::Node& node);
+
+// Build a BVH of the meshes in the coordinates of the scene root.
+// Returns false if canceled.
+bool buildPickBVH(const std::vector<PickMesh>& meshes,
+                  TriangleBVH& bvh,
+                  const std::atomic<bool> *canceled = nullptr);
+
+// The state of the building of the BVH of one scene
+class PickJob : public vsg::Inherit<vsg::Object, PickJob>
+{
+public:
+    std::atomic<bool> canceled{false};
+};
+
+// Builds the BVH of the loaded model in the background, and picks
+// the points on it.
+class Picker
+{
+public:
+    Picker();
+    ~Picker();
+
+    // Collect the meshes of node on the calling thread, which must
+    // own the scene, and build their BVH in the background. Picking
+    // is not possible until it is ready. Cancels the previous build.
+    void build(vsg::ref_ptr<vsg::Node> node);
+    void cancel();
+
+    bool isReady() const;
+
+    // The nearest point that the ray from start towards end hits
+    bool pick(const vsg::dvec3& start, const vsg::dvec3& end, TriangleBVH::Hit& hit) const;
+
+    // Called by the build thread
+    void setBVH(vsg::ref_ptr<PickJob> job, std::shared_ptr<const TriangleBVH> bvh);
+
+private:
+    vsg::ref_ptr<vsg::OperationThreads> m_threads;
+    mutable std::mutex m_mutex;
+    vsg::ref_ptr<PickJob> m_current;
+    std::shared_ptr<const TriangleBVH> m_bvh;
+};
+
+// Calls onPick with the ray through the mouse pointer, in the
+// coordinates of the scene root, when the left button is clicked
+// without dragging.
+class PickHandler : public vsg::Inherit<vsg::Visitor, PickHandler>
+{
+public:
+    using PickCallback = std::function<void(const vsg::dvec3& start, const vsg::dvec3& end)>;
+
+    // The camera of the view at the window coordinates of a click
+    using CameraLookup = std::function<vsg::ref_ptr<vsg::Camera>(int32_t x, int32_t y)>;
+
+    PickHandler(CameraLookup cameraAt_, PickCallback onPick_) :
+        cameraAt(cameraAt_), onPick(onPick_) {}
+
+    CameraLookup cameraAt;
+    PickCallback onPick;
+
+    void apply(vsg::ButtonPressEvent& buttonPress) override;
+    void apply(vsg::ButtonReleaseEvent& buttonRelease) override;
+
+private:
+    bool m_pressed = false;
+    int32_t m_pressX = 0, m_pressY = 0;
+};
+
+#endif /* PICKER */
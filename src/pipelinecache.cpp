@@ -0,0 +1,254 @@
+//======================================================================
+//  pipelinecache.cpp - A Vulkan pipeline cache that persists between runs
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "pipelinecache.h"
+#include "filehash.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+// Prepended to the data of the cache. The driver checks its own
+// header as well, but some drivers don't cope well with foreign or
+// truncated data, so it is validated before it is handed over.
+struct PipelineCacheFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t dataHash;
+};
+
+static const char PIPELINE_CACHE_MAGIC[4] = {'Q','V','P','C'};
+static const uint32_t PIPELINE_CACHE_VERSION = 1;
+
+static PipelineCacheFileHeader makeHeader(const VkPhysicalDeviceProperties& properties)
+{
+    PipelineCacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PIPELINE_CACHE_MAGIC, sizeof(header.magic));
+    header.version = PIPELINE_CACHE_VERSION;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
+
+PipelineCache& PipelineCache::instance()
+{
+    static PipelineCache cache;
+    return cache;
+}
+
+std::string PipelineCache::defaultPath(const std::string& settingsFilename)
+{
+    QFileInfo fi(QString::fromStdString(settingsFilename));
+    return (fi.absolutePath() + "/" + fi.completeBaseName() + "-pipelines.bin").toStdString();
+}
+
+bool PipelineCache::enableLayer()
+{
+    auto directory = vsg::filePath(vsg::executableFilePath());
+    auto manifest = directory / (PIPELINE_CACHE_LAYER_MANIFEST ".json");
+    if (!vsg::fileExists(manifest))
+    {
+        spdlog::warn("Missing the pipeline cache layer {}", manifest.string());
+        return false;
+    }
+
+    // VK_ADD_LAYER_PATH is searched in addition to the system paths,
+    // and needs Vulkan loader 1.3.234 or later
+    auto append = [](const char *name, const std::string& value) {
+        QByteArray list = qgetenv(name);
+        if (!list.isEmpty())
+            list += QDir::listSeparator().toLatin1();
+        qputenv(name, list + QByteArray::fromStdString(value));
+    };
+    append("VK_ADD_LAYER_PATH", directory.string());
+    append("VK_INSTANCE_LAYERS", PIPELINE_CACHE_LAYER_NAME);
+    return true;
+}
+
+bool PipelineCache::open(vsg::ref_ptr<vsg::Device> device, const std::string& path)
+{
+    close();
+
+    auto setDefaultCache = reinterpret_cast<PFN_vkSetDefaultPipelineCacheQTVSG>(
+        vkGetDeviceProcAddr(*device, "vkSetDefaultPipelineCacheQTVSG"));
+    auto getStats = reinterpret_cast<PFN_vkGetPipelineCreationStatsQTVSG>(
+        vkGetDeviceProcAddr(*device, "vkGetPipelineCreationStatsQTVSG"));
+    if (!setDefaultCache || !getStats)
+    {
+        spdlog::warn("The pipeline cache layer isn't loaded, so there is no pipeline cache");
+        return false;
+    }
+
+    if (path.empty())
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        m_device = device;
+        m_path.clear();
+        m_loadedSize = 0;
+        m_setDefaultCache = setDefaultCache;
+        m_getStats = getStats;
+        return true;
+    }
+
+    auto expected = makeHeader(device->getPhysicalDevice()->getProperties());
+
+    // Read the previous contents, if they belong to this device and driver
+    vector<char> data;
+    QFile file(QString::fromStdString(path));
+    if (file.open(QIODevice::ReadOnly))
+    {
+        PipelineCacheFileHeader header;
+        QByteArray contents = file.readAll();
+        if (size_t(contents.size()) >= sizeof(header))
+            memcpy(&header, contents.constData(), sizeof(header));
+        else
+            memset(&header, 0, sizeof(header));
+
+        const char *payload = contents.constData() + sizeof(header);
+        if (memcmp(&header, &expected, offsetof(PipelineCacheFileHeader, dataSize)) != 0)
+            spdlog::info("Ignoring pipeline cache {} of another device or driver", path);
+        else if (header.dataSize != uint64_t(contents.size()) - sizeof(header)
+                 || hashBytes(payload, header.dataSize) != header.dataHash)
+            spdlog::warn("Ignoring corrupt pipeline cache {}", path);
+        else
+            data.assign(payload, payload + header.dataSize);
+    }
+
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    VkPipelineCache cache;
+    VkResult result = vkCreatePipelineCache(*device, &createInfo, device->getAllocationCallbacks(), &cache);
+    if (result != VK_SUCCESS && !data.empty())
+    {
+        // Start over with an empty cache
+        spdlog::warn("The driver rejected the pipeline cache {}", path);
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        data.clear();
+        result = vkCreatePipelineCache(*device, &createInfo, device->getAllocationCallbacks(), &cache);
+    }
+    if (result != VK_SUCCESS)
+    {
+        spdlog::error("Failed creating a pipeline cache, result = {}", int(result));
+        return false;
+    }
+
+    setDefaultCache(*device, cache);
+
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    m_device = device;
+    m_cache = cache;
+    m_path = path;
+    m_loadedSize = data.size();
+    m_setDefaultCache = setDefaultCache;
+    m_getStats = getStats;
+
+    if (data.empty())
+        spdlog::info("Created an empty pipeline cache");
+    else
+        spdlog::info("Loaded pipeline cache {} ({} bytes)", path, data.size());
+    return true;
+}
+
+bool PipelineCache::save()
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    if (!m_cache)
+        return false;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(*m_device, m_cache, &size, nullptr) != VK_SUCCESS)
+        return false;
+    vector<char> data(size);
+    if (vkGetPipelineCacheData(*m_device, m_cache, &size, data.data()) != VK_SUCCESS)
+        return false;
+    data.resize(size);
+
+    auto header = makeHeader(m_device->getPhysicalDevice()->getProperties());
+    header.dataSize = data.size();
+    header.dataHash = hashBytes(data.data(), data.size());
+
+    // QSaveFile replaces the old file only once everything is written
+    QDir().mkpath(QFileInfo(QString::fromStdString(m_path)).absolutePath());
+    QSaveFile file(QString::fromStdString(m_path));
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header))
+        || file.write(data.data(), qint64(data.size())) != qint64(data.size())
+        || !file.commit())
+    {
+        spdlog::warn("Failed writing pipeline cache {}", m_path);
+        return false;
+    }
+
+    uint64_t numCreated = 0;
+    double createTime = 0;
+    m_getStats(*m_device, &numCreated, &createTime);
+    spdlog::info("Saved pipeline cache {} ({} bytes). Created {} pipelines in {:.0f} ms",
+                 m_path, data.size(), numCreated, createTime);
+    return true;
+}
+
+void PipelineCache::close()
+{
+    save();
+
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    if (m_cache)
+    {
+        m_setDefaultCache(*m_device, VK_NULL_HANDLE);
+        vkDestroyPipelineCache(*m_device, m_cache, m_device->getAllocationCallbacks());
+    }
+    m_cache = VK_NULL_HANDLE;
+    m_device = nullptr;
+    m_setDefaultCache = nullptr;
+    m_getStats = nullptr;
+}
+
+size_t PipelineCache::numCreated() const
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    uint64_t numCreated = 0;
+    double createTime = 0;
+    if (m_getStats)
+        m_getStats(*m_device, &numCreated, &createTime);
+    return size_t(numCreated);
+}
+
+double PipelineCache::createTime() const
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    uint64_t numCreated = 0;
+    double createTime = 0;
+    if (m_getStats)
+        m_getStats(*m_device, &numCreated, &createTime);
+    return createTime;
+}
+
+size_t PipelineCache::loadedSize() const
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    return m_loadedSize;
+}
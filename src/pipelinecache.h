@@ -0,0 +1,62 @@
+//======================================================================
+//  pipelinecache.h - A Vulkan pipeline cache that persists between runs
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+
+#include <vsg/all.h>
+#include "pipelinecachelayer.h"
+#include <mutex>
+#include <string>
+
+// vsg creates its graphics pipelines without a VkPipelineCache and
+// has no way of passing one, so the cache is handed to the driver by
+// the Vulkan layer of pipelinecachelayer.cpp, which also times the
+// creation of the pipelines. Only the pipelines of the device that the
+// cache was opened for use it.
+class PipelineCache
+{
+public:
+    static PipelineCache& instance();
+
+    // The cache file next to the settings file
+    static std::string defaultPath(const std::string& settingsFilename);
+
+    // Let the Vulkan loader find the layer next to the executable and
+    // enable it for the instances that are created afterwards. Returns
+    // false if the layer isn't there, in which case the cache isn't
+    // used and no pipelines are counted.
+    static bool enableLayer();
+
+    // Create the cache of device, with the contents of path if it was
+    // saved by the same device and driver. If path is empty no cache
+    // is created, and the pipelines of device are only counted.
+    bool open(vsg::ref_ptr<vsg::Device> device, const std::string& path);
+
+    // Write the cache back to the path it was opened with
+    bool save();
+
+    // Save and destroy the cache
+    void close();
+
+    // Statistics of the pipeline creation of the device of the cache
+    size_t numCreated() const;
+    double createTime() const;  // ms
+    size_t loadedSize() const;
+
+private:
+    PipelineCache() = default;
+
+    mutable std::mutex m_mutex;
+    vsg::ref_ptr<vsg::Device> m_device;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    std::string m_path;
+    size_t m_loadedSize = 0;
+    PFN_vkSetDefaultPipelineCacheQTVSG m_setDefaultCache = nullptr;
+    PFN_vkGetPipelineCreationStatsQTVSG m_getStats = nullptr;
+};
+
+#endif /* PIPELINECACHE */
@@ -0,0 +1,296 @@
+//======================================================================
+//  pipelinecachelayer.cpp - A Vulkan layer that adds a pipeline cache
+//
+//  vsg creates its graphics pipelines without a VkPipelineCache and
+//  has no way of passing one. This layer sits between vsg and the
+//  driver and passes the cache of PipelineCache instead. It is only
+//  loaded when PipelineCache::enableLayer() enables it, and only
+//  changes the calls that don't pass a cache of their own.
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "pipelinecachelayer.h"
+#include <vulkan/vk_layer.h>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+#ifdef _WIN32
+#define LAYER_EXPORT extern "C" __declspec(dllexport)
+#else
+#define LAYER_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace {
+
+struct InstanceData
+{
+    PFN_vkGetInstanceProcAddr getInstanceProcAddr = nullptr;
+    PFN_vkDestroyInstance destroyInstance = nullptr;
+};
+
+struct DeviceData
+{
+    PFN_vkGetDeviceProcAddr getDeviceProcAddr = nullptr;
+    PFN_vkDestroyDevice destroyDevice = nullptr;
+    PFN_vkCreateGraphicsPipelines createGraphicsPipelines = nullptr;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    uint64_t numCreated = 0;
+    double createTime = 0; // ms
+};
+
+// The dispatchable handles of the same instance or device start with
+// the same pointer to the loader's dispatch table
+template<class T>
+void *dispatchKey(T handle)
+{
+    return *reinterpret_cast<void**>(handle);
+}
+
+std::mutex layerMutex;
+std::map<void*, InstanceData> instances;
+std::map<void*, DeviceData> devices;
+
+DeviceData *findDevice(VkDevice device)
+{
+    auto it = devices.find(dispatchKey(device));
+    return it == devices.end() ? nullptr : &it->second;
+}
+
+// The link to the next layer or the driver in the create info
+template<class LinkInfo>
+LinkInfo *findLinkInfo(const void *next, VkStructureType type)
+{
+    auto info = static_cast<LinkInfo*>(const_cast<void*>(next));
+    while (info && !(info->sType == type && info->function == VK_LAYER_LINK_INFO))
+        info = static_cast<LinkInfo*>(const_cast<void*>(info->pNext));
+    return info;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL
+CreateInstance(const VkInstanceCreateInfo *pCreateInfo,
+               const VkAllocationCallbacks *pAllocator,
+               VkInstance *pInstance)
+{
+    auto link = findLinkInfo<VkLayerInstanceCreateInfo>(pCreateInfo->pNext,
+                                                        VK_STRUCTURE_TYPE_LOADER_INSTANCE_CREATE_INFO);
+    if (!link)
+        return VK_ERROR_INITIALIZATION_FAILED;
+
+    auto getInstanceProcAddr = link->u.pLayerInfo->pfnNextGetInstanceProcAddr;
+    link->u.pLayerInfo = link->u.pLayerInfo->pNext;
+    auto createInstance = reinterpret_cast<PFN_vkCreateInstance>(
+        getInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance"));
+    if (!createInstance)
+        return VK_ERROR_INITIALIZATION_FAILED;
+
+    VkResult result = createInstance(pCreateInfo, pAllocator, pInstance);
+    if (result != VK_SUCCESS)
+        return result;
+
+    InstanceData data;
+    data.getInstanceProcAddr = getInstanceProcAddr;
+    data.destroyInstance = reinterpret_cast<PFN_vkDestroyInstance>(
+        getInstanceProcAddr(*pInstance, "vkDestroyInstance"));
+    std::scoped_lock<std::mutex> lock(layerMutex);
+    instances[dispatchKey(*pInstance)] = data;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL
+DestroyInstance(VkInstance instance, const VkAllocationCallbacks *pAllocator)
+{
+    if (instance == VK_NULL_HANDLE)
+        return;
+
+    InstanceData data;
+    {
+        std::scoped_lock<std::mutex> lock(layerMutex);
+        auto it = instances.find(dispatchKey(instance));
+        if (it == instances.end())
+            return;
+        data = it->second;
+        instances.erase(it);
+    }
+    if (data.destroyInstance)
+        data.destroyInstance(instance, pAllocator);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL
+CreateDevice(VkPhysicalDevice physicalDevice,
+             const VkDeviceCreateInfo *pCreateInfo,
+             const VkAllocationCallbacks *pAllocator,
+             VkDevice *pDevice)
+{
+    auto link = findLinkInfo<VkLayerDeviceCreateInfo>(pCreateInfo->pNext,
+                                                      VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO);
+    if (!link)
+        return VK_ERROR_INITIALIZATION_FAILED;
+
+    auto getInstanceProcAddr = link->u.pLayerInfo->pfnNextGetInstanceProcAddr;
+    auto getDeviceProcAddr = link->u.pLayerInfo->pfnNextGetDeviceProcAddr;
+    link->u.pLayerInfo = link->u.pLayerInfo->pNext;
+    auto createDevice = reinterpret_cast<PFN_vkCreateDevice>(
+        getInstanceProcAddr(VK_NULL_HANDLE, "vkCreateDevice"));
+    if (!createDevice)
+        return VK_ERROR_INITIALIZATION_FAILED;
+
+    VkResult result = createDevice(physicalDevice, pCreateInfo, pAllocator, pDevice);
+    if (result != VK_SUCCESS)
+        return result;
+
+    DeviceData data;
+    data.getDeviceProcAddr = getDeviceProcAddr;
+    data.destroyDevice = reinterpret_cast<PFN_vkDestroyDevice>(
+        getDeviceProcAddr(*pDevice, "vkDestroyDevice"));
+    data.createGraphicsPipelines = reinterpret_cast<PFN_vkCreateGraphicsPipelines>(
+        getDeviceProcAddr(*pDevice, "vkCreateGraphicsPipelines"));
+    std::scoped_lock<std::mutex> lock(layerMutex);
+    devices[dispatchKey(*pDevice)] = data;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL
+DestroyDevice(VkDevice device, const VkAllocationCallbacks *pAllocator)
+{
+    if (device == VK_NULL_HANDLE)
+        return;
+
+    PFN_vkDestroyDevice destroyDevice = nullptr;
+    {
+        std::scoped_lock<std::mutex> lock(layerMutex);
+        auto it = devices.find(dispatchKey(device));
+        if (it == devices.end())
+            return;
+        destroyDevice = it->second.destroyDevice;
+        devices.erase(it);
+    }
+    if (destroyDevice)
+        destroyDevice(device, pAllocator);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL
+CreateGraphicsPipelines(VkDevice device,
+                        VkPipelineCache pipelineCache,
+                        uint32_t createInfoCount,
+                        const VkGraphicsPipelineCreateInfo *pCreateInfos,
+                        const VkAllocationCallbacks *pAllocator,
+                        VkPipeline *pPipelines)
+{
+    PFN_vkCreateGraphicsPipelines next = nullptr;
+    {
+        std::scoped_lock<std::mutex> lock(layerMutex);
+        auto data = findDevice(device);
+        if (!data || !data->createGraphicsPipelines)
+            return VK_ERROR_INITIALIZATION_FAILED;
+        next = data->createGraphicsPipelines;
+        if (pipelineCache == VK_NULL_HANDLE)
+            pipelineCache = data->cache;
+    }
+
+    // The cache is internally synchronized, so the pipelines of
+    // several threads are created concurrently
+    auto t0 = std::chrono::steady_clock::now();
+    VkResult result = next(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::scoped_lock<std::mutex> lock(layerMutex);
+    if (auto data = findDevice(device))
+    {
+        data->numCreated += createInfoCount;
+        data->createTime += ms;
+    }
+    return result;
+}
+
+VKAPI_ATTR void VKAPI_CALL
+SetDefaultPipelineCacheQTVSG(VkDevice device, VkPipelineCache cache)
+{
+    std::scoped_lock<std::mutex> lock(layerMutex);
+    if (auto data = findDevice(device))
+        data->cache = cache;
+}
+
+VKAPI_ATTR void VKAPI_CALL
+GetPipelineCreationStatsQTVSG(VkDevice device, uint64_t *numCreated, double *createTime)
+{
+    std::scoped_lock<std::mutex> lock(layerMutex);
+    auto data = findDevice(device);
+    *numCreated = data ? data->numCreated : 0;
+    *createTime = data ? data->createTime : 0.0;
+}
+
+#define LAYER_FUNCTION(name) \
+    if (strcmp(pName, "vk" #name) == 0) \
+        return reinterpret_cast<PFN_vkVoidFunction>(&name)
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice device, const char *pName);
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+GetInstanceProcAddr(VkInstance instance, const char *pName)
+{
+    LAYER_FUNCTION(GetInstanceProcAddr);
+    LAYER_FUNCTION(CreateInstance);
+    LAYER_FUNCTION(DestroyInstance);
+    LAYER_FUNCTION(CreateDevice);
+    LAYER_FUNCTION(GetDeviceProcAddr);
+    LAYER_FUNCTION(DestroyDevice);
+    LAYER_FUNCTION(CreateGraphicsPipelines);
+
+    if (instance == VK_NULL_HANDLE)
+        return nullptr;
+    PFN_vkGetInstanceProcAddr next = nullptr;
+    {
+        std::scoped_lock<std::mutex> lock(layerMutex);
+        auto it = instances.find(dispatchKey(instance));
+        if (it != instances.end())
+            next = it->second.getInstanceProcAddr;
+    }
+    return next ? next(instance, pName) : nullptr;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+GetDeviceProcAddr(VkDevice device, const char *pName)
+{
+    LAYER_FUNCTION(GetDeviceProcAddr);
+    LAYER_FUNCTION(DestroyDevice);
+    LAYER_FUNCTION(CreateGraphicsPipelines);
+    LAYER_FUNCTION(SetDefaultPipelineCacheQTVSG);
+    LAYER_FUNCTION(GetPipelineCreationStatsQTVSG);
+
+    if (device == VK_NULL_HANDLE)
+        return nullptr;
+    PFN_vkGetDeviceProcAddr next = nullptr;
+    {
+        std::scoped_lock<std::mutex> lock(layerMutex);
+        if (auto data = findDevice(device))
+            next = data->getDeviceProcAddr;
+    }
+    return next ? next(device, pName) : nullptr;
+}
+
+}
+
+// The only entry point that the loader looks up in the library. The
+// rest of the functions are handed over here.
+LAYER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL
+vkNegotiateLoaderLayerInterfaceVersion(VkNegotiateLayerInterface *pVersionStruct)
+{
+    if (!pVersionStruct || pVersionStruct->sType != LAYER_NEGOTIATE_INTERFACE_STRUCT)
+        return VK_ERROR_INITIALIZATION_FAILED;
+
+    if (pVersionStruct->loaderLayerInterfaceVersion > 2)
+        pVersionStruct->loaderLayerInterfaceVersion = 2;
+    if (pVersionStruct->loaderLayerInterfaceVersion < 2)
+        return VK_ERROR_INITIALIZATION_FAILED;
+
+    pVersionStruct->pfnGetInstanceProcAddr = GetInstanceProcAddr;
+    pVersionStruct->pfnGetDeviceProcAddr = GetDeviceProcAddr;
+    pVersionStruct->pfnGetPhysicalDeviceProcAddr = nullptr;
+    return VK_SUCCESS;
+}
@@ -0,0 +1,32 @@
+//======================================================================
+//  pipelinecachelayer.h - The interface of the pipeline cache layer
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef PIPELINECACHELAYER_H
+#define PIPELINECACHELAYER_H
+
+#include <vulkan/vulkan.h>
+
+// The name of the Vulkan layer, and of its manifest file without the
+// .json extension
+#define PIPELINE_CACHE_LAYER_NAME "VK_LAYER_QTVSG_pipeline_cache"
+#define PIPELINE_CACHE_LAYER_MANIFEST "VkLayer_qtvsg_pipeline_cache"
+
+// The functions of the layer, that the application gets through
+// vkGetDeviceProcAddr() by their names. They are null if the layer
+// isn't enabled.
+
+// Create the graphics pipelines of device with cache where the caller
+// doesn't pass a cache, which vsg never does. VK_NULL_HANDLE unsets it.
+typedef void (VKAPI_PTR *PFN_vkSetDefaultPipelineCacheQTVSG)(VkDevice device,
+                                                              VkPipelineCache cache);
+
+// The number of graphics pipelines that have been created for device,
+// and the time in ms that it took
+typedef void (VKAPI_PTR *PFN_vkGetPipelineCreationStatsQTVSG)(VkDevice device,
+                                                               uint64_t *numCreated,
+                                                               double *createTime);
+
+#endif /* PIPELINECACHELAYER */
@@ -0,0 +1,1205 @@
+//======================================================================
+//  pointcloud.cpp - Streaming of large point clouds through an octree
+//
+//  The octree is built in the way of Potree. The points are counted
+//  on a coarse grid, which is split into chunks of at most a few
+//  million points. The points are then distributed to a temporary
+//  file per chunk, and the subtree of each chunk is built in memory.
+//  The nodes above the chunks finally take a sample of the points of
+//  their children.
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "pointcloud.h"
+#include "modelcache.h"
+#include "modelloader.h"
+#include "bounds.h"
+#include "parallel.h"
+#include "tracing.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+using namespace std;
+
+static const int SAMPLE_GRID = 128;               // Cells per axis of the sampling of a node
+static const int COUNT_LEVEL = 7;                 // Of the counting grid, 128^3 cells
+static const size_t MAX_CHUNK_POINTS = 4000000;   // Built in memory at once
+static const size_t WRITE_BUFFER_POINTS = 4096;   // Per chunk, while distributing
+static const int MAX_DEPTH = 24;                  // Below which duplicate points stay together
+static const double REFERENCE_HEIGHT = 1080;      // px, of the switch ratios
+
+std::string PointCloudReader::defaultDirectory()
+{
+    return (QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + "/qtvsgviewer/pointclouds").toStdString();
+}
+
+std::string PointCloudReader::key() const
+{
+    return fmt::format("points{}_{}", maxNodePoints, errorPixels);
+}
+
+bool isPointCloudFile(const std::string& filename)
+{
+    auto ext = vsg::lowerCaseFileExtension(filename);
+    return ext == ".xyz" || ext == ".pts" || ext == ".las";
+}
+
+bool PointCloudReader::getFeatures(Features& features) const
+{
+    for (auto ext : {".xyz", ".pts", ".las", ".ply"})
+        features.extensionFeatureMap[ext] = vsg::ReaderWriter::READ_FILENAME;
+    return true;
+}
+
+// The uniform of the point sizes and the descriptor set that holds
+// it, which are shared by all the point clouds
+struct PointState
+{
+    vsg::ref_ptr<vsg::vec4Array> params; // viewport height, size scale, min and max size
+    vsg::ref_ptr<vsg::DescriptorSet> descriptorSet;
+    vsg::ref_ptr<vsg::PipelineLayout> layout;
+    vsg::ref_ptr<vsg::GraphicsPipeline> pipeline;
+
+    PointState();
+};
+
+static const char *POINT_VERTEX_GLSL =
+    "#version 450\n"
+    "\n"
+    "layout(push_constant) uniform PushConstants {\n"
+    "    mat4 projection;\n"
+    "    mat4 modelView;\n"
+    "} pc;\n"
+    "\n"
+    "layout(set = 0, binding = 0) uniform PointParams {\n"
+    "    vec4 params;\n"
+    "} point;\n"
+    "\n"
+    "layout(location = 0) in vec3 vsg_Vertex;\n"
+    "layout(location = 1) in vec4 vsg_Color;\n"
+    "layout(location = 2) in float point_spacing;\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "out gl_PerVertex {\n"
+    "    vec4 gl_Position;\n"
+    "    float gl_PointSize;\n"
+    "};\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = pc.projection * pc.modelView * vec4(vsg_Vertex, 1.0);\n"
+    "\n"
+    "    // The spacing in pixels, which works for the orthographic\n"
+    "    // projections as well, whose w is 1\n"
+    "    float spacing = point_spacing * length(pc.modelView[0].xyz);\n"
+    "    float pixels = spacing * abs(pc.projection[1][1]) * 0.5 * point.params.x / gl_Position.w;\n"
+    "    gl_PointSize = clamp(pixels * point.params.y, point.params.z, point.params.w);\n"
+    "    color = vsg_Color;\n"
+    "}\n";
+
+static const char *POINT_FRAGMENT_GLSL =
+    "#version 450\n"
+    "\n"
+    "layout(location = 0) in vec4 color;\n"
+    "layout(location = 0) out vec4 outColor;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 offset = gl_PointCoord * 2.0 - 1.0;\n"
+    "    if (dot(offset, offset) > 1.0)\n"
+    "        discard;\n"
+    "    outColor = color;\n"
+    "}\n";
+
+PointState::PointState()
+{
+    params = vsg::vec4Array::create(1);
+    params->properties.dataVariance = vsg::DYNAMIC_DATA;
+    (*params)[0] = vsg::vec4(float(REFERENCE_HEIGHT), 1.0f, 1.0f, 16.0f);
+    auto setLayout = vsg::DescriptorSetLayout::create(vsg::DescriptorSetLayoutBindings{
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr}});
+    descriptorSet = vsg::DescriptorSet::create(setLayout, vsg::Descriptors{
+        vsg::DescriptorBuffer::create(params, 0, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)});
+    layout = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{setLayout},
+                                         vsg::PushConstantRanges{{VK_SHADER_STAGE_VERTEX_BIT, 0, 128}});
+
+    vsg::ShaderStages stages{
+        vsg::ShaderStage::create(VK_SHADER_STAGE_VERTEX_BIT, "main", POINT_VERTEX_GLSL),
+        vsg::ShaderStage::create(VK_SHADER_STAGE_FRAGMENT_BIT, "main", POINT_FRAGMENT_GLSL)};
+
+    auto vertexInput = vsg::VertexInputState::create(
+        vsg::VertexInputState::Bindings{
+            {0, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX},
+            {1, sizeof(vsg::ubvec4), VK_VERTEX_INPUT_RATE_VERTEX},
+            {2, sizeof(float), VK_VERTEX_INPUT_RATE_INSTANCE}},
+        vsg::VertexInputState::Attributes{
+            {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+            {1, 1, VK_FORMAT_R8G8B8A8_UNORM, 0},
+            {2, 2, VK_FORMAT_R32_SFLOAT, 0}});
+    auto rasterization = vsg::RasterizationState::create();
+    rasterization->cullMode = VK_CULL_MODE_NONE;
+    vsg::GraphicsPipelineStates states{
+        vertexInput,
+        vsg::InputAssemblyState::create(VK_PRIMITIVE_TOPOLOGY_POINT_LIST),
+        rasterization,
+        vsg::MultisampleState::create(),
+        vsg::ColorBlendState::create(),
+        vsg::DepthStencilState::create()};
+    pipeline = vsg::GraphicsPipeline::create(layout, stages, states);
+}
+
+static PointState& pointState()
+{
+    static PointState state;
+    return state;
+}
+
+void setPointSize(float scale, float minPixels, float maxPixels)
+{
+    auto& params = *pointState().params;
+    params[0].y = scale;
+    params[0].z = minPixels;
+    params[0].w = maxPixels;
+    params.dirty();
+}
+
+void setPointCloudViewportHeight(float height)
+{
+    auto& params = *pointState().params;
+    if (params[0].x == height)
+        return;
+    params[0].x = height;
+    params.dirty();
+}
+
+// A point as it is stored in the temporary files and in the octree,
+// relative to the center of the octree
+struct OctreePoint
+{
+    vsg::vec3 position;
+    vsg::ubvec4 color;
+};
+
+// A locale independent parsing of a double. Returns the position
+// after the number, or p if there was no number.
+static const char *parseDouble(const char *p, const char *end, double& value)
+{
+    const char *start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int numDigits = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, numDigits++)
+    {
+        if (mantissa < 1000000000000000000ULL)
+            mantissa = mantissa*10 + (*p - '0');
+        else
+            exponent++;
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, numDigits++)
+        {
+            if (mantissa < 1000000000000000000ULL)
+            {
+                mantissa = mantissa*10 + (*p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (numDigits == 0)
+        return start;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        bool expNegative = false;
+        if (q < end && (*q == '-' || *q == '+'))
+            expNegative = (*q++ == '-');
+        int e = 0;
+        const char *digits = q;
+        for (; q < end && *q >= '0' && *q <= '9'; q++)
+            e = std::min(e*10 + (*q - '0'), 1000);
+        if (q > digits)
+        {
+            exponent += expNegative ? -e : e;
+            p = q;
+        }
+    }
+
+    double v = double(mantissa) * std::pow(10.0, exponent);
+    value = negative ? -v : v;
+    return p;
+}
+
+// Parse the numbers of the line that starts at p into values, and
+// return the start of the next line
+static const char *parseLine(const char *p, const char *end, vector<double>& values)
+{
+    values.clear();
+    while (p < end && *p != '\n')
+    {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == ',' || *p == ';')
+        {
+            p++;
+            continue;
+        }
+        double value;
+        const char *next = parseDouble(p, end, value);
+        if (next == p)
+        {
+            // Skip the words, e.g. of comments
+            while (p < end && *p != '\n' && *p != ' ' && *p != '\t')
+                p++;
+            continue;
+        }
+        values.push_back(value);
+        p = next;
+    }
+    return p < end ? p + 1 : end;
+}
+
+enum class PlyType { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+static bool parsePlyType(const string& name, PlyType& type, size_t& size)
+{
+    static const vector<tuple<const char *, PlyType, size_t>> types{
+        {"char", PlyType::INT8, 1}, {"int8", PlyType::INT8, 1},
+        {"uchar", PlyType::UINT8, 1}, {"uint8", PlyType::UINT8, 1},
+        {"short", PlyType::INT16, 2}, {"int16", PlyType::INT16, 2},
+        {"ushort", PlyType::UINT16, 2}, {"uint16", PlyType::UINT16, 2},
+        {"int", PlyType::INT32, 4}, {"int32", PlyType::INT32, 4},
+        {"uint", PlyType::UINT32, 4}, {"uint32", PlyType::UINT32, 4},
+        {"float", PlyType::FLOAT32, 4}, {"float32", PlyType::FLOAT32, 4},
+        {"double", PlyType::FLOAT64, 8}, {"float64", PlyType::FLOAT64, 8}};
+    for (auto& [n, t, s] : types)
+    {
+        if (name == n)
+        {
+            type = t;
+            size = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class T>
+static T readBinary(const uint8_t *p, bool bigEndian)
+{
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, p, sizeof(T));
+    if (bigEndian)
+        std::reverse(bytes, bytes + sizeof(T));
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+static double readPlyValue(const uint8_t *p, PlyType type, bool bigEndian)
+{
+    switch (type)
+    {
+    case PlyType::INT8: return double(int8_t(*p));
+    case PlyType::UINT8: return double(*p);
+    case PlyType::INT16: return double(readBinary<int16_t>(p, bigEndian));
+    case PlyType::UINT16: return double(readBinary<uint16_t>(p, bigEndian));
+    case PlyType::INT32: return double(readBinary<int32_t>(p, bigEndian));
+    case PlyType::UINT32: return double(readBinary<uint32_t>(p, bigEndian));
+    case PlyType::FLOAT32: return double(readBinary<float>(p, bigEndian));
+    case PlyType::FLOAT64: return readBinary<double>(p, bigEndian);
+    }
+    return 0.0;
+}
+
+// The points of a memory mapped file in one of the supported formats
+struct PointFile
+{
+    enum Format { XYZ, PLY_ASCII, PLY_BINARY, LAS };
+
+    Format format = XYZ;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    size_t dataOffset = 0;  // Of the first point
+    uint64_t numPoints = 0; // 0 if it is only known after a pass
+    bool hasColor = false;
+
+    // Binary records of PLY and LAS
+    size_t recordSize = 0;
+    bool bigEndian = false;
+
+    // Of PLY, the index of the properties and their offsets in the
+    // binary records
+    struct Property
+    {
+        PlyType type;
+        size_t offset;
+    };
+    vector<Property> properties;
+    int position[3] = {-1, -1, -1};
+    int color[3] = {-1, -1, -1};
+    double colorScale = 1.0;
+
+    // Of LAS
+    vsg::dvec3 scale, offset;
+    size_t colorOffset = 0;
+    int colorShift = 0;
+
+    // Of XYZ, the columns of the color
+    int colorColumn = -1;
+
+    // Call f(position, color) for each point. Returns false if it
+    // was canceled.
+    template<class F>
+    bool forEach(const LoadStatus *status, double progressBegin, double progressEnd, F f) const;
+};
+
+static bool isCanceled(const LoadStatus *status)
+{
+    return status && status->canceled;
+}
+
+static void setProgress(const LoadStatus *status, double progress)
+{
+    if (status)
+        status->progress = progress;
+}
+
+template<class F>
+bool PointFile::forEach(const LoadStatus *status, double progressBegin, double progressEnd, F f) const
+{
+    auto progress = [&](size_t pos) {
+        setProgress(status, progressBegin + (progressEnd - progressBegin) * double(pos) / double(size));
+        return !isCanceled(status);
+    };
+
+    if (format == LAS || format == PLY_BINARY)
+    {
+        for (uint64_t i = 0; i < numPoints; i++)
+        {
+            if ((i & 0xfffff) == 0 && !progress(dataOffset + i*recordSize))
+                return false;
+            const uint8_t *record = data + dataOffset + i*recordSize;
+            vsg::dvec3 point;
+            vsg::ubvec4 rgba(255, 255, 255, 255);
+            if (format == LAS)
+            {
+                for (int k = 0; k < 3; k++)
+                    point[k] = readBinary<int32_t>(record + 4*k, false) * scale[k] + offset[k];
+                if (hasColor)
+                    for (int k = 0; k < 3; k++)
+                        rgba[k] = uint8_t(std::min(255, readBinary<uint16_t>(record + colorOffset + 2*k, false) >> colorShift));
+            }
+            else
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    auto& p = properties[position[k]];
+                    point[k] = readPlyValue(record + p.offset, p.type, bigEndian);
+                }
+                if (hasColor)
+                    for (int k = 0; k < 3; k++)
+                    {
+                        auto& p = properties[color[k]];
+                        rgba[k] = uint8_t(std::clamp(readPlyValue(record + p.offset, p.type, bigEndian) * colorScale, 0.0, 255.0));
+                    }
+            }
+            f(point, rgba);
+        }
+        return true;
+    }
+
+    // The text formats
+    const char *p = (const char *)data + dataOffset;
+    const char *end = (const char *)data + size;
+    vector<double> values;
+    uint64_t count = 0;
+    for (size_t line = 0; p < end; line++)
+    {
+        if ((line & 0xfffff) == 0 && !progress(p - (const char *)data))
+            return false;
+        p = parseLine(p, end, values);
+        vsg::ubvec4 rgba(255, 255, 255, 255);
+        if (format == PLY_ASCII)
+        {
+            if (values.size() < properties.size())
+                continue;
+            if (hasColor)
+                for (int k = 0; k < 3; k++)
+                    rgba[k] = uint8_t(std::clamp(values[color[k]] * colorScale, 0.0, 255.0));
+            f(vsg::dvec3(values[position[0]], values[position[1]], values[position[2]]), rgba);
+            if (++count == numPoints)
+                break;
+            continue;
+        }
+
+        // A count on the first line of a PTS file has a single value
+        if (values.size() < 3)
+            continue;
+        if (hasColor && int(values.size()) >= colorColumn + 3)
+            for (int k = 0; k < 3; k++)
+                rgba[k] = uint8_t(std::clamp(values[colorColumn + k], 0.0, 255.0));
+        f(vsg::dvec3(values[0], values[1], values[2]), rgba);
+    }
+    return true;
+}
+
+// Read the header of a PLY file. Returns false if it isn't a PLY
+// file of points, e.g. if it has faces.
+static bool openPly(PointFile& file)
+{
+    const char *p = (const char *)file.data;
+    const char *end = p + file.size;
+    auto readLine = [&]() {
+        const char *start = p;
+        while (p < end && *p != '\n')
+            p++;
+        string line(start, p);
+        if (p < end)
+            p++;
+        if (line.size() && line.back() == '\r')
+            line.pop_back();
+        return line;
+    };
+
+    if (readLine() != "ply")
+        return false;
+
+    string element;
+    size_t offset = 0;
+    int colorFirst = -1;
+    bool anyElement = false;
+    bool vertexFirst = false;
+    while (p < end)
+    {
+        auto line = readLine();
+        vector<string> words;
+        for (size_t pos = 0; pos < line.size();)
+        {
+            size_t next = line.find(' ', pos);
+            if (next == string::npos)
+                next = line.size();
+            if (next > pos)
+                words.push_back(line.substr(pos, next - pos));
+            pos = next + 1;
+        }
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+            continue;
+        if (words[0] == "end_header")
+            break;
+        if (words[0] == "format" && words.size() >= 2)
+        {
+            if (words[1] == "ascii")
+                file.format = PointFile::PLY_ASCII;
+            else if (words[1] == "binary_little_endian" || words[1] == "binary_big_endian")
+            {
+                file.format = PointFile::PLY_BINARY;
+                file.bigEndian = words[1] == "binary_big_endian";
+            }
+            else
+                return false;
+        }
+        else if (words[0] == "element" && words.size() >= 3)
+        {
+            element = words[1];
+            uint64_t count = std::stoull(words[2]);
+            if (element == "vertex")
+            {
+                vertexFirst = !anyElement;
+                file.numPoints = count;
+            }
+            else if (element == "face" && count > 0)
+                return false;
+            anyElement = true;
+        }
+        else if (words[0] == "property" && element == "vertex")
+        {
+            PlyType type;
+            size_t size;
+            if (words.size() != 3 || !parsePlyType(words[1], type, size))
+                return false; // A list, which isn't a point
+            int index = int(file.properties.size());
+            file.properties.push_back({type, offset});
+            offset += size;
+            const auto& name = words[2];
+            if (name == "x" || name == "y" || name == "z")
+                file.position[name[0] - 'x'] = index;
+            for (int k = 0; k < 3; k++)
+            {
+                static const char *names[3][2] = {{"red", "diffuse_red"},
+                                                  {"green", "diffuse_green"},
+                                                  {"blue", "diffuse_blue"}};
+                if (name == names[k][0] || name == names[k][1])
+                {
+                    file.color[k] = index;
+                    if (k == 0)
+                        colorFirst = index;
+                }
+            }
+        }
+    }
+
+    // The points must come first, so that the other elements needn't
+    // be skipped
+    if (!vertexFirst || file.numPoints == 0
+        || file.position[0] < 0 || file.position[1] < 0 || file.position[2] < 0)
+        return false;
+
+    file.hasColor = file.color[0] >= 0 && file.color[1] >= 0 && file.color[2] >= 0;
+    if (file.hasColor)
+    {
+        auto type = file.properties[colorFirst].type;
+        file.colorScale = type == PlyType::FLOAT32 || type == PlyType::FLOAT64 ? 255.0
+            : type == PlyType::UINT16 ? 1.0 / 256.0 : 1.0;
+    }
+    file.recordSize = offset;
+    file.dataOffset = p - (const char *)file.data;
+    if (file.format == PointFile::PLY_BINARY
+        && file.dataOffset + file.numPoints * file.recordSize > file.size)
+        return false;
+    return true;
+}
+
+// Read the header of an uncompressed LAS file of version 1.0 to 1.4
+static bool openLas(PointFile& file)
+{
+    const uint8_t *d = file.data;
+    if (file.size < 227 || memcmp(d, "LASF", 4) != 0)
+        return false;
+
+    uint8_t versionMinor = d[25];
+    uint16_t headerSize = readBinary<uint16_t>(d + 94, false);
+    file.dataOffset = readBinary<uint32_t>(d + 96, false);
+    uint8_t formatId = d[104];
+    file.recordSize = readBinary<uint16_t>(d + 105, false);
+    file.numPoints = readBinary<uint32_t>(d + 107, false);
+    if (versionMinor >= 4 && headerSize >= 375 && file.size >= 255)
+    {
+        uint64_t numPoints = readBinary<uint64_t>(d + 247, false);
+        if (numPoints)
+            file.numPoints = numPoints;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        file.scale[k] = readBinary<double>(d + 131 + 8*k, false);
+        file.offset[k] = readBinary<double>(d + 155 + 8*k, false);
+    }
+
+    // The compressed LAZ records have the high bits set
+    if (formatId & 0xc0)
+    {
+        spdlog::error("Compressed LAS files aren't supported");
+        return false;
+    }
+    if (formatId > 10 || file.dataOffset + file.numPoints * file.recordSize > file.size)
+        return false;
+
+    static const size_t colorOffsets[11] = {0, 0, 20, 28, 0, 28, 0, 30, 30, 0, 30};
+    file.colorOffset = colorOffsets[formatId];
+    file.hasColor = file.colorOffset > 0 && file.recordSize >= file.colorOffset + 6;
+
+    // The colors should be 16 bit, but many writers store 8 bit values
+    if (file.hasColor)
+    {
+        uint16_t maxColor = 0;
+        for (uint64_t i = 0; i < std::min<uint64_t>(file.numPoints, 10000); i++)
+            for (int k = 0; k < 3; k++)
+                maxColor = std::max(maxColor, readBinary<uint16_t>(d + file.dataOffset + i*file.recordSize
+                                                                   + file.colorOffset + 2*k, false));
+        file.colorShift = maxColor > 255 ? 8 : 0;
+    }
+    file.format = PointFile::LAS;
+    return true;
+}
+
+static bool openXyz(PointFile& file)
+{
+    file.format = PointFile::XYZ;
+
+    // The columns are taken from the first line with a point
+    const char *p = (const char *)file.data;
+    const char *end = p + file.size;
+    vector<double> values;
+    while (p < end)
+    {
+        p = parseLine(p, end, values);
+        if (values.size() < 3)
+            continue;
+
+        // x y z r g b, or x y z intensity r g b
+        if (values.size() == 6 || values.size() == 7)
+        {
+            file.hasColor = true;
+            file.colorColumn = int(values.size()) - 3;
+        }
+        return true;
+    }
+    return false;
+}
+
+// A node of the octree while it is built. The cube is relative to
+// the center of the octree.
+struct OctreeNode
+{
+    string name;
+    vsg::dvec3 min;
+    double size = 0;
+    vector<OctreePoint> points;
+    bool hasChildren = false;
+};
+
+static vsg::dvec3 childMin(const vsg::dvec3& min, double size, int octant)
+{
+    double half = size * 0.5;
+    return min + vsg::dvec3((octant & 4) ? half : 0.0, (octant & 2) ? half : 0.0, (octant & 1) ? half : 0.0);
+}
+
+static int octantOf(const vsg::vec3& position, const vsg::dvec3& min, double size)
+{
+    vsg::dvec3 center = min + vsg::dvec3(size, size, size) * 0.5;
+    return (position.x >= center.x ? 4 : 0) | (position.y >= center.y ? 2 : 0) | (position.z >= center.z ? 1 : 0);
+}
+
+// Writes the files of the octree
+class OctreeWriter
+{
+public:
+    OctreeWriter(const string& directory_, double switchRatio_, size_t maxNodePoints_) :
+        directory(directory_), switchRatio(switchRatio_), maxNodePoints(maxNodePoints_)
+    {
+        options = vsg::Options::create();
+        options->extensionHint = ".vsgb";
+    }
+
+    string directory;
+    double switchRatio;
+    size_t maxNodePoints;
+    vsg::ref_ptr<vsg::Options> options;
+    std::atomic<bool> failed{false};
+    std::atomic<size_t> numFiles{0};
+    std::mutex mutex;
+    size_t maxFilePoints = 0;
+
+    // The scene graph of node, with a paged child of the file of its
+    // children
+    vsg::ref_ptr<vsg::Node> createNode(const OctreeNode& node)
+    {
+        vsg::dsphere bound(node.min + vsg::dvec3(node.size, node.size, node.size) * 0.5,
+                           node.size * std::sqrt(3.0) * 0.5);
+        auto group = vsg::CullGroup::create(bound);
+        if (!node.points.empty())
+        {
+            size_t n = node.points.size();
+            auto positions = vsg::vec3Array::create(uint32_t(n));
+            auto colors = vsg::ubvec4Array::create(uint32_t(n));
+            colors->properties.format = VK_FORMAT_R8G8B8A8_UNORM;
+            for (size_t i = 0; i < n; i++)
+            {
+                (*positions)[i] = node.points[i].position;
+                (*colors)[i] = node.points[i].color;
+            }
+
+            // The leaves are denser than the sampling grid when they
+            // are full
+            double spacing = node.size / SAMPLE_GRID;
+            if (!node.hasChildren)
+                spacing = node.size / std::max(double(SAMPLE_GRID), std::sqrt(double(n)));
+            auto draw = vsg::VertexDraw::create();
+            draw->assignArrays(vsg::DataList{positions, colors,
+                                             vsg::floatArray::create(1, float(spacing))});
+            draw->vertexCount = uint32_t(n);
+            draw->instanceCount = 1;
+            group->addChild(draw);
+        }
+        if (node.hasChildren)
+        {
+            auto plod = vsg::PagedLOD::create();
+            plod->bound = bound;
+            plod->filename = filename(node.name);
+            plod->children[0] = vsg::PagedLOD::Child{switchRatio, {}};
+            plod->children[1] = vsg::PagedLOD::Child{0.0, vsg::Group::create()};
+            group->addChild(plod);
+        }
+        return group;
+    }
+
+    string filename(const string& name) const
+    {
+        return directory + "/" + name + ".vsgb";
+    }
+
+    // Write the children of the node with name to its file
+    void writeChildren(const string& name, const vector<OctreeNode>& children)
+    {
+        auto group = vsg::Group::create();
+        size_t numPoints = 0;
+        for (auto& child : children)
+        {
+            group->addChild(createNode(child));
+            numPoints += child.points.size();
+        }
+        if (!write(group, filename(name)))
+            return;
+        numFiles++;
+        std::lock_guard<std::mutex> lock(mutex);
+        maxFilePoints = std::max(maxFilePoints, numPoints);
+    }
+
+    bool write(vsg::ref_ptr<vsg::Node> node, const string& path)
+    {
+        vsg::VSG vsgWriter;
+        if (!vsgWriter.write(node, path, options))
+        {
+            spdlog::error("Failed writing {}", path);
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    // Keep a grid sample of the points of node in it, and move the
+    // rest down to its children, whose files are written. Called on
+    // the points of a chunk.
+    void build(OctreeNode& node, int depth, vector<bool>& occupied)
+    {
+        if (node.points.size() <= maxNodePoints || depth >= MAX_DEPTH || failed)
+            return;
+
+        vector<OctreeNode> children(8);
+        for (int octant = 0; octant < 8; octant++)
+        {
+            children[octant].name = node.name + char('0' + octant);
+            children[octant].min = childMin(node.min, node.size, octant);
+            children[octant].size = node.size * 0.5;
+        }
+
+        occupied.assign(size_t(SAMPLE_GRID) * SAMPLE_GRID * SAMPLE_GRID, false);
+        size_t numKept = 0;
+        for (auto& point : node.points)
+        {
+            size_t cell = 0;
+            for (int k = 0; k < 3; k++)
+                cell = cell * SAMPLE_GRID + size_t(std::clamp(int((point.position[k] - node.min[k]) / node.size * SAMPLE_GRID),
+                                                              0, SAMPLE_GRID - 1));
+            if (!occupied[cell])
+            {
+                occupied[cell] = true;
+                node.points[numKept++] = point;
+            }
+            else
+                children[octantOf(point.position, node.min, node.size)].points.push_back(point);
+        }
+        node.points.resize(numKept);
+        node.points.shrink_to_fit();
+
+        children.erase(std::remove_if(children.begin(), children.end(),
+                                      [](const OctreeNode& child) { return child.points.empty(); }),
+                       children.end());
+        if (children.empty())
+            return;
+        for (auto& child : children)
+            build(child, depth + 1, occupied);
+        writeChildren(node.name, children);
+        node.hasChildren = true;
+    }
+};
+
+// The counts of the points on the grids of all the levels down to
+// COUNT_LEVEL, and the chunk of each cell of the finest grid
+struct ChunkGrid
+{
+    vector<vector<uint64_t>> counts; // [level][cell]
+    vector<int32_t> chunkOfCell;     // At COUNT_LEVEL, or -1
+    struct Chunk
+    {
+        int level;
+        uint32_t x, y, z;
+        string name;
+    };
+    vector<Chunk> chunks;
+
+    static size_t cellIndex(int level, uint32_t x, uint32_t y, uint32_t z)
+    {
+        return (size_t(x) << (2*level)) | (size_t(y) << level) | z;
+    }
+
+    // Split the cell into the chunks below it
+    void split(int level, uint32_t x, uint32_t y, uint32_t z, const string& name)
+    {
+        uint64_t count = counts[level][cellIndex(level, x, y, z)];
+        if (count == 0)
+            return;
+        if (count <= MAX_CHUNK_POINTS || level == COUNT_LEVEL)
+        {
+            int32_t chunk = int32_t(chunks.size());
+            chunks.push_back({level, x, y, z, name});
+            uint32_t n = 1u << (COUNT_LEVEL - level);
+            for (uint32_t i = 0; i < n; i++)
+                for (uint32_t j = 0; j < n; j++)
+                    for (uint32_t k = 0; k < n; k++)
+                        chunkOfCell[cellIndex(COUNT_LEVEL, x*n + i, y*n + j, z*n + k)] = chunk;
+            return;
+        }
+        for (int octant = 0; octant < 8; octant++)
+            split(level + 1, x*2 + ((octant >> 2) & 1), y*2 + ((octant >> 1) & 1), z*2 + (octant & 1),
+                  name + char('0' + octant));
+    }
+};
+
+// Builds the octree of a point file
+class OctreeBuilder
+{
+public:
+    OctreeBuilder(const PointFile& file_, OctreeWriter& writer_, const LoadStatus *status_) :
+        file(file_), writer(writer_), status(status_) {}
+
+    const PointFile& file;
+    OctreeWriter& writer;
+    const LoadStatus *status;
+    vsg::dbox bounds;
+    vsg::dvec3 center;
+    vsg::dvec3 min;  // Of the root cube, relative to center
+    double size = 0; // Of the root cube
+    uint64_t numPoints = 0;
+    ChunkGrid grid;
+    vector<OctreeNode> chunkRoots;
+
+    uint32_t gridCoordinate(double v, double lo) const
+    {
+        int n = 1 << COUNT_LEVEL;
+        return uint32_t(std::clamp(int((v - lo) / size * n), 0, n - 1));
+    }
+
+    bool build(OctreeNode& root)
+    {
+        {
+            TRACE_ZONE("point bounds", "read");
+            if (!file.forEach(status, 0.0, 0.2, [&](const vsg::dvec3& position, const vsg::ubvec4&) {
+                bounds.add(position);
+                numPoints++;
+            }))
+                return false;
+        }
+        if (numPoints == 0 || !bounds.valid())
+            return false;
+
+        center = (bounds.min + bounds.max) * 0.5;
+        vsg::dvec3 extent = bounds.max - bounds.min;
+        size = std::max({extent.x, extent.y, extent.z, 1e-6}) * 1.001;
+        min = vsg::dvec3(-size, -size, -size) * 0.5;
+
+        // Count the points on the finest grid, and sum them up to the
+        // coarser ones
+        grid.counts.resize(COUNT_LEVEL + 1);
+        for (int level = 0; level <= COUNT_LEVEL; level++)
+            grid.counts[level].assign(size_t(1) << (3*level), 0);
+        {
+            TRACE_ZONE("point counts", "read");
+            auto& finest = grid.counts[COUNT_LEVEL];
+            if (!file.forEach(status, 0.2, 0.4, [&](const vsg::dvec3& position, const vsg::ubvec4&) {
+                vsg::dvec3 p = position - center;
+                finest[ChunkGrid::cellIndex(COUNT_LEVEL, gridCoordinate(p.x, min.x),
+                                            gridCoordinate(p.y, min.y), gridCoordinate(p.z, min.z))]++;
+            }))
+                return false;
+        }
+        for (int level = COUNT_LEVEL; level > 0; level--)
+        {
+            uint32_t n = 1u << level;
+            for (uint32_t x = 0; x < n; x++)
+                for (uint32_t y = 0; y < n; y++)
+                    for (uint32_t z = 0; z < n; z++)
+                        grid.counts[level - 1][ChunkGrid::cellIndex(level - 1, x/2, y/2, z/2)]
+                            += grid.counts[level][ChunkGrid::cellIndex(level, x, y, z)];
+        }
+        grid.chunkOfCell.assign(grid.counts[COUNT_LEVEL].size(), -1);
+        grid.split(0, 0, 0, 0, "r");
+
+        if (!distribute() || !buildChunks())
+            return false;
+
+        TRACE_ZONE("point upper levels", "read");
+        root = buildUpper(0, 0, 0, 0, "r");
+        return !writer.failed;
+    }
+
+private:
+    string chunkPath(size_t chunk) const
+    {
+        return fmt::format("{}/chunk_{}.bin", writer.directory, chunk);
+    }
+
+    // Write the points to the temporary file of their chunk
+    bool distribute()
+    {
+        TRACE_ZONE("point distribution", "read");
+        vector<vector<OctreePoint>> buffers(grid.chunks.size());
+        auto flush = [&](size_t chunk) {
+            auto& buffer = buffers[chunk];
+            FILE *fh = fopen(chunkPath(chunk).c_str(), "ab");
+            bool ok = fh && fwrite(buffer.data(), sizeof(OctreePoint), buffer.size(), fh) == buffer.size();
+            if (fh)
+                ok = fclose(fh) == 0 && ok;
+            if (!ok)
+            {
+                spdlog::error("Failed writing {}", chunkPath(chunk));
+                writer.failed = true;
+            }
+            buffer.clear();
+        };
+
+        bool done = file.forEach(status, 0.4, 0.6, [&](const vsg::dvec3& position, const vsg::ubvec4& color) {
+            vsg::dvec3 p = position - center;
+            size_t cell = ChunkGrid::cellIndex(COUNT_LEVEL, gridCoordinate(p.x, min.x),
+                                               gridCoordinate(p.y, min.y), gridCoordinate(p.z, min.z));
+            size_t chunk = size_t(grid.chunkOfCell[cell]);
+            vsg::ubvec4 rgba = color;
+
+            // The points without colors are colored by their height
+            if (!file.hasColor)
+            {
+                double t = (position.z - bounds.min.z) / std::max(bounds.max.z - bounds.min.z, 1e-9);
+                rgba = vsg::ubvec4(uint8_t(255 * std::clamp(1.5 * t - 0.25, 0.0, 1.0)),
+                                   uint8_t(255 * std::clamp(1.0 - std::abs(2.0 * t - 1.0), 0.2, 1.0)),
+                                   uint8_t(255 * std::clamp(1.25 - 1.5 * t, 0.0, 1.0)), 255);
+            }
+            auto& buffer = buffers[chunk];
+            buffer.push_back({vsg::vec3(p), rgba});
+            if (buffer.size() >= WRITE_BUFFER_POINTS)
+                flush(chunk);
+        });
+        for (size_t chunk = 0; chunk < buffers.size(); chunk++)
+            if (!buffers[chunk].empty())
+                flush(chunk);
+        return done && !writer.failed;
+    }
+
+    // Build the subtrees of the chunks, a few in parallel
+    bool buildChunks()
+    {
+        TRACE_ZONE("point chunks", "read");
+        chunkRoots.resize(grid.chunks.size());
+        std::atomic<size_t> numBuilt{0};
+        parallelFor(grid.chunks.size(), [&](size_t begin, size_t end) {
+            vector<bool> occupied;
+            for (size_t i = begin; i < end && !writer.failed && !isCanceled(status); i++)
+            {
+                auto& chunk = grid.chunks[i];
+                auto& node = chunkRoots[i];
+                node.name = chunk.name;
+                node.size = size / double(1u << chunk.level);
+                node.min = min + vsg::dvec3(chunk.x, chunk.y, chunk.z) * node.size;
+
+                QFile chunkFile(QString::fromStdString(chunkPath(i)));
+                if (!chunkFile.open(QIODevice::ReadOnly))
+                {
+                    writer.failed = true;
+                    break;
+                }
+                node.points.resize(size_t(chunkFile.size()) / sizeof(OctreePoint));
+                chunkFile.read((char *)node.points.data(), qint64(node.points.size() * sizeof(OctreePoint)));
+                chunkFile.remove();
+
+                writer.build(node, chunk.level, occupied);
+                setProgress(status, 0.6 + 0.4 * double(++numBuilt) / double(grid.chunks.size()));
+            }
+        }, 1);
+        return !writer.failed && !isCanceled(status);
+    }
+
+    // The node of the cell above the chunks, which takes a grid
+    // sample of the points of its children
+    OctreeNode buildUpper(int level, uint32_t x, uint32_t y, uint32_t z, const string& name)
+    {
+        int32_t chunk = grid.chunkOfCell[ChunkGrid::cellIndex(COUNT_LEVEL, x << (COUNT_LEVEL - level),
+                                                              y << (COUNT_LEVEL - level),
+                                                              z << (COUNT_LEVEL - level))];
+        if (chunk >= 0 && grid.chunks[chunk].level == level)
+            return std::move(chunkRoots[chunk]);
+
+        OctreeNode node;
+        node.name = name;
+        node.size = size / double(1u << level);
+        node.min = min + vsg::dvec3(x, y, z) * node.size;
+        node.hasChildren = true;
+
+        vector<OctreeNode> children;
+        for (int octant = 0; octant < 8; octant++)
+        {
+            uint32_t cx = x*2 + ((octant >> 2) & 1), cy = y*2 + ((octant >> 1) & 1), cz = z*2 + (octant & 1);
+            if (grid.counts[level + 1][ChunkGrid::cellIndex(level + 1, cx, cy, cz)] > 0)
+                children.push_back(buildUpper(level + 1, cx, cy, cz, name + char('0' + octant)));
+        }
+
+        vector<bool> occupied(size_t(SAMPLE_GRID) * SAMPLE_GRID * SAMPLE_GRID, false);
+        for (auto& child : children)
+        {
+            size_t numLeft = 0;
+            for (auto& point : child.points)
+            {
+                size_t cell = 0;
+                for (int k = 0; k < 3; k++)
+                    cell = cell * SAMPLE_GRID + size_t(std::clamp(int((point.position[k] - node.min[k]) / node.size * SAMPLE_GRID),
+                                                                  0, SAMPLE_GRID - 1));
+                if (!occupied[cell])
+                {
+                    occupied[cell] = true;
+                    node.points.push_back(point);
+                }
+                else
+                    child.points[numLeft++] = point;
+            }
+            child.points.resize(numLeft);
+        }
+        writer.writeChildren(name, children);
+        return node;
+    }
+};
+
+// The mutex of the conversions into directory, which the loads of
+// the same file in parallel share, so that only one of them converts
+// it instead of all of them overwriting each other's files
+static std::shared_ptr<std::mutex> conversionMutex(const string& directory)
+{
+    static std::mutex mapMutex;
+    static std::map<string, std::weak_ptr<std::mutex>> mutexes;
+
+    std::scoped_lock<std::mutex> lock(mapMutex);
+    auto mutex = mutexes[directory].lock();
+    if (!mutex)
+    {
+        mutex = std::make_shared<std::mutex>();
+        mutexes[directory] = mutex;
+    }
+    return mutex;
+}
+
+// Convert file into the octree in directory, whose root is written
+// last, so that an octree with a root is complete
+static bool convertPointCloud(const PointFile& file, const string& directory,
+                              size_t maxNodePoints, double switchRatio, const LoadStatus *status)
+{
+    auto t0 = vsg::clock::now();
+    QDir dir(QString::fromStdString(directory));
+    dir.removeRecursively();
+    if (!QDir().mkpath(dir.path()))
+        return false;
+
+    OctreeWriter writer(directory, switchRatio, maxNodePoints);
+    OctreeBuilder builder(file, writer, status);
+    OctreeNode root;
+    bool ok = builder.build(root);
+    if (ok)
+    {
+        auto transform = vsg::MatrixTransform::create(vsg::translate(builder.center));
+        transform->addChild(writer.createNode(root));
+        transform->setValue("tilePoints", double(writer.maxFilePoints));
+        setBounds(*transform, builder.bounds);
+
+        auto rootPath = directory + "/root.vsgb";
+        auto tmpPath = directory + "/root.tmp.vsgb";
+        ok = writer.write(transform, tmpPath) && std::rename(tmpPath.c_str(), rootPath.c_str()) == 0;
+    }
+    if (!ok)
+    {
+        dir.removeRecursively();
+        return false;
+    }
+
+    spdlog::info("Converted {} points into an octree of {} files in {:.0f} ms",
+                 builder.numPoints, writer.numFiles.load(),
+                 std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count());
+    return true;
+}
+
+vsg::ref_ptr<vsg::Object> PointCloudReader::read(const vsg::Path& filename,
+                                                 vsg::ref_ptr<const vsg::Options> options) const
+{
+    auto ext = vsg::lowerCaseFileExtension(filename);
+    if (!isPointCloudFile(filename.string()) && ext != ".ply")
+        return {};
+
+    auto filenameToUse = vsg::findFile(filename, options);
+    if (!filenameToUse)
+        return {};
+
+    const LoadStatus *status = options ? options->getObject<LoadStatus>("LoadStatus") : nullptr;
+
+    QFile qfile(QString::fromStdString(filenameToUse.string()));
+    if (!qfile.open(QIODevice::ReadOnly))
+        return {};
+    PointFile file;
+    file.size = size_t(qfile.size());
+    file.data = file.size ? qfile.map(0, qfile.size()) : nullptr;
+    if (!file.data)
+        return {};
+
+    // The PLY files of meshes are left to the other readers
+    bool opened = ext == ".ply" ? openPly(file) : ext == ".las" ? openLas(file) : openXyz(file);
+    if (!opened)
+        return {};
+
+    std::string fileKey;
+    if (!ModelCache::makeKey(filenameToUse.string(), key(), fileKey))
+        return {};
+    auto octreeDirectory = (directory.empty() ? defaultDirectory() : directory) + "/" + fileKey;
+    auto rootPath = octreeDirectory + "/root.vsgb";
+    if (!QFileInfo::exists(QString::fromStdString(rootPath)))
+    {
+        auto mutex = conversionMutex(octreeDirectory);
+        std::scoped_lock<std::mutex> lock(*mutex);
+
+        // Another load of the file may have converted it meanwhile
+        if (!QFileInfo::exists(QString::fromStdString(rootPath)))
+        {
+            TRACE_ZONE("point octree", "read", filename.string());
+            double switchRatio = errorPixels * SAMPLE_GRID * std::sqrt(3.0) / REFERENCE_HEIGHT;
+            if (!convertPointCloud(file, octreeDirectory, maxNodePoints, switchRatio, status))
+                return {};
+        }
+    }
+
+    // The pager reads the files of the octree with the options of the
+    // root, which shouldn't keep the status of this load
+    auto octreeOptions = options ? vsg::Options::create(*options) : vsg::Options::create();
+    octreeOptions->setObject("LoadStatus", nullptr);
+    auto root = vsg::read_cast<vsg::MatrixTransform>(rootPath, octreeOptions);
+    if (!root)
+    {
+        spdlog::error("Failed reading the octree {}", rootPath);
+        return {};
+    }
+
+    // The octree only holds the draws, so the loaded nodes inherit
+    // the state from above the root
+    auto& state = pointState();
+    auto stateGroup = vsg::StateGroup::create();
+    stateGroup->add(vsg::BindGraphicsPipeline::create(state.pipeline));
+    stateGroup->add(vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS, state.layout, 0,
+                                                   state.descriptorSet));
+    stateGroup->children = std::move(root->children);
+    root->children.clear();
+    root->addChild(stateGroup);
+    root->setValue("z_up", true);
+    return root;
+}
@@ -0,0 +1,57 @@
+//======================================================================
+//  pointcloud.h - Streaming of large point clouds through an octree
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef POINTCLOUD_H
+#define POINTCLOUD_H
+
+#include <vsg/all.h>
+#include <string>
+
+// Reads point clouds in the XYZ/PTS text formats, in uncompressed LAS
+// and in PLY files without faces, which are left to the other readers.
+//
+// The first read of a file converts it out of core into an octree on
+// disk, in which each node holds a grid sampled subset of the points
+// in its cube and its children add the points in between. The
+// children of each node are stored in a file of their own, which the
+// database pager loads through a vsg::PagedLOD once the spacing of
+// the points of the node gets larger than errorPixels on the screen.
+// Later reads only read the root of the octree.
+//
+// The root holds the largest number of points of a file of the
+// octree as the double value "tilePoints", from which the pager gets
+// its point budget, and is tagged with the "z_up" value.
+class PointCloudReader : public vsg::Inherit<vsg::ReaderWriter, PointCloudReader>
+{
+public:
+    vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename,
+                                   vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+    bool getFeatures(Features& features) const override;
+
+    size_t maxNodePoints = 100000; // Of the nodes without children
+    double errorPixels = 1.0;      // Spacing of the points at which the children are loaded
+    std::string directory;         // Of the octrees, defaultDirectory() if empty
+
+    // Default location of the octrees, next to the model cache
+    static std::string defaultDirectory();
+
+    // A short string that identifies the settings, e.g. for cache keys
+    std::string key() const;
+};
+
+// Whether filename is of a format that only holds point clouds
+bool isPointCloudFile(const std::string& filename);
+
+// The points are drawn as discs whose size in pixels follows the
+// spacing of the points of their octree node, times scale, and
+// limited to between minPixels and maxPixels.
+void setPointSize(float scale, float minPixels = 1.0f, float maxPixels = 16.0f);
+
+// Height in pixels of the view that the point sizes are computed for
+void setPointCloudViewportHeight(float height);
+
+#endif /* POINTCLOUD */
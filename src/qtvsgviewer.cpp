@@ -13,15 +13,18 @@
 #include "spdlog/sinks/rotating_file_sink.h"
 #include "spdlog/spdlog.h"
 #include "spdlog/async_logger.h"
+#include "spdlog/async.h"
 #include <string>
 #include <fmt/core.h>
 #include <QMessageBox>
 #include "buildsha1.h"
+#include "benchmark.h"
+#include "thumbnails.h"
+#include "tracing.h"
+#include "pipelinecache.h"
 
 using namespace std;
 
-#define CASE(s) if (!strcmp(s, S_))
-
 static string join(const vector<string>& v, const string& glue)
 {
   string ret;
@@ -34,52 +37,116 @@ static string join(const vector<string>& v, const string& glue)
   return ret;
 }
 
+static bool hasOption(vsg::CommandLine& arguments, const string& option)
+{
+  for (int i=1; i<arguments.argc(); i++)
+    if (arguments[i] == option)
+      return true;
+  return false;
+}
+
 int main(int argc, char *argv[])
 {
     string log_filename;
-    int argp = 1;
+    string trace_filename;
     bool do_debug = true;
     std::vector<std::string> args(argv, argv+argc);
 
-    while(argp < argc && argv[argp][0] == '-') {
-        char *S_ = argv[argp++];
-
-        CASE("--help") {
-            string HelpMessage
-                = fmt::format(
-                    "qtfern - A 3D viewer\n"
-                    "\n"
-                    "Syntax:\n"
-                    "    qtfern [model]\n"
-                    "\n"
-                    "Options:\n"
-                    "    --log_file log_file   Log debug info to the given file name\n"
-                    "    --debug               Increase log level to debug\n"
-                    );
+    // The options of main() are removed from argv, and the rest are
+    // left to the benchmark, the thumbnails or the main window, which
+    // parse them with vsg::CommandLine as well.
+    vsg::CommandLine arguments(&argc, argv);
+    if (arguments.read("--help")) {
+        string HelpMessage
+            = fmt::format(
+                "qtfern - A 3D viewer\n"
+                "\n"
+                "Syntax:\n"
+                "    qtfern [model...]\n"
+                "\n"
+                "Options:\n"
+                "    --log_file log_file   Log debug info to the given file name\n"
+                "    --trace file.json     Write a timeline of the loading and the\n"
+                "                          rendering in the Chrome trace format\n"
+                "    --debug               Increase log level to debug\n"
+                "    --no-cache            Don't use the cache of loaded models\n"
+                "    --cache-size MB       Maximum size of the model cache\n"
+                "    --no-pipeline-cache   Don't keep the Vulkan pipelines between runs\n"
+                "    --continuous          Render continuously instead of on changes\n"
+                "    --max-fps fps         Maximum frame rate, default 60\n"
+                "    --profile             Show the frame profiler\n"
+                "    --crease-angle deg    Don't smooth STL normals across sharper edges\n"
+                "    --optimize            Optimize the meshes after loading\n"
+                "    --no-optimize         Don't optimize the meshes after loading\n"
+                "    --optimize-passes p   Comma separated list of optimization passes\n"
+                "                          out of merge,weld,vcache,vfetch,share\n"
+                "    --stream              Show large STL models in parts of a million\n"
+                "                          triangles while they are being read\n"
+                "    --stream-chunk n      Stream in parts of n triangles\n"
+                "    --cull-hierarchy      Group the parts of the models spatially for\n"
+                "                          faster culling\n"
+                "    --no-cull-hierarchy   Don't group the parts spatially\n"
+                "    --quantize            Store the vertices of the meshes in compact\n"
+                "                          16 and 8 bit formats to save GPU memory\n"
+                "    --no-quantize         Keep the vertices as floats\n"
+                "    --wireframe-overlay   Draw the wireframe in the fragment shaders from\n"
+                "                          barycentrics, also on top of the shading,\n"
+                "                          instead of with line mode pipelines\n"
+                "    --no-wireframe-overlay  Draw the wireframe with line mode pipelines\n"
+                "    --tiles               Convert the large models to tiles, which\n"
+                "                          are paged in from disk as they are needed\n"
+                "    --no-tiles            Load the models as a whole\n"
+                "    --tile-triangles n    At most n triangles per tile\n"
+                "    --tile-budget MB      Keep about MB of tiles loaded\n"
+                "    --point-budget M      Keep about M million points of the point\n"
+                "                          clouds loaded\n"
+                "    --point-size s        Scale the sizes of the points by s\n"
+                "    --point-error px      Load finer points when the spacing of the\n"
+                "                          points is larger than px pixels\n"
+                "    --point-node-size n   At most n points per leaf of the octrees\n"
+                "    --quad-view           Show the top, front and right views next to\n"
+                "                          the perspective one\n"
+                "    --lod                 Generate levels of detail of large meshes\n"
+                "    --no-lod              Don't generate levels of detail\n"
+                "    --lod-levels l        Comma separated triangle fractions of the\n"
+                "                          levels, e.g. 0.5,0.125,0.03\n"
+                "    --lod-min-triangles n Only meshes with n triangles get levels\n"
+                "    --reload-test n       Reload the models n times, log the growth\n"
+                "                          of the live GPU resources and exit\n"
+                "    --benchmark           Render the model without a window along a\n"
+                "                          fixed camera path and print the timings\n"
+                "                          as JSON\n"
+                "    --frames n            Number of frames to benchmark, default 300\n"
+                "    --pick-rays n         Number of rays to benchmark the picking\n"
+                "                          with, default 100000\n"
+                "    --wireframe           Benchmark the wireframe, with line mode\n"
+                "                          pipelines, or from the barycentrics with\n"
+                "                          --wireframe-overlay, which alone benchmarks\n"
+                "                          the edges on top of the shading\n"
+                "    --thumbnails dir      Render the models and the directories of\n"
+                "                          models given to PNG images in dir\n"
+                "    --viewpoints v        Comma separated viewpoints of the images\n"
+                "                          out of diag,top,front,right\n"
+                "    --threads n           Number of threads that read the models\n"
+                );
 #ifdef _WIN32
-            QMessageBox::information (nullptr,
-                                      "Command line Help",
-                                      HelpMessage.c_str());
+        QMessageBox::information (nullptr,
+                                  "Command line Help",
+                                  HelpMessage.c_str());
 #else
-            fmt::print("{}", HelpMessage);
+        fmt::print("{}", HelpMessage);
 #endif      
-            exit(0);
-        }
-
-        CASE("--log_file")
-        {
-            log_filename = argv[argp++];
-            continue;
-        }
-        CASE("--debug")
-        {
-            do_debug = true;
-            continue;
-        }
-        // Currently ignore unknown options
+        exit(0);
     }
+    arguments.read("--log_file", log_filename);
+    arguments.read("--trace", trace_filename);
 
-    MyApp app(argc, argv);
+    // These are left in place as they are read again later. --debug
+    // also turns on the validation layer of the main window.
+    if (hasOption(arguments, "--debug"))
+        do_debug = true;
+    bool do_benchmark = hasOption(arguments, "--benchmark");
+    bool do_thumbnails = hasOption(arguments, "--thumbnails");
 
     vector<spdlog::sink_ptr> log_sinks;
     if (log_filename.size())
@@ -93,17 +160,44 @@ int main(int argc, char *argv[])
     if (do_debug)
         log_level = spdlog::level::debug;
 
-    auto logger = std::make_shared<spdlog::logger>("qtvsgviewer logger", log_sinks.begin(), log_sinks.end());
+    // The sinks are written by a thread of their own, so that logging
+    // doesn't stall the loaders and the rendering
+    spdlog::init_thread_pool(8192, 1);
+    auto logger = std::make_shared<spdlog::async_logger>("qtvsgviewer logger",
+                                                         log_sinks.begin(), log_sinks.end(),
+                                                         spdlog::thread_pool(),
+                                                         spdlog::async_overflow_policy::block);
     spdlog::set_default_logger(logger);
     spdlog::set_level(log_level);
     logger->set_pattern("[%H:%M:%S] [%l] %v");
 
+    Tracer::instance().setThreadName("main");
+    if (trace_filename.size())
+        Tracer::instance().start(trace_filename);
+
+    // Also on the paths that call exit(). It is registered after the
+    // tracer was created, so it runs before the tracer is destroyed.
+    std::atexit([]() {
+        Tracer::instance().stop();
+        spdlog::shutdown();
+    });
+
     spdlog::info("======================================================");
     spdlog::info("Starting qtfern");
     spdlog::info("CommitID: {}", BUILD_SHA1);
     spdlog::info("CommitTime: {}", BUILD_COMMIT_TIME);
     spdlog::info("Command line: {}", join(args," "));
 
+    // The layer that passes the pipeline cache to the driver and
+    // counts the pipelines, before any Vulkan instance is created
+    PipelineCache::enableLayer();
+
+    if (do_benchmark)
+        exit(runBenchmark(argc, argv));
+    if (do_thumbnails)
+        exit(runThumbnails(argc, argv));
+
+    MyApp app(argc, argv);
 
     app.exec();
     
@@ -0,0 +1,511 @@
+//======================================================================
+//  quantize.cpp - Compact quantized vertex formats of the loaded meshes
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "quantize.h"
+#include "bounds.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <regex>
+#include <set>
+
+using namespace std;
+
+// The shader variants where the vertices are placed by more than the
+// model view matrix, which the bounds of the meshes are folded into
+static const char *UNSUPPORTED_DEFINES[] = {
+    "VSG_INSTANCE_POSITIONS", "VSG_BILLBOARD", "VSG_DISPLACEMENT_MAP",
+    "VSG_SKINNING", "VSG_POINT_SPRITE"
+};
+
+// Replaces the declaration of the normals in the vertex shader, so
+// that the rest of the shader reads the decoded ones
+static const char *OCT_NORMAL_GLSL =
+    "in vec2 vsg_NormalOct;\n"
+    "\n"
+    "vec3 octDecode(vec2 e)\n"
+    "{\n"
+    "    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+    "    float t = max(-n.z, 0.0);\n"
+    "    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);\n"
+    "    return normalize(n);\n"
+    "}\n"
+    "\n"
+    "#define vsg_Normal octDecode(vsg_NormalOct)\n";
+
+// How the arrays of the draws below a pipeline are quantized
+struct Layout
+{
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> bind; // Of the variant, or null
+    int position = -1;                            // Bindings of the arrays
+    int normal = -1;
+    int color = -1;
+    bool octNormals = false; // Otherwise the normals stay floats
+};
+
+// The locations of the vertex attributes that the shader declares
+static map<string, uint32_t> shaderAttributes(const string& source)
+{
+    static const std::regex declaration(R"(layout\s*\(\s*location\s*=\s*(\d+)\s*\)\s*in\s+\w+\s+(\w+)\s*;)");
+    map<string, uint32_t> locations;
+    for (std::sregex_iterator it(source.begin(), source.end(), declaration), end; it != end; ++it)
+        locations[(*it)[2].str()] = uint32_t(std::stoul((*it)[1].str()));
+    return locations;
+}
+
+// The binding of the per vertex attribute at location, if it has a
+// binding of its own and the given format, and otherwise -1
+static int attributeBinding(const vsg::VertexInputState& vis, uint32_t location, VkFormat format)
+{
+    for (auto& attribute : vis.vertexAttributeDescriptions)
+    {
+        if (attribute.location != location)
+            continue;
+        if (attribute.format != format || attribute.offset != 0)
+            return -1;
+        for (auto& other : vis.vertexAttributeDescriptions)
+            if (other.binding == attribute.binding && other.location != location)
+                return -1;
+        for (auto& binding : vis.vertexBindingDescriptions)
+            if (binding.binding == attribute.binding)
+                return binding.inputRate == VK_VERTEX_INPUT_RATE_VERTEX ? int(attribute.binding) : -1;
+        return -1;
+    }
+    return -1;
+}
+
+static vsg::BindGraphicsPipeline *findPipeline(vsg::StateGroup& sg)
+{
+    for (auto& sc : sg.stateCommands)
+        if (auto bgp = sc->cast<vsg::BindGraphicsPipeline>())
+            return bgp;
+    return nullptr;
+}
+
+// Create the variant of the pipeline of bind that reads quantized
+// arrays. Its layout has a null bind if the pipeline isn't supported.
+static Layout createLayout(const vsg::BindGraphicsPipeline& bind)
+{
+    Layout layout;
+    auto pipeline = bind.pipeline;
+    if (!pipeline)
+        return layout;
+
+    vsg::ref_ptr<vsg::ShaderStage> stage;
+    for (auto& s : pipeline->stages)
+        if (s->stage == VK_SHADER_STAGE_VERTEX_BIT)
+            stage = s;
+    const vsg::VertexInputState *vis = nullptr;
+    for (auto& state : pipeline->pipelineStates)
+        if (auto v = state->cast<vsg::VertexInputState>())
+            vis = v;
+    if (!stage || !stage->module || stage->module->source.empty() || !vis)
+        return layout;
+    auto& module = *stage->module;
+    if (module.hints)
+        for (auto define : UNSUPPORTED_DEFINES)
+            if (module.hints->defines.count(define))
+                return layout;
+
+    auto locations = shaderAttributes(module.source);
+    auto lookup = [&](const char *name, VkFormat format) {
+        auto it = locations.find(name);
+        return it == locations.end() ? -1 : attributeBinding(*vis, it->second, format);
+    };
+    layout.position = lookup("vsg_Vertex", VK_FORMAT_R32G32B32_SFLOAT);
+    if (layout.position < 0)
+        return layout;
+    layout.normal = lookup("vsg_Normal", VK_FORMAT_R32G32B32_SFLOAT);
+    layout.color = lookup("vsg_Color", VK_FORMAT_R32G32B32A32_SFLOAT);
+
+    // Only the normals need to be decoded by the shader. The positions
+    // and the colors are converted by their formats.
+    auto source = module.source;
+    if (layout.normal >= 0)
+    {
+        static const std::regex normalDeclaration(R"((layout\s*\(\s*location\s*=\s*\d+\s*\)\s*)in\s+vec3\s+vsg_Normal\s*;)");
+        auto decoded = std::regex_replace(source, normalDeclaration, "$1" + string(OCT_NORMAL_GLSL));
+        layout.octNormals = decoded != source;
+        source = decoded;
+    }
+
+    auto vertexInput = vsg::VertexInputState::create(vis->vertexBindingDescriptions,
+                                                     vis->vertexAttributeDescriptions);
+    auto setFormat = [&](int binding, VkFormat format, uint32_t stride) {
+        for (auto& attribute : vertexInput->vertexAttributeDescriptions)
+            if (int(attribute.binding) == binding)
+                attribute.format = format;
+        for (auto& description : vertexInput->vertexBindingDescriptions)
+            if (int(description.binding) == binding)
+                description.stride = stride;
+    };
+    setFormat(layout.position, VK_FORMAT_R16G16B16A16_UNORM, sizeof(vsg::usvec4));
+    if (layout.octNormals)
+        setFormat(layout.normal, VK_FORMAT_R16G16_SNORM, sizeof(vsg::svec2));
+    if (layout.color >= 0)
+        setFormat(layout.color, VK_FORMAT_R8G8B8A8_UNORM, sizeof(vsg::ubvec4));
+
+    auto states = pipeline->pipelineStates;
+    for (auto& state : states)
+        if (state->cast<vsg::VertexInputState>())
+            state = vertexInput;
+
+    // A new pipeline rather than a copy, which would share the
+    // compiled one if the pipeline is shared with a loaded model
+    auto stages = pipeline->stages;
+    for (auto& s : stages)
+    {
+        if (s != stage)
+            continue;
+        auto variantStage = vsg::ShaderStage::create(stage->stage, stage->entryPointName,
+                                                     vsg::ShaderModule::create(source, module.hints));
+        variantStage->specializationConstants = stage->specializationConstants;
+        s = variantStage;
+    }
+    auto variant = vsg::GraphicsPipeline::create(pipeline->layout, stages, states, pipeline->subpass);
+    layout.bind = vsg::BindGraphicsPipeline::create(variant);
+    layout.bind->slot = bind.slot;
+    return layout;
+}
+
+static vsg::BufferInfoList *drawArrays(vsg::Node& draw, uint32_t& firstBinding)
+{
+    if (auto vid = draw.cast<vsg::VertexIndexDraw>())
+    {
+        firstBinding = vid->firstBinding;
+        return &vid->arrays;
+    }
+    if (auto vd = draw.cast<vsg::VertexDraw>())
+    {
+        firstBinding = vd->firstBinding;
+        return &vd->arrays;
+    }
+    return nullptr;
+}
+
+template<class A>
+static A *arrayAt(const vsg::BufferInfoList& arrays, uint32_t firstBinding, int binding)
+{
+    if (binding < int(firstBinding) || size_t(binding - firstBinding) >= arrays.size())
+        return nullptr;
+    auto& info = arrays[binding - firstBinding];
+    if (!info || !info->data || info->data->stride() != sizeof(typename A::value_type))
+        return nullptr;
+    return info->data->cast<A>();
+}
+
+static bool fits(vsg::Node& draw, const Layout& layout)
+{
+    uint32_t firstBinding = 0;
+    auto arrays = drawArrays(draw, firstBinding);
+    if (!arrays)
+        return false;
+    auto positions = arrayAt<vsg::vec3Array>(*arrays, firstBinding, layout.position);
+    if (!positions || positions->size() == 0)
+        return false;
+    if (layout.normal >= 0)
+    {
+        auto normals = arrayAt<vsg::vec3Array>(*arrays, firstBinding, layout.normal);
+        if (!normals || normals->size() != positions->size())
+            return false;
+    }
+    if (layout.color >= 0)
+    {
+        auto colors = arrayAt<vsg::vec4Array>(*arrays, firstBinding, layout.color);
+        if (!colors || colors->size() != positions->size())
+            return false;
+    }
+    return true;
+}
+
+static uint16_t unorm16(float v)
+{
+    return uint16_t(std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f));
+}
+
+static int16_t snorm16(float v)
+{
+    return int16_t(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+static uint8_t unorm8(float v)
+{
+    return uint8_t(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+}
+
+// Project n onto the octahedron and unfold its lower half
+vsg::svec2 octEncode(const vsg::vec3& n)
+{
+    float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (sum <= 0.0f)
+        return vsg::svec2(0, 0);
+    float x = n.x / sum;
+    float y = n.y / sum;
+    if (n.z < 0.0f)
+    {
+        float ox = x;
+        x = (1.0f - std::fabs(y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - std::fabs(ox)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return vsg::svec2(snorm16(x), snorm16(y));
+}
+
+// The same as octDecode() of OCT_NORMAL_GLSL
+vsg::vec3 octDecode(const vsg::svec2& e)
+{
+    vsg::vec3 n(std::max(e.x / 32767.0f, -1.0f), std::max(e.y / 32767.0f, -1.0f), 0.0f);
+    n.z = 1.0f - std::fabs(n.x) - std::fabs(n.y);
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return vsg::normalize(n);
+}
+
+// Replace the arrays of a draw that fits layout by quantized ones.
+// Returns the bounds of the positions, which matrix maps the unit
+// cube of the quantized positions to.
+static vsg::dbox quantizeArrays(vsg::BufferInfoList& arrays,
+                                uint32_t firstBinding,
+                                const Layout& layout,
+                                vsg::dmat4& matrix,
+                                size_t& bytesBefore,
+                                size_t& bytesAfter)
+{
+    auto positions = arrayAt<vsg::vec3Array>(arrays, firstBinding, layout.position);
+    vsg::box box;
+    for (auto& p : *positions)
+        box.add(p);
+
+    // A flat mesh keeps a tiny extent across, so that the transform
+    // can still be inverted for the normals
+    vsg::vec3 extent = box.max - box.min;
+    float maxExtent = std::max({extent.x, extent.y, extent.z});
+    for (int i = 0; i < 3; i++)
+        extent[i] = std::max(extent[i], maxExtent > 0.0f ? maxExtent * 1e-6f : 1.0f);
+    matrix = vsg::translate(vsg::dvec3(box.min)) * vsg::scale(vsg::dvec3(extent));
+
+    auto quantizedPositions = vsg::usvec4Array::create(positions->size());
+    quantizedPositions->properties.format = VK_FORMAT_R16G16B16A16_UNORM;
+    for (size_t i = 0; i < positions->size(); i++)
+    {
+        vsg::vec3 p = (*positions)[i] - box.min;
+        (*quantizedPositions)[i] = vsg::usvec4(unorm16(p.x / extent.x), unorm16(p.y / extent.y),
+                                               unorm16(p.z / extent.z), 65535);
+    }
+    bytesBefore += positions->dataSize();
+    bytesAfter += quantizedPositions->dataSize();
+    arrays[layout.position - firstBinding] = vsg::BufferInfo::create(quantizedPositions);
+
+    // The shaders transform the normals by the model view matrix and
+    // not by its inverse transpose, so the scaling of the transform is
+    // undone beforehand.
+    if (layout.normal >= 0)
+    {
+        auto normals = arrayAt<vsg::vec3Array>(arrays, firstBinding, layout.normal);
+        vsg::ref_ptr<vsg::Data> result;
+        if (layout.octNormals)
+        {
+            auto encoded = vsg::svec2Array::create(normals->size());
+            encoded->properties.format = VK_FORMAT_R16G16_SNORM;
+            for (size_t i = 0; i < normals->size(); i++)
+            {
+                auto& n = (*normals)[i];
+                (*encoded)[i] = octEncode(vsg::vec3(n.x / extent.x, n.y / extent.y, n.z / extent.z));
+            }
+            result = encoded;
+        }
+        else
+        {
+            auto scaled = vsg::vec3Array::create(normals->size());
+            scaled->properties.format = VK_FORMAT_R32G32B32_SFLOAT;
+            for (size_t i = 0; i < normals->size(); i++)
+            {
+                auto& n = (*normals)[i];
+                vsg::vec3 s(n.x / extent.x, n.y / extent.y, n.z / extent.z);
+                float length = vsg::length(s);
+                (*scaled)[i] = length > 0.0f ? s / length : n;
+            }
+            result = scaled;
+        }
+        bytesBefore += normals->dataSize();
+        bytesAfter += result->dataSize();
+        arrays[layout.normal - firstBinding] = vsg::BufferInfo::create(result);
+    }
+
+    if (layout.color >= 0)
+    {
+        auto colors = arrayAt<vsg::vec4Array>(arrays, firstBinding, layout.color);
+        auto quantizedColors = vsg::ubvec4Array::create(colors->size());
+        quantizedColors->properties.format = VK_FORMAT_R8G8B8A8_UNORM;
+        for (size_t i = 0; i < colors->size(); i++)
+        {
+            auto& c = (*colors)[i];
+            (*quantizedColors)[i] = vsg::ubvec4(unorm8(c.r), unorm8(c.g), unorm8(c.b), unorm8(c.a));
+        }
+        bytesBefore += colors->dataSize();
+        bytesAfter += quantizedColors->dataSize();
+        arrays[layout.color - firstBinding] = vsg::BufferInfo::create(quantizedColors);
+    }
+
+    return vsg::dbox(vsg::dvec3(box.min), vsg::dvec3(box.min + extent));
+}
+
+// Find the state groups that bind a pipeline above plain draws, and
+// the parents that each draw is drawn by
+class QuantizeCollector : public vsg::Visitor
+{
+public:
+    std::set<vsg::Object*> visited;
+    std::vector<vsg::Object*> parents;
+    std::vector<vsg::StateGroup*> groups;
+    std::map<vsg::Node*, std::vector<vsg::Object*>> drawParents;
+
+    static bool isDraw(const vsg::Node& node)
+    {
+        return node.is_compatible(typeid(vsg::VertexIndexDraw))
+            || node.is_compatible(typeid(vsg::VertexDraw));
+    }
+
+    void apply(vsg::Object& object) override
+    {
+        if (!visited.insert(&object).second)
+            return;
+        parents.push_back(&object);
+        object.traverse(*this);
+        parents.pop_back();
+    }
+
+    void apply(vsg::StateGroup& sg) override
+    {
+        if (!visited.count(&sg) && findPipeline(sg) && !sg.children.empty()
+            && std::all_of(sg.children.begin(), sg.children.end(),
+                           [](const vsg::ref_ptr<vsg::Node>& child) { return child && isDraw(*child); }))
+            groups.push_back(&sg);
+        apply(static_cast<vsg::Object&>(sg));
+    }
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        drawParents[&vid].push_back(parents.empty() ? nullptr : parents.back());
+    }
+
+    void apply(vsg::VertexDraw& vd) override
+    {
+        drawParents[&vd].push_back(parents.empty() ? nullptr : parents.back());
+    }
+};
+
+QuantizeStats quantizeVertices(vsg::Node& node)
+{
+    QuantizeStats stats;
+    QuantizeCollector collector;
+    node.accept(collector);
+
+    map<vsg::GraphicsPipeline*, Layout> layouts;
+    map<vsg::Object*, const Layout*> groupLayouts;
+    for (auto sg : collector.groups)
+    {
+        auto bind = findPipeline(*sg);
+        auto it = layouts.find(bind->pipeline.get());
+        if (it == layouts.end())
+            it = layouts.emplace(bind->pipeline.get(), createLayout(*bind)).first;
+        if (it->second.bind)
+            groupLayouts[sg] = &it->second;
+    }
+
+    // A draw is quantized if all of the groups that draw it have the
+    // same pipeline, and if its arrays fit the layout of it
+    map<vsg::Node*, const Layout*> drawLayouts;
+    for (auto& [draw, drawParents] : collector.drawParents)
+    {
+        const Layout *layout = nullptr;
+        bool shared = true;
+        for (auto parent : drawParents)
+        {
+            auto it = groupLayouts.find(parent);
+            if (it == groupLayouts.end() || (layout && it->second != layout))
+            {
+                shared = false;
+                break;
+            }
+            layout = it->second;
+        }
+        if (shared && layout && fits(*draw, *layout))
+            drawLayouts[draw] = layout;
+    }
+
+    // The groups with a draw that can't be quantized are left as they
+    // are, and so are the draws that they share with other groups
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto it = groupLayouts.begin(); it != groupLayouts.end();)
+        {
+            auto& children = static_cast<vsg::StateGroup*>(it->first)->children;
+            if (std::all_of(children.begin(), children.end(),
+                            [&](const vsg::ref_ptr<vsg::Node>& child) { return drawLayouts.count(child.get()) > 0; }))
+            {
+                ++it;
+                continue;
+            }
+            for (auto& child : children)
+                drawLayouts.erase(child.get());
+            it = groupLayouts.erase(it);
+            changed = true;
+        }
+    }
+
+    vector<vsg::Node*> draws;
+    for (auto& [draw, layout] : drawLayouts)
+        draws.push_back(draw);
+    stats.numDraws = draws.size();
+    stats.numSkipped = collector.drawParents.size() - draws.size();
+
+    vector<vsg::dmat4> matrices(draws.size());
+    vector<vsg::dbox> bounds(draws.size());
+    vector<size_t> bytesBefore(draws.size(), 0), bytesAfter(draws.size(), 0);
+    parallelFor(draws.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            uint32_t firstBinding = 0;
+            auto arrays = drawArrays(*draws[i], firstBinding);
+            bounds[i] = quantizeArrays(*arrays, firstBinding, *drawLayouts.at(draws[i]),
+                                       matrices[i], bytesBefore[i], bytesAfter[i]);
+        }
+    }, 1);
+
+    // A draw that is shared between groups shares its transform too
+    map<vsg::Node*, vsg::ref_ptr<vsg::MatrixTransform>> transforms;
+    for (size_t i = 0; i < draws.size(); i++)
+    {
+        auto transform = vsg::MatrixTransform::create(matrices[i]);
+        transform->addChild(vsg::ref_ptr<vsg::Node>(draws[i]));
+        setBounds(*transform, bounds[i]);
+        transforms[draws[i]] = transform;
+        stats.bytesBefore += bytesBefore[i];
+        stats.bytesAfter += bytesAfter[i];
+    }
+
+    for (auto& [group, layout] : groupLayouts)
+    {
+        auto sg = static_cast<vsg::StateGroup*>(group);
+        for (auto& sc : sg->stateCommands)
+        {
+            if (sc->cast<vsg::BindGraphicsPipeline>())
+            {
+                sc = layout->bind;
+                break;
+            }
+        }
+        for (auto& child : sg->children)
+            child = transforms.at(child.get());
+    }
+
+    return stats;
+}
@@ -0,0 +1,43 @@
+//======================================================================
+//  quantize.h - Compact quantized vertex formats of the loaded meshes
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include <vsg/all.h>
+
+struct QuantizeStats
+{
+    size_t numDraws = 0;    // Quantized draws
+    size_t numSkipped = 0;  // Draws that were left as they were
+    size_t bytesBefore = 0; // Of the vertex arrays of the quantized draws
+    size_t bytesAfter = 0;
+};
+
+// Replace the float vertex arrays of the meshes in node by compact
+// ones:
+//
+//   positions - 16 bit unsigned normalized, relative to the bounding
+//               box of the mesh, which a transform above the draw
+//               scales back.
+//   normals   - octahedral encoded in two 16 bit signed normalized
+//               values, that the vertex shader decodes.
+//   colors    - 8 bit unsigned normalized.
+//
+// The pipelines get variants with the matching vertex input state and
+// vertex shader. Only the state groups that bind a pipeline of their
+// own above plain draws are quantized, and it must be run before the
+// wireframe switches are inserted, which then clone the variants.
+// The transforms above the draws get their bounds stored, as
+// vsg::ComputeBounds can't read the quantized positions.
+QuantizeStats quantizeVertices(vsg::Node& node);
+
+// The octahedral encoding of the unit vector n, which the quantized
+// normals are stored in, and its decoding as done by the shaders
+vsg::svec2 octEncode(const vsg::vec3& n);
+vsg::vec3 octDecode(const vsg::svec2& e);
+
+#endif /* QUANTIZE */
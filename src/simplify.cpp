@@ -0,0 +1,415 @@
+//======================================================================
+//  simplify.cpp - Quadric error metric simplification of triangle meshes
+//
+//  The collapses are done in passes over the triangles with an
+//  increasing error threshold, instead of through a priority queue,
+//  as this is much faster for large meshes and gives about the same
+//  quality.
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "simplify.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// Symmetric 4x4 matrix of the plane quadric
+struct Quadric
+{
+    double m[10] = {0,0,0,0,0,0,0,0,0,0};
+
+    Quadric() = default;
+    Quadric(double a, double b, double c, double d, double w)
+    {
+        m[0] = w*a*a; m[1] = w*a*b; m[2] = w*a*c; m[3] = w*a*d;
+                      m[4] = w*b*b; m[5] = w*b*c; m[6] = w*b*d;
+                                    m[7] = w*c*c; m[8] = w*c*d;
+                                                  m[9] = w*d*d;
+    }
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        for (int i=0; i<10; i++)
+            m[i] += q.m[i];
+        return *this;
+    }
+
+    double error(const vsg::dvec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        return m[0]*x*x + 2*m[1]*x*y + 2*m[2]*x*z + 2*m[3]*x
+            + m[4]*y*y + 2*m[5]*y*z + 2*m[6]*y
+            + m[7]*z*z + 2*m[8]*z
+            + m[9];
+    }
+};
+
+struct Triangle
+{
+    uint32_t v[3];
+    double err[4];  // Error of the three edges and their minimum
+    vsg::dvec3 n;
+    bool deleted = false;
+    bool dirty = false;
+};
+
+struct Vertex
+{
+    vsg::dvec3 p;
+    Quadric q;
+    uint32_t id;    // Index of the original vertex
+    uint32_t tstart = 0;
+    uint32_t tcount = 0;
+    bool locked = false;
+};
+
+// A reference from a vertex to one of its triangles
+struct Ref
+{
+    uint32_t tid;
+    uint32_t tvertex;
+};
+
+class Simplifier
+{
+public:
+    Simplifier(const vsg::vec3 *positions, size_t numVertices,
+               const vector<uint32_t>& indices);
+
+    bool run(size_t targetTriangles, const atomic<bool> *canceled);
+    void getResult(vector<uint32_t>& result) const;
+
+private:
+    void updateMesh(int iteration);
+    double edgeError(uint32_t i0, uint32_t i1, uint32_t& keep) const;
+    void updateErrors(Triangle& t);
+    bool flipped(const vsg::dvec3& p, uint32_t i1, const Vertex& v, vector<char>& deleted) const;
+    void updateTriangles(uint32_t i0, const Vertex& v, const vector<char>& deleted,
+                         size_t& numDeleted);
+
+    vector<Vertex> m_vertices;
+    vector<Triangle> m_triangles;
+    vector<Ref> m_refs;
+};
+
+Simplifier::Simplifier(const vsg::vec3 *positions, size_t numVertices,
+                       const vector<uint32_t>& indices)
+{
+    // Work in a unit sized frame so that the error thresholds don't
+    // depend on the units of the model.
+    vsg::dbox bounds;
+    for (uint32_t idx : indices)
+        bounds.add(vsg::dvec3(positions[idx]));
+    vsg::dvec3 center = (bounds.min+bounds.max)*0.5;
+    double scale = vsg::length(bounds.max-bounds.min);
+    scale = scale > 0 ? 1.0/scale : 1.0;
+
+    m_vertices.resize(numVertices);
+    for (size_t i=0; i<numVertices; i++)
+    {
+        m_vertices[i].p = (vsg::dvec3(positions[i])-center)*scale;
+        m_vertices[i].id = uint32_t(i);
+    }
+
+    m_triangles.reserve(indices.size()/3);
+    for (size_t i=0; i+2<indices.size(); i+=3)
+    {
+        Triangle t;
+        t.v[0] = indices[i];
+        t.v[1] = indices[i+1];
+        t.v[2] = indices[i+2];
+        if (t.v[0]==t.v[1] || t.v[1]==t.v[2] || t.v[2]==t.v[0])
+            continue;
+        m_triangles.push_back(t);
+    }
+}
+
+// Rebuild the vertex to triangle references and drop the deleted
+// triangles. The first time around the quadrics and the locked
+// vertices are also set up.
+void Simplifier::updateMesh(int iteration)
+{
+    if (iteration > 0)
+        m_triangles.erase(remove_if(m_triangles.begin(), m_triangles.end(),
+                                    [](const Triangle& t) { return t.deleted; }),
+                          m_triangles.end());
+
+    for (auto& v : m_vertices)
+    {
+        v.tstart = 0;
+        v.tcount = 0;
+    }
+    for (auto& t : m_triangles)
+        for (int j=0; j<3; j++)
+            m_vertices[t.v[j]].tcount++;
+    uint32_t tstart = 0;
+    for (auto& v : m_vertices)
+    {
+        v.tstart = tstart;
+        tstart += v.tcount;
+        v.tcount = 0;
+    }
+    m_refs.resize(m_triangles.size()*3);
+    for (size_t i=0; i<m_triangles.size(); i++)
+        for (int j=0; j<3; j++)
+        {
+            auto& v = m_vertices[m_triangles[i].v[j]];
+            m_refs[v.tstart+v.tcount] = {uint32_t(i), uint32_t(j)};
+            v.tcount++;
+        }
+
+    if (iteration > 0)
+        return;
+
+    // Lock the vertices of edges that only have a single triangle.
+    // These are the open borders and the seams where the attributes
+    // of coincident vertices differ.
+    vector<uint32_t> neighbours, counts;
+    for (size_t i=0; i<m_vertices.size(); i++)
+    {
+        auto& v = m_vertices[i];
+        neighbours.clear();
+        counts.clear();
+        for (uint32_t k=0; k<v.tcount; k++)
+        {
+            const auto& t = m_triangles[m_refs[v.tstart+k].tid];
+            for (int j=0; j<3; j++)
+            {
+                uint32_t id = t.v[j];
+                if (id == i)
+                    continue;
+                auto it = find(neighbours.begin(), neighbours.end(), id);
+                if (it == neighbours.end())
+                {
+                    neighbours.push_back(id);
+                    counts.push_back(1);
+                }
+                else
+                    counts[it-neighbours.begin()]++;
+            }
+        }
+        for (size_t j=0; j<neighbours.size(); j++)
+            if (counts[j] == 1)
+            {
+                v.locked = true;
+                m_vertices[neighbours[j]].locked = true;
+            }
+    }
+
+    // Area weighted plane quadrics
+    for (auto& t : m_triangles)
+    {
+        const auto& p0 = m_vertices[t.v[0]].p;
+        vsg::dvec3 n = vsg::cross(m_vertices[t.v[1]].p-p0, m_vertices[t.v[2]].p-p0);
+        double area = vsg::length(n);
+        t.n = area > 0 ? n/area : n;
+        Quadric q(t.n.x, t.n.y, t.n.z, -vsg::dot(t.n, p0), area);
+        for (int j=0; j<3; j++)
+            m_vertices[t.v[j]].q += q;
+    }
+    for (auto& t : m_triangles)
+        updateErrors(t);
+}
+
+// The error of collapsing the edge i0-i1 into one of its end points,
+// which is returned in keep.
+double Simplifier::edgeError(uint32_t i0, uint32_t i1, uint32_t& keep) const
+{
+    const auto& v0 = m_vertices[i0];
+    const auto& v1 = m_vertices[i1];
+    if (v0.locked && v1.locked)
+    {
+        keep = i0;
+        return numeric_limits<double>::max();
+    }
+    Quadric q = v0.q;
+    q += v1.q;
+    double err0 = v1.locked ? numeric_limits<double>::max() : q.error(v0.p);
+    double err1 = v0.locked ? numeric_limits<double>::max() : q.error(v1.p);
+    keep = err0 <= err1 ? i0 : i1;
+    return min(err0, err1);
+}
+
+void Simplifier::updateErrors(Triangle& t)
+{
+    uint32_t keep;
+    for (int j=0; j<3; j++)
+        t.err[j] = edgeError(t.v[j], t.v[(j+1)%3], keep);
+    t.err[3] = min(t.err[0], min(t.err[1], t.err[2]));
+}
+
+// Check if moving v to p flips any of its triangles. The triangles
+// that contain the edge to i1, which will go away, are marked in
+// deleted.
+bool Simplifier::flipped(const vsg::dvec3& p, uint32_t i1, const Vertex& v,
+                         vector<char>& deleted) const
+{
+    for (uint32_t k=0; k<v.tcount; k++)
+    {
+        const auto& ref = m_refs[v.tstart+k];
+        const auto& t = m_triangles[ref.tid];
+        if (t.deleted)
+            continue;
+
+        uint32_t id1 = t.v[(ref.tvertex+1)%3];
+        uint32_t id2 = t.v[(ref.tvertex+2)%3];
+        if (id1 == i1 || id2 == i1)
+        {
+            deleted[k] = 1;
+            continue;
+        }
+        deleted[k] = 0;
+
+        vsg::dvec3 d1 = m_vertices[id1].p - p;
+        vsg::dvec3 d2 = m_vertices[id2].p - p;
+        double l1 = vsg::length(d1), l2 = vsg::length(d2);
+        if (l1 == 0 || l2 == 0)
+            return true;
+        d1 /= l1;
+        d2 /= l2;
+        if (fabs(vsg::dot(d1, d2)) > 0.999)
+            return true;
+        vsg::dvec3 n = vsg::normalize(vsg::cross(d1, d2));
+        if (vsg::dot(n, t.n) < 0.2)
+            return true;
+    }
+    return false;
+}
+
+// Move the triangles of v over to i0 after a collapse
+void Simplifier::updateTriangles(uint32_t i0, const Vertex& v,
+                                 const vector<char>& deleted,
+                                 size_t& numDeleted)
+{
+    for (uint32_t k=0; k<v.tcount; k++)
+    {
+        Ref ref = m_refs[v.tstart+k];
+        auto& t = m_triangles[ref.tid];
+        if (t.deleted)
+            continue;
+        if (deleted[k])
+        {
+            t.deleted = true;
+            numDeleted++;
+            continue;
+        }
+        t.v[ref.tvertex] = i0;
+        t.dirty = true;
+        updateErrors(t);
+        m_refs.push_back(ref);
+    }
+}
+
+bool Simplifier::run(size_t targetTriangles, const atomic<bool> *canceled)
+{
+    size_t numTriangles = m_triangles.size();
+    size_t numDeleted = 0;
+    vector<char> deleted0, deleted1;
+
+    for (int iteration=0; iteration<100; iteration++)
+    {
+        if (numTriangles-numDeleted <= targetTriangles)
+            break;
+        if (canceled && *canceled)
+            return false;
+
+        // Compacting the references every few passes keeps them from
+        // growing without bound.
+        if (iteration % 5 == 0)
+        {
+            updateMesh(iteration);
+            numTriangles = m_triangles.size();
+            numDeleted = 0;
+        }
+
+        for (auto& t : m_triangles)
+            t.dirty = false;
+
+        double threshold = 1e-9*pow(double(iteration+3), 7.0);
+
+        for (size_t i=0; i<m_triangles.size(); i++)
+        {
+            auto& t = m_triangles[i];
+            if (t.err[3] > threshold || t.deleted || t.dirty)
+                continue;
+
+            for (int j=0; j<3; j++)
+            {
+                if (t.err[j] > threshold)
+                    continue;
+
+                uint32_t i0 = t.v[j];
+                uint32_t i1 = t.v[(j+1)%3];
+                uint32_t keep;
+                edgeError(i0, i1, keep);
+                auto& v0 = m_vertices[i0];
+                auto& v1 = m_vertices[i1];
+                vsg::dvec3 p = m_vertices[keep].p;
+
+                deleted0.resize(v0.tcount);
+                deleted1.resize(v1.tcount);
+                if (flipped(p, i1, v0, deleted0) || flipped(p, i0, v1, deleted1))
+                    continue;
+
+                // The collapsed vertex takes over the position and
+                // the identity of the vertex that is kept.
+                v0.p = p;
+                v0.id = m_vertices[keep].id;
+                v0.locked = m_vertices[keep].locked;
+                v0.q += v1.q;
+
+                size_t tstart = m_refs.size();
+                updateTriangles(i0, v0, deleted0, numDeleted);
+                updateTriangles(i0, v1, deleted1, numDeleted);
+                size_t tcount = m_refs.size()-tstart;
+
+                if (tcount <= v0.tcount)
+                {
+                    copy(m_refs.begin()+tstart, m_refs.end(), m_refs.begin()+v0.tstart);
+                    m_refs.resize(tstart);
+                }
+                else
+                    v0.tstart = uint32_t(tstart);
+                v0.tcount = uint32_t(tcount);
+                v1.tcount = 0;
+                break;
+            }
+
+            if (numTriangles-numDeleted <= targetTriangles)
+                break;
+        }
+    }
+    return true;
+}
+
+void Simplifier::getResult(vector<uint32_t>& result) const
+{
+    result.clear();
+    for (const auto& t : m_triangles)
+    {
+        if (t.deleted)
+            continue;
+        for (int j=0; j<3; j++)
+            result.push_back(m_vertices[t.v[j]].id);
+    }
+}
+
+}
+
+bool simplifyMesh(const vsg::vec3 *positions, size_t numVertices,
+                  const vector<uint32_t>& indices,
+                  size_t targetTriangles,
+                  vector<uint32_t>& result,
+                  const atomic<bool> *canceled)
+{
+    Simplifier simplifier(positions, numVertices, indices);
+    if (!simplifier.run(targetTriangles, canceled))
+        return false;
+    simplifier.getResult(result);
+    return true;
+}
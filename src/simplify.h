@@ -0,0 +1,28 @@
+//======================================================================
+//  simplify.h - Quadric error metric simplification of triangle meshes
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <vsg/all.h>
+#include <atomic>
+#include <vector>
+
+// Simplify the triangles in indices to about targetTriangles by
+// collapsing the edges with the smallest quadric error. Only half
+// edge collapses are done, so that the result indexes the original
+// vertices and can share their vertex arrays. Vertices on open
+// borders and on attribute seams are kept in place so that the
+// result has no cracks.
+//
+// Returns false if canceled.
+bool simplifyMesh(const vsg::vec3 *positions, size_t numVertices,
+                  const std::vector<uint32_t>& indices,
+                  size_t targetTriangles,
+                  std::vector<uint32_t>& result,
+                  const std::atomic<bool> *canceled = nullptr);
+
+#endif /* SIMPLIFY */
@@ -0,0 +1,167 @@
+//======================================================================
+//  spacemouse.cpp - 6 DOF navigation with a 3D mouse through spacenavd
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "spacemouse.h"
+#include <spnav.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+using namespace std;
+
+// constructor
+SpaceMouse::SpaceMouse(QObject *parent)
+  : QObject(parent)
+{
+    if (spnav_open() == -1)
+        return;
+
+    int fd = spnav_fd();
+    if (fd < 0)
+    {
+        spnav_close();
+        return;
+    }
+
+    m_lastTime = vsg::clock::now();
+    m_notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated,
+            this, &SpaceMouse::readEvents);
+    spdlog::info("Connected to spacenavd");
+}
+
+SpaceMouse::~SpaceMouse()
+{
+    if (m_notifier)
+        spnav_close();
+}
+
+// Add the deflection since the last event or take
+void SpaceMouse::integrate(vsg::time_point now)
+{
+    double dt = std::chrono::duration<double>(now - m_lastTime).count();
+    if (dt > 0)
+        for (int i = 0; i < 6; i++)
+            m_accumulated[i] += m_deflection[i] * dt;
+    m_lastTime = now;
+}
+
+// Read all the pending events instead of one per frame
+void SpaceMouse::readEvents()
+{
+    bool gotMotion = false;
+    spnav_event event;
+    while (spnav_poll_event(&event) > 0)
+    {
+        if (event.type != SPNAV_EVENT_MOTION)
+            continue;
+
+        auto now = vsg::clock::now();
+        integrate(now);
+        m_deflection[0] = event.motion.x;
+        m_deflection[1] = event.motion.y;
+        m_deflection[2] = event.motion.z;
+        m_deflection[3] = event.motion.rx;
+        m_deflection[4] = event.motion.ry;
+        m_deflection[5] = event.motion.rz;
+
+        if (!m_hasEvents)
+        {
+            m_hasEvents = true;
+            m_firstEvent = now;
+        }
+        gotMotion = true;
+    }
+
+    if (gotMotion)
+        emit motionReceived();
+}
+
+bool SpaceMouse::isMoving() const
+{
+    for (double d : m_deflection)
+        if (d != 0)
+            return true;
+    return false;
+}
+
+bool SpaceMouse::takeMotion(vsg::time_point now, Motion& motion)
+{
+    integrate(now);
+
+    bool hasMotion = false;
+    for (double a : m_accumulated)
+        if (a != 0)
+            hasMotion = true;
+
+    motion.translation = vsg::dvec3(m_accumulated[0], m_accumulated[1], m_accumulated[2]);
+    motion.rotation = vsg::dvec3(m_accumulated[3], m_accumulated[4], m_accumulated[5]);
+    motion.hasEvents = m_hasEvents;
+    motion.firstEvent = m_firstEvent;
+
+    std::fill(std::begin(m_accumulated), std::end(m_accumulated), 0.0);
+    m_hasEvents = false;
+    return hasMotion;
+}
+
+void SpaceMouseNavigation::apply(vsg::FrameEvent& frame)
+{
+    if (!spaceMouse)
+        return;
+
+    SpaceMouse::Motion motion;
+    if (spaceMouse->takeMotion(frame.time, motion))
+    {
+        if (!m_moving)
+        {
+            m_moving = true;
+            m_motionStartFrame = frame.frameStamp->frameCount;
+        }
+
+        auto t = motion.translation * translationSpeed;
+        auto r = motion.rotation * rotationSpeed;
+        trackball->pan({t.x, -t.y});
+        trackball->zoom(-t.z);
+        trackball->rotate(-r.x, vsg::dvec3(1,0,0));
+        trackball->rotate(-r.y, vsg::dvec3(0,1,0));
+        trackball->rotate(r.z, vsg::dvec3(0,0,1));
+
+        if (motion.hasEvents && profiler)
+            profiler->addInput(motion.firstEvent);
+    }
+
+    // Keep integrating while the device is deflected
+    if (spaceMouse->isMoving())
+        viewer->request();
+    else if (m_moving)
+    {
+        m_moving = false;
+        logLatency();
+    }
+}
+
+void SpaceMouseNavigation::logLatency()
+{
+    if (!profiler)
+        return;
+
+    vector<double> latencies;
+    for (auto& f : profiler->history())
+        if (f.frame >= m_motionStartFrame && f.inputLatency >= 0)
+            latencies.push_back(f.inputLatency);
+    if (latencies.empty())
+        return;
+
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (double l : latencies)
+        sum += l;
+    spdlog::debug("Spacemouse input to present latency: mean {:.1f} ms, p95 {:.1f} ms, max {:.1f} ms over {} frames",
+                  sum / latencies.size(),
+                  latencies[std::min(latencies.size()-1, size_t(0.95 * latencies.size()))],
+                  latencies.back(),
+                  latencies.size());
+}
@@ -0,0 +1,92 @@
+//======================================================================
+//  spacemouse.h - 6 DOF navigation with a 3D mouse through spacenavd
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef SPACEMOUSE_H
+#define SPACEMOUSE_H
+
+#include <vsg/all.h>
+#include <vsgQt/Viewer.h>
+#include <QObject>
+#include <QSocketNotifier>
+#include "frameprofiler.h"
+
+// A 3D mouse connected through the spacenavd daemon. The events are
+// read as soon as the daemon socket becomes readable. The device
+// reports a deflection that is taken as a velocity, so the motion is
+// integrated over time until it is taken by the next frame.
+class SpaceMouse : public QObject
+{
+    Q_OBJECT
+
+public:
+    SpaceMouse(QObject *parent = nullptr);
+    ~SpaceMouse();
+
+    bool isOpen() const { return m_notifier != nullptr; }
+
+    // The integrated deflections in device units times seconds
+    struct Motion
+    {
+        vsg::dvec3 translation;
+        vsg::dvec3 rotation;
+        bool hasEvents = false;    // New events since the last take
+        vsg::time_point firstEvent; // When the first of them arrived
+    };
+
+    // Take the motion up to now. Returns false if there is none.
+    bool takeMotion(vsg::time_point now, Motion& motion);
+
+    // True while the device is deflected
+    bool isMoving() const;
+
+signals:
+    void motionReceived();
+
+private slots:
+    void readEvents();
+
+private:
+    void integrate(vsg::time_point now);
+
+    QSocketNotifier *m_notifier = nullptr;
+    double m_deflection[6] = {0,0,0,0,0,0};
+    double m_accumulated[6] = {0,0,0,0,0,0};
+    vsg::time_point m_lastTime;
+    bool m_hasEvents = false;
+    vsg::time_point m_firstEvent;
+};
+
+// Applies the motion of a space mouse to a trackball once per frame,
+// and reports the latency from the events to the frames to the
+// profiler.
+class SpaceMouseNavigation : public vsg::Inherit<vsg::Visitor, SpaceMouseNavigation>
+{
+public:
+    // The viewer owns its event handlers so it isn't referenced
+    SpaceMouseNavigation(vsgQt::Viewer *viewer_,
+                         vsg::ref_ptr<vsg::Trackball> trackball_,
+                         vsg::ref_ptr<FrameProfiler> profiler_) :
+        viewer(viewer_), trackball(trackball_), profiler(profiler_) {}
+
+    vsgQt::Viewer *viewer;
+    vsg::ref_ptr<vsg::Trackball> trackball;
+    vsg::ref_ptr<FrameProfiler> profiler;
+    SpaceMouse *spaceMouse = nullptr;
+
+    // Trackball units per device unit and second
+    double translationSpeed = 0.025;
+    double rotationSpeed = 0.025;
+
+    void apply(vsg::FrameEvent& frame) override;
+
+private:
+    void logLatency();
+
+    bool m_moving = false;
+    uint64_t m_motionStartFrame = 0;
+};
+
+#endif /* SPACEMOUSE */
@@ -0,0 +1,654 @@
+//======================================================================
+//  stlreader.cpp - A native reader for binary and ascii STL files
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "stlreader.h"
+#include "modelloader.h"
+#include "parallel.h"
+#include "tracing.h"
+#include <QFile>
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#ifdef __SSE2__
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+static const size_t BINARY_HEADER_SIZE = 84;
+static const size_t BINARY_FACET_SIZE = 50;
+
+// The corners of all the triangles, three per triangle. Either read
+// straight from the mapped binary file or from the parsed ascii file.
+struct Corners
+{
+    const uint8_t *binary = nullptr;
+    const vsg::vec3 *ascii = nullptr;
+    size_t count = 0;
+
+    vsg::vec3 operator[](size_t i) const
+    {
+        if (ascii)
+            return ascii[i];
+
+        // Skip the facet normal at the start of each facet
+        vsg::vec3 v;
+        memcpy(&v, binary + (i/3)*BINARY_FACET_SIZE + 12 + (i%3)*12, sizeof(v));
+        return v;
+    }
+};
+
+static void setProgress(const LoadStatus *status, double progress)
+{
+    if (status)
+        status->progress = progress;
+}
+
+static bool isCanceled(const LoadStatus *status)
+{
+    return status && status->canceled;
+}
+
+// A locale independent parsing of a float. Returns the position
+// after the number, or p if there was no number.
+static const char *parseFloat(const char *p, const char *end, float& value)
+{
+    const char *start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int numDigits = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, numDigits++)
+    {
+        if (mantissa < 1000000000000000000ULL)
+            mantissa = mantissa*10 + (*p - '0');
+        else
+            exponent++;
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, numDigits++)
+        {
+            if (mantissa < 1000000000000000000ULL)
+            {
+                mantissa = mantissa*10 + (*p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (numDigits == 0)
+        return start;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        bool expNegative = false;
+        if (q < end && (*q == '-' || *q == '+'))
+            expNegative = (*q++ == '-');
+        int e = 0;
+        const char *digits = q;
+        for (; q < end && *q >= '0' && *q <= '9'; q++)
+            e = std::min(e*10 + (*q - '0'), 1000);
+        if (q > digits)
+        {
+            exponent += expNegative ? -e : e;
+            p = q;
+        }
+    }
+
+    double v = double(mantissa) * std::pow(10.0, exponent);
+    value = float(negative ? -v : v);
+    return p;
+}
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Parse all "vertex x y z" lines in [p, end)
+static void parseAsciiVertices(const char *p, const char *end, vector<vsg::vec3>& vertices)
+{
+    static const char keyword[] = "vertex";
+    const size_t keywordLen = sizeof(keyword) - 1;
+
+    while (p < end)
+    {
+        p = (const char*)memchr(p, 'v', end - p);
+        if (!p)
+            break;
+        if (size_t(end - p) < keywordLen + 1
+            || memcmp(p, keyword, keywordLen) != 0
+            || !isSpace(p[keywordLen]))
+        {
+            p++;
+            continue;
+        }
+        p += keywordLen;
+
+        vsg::vec3 v;
+        bool ok = true;
+        for (int i = 0; i < 3 && ok; i++)
+        {
+            while (p < end && isSpace(*p))
+                p++;
+            const char *q = parseFloat(p, end, v[i]);
+            ok = q != p;
+            p = q;
+        }
+        if (ok)
+            vertices.push_back(v);
+    }
+}
+
+// Parse an ascii file in parallel by splitting it after "endfacet"
+// keywords.
+static bool parseAscii(const char *text, size_t size, vector<vsg::vec3>& vertices)
+{
+    TRACE_ZONE("parse ascii stl", "read");
+    const char *end = text + size;
+    size_t numChunks = parallelChunkCount(size, 1 << 20);
+
+    // Find the chunk boundaries
+    vector<const char*> bounds(numChunks + 1, end);
+    bounds[0] = text;
+    for (size_t i = 1; i < numChunks; i++)
+    {
+        const char *p = std::max(bounds[i-1], text + i*(size/numChunks));
+        const char *found = std::search(p, end, "endfacet", "endfacet" + 8);
+        bounds[i] = found == end ? end : found + 8;
+    }
+
+    vector<vector<vsg::vec3>> chunkVertices(numChunks);
+    parallelForChunks(numChunks, numChunks, [&](size_t chunk, size_t, size_t) {
+        auto& v = chunkVertices[chunk];
+        v.reserve((bounds[chunk+1] - bounds[chunk]) / 40);
+        parseAsciiVertices(bounds[chunk], bounds[chunk+1], v);
+        v.resize(v.size() / 3 * 3);
+    });
+
+    size_t total = 0;
+    for (auto& v : chunkVertices)
+        total += v.size();
+    vertices.reserve(total);
+    for (auto& v : chunkVertices)
+    {
+        vertices.insert(vertices.end(), v.begin(), v.end());
+        vector<vsg::vec3>().swap(v);
+    }
+
+    return total > 0;
+}
+
+static inline uint32_t hashPosition(const vsg::vec3& v)
+{
+    uint32_t bits[3];
+    memcpy(bits, &v, sizeof(bits));
+    uint64_t h = 0;
+    for (auto b : bits)
+    {
+        if (b == 0x80000000u) // -0.0 is equal to 0.0
+            b = 0;
+        h = (h ^ b) * 0x9E3779B97F4A7C15ULL;
+    }
+    return uint32_t(h >> 32);
+}
+
+static size_t nextPowerOfTwo(size_t n)
+{
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+// Exclusive prefix sum of counts in place. Returns the total.
+static size_t prefixSum(vector<size_t>& counts)
+{
+    size_t sum = 0;
+    for (auto& c : counts)
+    {
+        size_t n = c;
+        c = sum;
+        sum += n;
+    }
+    return sum;
+}
+
+// Weld corners with equal positions into shared vertices. The
+// vertices are numbered in the order of their first use, and
+// indices gets the vertex of each corner.
+//
+// The corners are partitioned by their hash so that each partition
+// can be welded with its own hash table on a separate thread.
+static vsg::ref_ptr<vsg::vec3Array> weldCorners(const Corners& corners, vsg::uintArray& indices)
+{
+    TRACE_ZONE("weld stl", "read");
+    const size_t numCorners = corners.count;
+    const int partitionBits = 8;
+    const size_t numPartitions = size_t(1) << partitionBits;
+    const uint32_t EMPTY = 0xffffffff;
+
+    vector<uint32_t> hashes(numCorners);
+    parallelFor(numCorners, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            hashes[i] = hashPosition(corners[i]);
+    });
+
+    // Scatter the corners into the partitions, keeping them in index
+    // order within each partition.
+    size_t numChunks = parallelChunkCount(numCorners);
+    vector<size_t> offsets(numChunks * numPartitions, 0);
+    parallelForChunks(numChunks, numCorners, [&](size_t chunk, size_t begin, size_t end) {
+        size_t *count = &offsets[chunk * numPartitions];
+        for (size_t i = begin; i < end; i++)
+            count[hashes[i] >> (32 - partitionBits)]++;
+    });
+
+    vector<size_t> partitionStart(numPartitions + 1);
+    size_t sum = 0;
+    for (size_t p = 0; p < numPartitions; p++)
+    {
+        partitionStart[p] = sum;
+        for (size_t chunk = 0; chunk < numChunks; chunk++)
+        {
+            size_t n = offsets[chunk * numPartitions + p];
+            offsets[chunk * numPartitions + p] = sum;
+            sum += n;
+        }
+    }
+    partitionStart[numPartitions] = sum;
+
+    vector<uint32_t> order(numCorners);
+    parallelForChunks(numChunks, numCorners, [&](size_t chunk, size_t begin, size_t end) {
+        size_t *offset = &offsets[chunk * numPartitions];
+        for (size_t i = begin; i < end; i++)
+            order[offset[hashes[i] >> (32 - partitionBits)]++] = uint32_t(i);
+    });
+
+    // Find the first corner with the same position in each partition
+    vector<uint32_t> first(numCorners);
+    parallelFor(numPartitions, [&](size_t begin, size_t end) {
+        vector<uint32_t> table;
+        for (size_t p = begin; p < end; p++)
+        {
+            size_t n = partitionStart[p+1] - partitionStart[p];
+            size_t mask = nextPowerOfTwo(std::max<size_t>(16, 2*n)) - 1;
+            table.assign(mask + 1, EMPTY);
+
+            for (size_t k = partitionStart[p]; k < partitionStart[p+1]; k++)
+            {
+                uint32_t i = order[k];
+                vsg::vec3 pos = corners[i];
+                for (size_t slot = hashes[i] & mask; ; slot = (slot + 1) & mask)
+                {
+                    uint32_t j = table[slot];
+                    if (j == EMPTY)
+                    {
+                        table[slot] = i;
+                        first[i] = i;
+                        break;
+                    }
+                    if (corners[j] == pos)
+                    {
+                        first[i] = j;
+                        break;
+                    }
+                }
+            }
+        }
+    }, 1);
+    vector<uint32_t>().swap(hashes);
+    vector<uint32_t>().swap(order);
+
+    // Number the vertices in the order of their first use
+    vector<size_t> vertexBase(numChunks, 0);
+    parallelForChunks(numChunks, numCorners, [&](size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            vertexBase[chunk] += (first[i] == i);
+    });
+    size_t numVertices = prefixSum(vertexBase);
+
+    auto vertices = vsg::vec3Array::create(numVertices);
+    uint32_t *idx = indices.data();
+    parallelForChunks(numChunks, numCorners, [&](size_t chunk, size_t begin, size_t end) {
+        size_t id = vertexBase[chunk];
+        for (size_t i = begin; i < end; i++)
+        {
+            if (first[i] == i)
+            {
+                idx[i] = uint32_t(id);
+                (*vertices)[id++] = corners[i];
+            }
+        }
+    });
+    parallelFor(numCorners, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            if (first[i] != i)
+                idx[i] = idx[first[i]];
+    });
+
+    return vertices;
+}
+
+// The area weighted normals of triangles [begin, end). Four
+// triangles at a time are gathered into SSE registers.
+static void computeFaceNormals(const vsg::vec3 *pos, const uint32_t *idx,
+                               vsg::vec3 *normals, size_t begin, size_t end)
+{
+    size_t t = begin;
+#ifdef __SSE2__
+    for (; t + 4 <= end; t += 4)
+    {
+        const uint32_t *ti = idx + 3*t;
+        const vsg::vec3 &a0 = pos[ti[0]], &b0 = pos[ti[1]],  &c0 = pos[ti[2]];
+        const vsg::vec3 &a1 = pos[ti[3]], &b1 = pos[ti[4]],  &c1 = pos[ti[5]];
+        const vsg::vec3 &a2 = pos[ti[6]], &b2 = pos[ti[7]],  &c2 = pos[ti[8]];
+        const vsg::vec3 &a3 = pos[ti[9]], &b3 = pos[ti[10]], &c3 = pos[ti[11]];
+
+        __m128 ax = _mm_setr_ps(a0.x, a1.x, a2.x, a3.x);
+        __m128 ay = _mm_setr_ps(a0.y, a1.y, a2.y, a3.y);
+        __m128 az = _mm_setr_ps(a0.z, a1.z, a2.z, a3.z);
+        __m128 ux = _mm_sub_ps(_mm_setr_ps(b0.x, b1.x, b2.x, b3.x), ax);
+        __m128 uy = _mm_sub_ps(_mm_setr_ps(b0.y, b1.y, b2.y, b3.y), ay);
+        __m128 uz = _mm_sub_ps(_mm_setr_ps(b0.z, b1.z, b2.z, b3.z), az);
+        __m128 vx = _mm_sub_ps(_mm_setr_ps(c0.x, c1.x, c2.x, c3.x), ax);
+        __m128 vy = _mm_sub_ps(_mm_setr_ps(c0.y, c1.y, c2.y, c3.y), ay);
+        __m128 vz = _mm_sub_ps(_mm_setr_ps(c0.z, c1.z, c2.z, c3.z), az);
+
+        float nx[4], ny[4], nz[4];
+        _mm_storeu_ps(nx, _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy)));
+        _mm_storeu_ps(ny, _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz)));
+        _mm_storeu_ps(nz, _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx)));
+        for (int k = 0; k < 4; k++)
+            normals[t+k].set(nx[k], ny[k], nz[k]);
+    }
+#endif
+    for (; t < end; t++)
+    {
+        const uint32_t *ti = idx + 3*t;
+        normals[t] = vsg::cross(pos[ti[1]] - pos[ti[0]], pos[ti[2]] - pos[ti[0]]);
+    }
+}
+
+static inline vsg::vec3 safeNormalize(const vsg::vec3& v)
+{
+    float len = vsg::length(v);
+    return len > 0.0f ? v / len : vsg::vec3(0.0f, 0.0f, 0.0f);
+}
+
+// Group the corners of a vertex into smoothing clusters. A face joins
+// the first cluster whose normal is within the crease angle of its
+// own normal. Returns the number of clusters.
+static size_t clusterCorners(const uint32_t *corners, size_t numCorners,
+                             const vsg::vec3 *faceNormals, float cosCrease,
+                             vector<vsg::vec3>& clusterNormals,
+                             vector<uint32_t>& cornerCluster)
+{
+    clusterNormals.clear();
+    cornerCluster.resize(numCorners);
+    for (size_t k = 0; k < numCorners; k++)
+    {
+        const vsg::vec3& fn = faceNormals[corners[k]/3];
+        vsg::vec3 n = safeNormalize(fn);
+        size_t c = 0;
+        for (; c < clusterNormals.size(); c++)
+            if (vsg::dot(n, safeNormalize(clusterNormals[c])) >= cosCrease)
+                break;
+        if (c == clusterNormals.size())
+            clusterNormals.push_back(vsg::vec3(0.0f, 0.0f, 0.0f));
+        clusterNormals[c] += fn;
+        cornerCluster[k] = uint32_t(c);
+    }
+    return clusterNormals.size();
+}
+
+// Compute smooth vertex normals, duplicating the vertices along
+// edges sharper than the crease angle.
+static void computeNormals(vsg::ref_ptr<vsg::vec3Array>& vertices,
+                           vsg::ref_ptr<vsg::vec3Array>& normals,
+                           vsg::uintArray& indices,
+                           double creaseAngle)
+{
+    TRACE_ZONE("stl normals", "read");
+    const size_t numCorners = indices.size();
+    const size_t numTriangles = numCorners / 3;
+    const size_t numVertices = vertices->size();
+    uint32_t *idx = indices.data();
+    const float cosCrease = float(std::cos(vsg::radians(creaseAngle)));
+
+    vector<vsg::vec3> faceNormals(numTriangles);
+    parallelFor(numTriangles, [&](size_t begin, size_t end) {
+        computeFaceNormals(vertices->data(), idx, faceNormals.data(), begin, end);
+    });
+
+    // The corners of each vertex
+    vector<uint32_t> vertexStart(numVertices + 1, 0);
+    for (size_t i = 0; i < numCorners; i++)
+        vertexStart[idx[i] + 1]++;
+    for (size_t v = 0; v < numVertices; v++)
+        vertexStart[v+1] += vertexStart[v];
+    vector<uint32_t> vertexCorners(numCorners);
+    {
+        vector<uint32_t> fill(vertexStart.begin(), vertexStart.end() - 1);
+        for (size_t i = 0; i < numCorners; i++)
+            vertexCorners[fill[idx[i]]++] = uint32_t(i);
+    }
+
+    // Count the extra vertices needed for the creases
+    size_t numChunks = parallelChunkCount(numVertices);
+    vector<size_t> extraBase(numChunks, 0);
+    parallelForChunks(numChunks, numVertices, [&](size_t chunk, size_t begin, size_t end) {
+        vector<vsg::vec3> clusterNormals;
+        vector<uint32_t> cornerCluster;
+        for (size_t v = begin; v < end; v++)
+            extraBase[chunk] += clusterCorners(&vertexCorners[vertexStart[v]],
+                                               vertexStart[v+1] - vertexStart[v],
+                                               faceNormals.data(), cosCrease,
+                                               clusterNormals, cornerCluster) - 1;
+    });
+    size_t numExtra = prefixSum(extraBase);
+
+    auto outVertices = vsg::vec3Array::create(numVertices + numExtra);
+    normals = vsg::vec3Array::create(numVertices + numExtra);
+    parallelForChunks(numChunks, numVertices, [&](size_t chunk, size_t begin, size_t end) {
+        vector<vsg::vec3> clusterNormals;
+        vector<uint32_t> cornerCluster;
+        size_t extra = numVertices + extraBase[chunk];
+        for (size_t v = begin; v < end; v++)
+        {
+            const uint32_t *corners = &vertexCorners[vertexStart[v]];
+            size_t n = vertexStart[v+1] - vertexStart[v];
+            size_t numClusters = clusterCorners(corners, n, faceNormals.data(), cosCrease,
+                                                clusterNormals, cornerCluster);
+
+            // The first cluster keeps the vertex
+            (*outVertices)[v] = (*vertices)[v];
+            (*normals)[v] = safeNormalize(numClusters ? clusterNormals[0] : vsg::vec3(0.0f, 0.0f, 1.0f));
+            size_t clusterBase = extra - 1;
+            for (size_t c = 1; c < numClusters; c++)
+            {
+                (*outVertices)[extra] = (*vertices)[v];
+                (*normals)[extra] = safeNormalize(clusterNormals[c]);
+                extra++;
+            }
+            for (size_t k = 0; k < n; k++)
+                if (cornerCluster[k] > 0)
+                    idx[corners[k]] = uint32_t(clusterBase + cornerCluster[k]);
+        }
+    });
+
+    vertices = outVertices;
+}
+
+static vsg::ref_ptr<vsg::Node> createScene(vsg::ref_ptr<vsg::vec3Array> vertices,
+                                           vsg::ref_ptr<vsg::vec3Array> normals,
+                                           vsg::ref_ptr<vsg::uintArray> indices,
+                                           vsg::ref_ptr<const vsg::Options> options)
+{
+    TRACE_ZONE("stl scene", "read");
+    auto shaderSet = vsg::createPhongShaderSet(options);
+    auto config = vsg::GraphicsPipelineConfigurator::create(shaderSet);
+
+    vsg::DataList vertexArrays;
+    config->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, vertices);
+    config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_VERTEX, normals);
+    config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_INSTANCE,
+                        vsg::vec2Array::create(1, vsg::vec2(0.0f, 0.0f)));
+    config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_INSTANCE,
+                        vsg::vec4Array::create(1, vsg::vec4(1.0f, 1.0f, 1.0f, 1.0f)));
+
+    auto material = vsg::PhongMaterialValue::create();
+    material->value().diffuse = vsg::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+    material->value().specular = vsg::vec4(0.2f, 0.2f, 0.2f, 1.0f);
+    config->assignDescriptor("material", material);
+
+    if (options && options->sharedObjects)
+        options->sharedObjects->share(config, [](auto gpc) { gpc->init(); });
+    else
+        config->init();
+
+    auto stateGroup = vsg::StateGroup::create();
+    config->copyTo(stateGroup);
+
+    auto draw = vsg::VertexIndexDraw::create();
+    draw->assignArrays(vertexArrays);
+    draw->assignIndices(indices);
+    draw->indexCount = uint32_t(indices->size());
+    draw->instanceCount = 1;
+    stateGroup->addChild(draw);
+
+    return stateGroup;
+}
+
+vsg::ref_ptr<vsg::Object> STLReader::read(const vsg::Path& filename,
+                                          vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (vsg::lowerCaseFileExtension(filename) != ".stl")
+        return {};
+
+    auto filenameToUse = vsg::findFile(filename, options);
+    if (!filenameToUse)
+        return {};
+
+    const LoadStatus *status = options ? options->getObject<LoadStatus>("LoadStatus") : nullptr;
+
+    QFile file(QString::fromStdString(filenameToUse.string()));
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    size_t size = size_t(file.size());
+    const uint8_t *data = size ? file.map(0, file.size()) : nullptr;
+    if (!data)
+        return {};
+
+    // A binary file has a fixed size given by its facet count. Some
+    // binary files start with "solid" as well, so check it first.
+    Corners corners;
+    vector<vsg::vec3> asciiVertices;
+    uint32_t numFacets = 0;
+    if (size >= BINARY_HEADER_SIZE)
+        memcpy(&numFacets, data + 80, sizeof(numFacets));
+    if (size >= BINARY_HEADER_SIZE
+        && size >= BINARY_HEADER_SIZE + size_t(numFacets)*BINARY_FACET_SIZE
+        && (size == BINARY_HEADER_SIZE + size_t(numFacets)*BINARY_FACET_SIZE
+            || memcmp(data, "solid", 5) != 0))
+    {
+        corners.binary = data + BINARY_HEADER_SIZE;
+        corners.count = size_t(numFacets) * 3;
+    }
+    else
+    {
+        if (!parseAscii((const char*)data, size, asciiVertices))
+        {
+            spdlog::error("STLReader: No triangles found in {}", filename.string());
+            return {};
+        }
+        corners.ascii = asciiVertices.data();
+        corners.count = asciiVertices.size();
+    }
+    setProgress(status, 0.2);
+
+    if (corners.count == 0 || corners.count > 0xfffffffeULL)
+    {
+        spdlog::error("STLReader: Unsupported number of triangles in {}", filename.string());
+        return {};
+    }
+    if (isCanceled(status))
+        return {};
+
+    // Stream the triangles in parts that are meshes of their own. The
+    // normals aren't smoothed across the borders of the parts.
+    size_t numTriangles = corners.count / 3;
+    if (status && status->onChunk && status->chunkTriangles > 0
+        && numTriangles > status->chunkTriangles)
+    {
+        auto group = vsg::Group::create();
+        for (size_t first = 0; first < numTriangles; first += status->chunkTriangles)
+        {
+            if (isCanceled(status))
+                return {};
+
+            size_t count = std::min(status->chunkTriangles, numTriangles - first);
+            Corners chunkCorners;
+            if (corners.binary)
+                chunkCorners.binary = corners.binary + first * BINARY_FACET_SIZE;
+            else
+                chunkCorners.ascii = corners.ascii + first * 3;
+            chunkCorners.count = count * 3;
+
+            auto chunkIndices = vsg::uintArray::create(chunkCorners.count);
+            auto chunkVertices = weldCorners(chunkCorners, *chunkIndices);
+            vsg::ref_ptr<vsg::vec3Array> chunkNormals;
+            computeNormals(chunkVertices, chunkNormals, *chunkIndices, creaseAngle);
+
+            auto chunk = createScene(chunkVertices, chunkNormals, chunkIndices, options);
+            group->addChild(chunk);
+            status->onChunk(chunk);
+            setProgress(status, 0.2 + 0.8 * double(first + count) / numTriangles);
+        }
+        file.unmap((uchar*)data);
+
+        spdlog::debug("STLReader: {} triangles in {} parts", numTriangles, group->children.size());
+        group->setValue("z_up", true);
+        return group;
+    }
+
+    auto indices = vsg::uintArray::create(corners.count);
+    auto vertices = weldCorners(corners, *indices);
+    vector<vsg::vec3>().swap(asciiVertices);
+    file.unmap((uchar*)data);
+    setProgress(status, 0.6);
+    if (isCanceled(status))
+        return {};
+
+    vsg::ref_ptr<vsg::vec3Array> normals;
+    computeNormals(vertices, normals, *indices, creaseAngle);
+    setProgress(status, 0.9);
+
+    spdlog::debug("STLReader: {} triangles, {} vertices", indices->size()/3, vertices->size());
+
+    auto scene = createScene(vertices, normals, indices, options);
+    scene->setValue("z_up", true);
+    setProgress(status, 1.0);
+    return scene;
+}
+
+bool STLReader::getFeatures(Features& features) const
+{
+    features.extensionFeatureMap[".stl"] = vsg::ReaderWriter::READ_FILENAME;
+    return true;
+}
+
+std::string STLReader::key() const
+{
+    return fmt::format("crease{}", creaseAngle);
+}
@@ -0,0 +1,31 @@
+//======================================================================
+//  stlreader.h - A native reader for binary and ascii STL files
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef STLREADER_H
+#define STLREADER_H
+
+#include <vsg/all.h>
+
+// Reads STL files through a memory map and builds a single indexed
+// mesh. The triangles are parsed and welded in parallel, and the
+// vertex normals are smoothed, except across edges sharper than
+// creaseAngle. The result is in the z-up orientation of the file
+// and is tagged with the "z_up" value.
+class STLReader : public vsg::Inherit<vsg::ReaderWriter, STLReader>
+{
+public:
+    vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename,
+                                   vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+    bool getFeatures(Features& features) const override;
+
+    double creaseAngle = 30.0; // degrees
+
+    // A short string that identifies the settings, e.g. for cache keys
+    std::string key() const;
+};
+
+#endif /* STLREADER */
@@ -0,0 +1,282 @@
+//======================================================================
+//  thumbnails.cpp - Render preview images of many models without a window
+//
+//  The models are read and compiled by a pool of load threads ahead
+//  of the renderer, and the images are copied to pooled readback
+//  buffers that are written as PNG by a pool of write threads. Thus
+//  the reading, the rendering and the encoding of different models
+//  overlap.
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "thumbnails.h"
+#include "myapp.h"
+#include "modelloader.h"
+#include "offscreen.h"
+#include "viewpoints.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+using namespace std;
+
+// A model that is read and compiled on a load thread
+class ThumbnailJob : public vsg::Inherit<vsg::Object, ThumbnailJob>
+{
+public:
+    ThumbnailJob(const vsg::Path& filename_) : filename(filename_) {}
+
+    vsg::Path filename;
+    vsg::ref_ptr<vsg::Node> node;
+    vsg::CompileResult result;
+    std::string error;
+    vsg::ref_ptr<vsg::Latch> done = vsg::Latch::create(1);
+};
+
+class ReadOperation : public vsg::Inherit<vsg::Operation, ReadOperation>
+{
+public:
+    ReadOperation(vsg::ref_ptr<ThumbnailJob> job_,
+                  vsg::ref_ptr<vsg::Viewer> viewer_,
+                  vsg::ref_ptr<const vsg::Options> options_,
+                  const ReadSettings& settings_) :
+        job(job_),
+        viewer(viewer_),
+        options(options_),
+        settings(settings_) {}
+
+    vsg::ref_ptr<ThumbnailJob> job;
+    vsg::ref_ptr<vsg::Viewer> viewer;
+    vsg::ref_ptr<const vsg::Options> options;
+    ReadSettings settings;
+
+    void run() override
+    {
+        auto status = LoadStatus::create(job->filename.string());
+        job->node = ModelLoader::readModel(job->filename.string(), options, settings, status);
+        if (job->node)
+        {
+            job->result = viewer->compileManager->compile(job->node);
+            if (!job->result)
+            {
+                job->error = job->result.message;
+                job->node = nullptr;
+            }
+        }
+        else
+            job->error = status->error.empty() ? "Failed reading" : status->error;
+        job->done->count_down();
+    }
+};
+
+class WriteOperation : public vsg::Inherit<vsg::Operation, WriteOperation>
+{
+public:
+    WriteOperation(vsg::ref_ptr<vsg::Data> image_,
+                   vsg::ref_ptr<vsg::Buffer> buffer_,
+                   ReadbackPool& pool_,
+                   const vsg::Path& filename_,
+                   vsg::ref_ptr<const vsg::Options> options_,
+                   std::atomic<int>& numFailedWrites_) :
+        image(image_),
+        buffer(buffer_),
+        pool(pool_),
+        filename(filename_),
+        options(options_),
+        numFailedWrites(numFailedWrites_) {}
+
+    vsg::ref_ptr<vsg::Data> image;
+    vsg::ref_ptr<vsg::Buffer> buffer;
+    ReadbackPool& pool;
+    vsg::Path filename;
+    vsg::ref_ptr<const vsg::Options> options;
+    std::atomic<int>& numFailedWrites;
+
+    void run() override
+    {
+        if (!vsg::write(image, filename, options))
+        {
+            spdlog::error("Failed writing {}", filename.string());
+            numFailedWrites++;
+        }
+
+        // Unmap before the buffer is reused
+        image = nullptr;
+        pool.release(buffer);
+    }
+};
+
+// The readable files of the directories, and the files themselves
+static vector<vsg::Path> collectFiles(const vector<vsg::Path>& paths,
+                                      vsg::ref_ptr<const vsg::Options> options)
+{
+    set<vsg::Path> extensions;
+    for (auto& readerWriter : options->readerWriters)
+    {
+        vsg::ReaderWriter::Features features;
+        if (!readerWriter->getFeatures(features))
+            continue;
+        for (auto& [extension, featureMask] : features.extensionFeatureMap)
+            if (featureMask & vsg::ReaderWriter::READ_FILENAME)
+                extensions.insert(extension);
+    }
+
+    vector<vsg::Path> files;
+    for (auto& path : paths)
+    {
+        if (vsg::fileType(path) != vsg::DIRECTORY)
+        {
+            files.push_back(path);
+            continue;
+        }
+
+        set<vsg::Path> sorted;
+        for (auto& entry : vsg::getDirectoryContents(path))
+        {
+            auto filename = path / entry;
+            if (vsg::fileType(filename) == vsg::REGULAR_FILE
+                && extensions.count(vsg::lowerCaseFileExtension(filename)))
+                sorted.insert(filename);
+        }
+        files.insert(files.end(), sorted.begin(), sorted.end());
+    }
+    return files;
+}
+
+int runThumbnails(int argc, char *argv[])
+{
+    vsg::CommandLine arguments(&argc, argv);
+    arguments.read("--debug");
+
+    vsg::Path outputDir;
+    arguments.read("--thumbnails", outputDir);
+    uint32_t width = 256, height = 256;
+    arguments.read({"--window", "-w"}, width, height);
+    bool debugLayer = arguments.read({"--debug-layer", "-d"});
+    std::string viewpointNames = "diag";
+    arguments.read("--viewpoints", viewpointNames);
+    uint32_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    arguments.read("--threads", numThreads);
+    numThreads = std::max(1u, numThreads);
+    ReadSettings readSettings;
+    readSettings.optimize.enabled = arguments.read("--optimize");
+    std::string optimizePasses;
+    if (arguments.read("--optimize-passes", optimizePasses)
+        && !readSettings.optimize.parsePasses(optimizePasses))
+        return -1;
+    readSettings.cullHierarchy.enabled = arguments.read("--cull-hierarchy");
+    auto options = createReaderOptions(arguments);
+
+    if (arguments.errors())
+    {
+        arguments.writeErrorMessages(std::cerr);
+        return -1;
+    }
+
+    vector<Viewpoint> viewpoints;
+    if (!parseViewpoints(viewpointNames, viewpoints))
+    {
+        std::cerr << "Unknown viewpoints " << viewpointNames << std::endl;
+        return -1;
+    }
+
+    vector<vsg::Path> paths;
+    for (int i=1; i<arguments.argc(); i++)
+        paths.push_back(arguments[i]);
+    auto files = collectFiles(paths, options);
+    if (outputDir.empty() || files.empty())
+    {
+        std::cerr << "Please specify an output directory and the models to render." << std::endl;
+        return -1;
+    }
+    if (!vsg::makeDirectory(outputDir))
+    {
+        std::cerr << "Failed creating " << outputDir << std::endl;
+        return -1;
+    }
+
+    OffscreenRenderer renderer(width, height, debugLayer);
+    if (!renderer.valid())
+        return -1;
+    auto viewer = renderer.viewer();
+    viewer->compile();
+
+    // PNG encoding is slower than the rendering, so it gets half of
+    // the threads, and there is a readback buffer for each of them
+    // and one that is being rendered to.
+    uint32_t numWriteThreads = std::max(1u, numThreads/2);
+    auto loadThreads = vsg::OperationThreads::create(numThreads);
+    auto writeThreads = vsg::OperationThreads::create(numWriteThreads);
+    ReadbackPool readbackPool(renderer.device(), renderer.imageSize(), numWriteThreads + 1);
+    std::atomic<int> numFailedWrites{0};
+    size_t numFailedModels = 0;
+
+    // Read ahead of the renderer, but not so far that all the models
+    // are kept in memory
+    size_t readAhead = 2 * numThreads;
+    std::deque<vsg::ref_ptr<ThumbnailJob>> jobs;
+    size_t nextFile = 0;
+    auto start = chrono::steady_clock::now();
+
+    while (nextFile < files.size() || !jobs.empty())
+    {
+        while (nextFile < files.size() && jobs.size() < readAhead)
+        {
+            auto job = ThumbnailJob::create(files[nextFile++]);
+            loadThreads->add(ReadOperation::create(job, viewer, options, readSettings));
+            jobs.push_back(job);
+        }
+
+        auto job = jobs.front();
+        jobs.pop_front();
+        job->done->wait();
+        if (!job->node)
+        {
+            spdlog::error("{}: {}", job->filename.string(), job->error);
+            std::cerr << job->filename << ": " << job->error << std::endl;
+            numFailedModels++;
+            continue;
+        }
+
+        vsg::updateViewer(*viewer, job->result);
+        renderer.sceneRoot()->children = {job->node};
+
+        vsg::dvec3 center;
+        double radius;
+        computeFraming(*job->node, center, radius);
+
+        auto stem = vsg::simpleFilename(job->filename).string();
+        for (auto viewpoint : viewpoints)
+        {
+            renderer.setCamera(*createViewpoint(viewpoint, center, radius), radius);
+            auto buffer = readbackPool.acquire();
+            renderer.renderFrame(buffer);
+
+            std::string name = viewpoints.size() > 1
+                ? fmt::format("{}-{}.png", stem, viewpointName(viewpoint))
+                : stem + ".png";
+            writeThreads->add(WriteOperation::create(renderer.mapImage(buffer), buffer, readbackPool,
+                                                     outputDir / name, options, numFailedWrites));
+        }
+        renderer.sceneRoot()->children.clear();
+    }
+
+    readbackPool.waitIdle();
+    loadThreads->stop();
+    writeThreads->stop();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    size_t numImages = (files.size() - numFailedModels) * viewpoints.size() - numFailedWrites;
+    fmt::print("Rendered {} images of {} models in {:.1f}s, {:.0f} images per minute\n",
+               numImages, files.size(), seconds,
+               seconds > 0 ? numImages * 60.0 / seconds : 0.0);
+
+    return numFailedModels > 0 || numFailedWrites > 0 ? 1 : 0;
+}
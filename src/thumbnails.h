@@ -0,0 +1,15 @@
+//======================================================================
+//  thumbnails.h - Render preview images of many models without a window
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef THUMBNAILS_H
+#define THUMBNAILS_H
+
+// Render the files and directories given on the command line to PNG
+// images in the directory given by --thumbnails. Returns the exit
+// code, which is non-zero if any of the models failed.
+int runThumbnails(int argc, char *argv[]);
+
+#endif /* THUMBNAILS */
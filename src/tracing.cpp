@@ -0,0 +1,175 @@
+//======================================================================
+//  tracing.cpp - Timeline of scoped zones written as Chrome trace JSON
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "tracing.h"
+#include <spdlog/spdlog.h>
+#include <fmt/core.h>
+#include <chrono>
+
+using namespace std;
+
+// How often the writer flushes the buffers of the threads
+static const auto FLUSH_INTERVAL = std::chrono::milliseconds(250);
+
+static string jsonEscape(const string& s)
+{
+    string ret;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            ret += '\\';
+        if ((unsigned char)c < 0x20)
+            ret += fmt::format("\\u{:04x}", int(c));
+        else
+            ret += c;
+    }
+    return ret;
+}
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+bool Tracer::start(const std::string& filename)
+{
+    stop();
+
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    m_file = fopen(filename.c_str(), "w");
+    if (!m_file)
+    {
+        spdlog::error("Failed opening the trace file {}", filename);
+        return false;
+    }
+    fmt::print(m_file, "{{\"traceEvents\":[\n");
+    m_firstEvent = true;
+    m_startTime = vsg::clock::now();
+    m_stopWriter = false;
+    for (auto& buffer : m_buffers)
+        buffer->nameChanged = !buffer->name.empty();
+    m_writer = std::thread([this]() { writerLoop(); });
+    m_enabled = true;
+    spdlog::info("Tracing to {}", filename);
+    return true;
+}
+
+void Tracer::stop()
+{
+    if (!m_writer.joinable())
+        return;
+    m_enabled = false;
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        m_stopWriter = true;
+    }
+    m_wakeWriter.notify_one();
+    m_writer.join();
+
+    // The zones that ended while the writer was stopping
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    flush();
+    fmt::print(m_file, "\n]}}\n");
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+Tracer::ThreadBuffer& Tracer::threadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<ThreadBuffer>();
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        buffer->tid = uint32_t(m_buffers.size() + 1);
+        m_buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Tracer::setThreadName(const std::string& name)
+{
+    auto& buffer = threadBuffer();
+    std::scoped_lock<std::mutex> lock(buffer.mutex);
+    if (buffer.name == name)
+        return;
+    buffer.name = name;
+    buffer.nameChanged = true;
+}
+
+void Tracer::addZone(const char *name,
+                     const char *category,
+                     vsg::clock::time_point start,
+                     vsg::clock::time_point end,
+                     std::string&& detail)
+{
+    if (!enabled())
+        return;
+    auto& buffer = threadBuffer();
+    std::scoped_lock<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({
+        name, category,
+        std::chrono::duration<double, std::micro>(start - m_startTime).count(),
+        std::chrono::duration<double, std::micro>(end - start).count(),
+        std::move(detail)});
+}
+
+void Tracer::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopWriter)
+    {
+        m_wakeWriter.wait_for(lock, FLUSH_INTERVAL, [this]() { return m_stopWriter; });
+        flush();
+    }
+}
+
+// Must be called with m_mutex held. The events are taken out of the
+// buffers first, so that the threads only wait for a swap.
+void Tracer::flush()
+{
+    if (!m_file)
+        return;
+
+    std::vector<Event> events;
+    for (auto& buffer : m_buffers)
+    {
+        std::string name;
+        {
+            std::scoped_lock<std::mutex> lock(buffer->mutex);
+            events.swap(buffer->events);
+            if (buffer->nameChanged)
+                name = buffer->name;
+            buffer->nameChanged = false;
+        }
+
+        auto separator = [this]() {
+            if (!m_firstEvent)
+                fmt::print(m_file, ",\n");
+            m_firstEvent = false;
+        };
+        if (!name.empty())
+        {
+            separator();
+            fmt::print(m_file, "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                       "\"args\":{{\"name\":\"{}\"}}}}", buffer->tid, jsonEscape(name));
+        }
+        for (auto& event : events)
+        {
+            separator();
+            fmt::print(m_file, "{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},"
+                       "\"dur\":{:.3f},\"pid\":1,\"tid\":{}",
+                       event.name, event.category, event.start, event.duration, buffer->tid);
+            if (!event.detail.empty())
+                fmt::print(m_file, ",\"args\":{{\"detail\":\"{}\"}}", jsonEscape(event.detail));
+            fmt::print(m_file, "}}");
+        }
+        events.clear();
+    }
+    fflush(m_file);
+}
@@ -0,0 +1,118 @@
+//======================================================================
+//  tracing.h - Timeline of scoped zones written as Chrome trace JSON
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <vsg/all.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Collects the zones of all threads and writes them to a file in the
+// Chrome trace event format, which chrome://tracing and Perfetto
+// show as a flame chart. Each thread appends to a buffer of its own,
+// and a writer thread flushes the buffers in the background.
+class Tracer
+{
+public:
+    static Tracer& instance();
+
+    bool start(const std::string& filename);
+
+    // Flush the remaining zones and close the file
+    void stop();
+
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // The name of the calling thread in the timeline
+    void setThreadName(const std::string& name);
+
+    void addZone(const char *name,
+                 const char *category,
+                 vsg::clock::time_point start,
+                 vsg::clock::time_point end,
+                 std::string&& detail);
+
+private:
+    struct Event
+    {
+        const char *name;
+        const char *category;
+        double start;    // us since the start of the trace
+        double duration; // us
+        std::string detail;
+    };
+
+    // The mutex is only contended while the writer takes the events
+    struct ThreadBuffer
+    {
+        std::mutex mutex;
+        std::vector<Event> events;
+        uint32_t tid = 0;
+        std::string name;
+        bool nameChanged = false;
+    };
+
+    Tracer() = default;
+    ThreadBuffer& threadBuffer();
+    void writerLoop();
+    void flush();
+
+    std::atomic<bool> m_enabled{false};
+    vsg::clock::time_point m_startTime;
+    std::mutex m_mutex; // Guards the list of buffers and the file
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+    FILE *m_file = nullptr;
+    bool m_firstEvent = true;
+    std::thread m_writer;
+    std::condition_variable m_wakeWriter;
+    bool m_stopWriter = false;
+};
+
+// Adds a zone from its construction to its destruction. The name and
+// the category must be string literals, as only their pointers are
+// kept. It costs a flag test when tracing isn't enabled.
+class TraceZone
+{
+public:
+    TraceZone(const char *name, const char *category = "app", std::string detail = {})
+    {
+        if (Tracer::instance().enabled())
+        {
+            m_name = name;
+            m_category = category;
+            m_detail = std::move(detail);
+            m_start = vsg::clock::now();
+        }
+    }
+
+    ~TraceZone()
+    {
+        if (m_name)
+            Tracer::instance().addZone(m_name, m_category, m_start, vsg::clock::now(),
+                                       std::move(m_detail));
+    }
+
+private:
+    const char *m_name = nullptr;
+    const char *m_category = nullptr;
+    std::string m_detail;
+    vsg::clock::time_point m_start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// E.g. TRACE_ZONE("compile", "load", filename)
+#define TRACE_ZONE(...) TraceZone TRACE_CONCAT(traceZone, __LINE__)(__VA_ARGS__)
+
+#endif /* TRACING */
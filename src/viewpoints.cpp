@@ -0,0 +1,96 @@
+//======================================================================
+//  viewpoints.cpp - The standard framing and viewpoints of a model
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "viewpoints.h"
+#include "bounds.h"
+#include <sstream>
+
+const char *viewpointName(Viewpoint viewpoint)
+{
+    switch (viewpoint)
+    {
+    case Viewpoint::DIAG: return "diag";
+    case Viewpoint::TOP: return "top";
+    case Viewpoint::FRONT: return "front";
+    case Viewpoint::RIGHT: return "right";
+    }
+    return "";
+}
+
+bool parseViewpoint(const std::string& name, Viewpoint& viewpoint)
+{
+    for (auto v : {Viewpoint::DIAG, Viewpoint::TOP, Viewpoint::FRONT, Viewpoint::RIGHT})
+        if (name == viewpointName(v))
+        {
+            viewpoint = v;
+            return true;
+        }
+    return false;
+}
+
+bool parseViewpoints(const std::string& names, std::vector<Viewpoint>& viewpoints)
+{
+    viewpoints.clear();
+
+    std::stringstream ss(names);
+    std::string name;
+    while (std::getline(ss, name, ','))
+    {
+        Viewpoint viewpoint;
+        if (!parseViewpoint(name, viewpoint))
+            return false;
+        viewpoints.push_back(viewpoint);
+    }
+    return !viewpoints.empty();
+}
+
+void computeFraming(vsg::Node& scene, vsg::dvec3& center, double& radius)
+{
+    auto bounds = getBounds(scene);
+    if (!bounds.valid())
+    {
+        center = vsg::dvec3(0.0, 0.0, 0.0);
+        radius = 1.0;
+        return;
+    }
+    center = (bounds.min + bounds.max) * 0.5;
+    radius = vsg::length(bounds.max - bounds.min) * 0.6;
+    if (radius <= 0.0)
+        radius = 1.0;
+}
+
+vsg::ref_ptr<vsg::LookAt> createViewpoint(Viewpoint viewpoint,
+                                          const vsg::dvec3& center,
+                                          double radius)
+{
+    switch (viewpoint)
+    {
+    case Viewpoint::TOP:
+        return vsg::LookAt::create(center + vsg::dvec3(0.0, 0.0, radius * 2.5),
+                                   center,
+                                   vsg::dvec3(0.0, 1.0, 0.0));
+    case Viewpoint::FRONT:
+        return vsg::LookAt::create(center + vsg::dvec3(0.0, -radius * 2.5, 0.0),
+                                   center,
+                                   vsg::dvec3(0.0, 0.0, 1.0));
+    case Viewpoint::RIGHT:
+        return vsg::LookAt::create(center + vsg::dvec3(radius * 2.5, 0.0, 0.0),
+                                   center,
+                                   vsg::dvec3(0.0, 0.0, 1.0));
+    case Viewpoint::DIAG:
+    default:
+        return vsg::LookAt::create(center + vsg::dvec3(radius, -radius * 2.5, radius),
+                                   center,
+                                   vsg::dvec3(0.0, 0.0, 1.0));
+    }
+}
+
+double viewpointDistance(Viewpoint viewpoint, double radius)
+{
+    auto lookAt = createViewpoint(viewpoint, vsg::dvec3(0.0, 0.0, 0.0), radius);
+    return vsg::length(lookAt->eye - lookAt->center);
+}
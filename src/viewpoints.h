@@ -0,0 +1,41 @@
+//======================================================================
+//  viewpoints.h - The standard framing and viewpoints of a model
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef VIEWPOINTS_H
+#define VIEWPOINTS_H
+
+#include <vsg/all.h>
+#include <string>
+#include <vector>
+
+enum class Viewpoint { DIAG, TOP, FRONT, RIGHT };
+
+// The names are diag, top, front and right
+const char *viewpointName(Viewpoint viewpoint);
+bool parseViewpoint(const std::string& name, Viewpoint& viewpoint);
+
+// Parse a comma separated list of viewpoint names
+bool parseViewpoints(const std::string& names, std::vector<Viewpoint>& viewpoints);
+
+// The center and the radius that a model is framed by. An empty
+// scene gives a unit sphere. Uses the bounds stored by cacheBounds().
+void computeFraming(vsg::Node& scene, vsg::dvec3& center, double& radius);
+
+// The camera of viewpoint for a model framed by center and radius
+vsg::ref_ptr<vsg::LookAt> createViewpoint(Viewpoint viewpoint,
+                                          const vsg::dvec3& center,
+                                          double radius);
+
+// The distance from the center of the camera of each viewpoint
+double viewpointDistance(Viewpoint viewpoint, double radius);
+
+// The near and far planes that keep the whole model visible from
+// the viewpoints
+const double NEAR_FAR_RATIO = 0.001;
+inline double framingNear(double radius) { return NEAR_FAR_RATIO * radius; }
+inline double framingFar(double radius) { return radius * 4.5; }
+
+#endif /* VIEWPOINTS */
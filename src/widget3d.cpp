@@ -6,9 +6,23 @@
 //----------------------------------------------------------------------
 
 #include "widget3d.h"
+#include "wireframe.h"
+#include "pipelinecache.h"
+#include "viewpoints.h"
+#include "spacemouse.h"
+#include "cullhierarchy.h"
+#include "pagedtiles.h"
+#include "pointcloud.h"
+#include <vsgImGui/RenderImGui.h>
+#include <vsgImGui/SendEventsToImGui.h>
+#include <QCoreApplication>
+#include <QDragEnterEvent>
+#include <QDropEvent>
+#include <QMimeData>
 #include <QVBoxLayout>
 #include <spdlog/spdlog.h>
 #include <fmt/core.h>
+#include <algorithm>
 
 using fmt::print;
 
@@ -36,6 +50,177 @@ private:
     vsg::ref_ptr<vsg::ViewMatrix> parentTransform_;
 };
 
+// Requests frames for as long as the camera moves by itself, e.g.
+// during the trackball animations to the key viewpoints and after the
+// model has been thrown, when rendering on demand. The frame rate of
+// each such motion is logged.
+class RenderOnDemand : public vsg::Inherit<vsg::Visitor, RenderOnDemand>
+{
+public:
+    // The viewer owns its event handlers so it isn't referenced
+    RenderOnDemand(vsgQt::Viewer *viewer_, vsg::ref_ptr<vsg::Camera> camera_) :
+        viewer(viewer_), camera(camera_) {}
+
+    vsgQt::Viewer *viewer;
+    vsg::ref_ptr<vsg::Camera> camera;
+    vsg::ref_ptr<vsg::DatabasePager> pager;
+    bool enabled = false;
+
+    void apply(vsg::FrameEvent& frame) override
+    {
+        vsg::dmat4 view = camera->viewMatrix->transform();
+        bool moved = view != m_lastView;
+        m_lastView = view;
+
+        // The paged tiles are merged into the scene between the frames
+        if (enabled && pager && pager->numActiveRequests > 0)
+            viewer->request();
+
+        if (moved)
+        {
+            if (!m_moving)
+            {
+                m_moving = true;
+                m_motionStart = frame.time;
+                m_numFrames = 0;
+            }
+            m_numFrames++;
+            if (enabled)
+                viewer->request();
+        }
+        else if (m_moving)
+        {
+            m_moving = false;
+            double ms = std::chrono::duration<double, std::milli>(frame.time - m_motionStart).count();
+            if (ms > 0)
+                spdlog::debug("Camera motion: {} frames in {:.0f} ms = {:.1f} fps",
+                              m_numFrames, ms, m_numFrames*1000.0/ms);
+        }
+    }
+
+private:
+    vsg::dmat4 m_lastView;
+    bool m_moving = false;
+    vsg::time_point m_motionStart;
+    size_t m_numFrames = 0;
+};
+
+// Counts the culling of the scene in each frame for the profiler.
+// That costs about as much as the culling itself, so it is only done
+// while the overlay is shown.
+class CullCountHandler : public vsg::Inherit<vsg::Visitor, CullCountHandler>
+{
+public:
+    CullCountHandler(vsg::ref_ptr<vsg::Camera> camera_,
+                     vsg::ref_ptr<vsg::Node> scene_,
+                     vsg::ref_ptr<FrameProfiler> profiler_) :
+        camera(camera_), scene(scene_), profiler(profiler_) {}
+
+    vsg::ref_ptr<vsg::Camera> camera;
+    vsg::ref_ptr<vsg::Node> scene;
+    vsg::ref_ptr<FrameProfiler> profiler;
+
+    void apply(vsg::FrameEvent&) override
+    {
+        if (!profiler->showOverlay)
+            return;
+
+        auto counts = countCulling(*scene, camera->projectionMatrix->transform()
+                                   * camera->viewMatrix->transform());
+        profiler->setCullCounts(counts.tests, counts.culled, counts.drawn);
+    }
+};
+
+// Keeps the sizes of the points of the point clouds in pixels as the
+// window is resized, or is split by the quad view
+class PointSizeHandler : public vsg::Inherit<vsg::Visitor, PointSizeHandler>
+{
+public:
+    using CameraFunction = std::function<vsg::ref_ptr<vsg::Camera>()>;
+
+    PointSizeHandler(CameraFunction camera_) : camera(camera_) {}
+
+    CameraFunction camera; // Of the perspective view that is shown
+
+    void apply(vsg::FrameEvent&) override
+    {
+        setPointCloudViewportHeight(camera()->getViewport().height);
+    }
+};
+
+// Lays out the quad view again when the window has been resized
+class QuadViewResizeHandler : public vsg::Inherit<vsg::Visitor, QuadViewResizeHandler>
+{
+public:
+    using LayoutFunction = std::function<void(VkExtent2D extent)>;
+
+    QuadViewResizeHandler(vsg::ref_ptr<vsg::Window> window_, LayoutFunction layout_) :
+        window(window_), layout(layout_) {}
+
+    vsg::ref_ptr<vsg::Window> window;
+    LayoutFunction layout;
+
+    void apply(vsg::FrameEvent&) override
+    {
+        auto extent = window->extent2D();
+        if (extent.width == m_extent.width && extent.height == m_extent.height)
+            return;
+        m_extent = extent;
+        layout(extent);
+    }
+
+private:
+    VkExtent2D m_extent{0, 0};
+};
+
+// Passes the events on to the trackball. In the quad view only the
+// presses and scrolls over the perspective view are passed, since the
+// orthographic views have no manipulators of their own.
+class TrackballFilter : public vsg::Inherit<vsg::Visitor, TrackballFilter>
+{
+public:
+    using AcceptFunction = std::function<bool(int32_t x, int32_t y)>;
+
+    TrackballFilter(vsg::ref_ptr<vsg::Trackball> trackball_, AcceptFunction accepts_) :
+        trackball(trackball_), accepts(accepts_) {}
+
+    vsg::ref_ptr<vsg::Trackball> trackball;
+    AcceptFunction accepts;
+
+    void apply(vsg::Object& object) override
+    {
+        object.accept(*trackball);
+    }
+
+    void apply(vsg::ButtonPressEvent& buttonPress) override
+    {
+        if (accepts(buttonPress.x, buttonPress.y))
+            buttonPress.accept(*trackball);
+    }
+
+    void apply(vsg::TouchDownEvent& touchDown) override
+    {
+        if (accepts(touchDown.x, touchDown.y))
+            touchDown.accept(*trackball);
+    }
+
+    void apply(vsg::MoveEvent& move) override
+    {
+        m_x = move.x;
+        m_y = move.y;
+        move.accept(*trackball);
+    }
+
+    void apply(vsg::ScrollWheelEvent& scrollWheel) override
+    {
+        if (accepts(m_x, m_y))
+            scrollWheel.accept(*trackball);
+    }
+
+private:
+    int32_t m_x = 0, m_y = 0; // The last position of the pointer
+};
+
 // Create an arrow with the back at pos and pointing in the direction of dir
 // Place a cone at the end of the arrow with the color color
 static vsg::ref_ptr<vsg::Node>
@@ -132,22 +317,63 @@ Widget3D::createViewGizmo(vsg::ref_ptr<vsg::Camera> camera,
 
 Widget3D::Widget3D(QWidget *parent,
                    vsg::ref_ptr<vsg::Node> vsg_scene,
-                   vsg::ref_ptr<vsg::WindowTraits> windowTraits)
+                   vsg::ref_ptr<vsg::WindowTraits> windowTraits,
+                   const std::string& pipelineCachePath)
   : QWidget(parent),
+    m_pipelineCachePath(pipelineCachePath),
     m_scene(vsg_scene)
 {
     auto window = createWindow(windowTraits, vsg_scene);
+    window->installEventFilter(this);
     m_vsgwidget = QWidget::createWindowContainer(window, this);
     auto layout = new QVBoxLayout;
     layout->addWidget(m_vsgwidget);
     layout->setContentsMargins(0, 0, 0, 0);
     this->setLayout(layout);
     m_vsgwidget->show();
-    m_viewer->continuousUpdate = true;
-    m_viewer->setInterval(20);
 
     m_viewer->addEventHandler(vsg::CloseHandler::create(m_viewer));
+    m_spaceMouseNavigation = SpaceMouseNavigation::create(m_viewer.get(), m_trackball, m_profiler);
+    m_viewer->addEventHandler(m_spaceMouseNavigation);
+    m_renderOnDemand = RenderOnDemand::create(m_viewer.get(), m_view->camera);
+    m_viewer->addEventHandler(m_renderOnDemand);
+    m_viewer->addEventHandler(CullCountHandler::create(m_view->camera, m_scene, m_profiler));
+    setRenderOnDemand(false, 50);
+
+    // The pager of the models that were converted to paged tiles. The
+    // scene is still empty, so the viewer doesn't create one, but it
+    // starts it in the compile.
+    m_databasePager = vsg::DatabasePager::create();
+    for (auto& task : m_viewer->recordAndSubmitTasks)
+        task->databasePager = m_databasePager;
+    m_renderOnDemand->pager = m_databasePager;
+    m_viewer->addEventHandler(TilePrefetcher::create(m_view->camera, m_scene, m_databasePager));
+    m_viewer->addEventHandler(PointSizeHandler::create([this]() {
+        return m_quadView ? m_quadPerspectiveView->camera : m_view->camera;
+    }));
+    m_viewer->addEventHandler(QuadViewResizeHandler::create(
+        window->windowAdapter, [this](VkExtent2D extent) { layoutQuadView(extent); }));
+
+    auto t0 = vsg::clock::now();
     m_viewer->compile();
+    m_viewer->setupThreading();
+    auto& pipelineCache = PipelineCache::instance();
+    spdlog::info("Initial compile took {:.0f} ms. Created {} pipelines in {:.0f} ms {}",
+                 std::chrono::duration<double, std::milli>(vsg::clock::now() - t0).count(),
+                 pipelineCache.numCreated(), pipelineCache.createTime(),
+                 m_pipelineCachePath.empty() ? "without a pipeline cache"
+                 : pipelineCache.loadedSize() ? "with a warm pipeline cache"
+                 : "with a cold pipeline cache");
+
+    // The main window is never destroyed, so save the pipeline cache
+    // while the device is still alive.
+    connect(qApp, &QCoreApplication::aboutToQuit, []() {
+        PipelineCache::instance().close();
+    });
+
+    // ImGui must see the events before the trackball
+    auto& handlers = m_viewer->getEventHandlers();
+    handlers.insert(handlers.begin(), vsgImGui::SendEventsToImGui::create());
 
     setAcceptDrops(true);
     setFocusPolicy(Qt::StrongFocus);
@@ -156,97 +382,24 @@ Widget3D::Widget3D(QWidget *parent,
 
 Widget3D::~Widget3D()
 {
+    PipelineCache::instance().close();
 }
 
-class InsertWireframeSwitch : public vsg::Visitor
-{
-public:
-    std::vector<vsg::Object*> parents;
-    std::set<vsg::Object*> visited;
-    std::map<vsg::BindGraphicsPipeline*, vsg::ref_ptr<vsg::StateSwitch>> pipelineMap;
-    vsg::Mask mask_1 = 0x1;
-    vsg::Mask mask_2 = 0x2;
-
-    void traverse(vsg::Object& object)
-    {
-        parents.push_back(&object);
-        object.traverse(*this);
-        parents.pop_back();
-    }
-
-    void apply(vsg::Object& object) override
-    {
-        traverse(object);
-    }
-
-    vsg::ref_ptr<vsg::GraphicsPipeline> createAlternate(vsg::GraphicsPipeline& pipeline)
-    {
-        auto alternative_pipeline = vsg::GraphicsPipeline::create();
-
-        *alternative_pipeline = pipeline;
-
-        for (auto& pipelineState : alternative_pipeline->pipelineStates)
-        {
-            if (auto rasterizationState = pipelineState.cast<vsg::RasterizationState>())
-            {
-                auto alternate_rasterizationState = vsg::RasterizationState::create(*rasterizationState);
-
-                alternate_rasterizationState->polygonMode = VK_POLYGON_MODE_LINE;
-                pipelineState = alternate_rasterizationState;
-            }
-        }
-        return alternative_pipeline;
-    }
-
-    void apply(vsg::StateGroup& sg) override
-    {
-        if (visited.count(&sg) > 0) return;
-        visited.insert(&sg);
-
-        for (auto& sc : sg.stateCommands)
-        {
-            if (auto bgp = sc->cast<vsg::BindGraphicsPipeline>())
-            {
-                auto& stateSwitch = pipelineMap[bgp];
-
-                if (!stateSwitch)
-                {
-                    stateSwitch = vsg::StateSwitch::create();
-                    stateSwitch->slot = bgp->slot;
-                    stateSwitch->add(mask_1, sc);
-
-                    auto alternate_gp = createAlternate(*(bgp->pipeline));
-                    auto alternate_bgp = vsg::BindGraphicsPipeline::create(alternate_gp);
-
-                    stateSwitch->add(mask_2, alternate_bgp);
-                }
-                sc = stateSwitch;
-            }
-        }
-
-        traverse(sg);
-    }
-};
-
-
 vsgQt::Window* Widget3D::createWindow(
   vsg::ref_ptr<vsg::WindowTraits> windowTraits,
   vsg::ref_ptr<vsg::Node> vsg_scene)
 
 {
-    m_viewer = vsgQt::Viewer::create();
+    // The viewer reports the time of each phase of its frames
+    m_profiler = FrameProfiler::create();
+    auto viewer = ProfilingViewer::create();
+    viewer->profiler = m_profiler;
+    m_viewer = viewer;
     auto window = new vsgQt::Window(m_viewer, windowTraits, (QWindow*)nullptr);
 
     // Insert a wireframe switch. This should perhaps be modified
     // if using a tray.
-    vsg::Mask mask_1 = 0x1;
-    vsg::Mask mask_2 = 0x2;
-    {
-        InsertWireframeSwitch wireframeVisitor;
-        wireframeVisitor.mask_1 = mask_1;
-        wireframeVisitor.mask_2 = mask_2;
-        vsg_scene->accept(wireframeVisitor);
-    }
+    insertWireframeSwitch(*vsg_scene);
 
     // Turn off the wireframe switch
     window->initializeWindow();
@@ -255,12 +408,16 @@ vsgQt::Window* Widget3D::createWindow(
     if (!windowTraits->device)
         windowTraits->device = window->windowAdapter->getOrCreateDevice();
 
+    m_profiler->setupTimestamps(window->windowAdapter->getOrCreateDevice(),
+                                window->windowAdapter->getOrCreatePhysicalDevice());
+
+    // The pipelines of the first compile should already use the cache.
+    // Without a cache they are still counted.
+    PipelineCache::instance().open(window->windowAdapter->getOrCreateDevice(),
+                                   m_pipelineCachePath);
+
     // compute the bounds of the scene graph to help position camera
-    vsg::ComputeBounds computeBounds;
-    vsg_scene->accept(computeBounds);
-    m_center = (computeBounds.bounds.min + computeBounds.bounds.max) * 0.5;
-    m_radius = vsg::length(computeBounds.bounds.max - computeBounds.bounds.min) * 0.6;
-    double nearFarRatio = 0.001;
+    computeBounds();
 
     uint32_t width = window->traits->width;
     uint32_t height = window->traits->height;
@@ -270,22 +427,22 @@ vsgQt::Window* Widget3D::createWindow(
     vsg::ref_ptr<vsg::Camera> camera;
     {
         // set up the camera
-        auto lookAt = vsg::LookAt::create(m_center + vsg::dvec3(m_radius, -m_radius * 2.5, m_radius),
-                                          m_center, vsg::dvec3(0.0, 0.0, 1.0));
+        auto lookAt = createViewpoint(Viewpoint::DIAG, m_center, m_radius);
 
         vsg::ref_ptr<vsg::ProjectionMatrix> perspective;
         if (ellipsoidModel)
         {
             perspective = vsg::EllipsoidPerspective::create(
                 lookAt, ellipsoidModel, 30.0, aspectRatio,
-                nearFarRatio, false);
+                NEAR_FAR_RATIO, false);
         }
         else
         {
-            perspective = vsg::Perspective::create(
+            m_perspective = vsg::Perspective::create(
                 30.0,
                 aspectRatio,
-                nearFarRatio * m_radius, m_radius * 4.5);
+                framingNear(m_radius), framingFar(m_radius));
+            perspective = m_perspective;
         }
 
         camera = vsg::Camera::create(perspective, lookAt, vsg::ViewportState::create(VkExtent2D{width, height}));
@@ -295,78 +452,210 @@ vsgQt::Window* Widget3D::createWindow(
     m_trackball->addWindow(*window);
     autoScale();
 
-    m_viewer->addEventHandler(m_trackball);
+    m_trackballFilter = TrackballFilter::create(m_trackball, [this](int32_t x, int32_t y) {
+        return !m_quadView || cameraAt(x, y) == m_quadPerspectiveView->camera;
+    });
+    m_viewer->addEventHandler(m_trackballFilter);
     auto scene = vsg::StateGroup::create();
     scene->addChild(vsg::createHeadlight());
     scene->addChild(vsg_scene);
 
     m_commandGraph = vsg::CommandGraph::create(*window);
-    vsg::ref_ptr<vsg::Framebuffer> framebuffer;
-    vsg::ImageViews atttachments;
-
     auto renderGraph = vsg::RenderGraph::create(*window);
-    m_view = vsg::View::create(camera);
-    m_view->mask = mask_1;
-    m_view->addChild(scene);
 
-    renderGraph->addChild(m_view);
+    // Each view is recorded into a secondary command buffer of its
+    // own, which the viewer records on a thread of its own. The views
+    // that the layout doesn't show record empty buffers.
+    renderGraph->contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+    auto executeCommands = vsg::ExecuteCommands::create();
+    renderGraph->addChild(executeCommands);
+    vsg::CommandGraphs commandGraphs{m_commandGraph};
+    auto addSecondary = [&](vsg::ref_ptr<vsg::Node> child) {
+        auto secondary = vsg::SecondaryCommandGraph::create(*window);
+        secondary->addChild(child);
+        executeCommands->connect(secondary);
+        commandGraphs.push_back(secondary);
+    };
+    auto addLayoutSecondary = [&](std::vector<vsg::ref_ptr<vsg::Switch>>& layout,
+                                  vsg::ref_ptr<vsg::Node> child) {
+        auto layoutSwitch = vsg::Switch::create();
+        layoutSwitch->addChild(&layout == &m_singleLayout, child);
+        layout.push_back(layoutSwitch);
+        addSecondary(layoutSwitch);
+    };
 
-    renderGraph->addChild(createViewGizmo(camera, aspectRatio));
+    m_view = vsg::View::create(camera);
+    m_view->mask = WIREFRAME_MASK_SHADED;
+    m_view->addChild(scene);
+    addLayoutSecondary(m_singleLayout, m_view);
+
+    // The quad view: top, perspective, front and right, left to right
+    // and top to bottom. The cells are laid out by layoutQuadView().
+    m_quadPerspective = vsg::Perspective::create(30.0, aspectRatio,
+                                                 framingNear(m_radius), framingFar(m_radius));
+    auto quadCamera = vsg::Camera::create(m_quadPerspective, camera->viewMatrix,
+                                          vsg::ViewportState::create(VkExtent2D{width, height}));
+    m_quadPerspectiveView = vsg::View::create(quadCamera);
+    m_quadPerspectiveView->mask = WIREFRAME_MASK_SHADED;
+    m_quadPerspectiveView->addChild(scene);
+    addLayoutSecondary(m_quadLayout, m_quadPerspectiveView);
+
+    const std::pair<Viewpoint, std::pair<int, int>> orthoViewpoints[] = {
+        {Viewpoint::TOP, {0, 0}}, {Viewpoint::FRONT, {0, 1}}, {Viewpoint::RIGHT, {1, 1}}};
+    for (auto& [viewpoint, cell] : orthoViewpoints)
+    {
+        OrthoView ortho;
+        ortho.viewpoint = viewpoint;
+        ortho.cell = cell;
+        ortho.lookAt = createViewpoint(viewpoint, m_center, m_radius);
+        ortho.orthographic = vsg::Orthographic::create();
+        ortho.view = vsg::View::create(vsg::Camera::create(ortho.orthographic, ortho.lookAt,
+                                                           vsg::ViewportState::create(VkExtent2D{width, height})));
+        ortho.view->mask = WIREFRAME_MASK_SHADED;
+        ortho.view->addChild(scene);
+        addLayoutSecondary(m_quadLayout, ortho.view);
+        m_orthoViews.push_back(ortho);
+    }
+    layoutQuadView(VkExtent2D{width, height});
 
+    // The GPU time of the views is measured by the timestamps between
+    // them, and the first one is written before the render pass
+    m_commandGraph->addChild(m_profiler->createResetCommand());
+    m_commandGraph->addChild(m_profiler->createTimestampCommand(0));
     m_commandGraph->addChild(renderGraph);
 
-    m_viewer->addRecordAndSubmitTaskAndPresentation({m_commandGraph});
+    auto overlay = vsg::Group::create();
+    overlay->addChild(m_profiler->createTimestampCommand(1));
+    auto singleGizmo = vsg::Switch::create();
+    singleGizmo->addChild(true, createViewGizmo(camera, aspectRatio));
+    m_singleLayout.push_back(singleGizmo);
+    overlay->addChild(singleGizmo);
+    auto quadGizmo = vsg::Switch::create();
+    quadGizmo->addChild(false, createViewGizmo(quadCamera, aspectRatio));
+    m_quadLayout.push_back(quadGizmo);
+    overlay->addChild(quadGizmo);
+    overlay->addChild(m_profiler->createTimestampCommand(2));
+    overlay->addChild(vsgImGui::RenderImGui::create(window->windowAdapter,
+                                                    m_profiler->createOverlay()));
+    addSecondary(overlay);
+
+    m_viewer->addRecordAndSubmitTaskAndPresentation(commandGraphs);
 
     return window;
 }
 
-void Widget3D::updateTrackball(double dx, double dy, double dz,
-                               double xrot, double yrot, double zrot)
+// The local files of a drag, or an empty list if there are none
+static QStringList droppedFiles(const QMimeData *mimeData)
 {
-  m_trackball->pan({dx,dy});
-  m_trackball->zoom(dz);
-  m_trackball->rotate(xrot, vsg::dvec3(1,0,0));
-  m_trackball->rotate(yrot, vsg::dvec3(0,1,0));
-  m_trackball->rotate(zrot, vsg::dvec3(0,0,1));
-    
-  m_viewer->update();
-  m_viewer->request();
-  m_viewer->render();
+    QStringList filenames;
+    if (!mimeData || !mimeData->hasUrls())
+        return filenames;
+    for (auto& url : mimeData->urls())
+        if (url.isLocalFile())
+            filenames << url.toLocalFile();
+    return filenames;
+}
+
+void Widget3D::dragEnterEvent(QDragEnterEvent *event)
+{
+    if (!droppedFiles(event->mimeData()).isEmpty())
+        event->acceptProposedAction();
+}
+
+void Widget3D::dropEvent(QDropEvent *event)
+{
+    auto filenames = droppedFiles(event->mimeData());
+    if (filenames.isEmpty())
+        return;
+    event->acceptProposedAction();
+    emit filesDropped(filenames);
 }
 
-void Widget3D::compile()
+bool Widget3D::eventFilter(QObject *watched, QEvent *event)
 {
-  m_viewer->compile();
+    switch (event->type())
+    {
+    case QEvent::DragEnter:
+    case QEvent::DragMove:
+    {
+        auto dragEvent = static_cast<QDragMoveEvent*>(event);
+        if (droppedFiles(dragEvent->mimeData()).isEmpty())
+            return false;
+        dragEvent->acceptProposedAction();
+        return true;
+    }
+    case QEvent::Drop:
+        dropEvent(static_cast<QDropEvent*>(event));
+        return true;
+    default:
+        return QWidget::eventFilter(watched, event);
+    }
+}
+
+void Widget3D::insertEventHandler(vsg::ref_ptr<vsg::Visitor> handler)
+{
+    auto& handlers = m_viewer->getEventHandlers();
+    auto pos = std::find(handlers.begin(), handlers.end(), m_trackballFilter);
+    handlers.insert(pos, handler);
+}
+
+void Widget3D::setSpaceMouse(SpaceMouse *spaceMouse)
+{
+    m_spaceMouseNavigation->spaceMouse = spaceMouse;
+    if (spaceMouse)
+        connect(spaceMouse, &SpaceMouse::motionReceived,
+                this, &Widget3D::requestRender);
+}
+
+// Get the center and the radius of m_scene. The scene is empty until
+// the first model has been loaded, which gives a unit sphere. Only the
+// containers above the models are traversed, as the bounds of the
+// models are stored on them when they are loaded.
+void Widget3D::computeBounds()
+{
+    computeFraming(*m_scene, m_center, m_radius);
 }
 
 // Setup the camera to match the contents in the m_scene
 void Widget3D::autoScale(bool changeRotation)
 {
-    vsg::ComputeBounds computeBounds;
-    m_scene->accept(computeBounds);
-    m_center = (computeBounds.bounds.min + computeBounds.bounds.max) * 0.5;
-    m_radius = vsg::length(computeBounds.bounds.max - computeBounds.bounds.min) * 0.6;
+    computeBounds();
+
+    // The near and far planes follow the size of the model
+    if (m_perspective)
+    {
+        m_perspective->nearDistance = framingNear(m_radius);
+        m_perspective->farDistance = framingFar(m_radius);
+    }
+    // The quad view is set up after the first framing
+    if (m_quadPerspective)
+    {
+        m_quadPerspective->nearDistance = framingNear(m_radius);
+        m_quadPerspective->farDistance = framingFar(m_radius);
+        updateOrthoViews();
+    }
 
     // set up the camera
-    auto lookAt = vsg::LookAt::create(m_center + vsg::dvec3(m_radius, -m_radius * 2.5, m_radius),
-                                      m_center, vsg::dvec3(0.0, 0.0, 1.0));
+    auto lookAt = createViewpoint(Viewpoint::DIAG, m_center, m_radius);
 
     if (changeRotation)
         m_trackball->setViewpoint(lookAt, 0.1);
 
+    // A reload usually doesn't change the framing, and then the key
+    // viewpoints are still valid
+    if (m_radius == m_keyViewpointRadius && m_center == m_keyViewpointCenter)
+    {
+        requestRender();
+        return;
+    }
+    m_keyViewpointCenter = m_center;
+    m_keyViewpointRadius = m_radius;
+
     // Setup keybindings for looking from different dirs
-    auto lookAtDiag = vsg::LookAt::create(m_center + vsg::dvec3(m_radius, -m_radius * 2.5, m_radius),
-                                          m_center,
-                                          vsg::dvec3(0.0, 0.0, 1.0));
-    auto lookAtTop = vsg::LookAt::create(m_center + vsg::dvec3(0.0, 0.0, m_radius * 2.5),
-                                         m_center,
-                                         vsg::dvec3(0.0, 1.0, 0.0));
-    auto lookAtFront = vsg::LookAt::create(m_center + vsg::dvec3(0.0, -m_radius * 2.5, 0.0),
-                                           m_center,
-                                           vsg::dvec3(0.0, 0.0, 1.0));
-    auto lookAtRight = vsg::LookAt::create(m_center + vsg::dvec3(m_radius * 2.5, 0.0, 0.0),
-                                           m_center,
-                                           vsg::dvec3(0.0, 0.0, 1.0));
+    auto lookAtDiag = createViewpoint(Viewpoint::DIAG, m_center, m_radius);
+    auto lookAtTop = createViewpoint(Viewpoint::TOP, m_center, m_radius);
+    auto lookAtFront = createViewpoint(Viewpoint::FRONT, m_center, m_radius);
+    auto lookAtRight = createViewpoint(Viewpoint::RIGHT, m_center, m_radius);
 
     m_trackball->addKeyViewpoint(vsg::KeySymbol::KEY_f, lookAtDiag, 0.5);
 
@@ -385,15 +674,114 @@ void Widget3D::autoScale(bool changeRotation)
     m_trackball->addKeyViewpoint(vsg::KeySymbol::KEY_KP_3, lookAtRight, 0.5);
     m_trackball->addKeyViewpoint(vsg::KeySymbol::KEY_KP_Page_Down, lookAtRight, 0.5);
     m_trackball->addKeyViewpoint(vsg::KeySymbol::KEY_Page_Down, lookAtRight, 0.5);
+
+    // Start the animation to the new viewpoint
+    requestRender();
+}
+
+double Widget3D::homeScreenHeightRatio(double radius) const
+{
+    double fovy = m_perspective ? m_perspective->fieldOfViewY : 30.0;
+    double homeDistance = viewpointDistance(Viewpoint::DIAG, m_radius);
+    return radius / (tan(vsg::radians(fovy) * 0.5) * homeDistance);
 }
 
 void Widget3D::setWireframeMode(bool wireframe)
 {
-    auto mask = wireframe ? 0x2 : 0x1;
+    auto mask = wireframe ? WIREFRAME_MASK_LINE : WIREFRAME_MASK_SHADED;
     m_view->mask = mask;
+    m_quadPerspectiveView->mask = mask;
+    for (auto& ortho : m_orthoViews)
+        ortho.view->mask = mask;
+
+    requestRender();
+}
+
+// The orthographic views are fixed and frame the whole model. Their
+// extents keep the aspect ratio of their viewports.
+void Widget3D::updateOrthoViews()
+{
+    double extent = m_radius * 1.05;
+    for (auto& ortho : m_orthoViews)
+    {
+        auto lookAt = createViewpoint(ortho.viewpoint, m_center, m_radius);
+        ortho.lookAt->set(lookAt->eye, lookAt->center, lookAt->up);
+
+        auto viewport = ortho.view->camera->getViewport();
+        double aspectRatio = viewport.height > 0 ? double(viewport.width) / viewport.height : 1.0;
+        auto& orthographic = *ortho.orthographic;
+        orthographic.left = -extent * aspectRatio;
+        orthographic.right = extent * aspectRatio;
+        orthographic.bottom = -extent;
+        orthographic.top = extent;
+        orthographic.nearDistance = framingNear(m_radius);
+        orthographic.farDistance = framingFar(m_radius);
+    }
+}
+
+// Split the window into the four cells of the quad view
+void Widget3D::layoutQuadView(VkExtent2D extent)
+{
+    uint32_t halfWidth = extent.width/2, halfHeight = extent.height/2;
+    auto setCell = [&](vsg::Camera& camera, std::pair<int, int> cell) {
+        camera.viewportState->set(int32_t(cell.first*halfWidth), int32_t(cell.second*halfHeight),
+                                  halfWidth, halfHeight);
+    };
+
+    setCell(*m_quadPerspectiveView->camera, {1, 0});
+    if (halfHeight > 0)
+        m_quadPerspective->aspectRatio = double(halfWidth) / halfHeight;
+    for (auto& ortho : m_orthoViews)
+        setCell(*ortho.view->camera, ortho.cell);
+    updateOrthoViews();
+}
+
+void Widget3D::setQuadView(bool quadView)
+{
+    m_quadView = quadView;
+    for (auto& layoutSwitch : m_singleLayout)
+        layoutSwitch->setAllChildren(!quadView);
+    for (auto& layoutSwitch : m_quadLayout)
+        layoutSwitch->setAllChildren(quadView);
+
+    requestRender();
+}
+
+vsg::ref_ptr<vsg::Camera> Widget3D::cameraAt(int32_t x, int32_t y) const
+{
+    if (!m_quadView)
+        return m_view->camera;
+
+    std::vector<vsg::ref_ptr<vsg::View>> views{m_quadPerspectiveView};
+    for (auto& ortho : m_orthoViews)
+        views.push_back(ortho.view);
+    for (auto& view : views)
+    {
+        auto viewport = view->camera->getViewport();
+        if (x >= viewport.x && x < viewport.x + viewport.width
+            && y >= viewport.y && y < viewport.y + viewport.height)
+            return view->camera;
+    }
+    return {};
+}
 
-    m_viewer->update();
+void Widget3D::setWireframeOverlay(WireframeOverlay mode)
+{
+    ::setWireframeOverlay(mode);
+
+    requestRender();
+}
+
+void Widget3D::setRenderOnDemand(bool onDemand, double maxFrameRate)
+{
+    m_viewer->continuousUpdate = !onDemand;
+    m_viewer->setInterval(int(1000.0/std::max(maxFrameRate, 1.0)));
+    m_renderOnDemand->enabled = onDemand;
+    requestRender();
+}
+
+void Widget3D::requestRender()
+{
     m_viewer->request();
-    m_viewer->render();
 }
 
@@ -9,7 +9,15 @@
 
 #include <vsg/all.h>
 #include <vsgQt/Window.h>
+#include "frameprofiler.h"
+#include "wireframe.h"
+#include "viewpoints.h"
 #include <QWidget>
+#include <QStringList>
+
+class RenderOnDemand;
+class SpaceMouse;
+class SpaceMouseNavigation;
 
 class Widget3D : public QWidget
 {
@@ -18,31 +26,104 @@ class Widget3D : public QWidget
 public:
     Widget3D(QWidget *parent = 0,
              vsg::ref_ptr<vsg::Node> scene = nullptr,
-             vsg::ref_ptr<vsg::WindowTraits> traits = nullptr);
+             vsg::ref_ptr<vsg::WindowTraits> traits = nullptr,
+             const std::string& pipelineCachePath = {});
     ~Widget3D();
 
-    void updateTrackball(double dx, double dy, double dz,
-                         double xrot, double yrot, double zrot);
-    void compile();
+    // Navigate with spaceMouse. Its motion is applied once per frame.
+    void setSpaceMouse(SpaceMouse *spaceMouse);
     void autoScale(bool changeRotation = true);
     void setWireframeMode(bool wireframe);
 
+    // Draw the edges of the models that were loaded with barycentrics,
+    // which don't switch to line mode pipelines
+    void setWireframeOverlay(WireframeOverlay mode);
+
+    // Only render when something has changed instead of continuously.
+    // In both modes at most maxFrameRate frames are rendered per second.
+    void setRenderOnDemand(bool onDemand, double maxFrameRate = 60);
+
+    // Render a frame with the current state of the scene
+    void requestRender();
+    vsg::ref_ptr<vsg::Viewer> viewer() { return m_viewer; }
+    vsg::ref_ptr<vsg::Camera> camera() { return m_view->camera; }
+
+    // Pages the tiles of the models that were converted to tiles
+    vsg::ref_ptr<vsg::DatabasePager> databasePager() { return m_databasePager; }
+
+    // Show the top, front and right orthographic views next to the
+    // perspective one. All the views draw the same compiled scene.
+    void setQuadView(bool quadView);
+
+    // The camera of the view that is shown at the window coordinates
+    vsg::ref_ptr<vsg::Camera> cameraAt(int32_t x, int32_t y) const;
+
+    // Add an event handler that sees the mouse events before the
+    // trackball does
+    void insertEventHandler(vsg::ref_ptr<vsg::Visitor> handler);
+    FrameProfiler* profiler() { return m_profiler; }
+
+    // The screen height ratio, as used by vsg::LOD, of a sphere of
+    // radius in the center of the home view set up by autoScale().
+    double homeScreenHeightRatio(double radius) const;
+
+signals:
+    // Model files were dropped on the widget
+    void filesDropped(const QStringList& filenames);
+
+protected:
+    void dragEnterEvent(QDragEnterEvent *event) override;
+    void dropEvent(QDropEvent *event) override;
+
+    // The drops on the vsg window, which is a QWindow and not a widget
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private:
     vsgQt::Window* createWindow(
       vsg::ref_ptr<vsg::WindowTraits> traits,
       vsg::ref_ptr<vsg::Node> vsg_scene);
 
+    void computeBounds();
+
     vsg::ref_ptr<vsg::View> createViewGizmo(vsg::ref_ptr<vsg::Camera> camera,
                                             double aspectRatio);
+    void updateOrthoViews();
+    void layoutQuadView(VkExtent2D extent);
 
     QWidget *m_vsgwidget = nullptr;
+    std::string m_pipelineCachePath;
     vsg::ref_ptr<vsg::Node> m_scene;
     vsg::ref_ptr<vsgQt::Viewer> m_viewer;
     vsg::ref_ptr<vsg::View> m_view;
     vsg::ref_ptr<vsg::Trackball> m_trackball;
+    vsg::ref_ptr<vsg::Visitor> m_trackballFilter; // Passes the events to m_trackball
+    vsg::ref_ptr<vsg::Perspective> m_perspective;
     vsg::ref_ptr<vsg::CommandGraph> m_commandGraph;
+    vsg::ref_ptr<RenderOnDemand> m_renderOnDemand;
+    vsg::ref_ptr<SpaceMouseNavigation> m_spaceMouseNavigation;
+    vsg::ref_ptr<FrameProfiler> m_profiler;
+    vsg::ref_ptr<vsg::DatabasePager> m_databasePager;
+
+    // The views of the quad view. Its perspective view shares the view
+    // matrix of m_view, and so the trackball.
+    struct OrthoView
+    {
+        Viewpoint viewpoint;
+        std::pair<int, int> cell; // Column and row
+        vsg::ref_ptr<vsg::LookAt> lookAt;
+        vsg::ref_ptr<vsg::Orthographic> orthographic;
+        vsg::ref_ptr<vsg::View> view;
+    };
+    bool m_quadView = false;
+    vsg::ref_ptr<vsg::View> m_quadPerspectiveView;
+    vsg::ref_ptr<vsg::Perspective> m_quadPerspective;
+    std::vector<OrthoView> m_orthoViews;
+    std::vector<vsg::ref_ptr<vsg::Switch>> m_singleLayout; // On without the quad view
+    std::vector<vsg::ref_ptr<vsg::Switch>> m_quadLayout;
     vsg::dvec3 m_center;
     double m_radius;
+    vsg::dvec3 m_keyViewpointCenter;
+    double m_keyViewpointRadius = 0;
 };
 
 #endif /* WIDGET3D */
@@ -0,0 +1,670 @@
+//======================================================================
+//  wireframe.cpp - Switching of a scene graph between shaded and wireframe
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+
+#include "wireframe.h"
+#include "parallel.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <map>
+#include <regex>
+#include <set>
+#include <unordered_map>
+
+using namespace std;
+
+class InsertWireframeSwitch : public vsg::Visitor
+{
+public:
+    std::vector<vsg::Object*> parents;
+    std::set<vsg::Object*> visited;
+    std::map<vsg::BindGraphicsPipeline*, vsg::ref_ptr<vsg::StateSwitch>> pipelineMap;
+    vsg::Mask mask_1 = 0x1;
+    vsg::Mask mask_2 = 0x2;
+
+    void traverse(vsg::Object& object)
+    {
+        parents.push_back(&object);
+        object.traverse(*this);
+        parents.pop_back();
+    }
+
+    void apply(vsg::Object& object) override
+    {
+        traverse(object);
+    }
+
+    vsg::ref_ptr<vsg::GraphicsPipeline> createAlternate(vsg::GraphicsPipeline& pipeline)
+    {
+        auto alternative_pipeline = vsg::GraphicsPipeline::create();
+
+        *alternative_pipeline = pipeline;
+
+        for (auto& pipelineState : alternative_pipeline->pipelineStates)
+        {
+            if (auto rasterizationState = pipelineState.cast<vsg::RasterizationState>())
+            {
+                auto alternate_rasterizationState = vsg::RasterizationState::create(*rasterizationState);
+
+                alternate_rasterizationState->polygonMode = VK_POLYGON_MODE_LINE;
+                pipelineState = alternate_rasterizationState;
+            }
+        }
+        return alternative_pipeline;
+    }
+
+    void apply(vsg::StateGroup& sg) override
+    {
+        if (visited.count(&sg) > 0) return;
+        visited.insert(&sg);
+
+        for (auto& sc : sg.stateCommands)
+        {
+            if (auto bgp = sc->cast<vsg::BindGraphicsPipeline>())
+            {
+                auto& stateSwitch = pipelineMap[bgp];
+
+                if (!stateSwitch)
+                {
+                    stateSwitch = vsg::StateSwitch::create();
+                    stateSwitch->slot = bgp->slot;
+                    stateSwitch->add(mask_1, sc);
+
+                    auto alternate_gp = createAlternate(*(bgp->pipeline));
+                    auto alternate_bgp = vsg::BindGraphicsPipeline::create(alternate_gp);
+
+                    stateSwitch->add(mask_2, alternate_bgp);
+                }
+                sc = stateSwitch;
+            }
+        }
+
+        traverse(sg);
+    }
+};
+
+void insertWireframeSwitch(vsg::Node& node,
+                           vsg::Mask maskShaded,
+                           vsg::Mask maskLine)
+{
+    InsertWireframeSwitch wireframeVisitor;
+    wireframeVisitor.mask_1 = maskShaded;
+    wireframeVisitor.mask_2 = maskLine;
+    node.accept(wireframeVisitor);
+}
+
+// The key of the value on the overlay pipelines that holds the index
+// of the descriptor set of the overlay uniform
+static const char *OVERLAY_SET_KEY = "wireframeOverlaySet";
+
+// The uniform of the overlay and the descriptor set that holds it,
+// which are shared by all the models
+struct OverlayState
+{
+    vsg::ref_ptr<vsg::vec4Array> params; // mode and line width, edge color
+    vsg::ref_ptr<vsg::DescriptorSetLayout> setLayout;
+    vsg::ref_ptr<vsg::DescriptorSet> descriptorSet;
+
+    OverlayState()
+    {
+        params = vsg::vec4Array::create(2);
+        params->properties.dataVariance = vsg::DYNAMIC_DATA;
+        (*params)[0] = vsg::vec4(0.0f, 1.5f, 0.0f, 0.0f);
+        (*params)[1] = vsg::vec4(0.05f, 0.05f, 0.05f, 1.0f);
+        setLayout = vsg::DescriptorSetLayout::create(vsg::DescriptorSetLayoutBindings{
+            {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr}});
+        descriptorSet = vsg::DescriptorSet::create(setLayout, vsg::Descriptors{
+            vsg::DescriptorBuffer::create(params, 0, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)});
+    }
+};
+
+static OverlayState& overlayState()
+{
+    static OverlayState state;
+    return state;
+}
+
+// The edge is computed before the original main() runs, so that the
+// discarded fragments of the wire mode aren't shaded
+static const char *OVERLAY_MAIN_GLSL =
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    float wire_edge = 0.0;\n"
+    "    if (wire_overlay.params.x > 0.5)\n"
+    "    {\n"
+    "        vec3 width = fwidth(wire_barycentric) * wire_overlay.params.y;\n"
+    "        vec3 inside = smoothstep(width * 0.5, width, wire_barycentric);\n"
+    "        wire_edge = 1.0 - min(min(inside.x, inside.y), inside.z);\n"
+    "        if (wire_overlay.params.x > 1.5 && wire_edge < 0.5)\n"
+    "            discard;\n"
+    "    }\n"
+    "    wire_shadedMain();\n"
+    "    if (wire_overlay.params.x > 0.5 && wire_overlay.params.x < 1.5)\n"
+    "        OUTPUT.rgb = mix(OUTPUT.rgb, wire_overlay.color.rgb, wire_edge * wire_overlay.color.a);\n"
+    "}\n";
+
+static const std::regex MAIN_DECLARATION(R"(\bvoid\s+main\s*\(\s*\))");
+
+// The highest location of the declarations with the given storage
+// qualifier, e.g. "layout(location = 3) in", or -1
+static int maxLocation(const string& source, const string& qualifier)
+{
+    std::regex declaration(R"(layout\s*\(\s*location\s*=\s*(\d+)\s*\)\s*(?:flat\s+|smooth\s+|noperspective\s+)?)"
+                           + qualifier + R"(\s)");
+    int location = -1;
+    for (std::sregex_iterator it(source.begin(), source.end(), declaration), end; it != end; ++it)
+        location = std::max(location, std::stoi((*it)[1].str()));
+    return location;
+}
+
+static bool insertBeforeMain(string& source, const string& text)
+{
+    std::smatch match;
+    if (!std::regex_search(source, match, MAIN_DECLARATION))
+        return false;
+    source.insert(match.position(0), text);
+    return true;
+}
+
+// How the draws below a pipeline get their barycentrics
+struct OverlayLayout
+{
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> bind; // Of the variant, or null
+    uint32_t binding = 0;                         // Of the barycentrics
+    std::set<uint32_t> vertexBindings;            // The per vertex arrays
+};
+
+static vsg::BindGraphicsPipeline *findPipeline(vsg::StateGroup& sg)
+{
+    for (auto& sc : sg.stateCommands)
+        if (auto bgp = sc->cast<vsg::BindGraphicsPipeline>())
+            return bgp;
+    return nullptr;
+}
+
+// Create the variant of the pipeline of bind that draws the overlay.
+// Its layout has a null bind if the pipeline isn't supported.
+static OverlayLayout createOverlayLayout(const vsg::BindGraphicsPipeline& bind)
+{
+    OverlayLayout layout;
+    auto pipeline = bind.pipeline;
+    if (!pipeline || !pipeline->layout || pipeline->layout->setLayouts.size() >= 4)
+        return layout;
+
+    vsg::ref_ptr<vsg::ShaderStage> vertexStage, fragmentStage;
+    for (auto& s : pipeline->stages)
+    {
+        if (s->stage == VK_SHADER_STAGE_VERTEX_BIT)
+            vertexStage = s;
+        else if (s->stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+            fragmentStage = s;
+        else
+            return layout;
+    }
+    const vsg::VertexInputState *vis = nullptr;
+    bool triangleList = false;
+    for (auto& state : pipeline->pipelineStates)
+    {
+        if (auto v = state->cast<vsg::VertexInputState>())
+            vis = v;
+        if (auto ias = state->cast<vsg::InputAssemblyState>())
+            triangleList = ias->topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    }
+    if (!vertexStage || !vertexStage->module || vertexStage->module->source.empty()
+        || !fragmentStage || !fragmentStage->module || fragmentStage->module->source.empty()
+        || !vis || vis->vertexBindingDescriptions.empty() || !triangleList)
+        return layout;
+
+    auto vertexSource = vertexStage->module->source;
+    auto fragmentSource = fragmentStage->module->source;
+    static const std::regex outputDeclaration(R"(layout\s*\(\s*location\s*=\s*0\s*\)\s*out\s+vec4\s+(\w+)\s*;)");
+    std::smatch output;
+    if (!std::regex_search(fragmentSource, output, outputDeclaration))
+        return layout;
+    string outputName = output[1].str();
+
+    // New locations after all the declared ones, also those that are
+    // only declared for some of the defines
+    int attributeLocation = maxLocation(vertexSource, "in");
+    for (auto& attribute : vis->vertexAttributeDescriptions)
+        attributeLocation = std::max(attributeLocation, int(attribute.location));
+    attributeLocation++;
+    int varyingLocation = std::max(maxLocation(vertexSource, "out"),
+                                   maxLocation(fragmentSource, "in")) + 1;
+    uint32_t set = uint32_t(pipeline->layout->setLayouts.size());
+
+    if (!insertBeforeMain(vertexSource,
+                          fmt::format("layout(location = {}) in vec3 wire_Barycentric;\n"
+                                      "layout(location = {}) out vec3 wire_barycentric;\n\n",
+                                      attributeLocation, varyingLocation)))
+        return layout;
+    static const std::regex mainBody(R"(\bvoid\s+main\s*\(\s*\)\s*\{)");
+    vertexSource = std::regex_replace(vertexSource, mainBody,
+                                      "$&\n    wire_barycentric = wire_Barycentric;",
+                                      std::regex_constants::format_first_only);
+
+    if (!insertBeforeMain(fragmentSource,
+                          fmt::format("layout(location = {}) in vec3 wire_barycentric;\n\n"
+                                      "layout(set = {}, binding = 0) uniform WireframeOverlay\n"
+                                      "{{\n"
+                                      "    vec4 params; // mode, line width\n"
+                                      "    vec4 color;\n"
+                                      "}} wire_overlay;\n\n",
+                                      varyingLocation, set)))
+        return layout;
+    fragmentSource = std::regex_replace(fragmentSource, MAIN_DECLARATION, "void wire_shadedMain()",
+                                        std::regex_constants::format_first_only);
+    fragmentSource += std::regex_replace(OVERLAY_MAIN_GLSL, std::regex("OUTPUT"), outputName);
+
+    for (auto& description : vis->vertexBindingDescriptions)
+    {
+        layout.binding = std::max(layout.binding, description.binding + 1);
+        if (description.inputRate == VK_VERTEX_INPUT_RATE_VERTEX)
+            layout.vertexBindings.insert(description.binding);
+    }
+    auto vertexInput = vsg::VertexInputState::create(vis->vertexBindingDescriptions,
+                                                     vis->vertexAttributeDescriptions);
+    vertexInput->vertexBindingDescriptions.push_back(
+        VkVertexInputBindingDescription{layout.binding, sizeof(vsg::ubvec4), VK_VERTEX_INPUT_RATE_VERTEX});
+    vertexInput->vertexAttributeDescriptions.push_back(
+        VkVertexInputAttributeDescription{uint32_t(attributeLocation), layout.binding,
+                                          VK_FORMAT_R8G8B8A8_UNORM, 0});
+
+    auto states = pipeline->pipelineStates;
+    for (auto& state : states)
+        if (state->cast<vsg::VertexInputState>())
+            state = vertexInput;
+
+    auto createStage = [](const vsg::ShaderStage& stage, const string& source) {
+        auto variantStage = vsg::ShaderStage::create(stage.stage, stage.entryPointName,
+                                                     vsg::ShaderModule::create(source, stage.module->hints));
+        variantStage->specializationConstants = stage.specializationConstants;
+        return variantStage;
+    };
+    vsg::ShaderStages stages;
+    for (auto& s : pipeline->stages)
+        stages.push_back(s == vertexStage ? createStage(*s, vertexSource) : createStage(*s, fragmentSource));
+
+    // The sets before the one of the overlay are unchanged, so the
+    // descriptor sets that are bound with the original layout stay
+    // compatible
+    auto setLayouts = pipeline->layout->setLayouts;
+    setLayouts.push_back(overlayState().setLayout);
+    auto pipelineLayout = vsg::PipelineLayout::create(setLayouts, pipeline->layout->pushConstantRanges,
+                                                      pipeline->layout->flags);
+
+    auto variant = vsg::GraphicsPipeline::create(pipelineLayout, stages, states, pipeline->subpass);
+    variant->setValue(OVERLAY_SET_KEY, set);
+    layout.bind = vsg::BindGraphicsPipeline::create(variant);
+    layout.bind->slot = bind.slot;
+    return layout;
+}
+
+static vsg::BufferInfoList *drawArrays(vsg::Node& draw, uint32_t& firstBinding)
+{
+    if (auto vid = draw.cast<vsg::VertexIndexDraw>())
+    {
+        firstBinding = vid->firstBinding;
+        return &vid->arrays;
+    }
+    if (auto vd = draw.cast<vsg::VertexDraw>())
+    {
+        firstBinding = vd->firstBinding;
+        return &vd->arrays;
+    }
+    return nullptr;
+}
+
+// The vertex arrays that copyVertices() handles, which are those of
+// the readers and of quantizeVertices()
+static bool isCopyable(const vsg::Data& data)
+{
+    return data.is_compatible(typeid(vsg::vec2Array)) || data.is_compatible(typeid(vsg::vec3Array))
+        || data.is_compatible(typeid(vsg::vec4Array)) || data.is_compatible(typeid(vsg::ubvec4Array))
+        || data.is_compatible(typeid(vsg::usvec4Array)) || data.is_compatible(typeid(vsg::svec2Array));
+}
+
+template<class A>
+static vsg::ref_ptr<vsg::Data> copyAs(const vsg::Data& data, const vector<uint32_t>& sources)
+{
+    auto array = data.cast<A>();
+    if (!array || array->stride() != sizeof(typename A::value_type))
+        return {};
+    auto copy = A::create(uint32_t(sources.size()));
+    copy->properties.format = array->properties.format;
+    for (size_t i = 0; i < sources.size(); i++)
+        (*copy)[i] = (*array)[sources[i]];
+    return copy;
+}
+
+// A new array with the vertices of data at sources
+static vsg::ref_ptr<vsg::Data> copyVertices(const vsg::Data& data, const vector<uint32_t>& sources)
+{
+    vsg::ref_ptr<vsg::Data> copy;
+    if (!copy) copy = copyAs<vsg::vec2Array>(data, sources);
+    if (!copy) copy = copyAs<vsg::vec3Array>(data, sources);
+    if (!copy) copy = copyAs<vsg::vec4Array>(data, sources);
+    if (!copy) copy = copyAs<vsg::ubvec4Array>(data, sources);
+    if (!copy) copy = copyAs<vsg::usvec4Array>(data, sources);
+    if (!copy) copy = copyAs<vsg::svec2Array>(data, sources);
+    return copy;
+}
+
+// The number of vertices of the per vertex arrays of a draw, or 0 if
+// the draw doesn't fit layout
+static size_t overlayVertexCount(vsg::Node& draw, const OverlayLayout& layout)
+{
+    uint32_t firstBinding = 0;
+    auto arrays = drawArrays(draw, firstBinding);
+    if (!arrays || firstBinding + arrays->size() != layout.binding)
+        return 0;
+
+    size_t numVertices = 0;
+    for (auto binding : layout.vertexBindings)
+    {
+        if (binding < firstBinding)
+            return 0;
+        auto& info = (*arrays)[binding - firstBinding];
+        if (!info || !info->data || !isCopyable(*info->data)
+            || (numVertices && info->data->valueCount() != numVertices))
+            return 0;
+        numVertices = info->data->valueCount();
+    }
+    if (numVertices == 0)
+        return 0;
+
+    if (auto vd = draw.cast<vsg::VertexDraw>())
+        return vd->firstVertex == 0 && vd->vertexCount % 3 == 0 && vd->vertexCount <= numVertices
+            ? numVertices : 0;
+
+    auto vid = draw.cast<vsg::VertexIndexDraw>();
+    if (!vid->indices || !vid->indices->data || vid->firstIndex != 0 || vid->vertexOffset != 0
+        || vid->indexCount % 3 != 0 || vid->indexCount != vid->indices->data->valueCount())
+        return 0;
+    auto inRange = [&](auto& indices) {
+        return std::all_of(indices.begin(), indices.end(), [&](auto i) { return i < numVertices; });
+    };
+    if (auto ui = vid->indices->data->cast<vsg::uintArray>())
+        return inRange(*ui) ? numVertices : 0;
+    if (auto us = vid->indices->data->cast<vsg::ushortArray>())
+        return inRange(*us) ? numVertices : 0;
+    return 0;
+}
+
+// Give each corner of the triangles a different one of the three
+// labels. A corner keeps the label of its vertex if it is free in the
+// triangle, and otherwise gets a copy of the vertex with a free label.
+// The copies are appended to labels and their originals to sources.
+static void labelCorners(vector<uint32_t>& indices, vector<int8_t>& labels, vector<uint32_t>& sources)
+{
+    std::unordered_map<uint64_t, uint32_t> copies;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        uint32_t *corner = &indices[t];
+        bool taken[3] = {false, false, false};
+        bool labeled[3] = {false, false, false};
+        for (int k = 0; k < 3; k++)
+        {
+            int label = labels[corner[k]];
+            if (label >= 0 && !taken[label])
+                taken[label] = labeled[k] = true;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            if (labeled[k])
+                continue;
+            uint32_t v = corner[k];
+            if (labels[v] < 0)
+            {
+                int label = int(std::find(taken, taken + 3, false) - taken);
+                labels[v] = int8_t(label);
+                taken[label] = true;
+                continue;
+            }
+
+            // Prefer a label that the vertex already has a copy with
+            int label = -1;
+            for (int l = 0; l < 3 && label < 0; l++)
+                if (!taken[l] && copies.count(uint64_t(v) * 3 + l))
+                    label = l;
+            if (label < 0)
+                label = int(std::find(taken, taken + 3, false) - taken);
+            taken[label] = true;
+
+            auto [it, inserted] = copies.try_emplace(uint64_t(v) * 3 + label, uint32_t(sources.size()));
+            if (inserted)
+            {
+                sources.push_back(v);
+                labels.push_back(int8_t(label));
+            }
+            corner[k] = it->second;
+        }
+    }
+}
+
+// Add the barycentrics to a draw that fits layout
+static void addBarycentrics(vsg::Node& draw, const OverlayLayout& layout, size_t numVertices)
+{
+    uint32_t firstBinding = 0;
+    auto arrays = drawArrays(draw, firstBinding);
+    vector<int8_t> labels(numVertices, -1);
+
+    if (auto vd = draw.cast<vsg::VertexDraw>())
+    {
+        for (uint32_t i = 0; i < vd->vertexCount; i++)
+            labels[i] = int8_t(i % 3);
+    }
+    else
+    {
+        auto vid = draw.cast<vsg::VertexIndexDraw>();
+        auto data = vid->indices->data;
+        vector<uint32_t> indices;
+        if (auto ui = data->cast<vsg::uintArray>())
+            indices.assign(ui->begin(), ui->end());
+        else if (auto us = data->cast<vsg::ushortArray>())
+            indices.assign(us->begin(), us->end());
+
+        vector<uint32_t> sources(numVertices);
+        for (size_t i = 0; i < numVertices; i++)
+            sources[i] = uint32_t(i);
+        labelCorners(indices, labels, sources);
+
+        if (sources.size() > numVertices)
+        {
+            for (auto binding : layout.vertexBindings)
+            {
+                auto& info = (*arrays)[binding - firstBinding];
+                info = vsg::BufferInfo::create(copyVertices(*info->data, sources));
+            }
+
+            // The copies may need wider indices
+            if (data->cast<vsg::ushortArray>() && sources.size() <= 65536)
+            {
+                auto shortIndices = vsg::ushortArray::create(uint32_t(indices.size()));
+                std::copy(indices.begin(), indices.end(), shortIndices->begin());
+                vid->assignIndices(shortIndices);
+            }
+            else
+            {
+                auto longIndices = vsg::uintArray::create(uint32_t(indices.size()));
+                std::copy(indices.begin(), indices.end(), longIndices->begin());
+                vid->assignIndices(longIndices);
+            }
+        }
+    }
+
+    auto barycentrics = vsg::ubvec4Array::create(uint32_t(labels.size()));
+    barycentrics->properties.format = VK_FORMAT_R8G8B8A8_UNORM;
+    for (size_t i = 0; i < labels.size(); i++)
+    {
+        vsg::ubvec4 b(0, 0, 0, 0);
+        if (labels[i] >= 0)
+            b[labels[i]] = 255;
+        (*barycentrics)[i] = b;
+    }
+    arrays->push_back(vsg::BufferInfo::create(barycentrics));
+}
+
+// Find the draws below each state group that binds a pipeline, in the
+// order of the traversal
+class OverlayCollector : public vsg::Visitor
+{
+public:
+    std::vector<vsg::StateGroup*> groupStack{nullptr};
+    std::vector<vsg::StateGroup*> groups;
+    std::map<vsg::StateGroup*, std::vector<vsg::Node*>> groupDraws;
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::StateGroup& sg) override
+    {
+        if (!findPipeline(sg))
+        {
+            sg.traverse(*this);
+            return;
+        }
+        if (!groupDraws.count(&sg))
+            groups.push_back(&sg);
+        groupDraws[&sg];
+        groupStack.push_back(&sg);
+        sg.traverse(*this);
+        groupStack.pop_back();
+    }
+
+    void addDraw(vsg::Node& draw)
+    {
+        if (!groupStack.back())
+            return;
+        auto& draws = groupDraws[groupStack.back()];
+        if (std::find(draws.begin(), draws.end(), &draw) == draws.end())
+            draws.push_back(&draw);
+    }
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        addDraw(vid);
+    }
+
+    void apply(vsg::VertexDraw& vd) override
+    {
+        addDraw(vd);
+    }
+};
+
+size_t addWireframeBarycentrics(vsg::Node& node)
+{
+    OverlayCollector collector;
+    node.accept(collector);
+
+    // A group gets the variant if all its draws fit, and a draw that
+    // is shared with an earlier group keeps the barycentrics it got
+    // there. Those are harmless for the pipelines that don't read
+    // them, as the copies of the vertices are complete.
+    map<vsg::GraphicsPipeline*, OverlayLayout> layouts;
+    map<vsg::Node*, pair<const OverlayLayout*, size_t>> drawLayouts;
+    vector<pair<vsg::StateGroup*, const OverlayLayout*>> groupLayouts;
+    for (auto sg : collector.groups)
+    {
+        auto& draws = collector.groupDraws[sg];
+        if (draws.empty())
+            continue;
+        auto bind = findPipeline(*sg);
+        auto it = layouts.find(bind->pipeline.get());
+        if (it == layouts.end())
+            it = layouts.emplace(bind->pipeline.get(), createOverlayLayout(*bind)).first;
+        auto& layout = it->second;
+        if (!layout.bind)
+            continue;
+
+        vector<size_t> numVertices(draws.size(), 0);
+        bool fits = true;
+        for (size_t i = 0; i < draws.size() && fits; i++)
+        {
+            auto d = drawLayouts.find(draws[i]);
+            if (d != drawLayouts.end())
+                fits = d->second.first->binding == layout.binding;
+            else
+                fits = (numVertices[i] = overlayVertexCount(*draws[i], layout)) > 0;
+        }
+        if (!fits)
+            continue;
+        for (size_t i = 0; i < draws.size(); i++)
+            if (numVertices[i])
+                drawLayouts[draws[i]] = {&layout, numVertices[i]};
+        groupLayouts.push_back({sg, &layout});
+    }
+
+    vector<pair<vsg::Node*, pair<const OverlayLayout*, size_t>>> draws(drawLayouts.begin(), drawLayouts.end());
+    parallelFor(draws.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            addBarycentrics(*draws[i].first, *draws[i].second.first, draws[i].second.second);
+    }, 1);
+
+    for (auto& [sg, layout] : groupLayouts)
+    {
+        for (auto& sc : sg->stateCommands)
+        {
+            if (sc->cast<vsg::BindGraphicsPipeline>())
+            {
+                sc = layout->bind;
+                break;
+            }
+        }
+    }
+
+    return draws.size();
+}
+
+class BindWireframeOverlay : public vsg::Visitor
+{
+public:
+    std::set<vsg::Object*> visited;
+    std::map<vsg::PipelineLayout*, vsg::ref_ptr<vsg::BindDescriptorSet>> binds;
+
+    void apply(vsg::Object& object) override
+    {
+        if (!visited.insert(&object).second)
+            return;
+        object.traverse(*this);
+    }
+
+    void apply(vsg::StateGroup& sg) override
+    {
+        if (visited.count(&sg))
+            return;
+        auto bgp = findPipeline(sg);
+        uint32_t set = 0;
+        if (bgp && bgp->pipeline && bgp->pipeline->getValue(OVERLAY_SET_KEY, set))
+        {
+            auto& bind = binds[bgp->pipeline->layout.get()];
+            if (!bind)
+                bind = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                                      bgp->pipeline->layout, set,
+                                                      overlayState().descriptorSet);
+            if (std::none_of(sg.stateCommands.begin(), sg.stateCommands.end(),
+                             [&](const vsg::ref_ptr<vsg::StateCommand>& sc) { return sc.get() == bind.get(); }))
+                sg.add(bind);
+        }
+        apply(static_cast<vsg::Object&>(sg));
+    }
+};
+
+void bindWireframeOverlay(vsg::Node& node)
+{
+    BindWireframeOverlay bindVisitor;
+    node.accept(bindVisitor);
+}
+
+void setWireframeOverlay(WireframeOverlay mode, float lineWidth)
+{
+    auto& params = overlayState().params;
+    (*params)[0] = vsg::vec4(float(int(mode)), lineWidth, 0.0f, 0.0f);
+    params->dirty();
+}
@@ -0,0 +1,53 @@
+//======================================================================
+//  wireframe.h - Switching of a scene graph between shaded and wireframe
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef WIREFRAME_H
+#define WIREFRAME_H
+
+#include <vsg/all.h>
+
+// The view masks that select the shaded and the wireframe pipelines
+const vsg::Mask WIREFRAME_MASK_SHADED = 0x1;
+const vsg::Mask WIREFRAME_MASK_LINE = 0x2;
+
+// Replace every BindGraphicsPipeline in node by a StateSwitch between
+// the original pipeline and a line-mode clone of it. It only touches
+// node, so it may be run on a loader thread before the subgraph is
+// merged into the viewed scene.
+void insertWireframeSwitch(vsg::Node& node,
+                           vsg::Mask maskShaded = WIREFRAME_MASK_SHADED,
+                           vsg::Mask maskLine = WIREFRAME_MASK_LINE);
+
+// What the fragment shaders of the meshes that were given barycentric
+// coordinates draw
+enum class WireframeOverlay
+{
+    OFF,         // Only the shading
+    SHADED_WIRE, // The edges on top of the shading
+    WIRE         // Only the edges, the rest of the faces is discarded
+};
+
+// Give the triangle meshes in node a vertex attribute with the
+// barycentric coordinates of the corners of their triangles, and
+// replace their pipelines by variants whose fragment shaders draw the
+// edges from it, as set by setWireframeOverlay(). The vertices that are
+// shared by triangles that need different corners are duplicated.
+// Unlike insertWireframeSwitch() no pipelines are added, so it may run
+// before the model is cached, and bindWireframeOverlay() must then be
+// run on the loaded model. Returns the number of meshes that got the
+// attribute.
+size_t addWireframeBarycentrics(vsg::Node& node);
+
+// Bind the descriptor set of the overlay uniform, that all the models
+// share, above the pipelines made by addWireframeBarycentrics(). Like
+// insertWireframeSwitch() it only touches node.
+void bindWireframeOverlay(vsg::Node& node);
+
+// Change what the overlay draws in all the models. It must be called
+// on the viewer thread, and lineWidth is in pixels.
+void setWireframeOverlay(WireframeOverlay mode, float lineWidth = 1.5f);
+
+#endif /* WIREFRAME */
@@ -0,0 +1,39 @@
+//======================================================================
+//  check.h - Minimal checks for the unit tests
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cstdio>
+
+// The failed checks are reported and counted, and the test goes on,
+// so that a single run shows all of them. main() returns checkResult().
+inline int& checkFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline bool checkCondition(bool ok, const char *expression, const char *file, int line)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        checkFailures()++;
+    }
+    return ok;
+}
+
+inline int checkResult()
+{
+    if (checkFailures())
+        fprintf(stderr, "%d checks failed\n", checkFailures());
+    return checkFailures() ? 1 : 0;
+}
+
+#define CHECK(expression) checkCondition(bool(expression), #expression, __FILE__, __LINE__)
+
+#endif /* CHECK */
@@ -0,0 +1,78 @@
+//======================================================================
+//  test_bounds.cpp - Test of the bounds that are stored on the nodes
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "bounds.h"
+
+using namespace std;
+
+// A triangle with the corners min and max of its bounds
+static vsg::ref_ptr<vsg::Node> triangle(const vsg::vec3& min, const vsg::vec3& max)
+{
+    auto vid = vsg::VertexIndexDraw::create();
+    vid->assignArrays({vsg::vec3Array::create({min, vsg::vec3(max.x, min.y, min.z), max})});
+    vid->assignIndices(vsg::uintArray::create({0, 1, 2}));
+    vid->indexCount = 3;
+    vid->instanceCount = 1;
+    return vid;
+}
+
+static bool equal(const vsg::dbox& a, const vsg::dbox& b)
+{
+    return a.valid() && b.valid()
+        && vsg::length(a.min - b.min) < 1e-9 && vsg::length(a.max - b.max) < 1e-9;
+}
+
+int main(int, char **)
+{
+    // A model of translated parts, of which the bounds are computed
+    // in parallel
+    auto model = vsg::Group::create();
+    for (int i = 0; i < 8; i++)
+    {
+        auto transform = vsg::MatrixTransform::create(vsg::translate(double(i), 0.0, 0.0));
+        transform->addChild(triangle(vsg::vec3(0, 0, 0), vsg::vec3(0.5f, 1, 2)));
+        model->addChild(transform);
+    }
+    auto root = vsg::MatrixTransform::create(vsg::translate(0.0, 10.0, 0.0));
+    root->addChild(model);
+
+    vsg::dbox expected(vsg::dvec3(0, 10, 0), vsg::dvec3(7.5, 11, 2));
+    auto bounds = cacheBounds(*root);
+    CHECK(equal(bounds, expected));
+
+    vsg::dbox stored;
+    CHECK(findBounds(*root, stored) && equal(stored, expected));
+    CHECK(findBounds(*model->children[3], stored)
+          && equal(stored, vsg::dbox(vsg::dvec3(3, 0, 0), vsg::dvec3(3.5, 1, 2))));
+
+    // The stored bounds are used rather than the geometry, until they
+    // are cleared
+    setBounds(*model->children[0], vsg::dbox(vsg::dvec3(-5, 0, 0), vsg::dvec3(0, 1, 1)));
+    clearBounds(*root);
+    clearBounds(*model);
+    CHECK(equal(cacheBounds(*root), vsg::dbox(vsg::dvec3(-5, 10, 0), vsg::dvec3(7.5, 11, 2))));
+    clearBounds(*model->children[0]);
+    clearBounds(*root);
+    clearBounds(*model);
+    CHECK(equal(cacheBounds(*root), expected));
+
+    // The models that are switched off don't count
+    auto modelSwitch = vsg::Switch::create();
+    modelSwitch->addChild(true, root);
+    auto other = vsg::MatrixTransform::create(vsg::translate(100.0, 0.0, 0.0));
+    other->addChild(triangle(vsg::vec3(0, 0, 0), vsg::vec3(1, 1, 1)));
+    modelSwitch->addChild(false, other);
+    auto scene = vsg::Group::create();
+    scene->addChild(modelSwitch);
+    CHECK(equal(getBounds(*scene), expected));
+    CHECK(!findBounds(*scene, stored));
+
+    modelSwitch->setAllChildren(true);
+    CHECK(equal(getBounds(*scene), vsg::dbox(vsg::dvec3(0, 0, 0), vsg::dvec3(101, 11, 2))));
+
+    return checkResult();
+}
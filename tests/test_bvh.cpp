@@ -0,0 +1,113 @@
+//======================================================================
+//  test_bvh.cpp - Test of the triangle BVH against brute force
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "bvh.h"
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+// Möller–Trumbore, the distance along direction or negative on a miss
+static double intersectTriangle(const vsg::dvec3& origin, const vsg::dvec3& direction,
+                                const vsg::dvec3& a, const vsg::dvec3& b, const vsg::dvec3& c)
+{
+    auto e1 = b - a, e2 = c - a;
+    auto p = vsg::cross(direction, e2);
+    double det = vsg::dot(e1, p);
+    if (std::fabs(det) < 1e-12)
+        return -1.0;
+    auto s = origin - a;
+    double u = vsg::dot(s, p) / det;
+    if (u < 0.0 || u > 1.0)
+        return -1.0;
+    auto q = vsg::cross(s, e1);
+    double v = vsg::dot(direction, q) / det;
+    if (v < 0.0 || u + v > 1.0)
+        return -1.0;
+    return vsg::dot(e2, q) / det;
+}
+
+int main(int, char **)
+{
+    mt19937 rng(42);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    uniform_real_distribution<float> small(-0.05f, 0.05f);
+
+    // Small random triangles in the unit cube
+    const size_t numTriangles = 5000;
+    vector<vsg::vec3> vertices;
+    vector<uint32_t> indices;
+    for (size_t t = 0; t < numTriangles; t++)
+    {
+        vsg::vec3 center(unit(rng), unit(rng), unit(rng));
+        for (int i = 0; i < 3; i++)
+        {
+            indices.push_back(uint32_t(vertices.size()));
+            vertices.push_back(center + vsg::vec3(small(rng), small(rng), small(rng)));
+        }
+    }
+
+    TriangleBVH bvh;
+    CHECK(bvh.empty());
+    auto verticesCopy = vertices;
+    auto indicesCopy = indices;
+    CHECK(bvh.build(std::move(verticesCopy), std::move(indicesCopy)));
+    CHECK(!bvh.empty());
+    CHECK(bvh.numTriangles() == numTriangles);
+    auto bounds = bvh.bounds();
+    CHECK(bounds.valid() && bounds.min.x > -0.1 && bounds.max.x < 1.1);
+
+    // Rays through the cube find the same nearest hit as brute force
+    size_t numHits = 0, numAgree = 0;
+    const size_t numRays = 500;
+    for (size_t r = 0; r < numRays; r++)
+    {
+        vsg::dvec3 origin(unit(rng) * 3.0 - 1.0, unit(rng) * 3.0 - 1.0, -1.0);
+        vsg::dvec3 target(unit(rng), unit(rng), unit(rng));
+        vsg::dvec3 direction = target - origin;
+
+        double nearest = std::numeric_limits<double>::max();
+        for (size_t t = 0; t < numTriangles; t++)
+        {
+            double d = intersectTriangle(origin, direction,
+                                         vsg::dvec3(vertices[indices[t*3]]),
+                                         vsg::dvec3(vertices[indices[t*3+1]]),
+                                         vsg::dvec3(vertices[indices[t*3+2]]));
+            if (d >= 0.0 && d < nearest)
+                nearest = d;
+        }
+
+        TriangleBVH::Hit hit;
+        bool found = bvh.intersect(origin, direction, hit);
+        bool expected = nearest != std::numeric_limits<double>::max();
+        if (expected)
+            numHits++;
+        if (found == expected && (!found || std::fabs(hit.t - nearest) < 1e-5))
+            numAgree++;
+
+        if (found)
+        {
+            // The hit point is on the ray, and the normal faces it
+            auto point = origin + direction * hit.t;
+            CHECK(vsg::length(point - hit.point) < 1e-5);
+            CHECK(vsg::dot(hit.normal, direction) <= 0.0);
+
+            // Nothing is hit before the nearest hit
+            TriangleBVH::Hit before;
+            CHECK(!bvh.intersect(origin, direction, before, hit.t * 0.999));
+        }
+    }
+    CHECK(numAgree == numRays);
+    CHECK(numHits > numRays / 10);
+
+    // A canceled build returns false
+    std::atomic<bool> canceled{true};
+    TriangleBVH canceledBVH;
+    CHECK(!canceledBVH.build(std::move(vertices), std::move(indices), &canceled));
+
+    return checkResult();
+}
@@ -0,0 +1,46 @@
+//======================================================================
+//  test_filehash.cpp - Test of the XXH64 hashing of files
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "filehash.h"
+#include <QTemporaryDir>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main(int, char **)
+{
+    // The reference values of XXH64 with seed 0
+    CHECK(hashBytes("", 0) == 0xef46db3751d8e999ULL);
+    CHECK(hashBytes("a", 1) == 0xd24ec4f1a98c6e5bULL);
+    CHECK(hashBytes("abc", 3) == 0x44bc2cf5ad770999ULL);
+    const char *text = "Nobody inspects the spammish repetition";
+    CHECK(hashBytes(text, strlen(text)) == 0xfbcea83c8a378bf1ULL);
+    CHECK(hashBytes("abc", 3, 1) != hashBytes("abc", 3));
+
+    // A file is hashed as its content, also when it is larger than
+    // the blocks it is read in
+    vector<char> data(3 << 20);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = char(i * 7 + (i >> 12));
+    QTemporaryDir dir;
+    CHECK(dir.isValid());
+    auto filename = dir.filePath("data.bin").toStdString();
+    FILE *fh = fopen(filename.c_str(), "wb");
+    CHECK(fh && fwrite(data.data(), 1, data.size(), fh) == data.size());
+    if (fh)
+        fclose(fh);
+
+    uint64_t hash = 0;
+    CHECK(hashFile(filename, hash));
+    CHECK(hash == hashBytes(data.data(), data.size()));
+    CHECK(!hashFile(dir.filePath("missing.bin").toStdString(), hash));
+
+    return checkResult();
+}
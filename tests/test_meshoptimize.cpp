@@ -0,0 +1,151 @@
+//======================================================================
+//  test_meshoptimize.cpp - Test of the mesh optimization passes
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "testmeshes.h"
+#include "meshoptimize.h"
+#include <array>
+#include <deque>
+#include <set>
+
+using namespace std;
+
+// The average number of vertices that miss a FIFO post transform
+// cache of cacheSize entries, per triangle
+static double acmr(const vector<uint32_t>& indices, size_t cacheSize = 16)
+{
+    deque<uint32_t> cache;
+    size_t misses = 0;
+    for (auto i : indices)
+    {
+        if (find(cache.begin(), cache.end(), i) != cache.end())
+            continue;
+        misses++;
+        cache.push_back(i);
+        if (cache.size() > cacheSize)
+            cache.pop_front();
+    }
+    return indices.empty() ? 0.0 : double(misses) / (indices.size() / 3);
+}
+
+// The triangles of a draw by the positions of their corners, with
+// the corners in a canonical rotation
+static set<array<float, 9>> triangleSet(const vsg::VertexIndexDraw& vid)
+{
+    auto positions = vid.arrays[0]->data.cast<vsg::vec3Array>();
+    auto indices = drawIndices(vid);
+    set<array<float, 9>> triangles;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        size_t first = t;
+        for (size_t i = t + 1; i < t + 3; i++)
+            if (indices[i] < indices[first])
+                first = i;
+        array<float, 9> triangle;
+        for (size_t i = 0; i < 3; i++)
+        {
+            auto& p = positions->at(indices[t + (first - t + i) % 3]);
+            triangle[i*3] = p.x;
+            triangle[i*3 + 1] = p.y;
+            triangle[i*3 + 2] = p.z;
+        }
+        triangles.insert(triangle);
+    }
+    return triangles;
+}
+
+static MeshOptimizeSettings only()
+{
+    MeshOptimizeSettings settings;
+    settings.enabled = true;
+    settings.merge = settings.weld = settings.vertexCache = settings.vertexFetch = false;
+    settings.share = false;
+    return settings;
+}
+
+int main(int, char **)
+{
+    QTemporaryDir dir;
+    CHECK(dir.isValid());
+
+    // The triangles of a shuffled grid are reordered for the vertex
+    // cache, and stay the same triangles
+    {
+        auto scene = gridScene(dir, 40, true);
+        vector<vsg::ref_ptr<vsg::VertexIndexDraw>> draws;
+        if (CHECK(scene))
+            draws = findDraws(*scene);
+        CHECK(draws.size() == 1);
+        if (draws.size() == 1)
+        {
+            auto vid = draws[0];
+            double before = acmr(drawIndices(*vid));
+            auto triangles = triangleSet(*vid);
+
+            auto settings = only();
+            settings.vertexCache = true;
+            optimizeMeshes(*scene, settings);
+
+            double after = acmr(drawIndices(*vid));
+            CHECK(after < before);
+            CHECK(after < 1.0);
+            CHECK(vid->indexCount == 40 * 40 * 6);
+            CHECK(triangleSet(*vid) == triangles);
+        }
+    }
+
+    // Unwelded corners are welded into the vertices of the grid
+    {
+        auto scene = gridScene(dir, 8);
+        vector<vsg::ref_ptr<vsg::VertexIndexDraw>> draws;
+        if (CHECK(scene))
+            draws = findDraws(*scene);
+        CHECK(draws.size() == 1);
+        if (draws.size() == 1)
+        {
+            auto vid = draws[0];
+            auto triangles = triangleSet(*vid);
+            auto indices = drawIndices(*vid);
+            vsg::DataList arrays;
+            for (auto& array : vid->arrays)
+            {
+                auto values = array->data.cast<vsg::vec3Array>();
+                if (!values || values->size() == 1)
+                {
+                    arrays.push_back(array->data);
+                    continue;
+                }
+                auto corners = vsg::vec3Array::create(uint32_t(indices.size()));
+                for (size_t i = 0; i < indices.size(); i++)
+                    corners->at(i) = values->at(indices[i]);
+                arrays.push_back(corners);
+            }
+            auto sequential = vsg::uintArray::create(uint32_t(indices.size()));
+            for (size_t i = 0; i < indices.size(); i++)
+                sequential->at(i) = uint32_t(i);
+            vid->assignArrays(arrays);
+            vid->assignIndices(sequential);
+
+            auto settings = only();
+            settings.weld = true;
+            optimizeMeshes(*scene, settings);
+
+            CHECK(vid->arrays[0]->data->valueCount() == 9 * 9);
+            CHECK(vid->indexCount == 8 * 8 * 6);
+            CHECK(triangleSet(*vid) == triangles);
+        }
+    }
+
+    // The passes are parsed from their names
+    MeshOptimizeSettings settings;
+    CHECK(settings.parsePasses("weld,merge"));
+    CHECK(settings.weld && settings.merge && !settings.vertexCache);
+    CHECK(settings.parsePasses("share"));
+    CHECK(settings.share && !settings.weld && !settings.merge);
+    CHECK(!settings.parsePasses("weld,nonsense"));
+
+    return checkResult();
+}
@@ -0,0 +1,107 @@
+//======================================================================
+//  test_modelcache.cpp - Test of the persistent model cache
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "modelcache.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+using namespace std;
+
+static vsg::ref_ptr<vsg::Node> model(size_t numVertices)
+{
+    auto vid = vsg::VertexIndexDraw::create();
+    vid->assignArrays({vsg::vec3Array::create(uint32_t(numVertices), vsg::vec3(1, 2, 3))});
+    vid->assignIndices(vsg::uintArray::create({0, 1, 2}));
+    vid->indexCount = 3;
+    vid->instanceCount = 1;
+    auto group = vsg::Group::create();
+    group->addChild(vid);
+    group->setValue("z_up", true);
+    return group;
+}
+
+static qint64 fileSize(const QTemporaryDir& dir, const string& key)
+{
+    return QFileInfo(dir.filePath(QString::fromStdString(key) + ".vsgb")).size();
+}
+
+static void setAge(const QTemporaryDir& dir, const string& key, int seconds)
+{
+    QFile file(dir.filePath(QString::fromStdString(key) + ".vsgb"));
+    if (file.open(QIODevice::ReadWrite))
+        file.setFileTime(QDateTime::currentDateTime().addSecs(-seconds),
+                         QFileDevice::FileModificationTime);
+}
+
+int main(int, char **)
+{
+    QTemporaryDir dir;
+    CHECK(dir.isValid());
+    auto directory = dir.path().toStdString();
+
+    // The key depends on the content and on the variant, and native
+    // files aren't cached
+    auto source = dir.filePath("model.stl");
+    QFile file(source);
+    CHECK(file.open(QIODevice::WriteOnly) && file.write("solid model\n") > 0);
+    file.close();
+    string key, otherKey;
+    CHECK(ModelCache::makeKey(source.toStdString(), "v1", key));
+    CHECK(ModelCache::makeKey(source.toStdString(), "v2", otherKey));
+    CHECK(key != otherKey);
+    CHECK(!ModelCache::makeKey(dir.filePath("model.vsgb").toStdString(), "", key));
+    CHECK(!ModelCache::makeKey(dir.filePath("missing.stl").toStdString(), "", key));
+
+    // A written model reads back the same
+    {
+        auto cache = ModelCache::create(directory, uint64_t(1) << 30);
+        CHECK(!cache->read("a"));
+        CHECK(cache->write("a", model(1000)));
+        auto node = cache->read("a");
+        CHECK(node);
+        bool zUp = false;
+        CHECK(node && node->getValue("z_up", zUp) && zUp);
+        auto group = node.cast<vsg::Group>();
+        auto vid = group && group->children.size() == 1
+            ? group->children[0].cast<vsg::VertexIndexDraw>() : vsg::ref_ptr<vsg::VertexIndexDraw>();
+        CHECK(vid && vid->indexCount == 3 && vid->arrays.size() == 1);
+        CHECK(vid && vid->arrays[0]->data->valueCount() == 1000);
+    }
+
+    // The least recently used entries are evicted, and the entries
+    // that are being written are neither counted nor evicted
+    {
+        qint64 entrySize = fileSize(dir, "a");
+        CHECK(entrySize > 0);
+        QFile partial(dir.filePath("c.1234.tmp.vsgb"));
+        CHECK(partial.open(QIODevice::WriteOnly) && partial.write(QByteArray(4 * entrySize, 'x')) > 0);
+        partial.close();
+
+        auto cache = ModelCache::create(directory, uint64_t(entrySize * 5 / 2));
+        CHECK(cache->write("b", model(1000)));
+        CHECK(fileSize(dir, "a") > 0 && fileSize(dir, "b") > 0);
+
+        setAge(dir, "a", 3600);
+        setAge(dir, "b", 60);
+        CHECK(cache->write("c", model(1000)));
+        CHECK(fileSize(dir, "a") == 0);
+        CHECK(fileSize(dir, "b") > 0 && fileSize(dir, "c") > 0);
+        CHECK(QFileInfo::exists(dir.filePath("c.1234.tmp.vsgb")));
+
+        // Reading marks an entry as used
+        setAge(dir, "b", 60);
+        setAge(dir, "c", 3600);
+        CHECK(cache->read("c"));
+        CHECK(cache->write("d", model(1000)));
+        CHECK(fileSize(dir, "b") == 0);
+        CHECK(fileSize(dir, "c") > 0 && fileSize(dir, "d") > 0);
+    }
+
+    return checkResult();
+}
@@ -0,0 +1,79 @@
+//======================================================================
+//  test_pagedtiles.cpp - Test of the conversion into paged tiles
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "testmeshes.h"
+#include "pagedtiles.h"
+
+using namespace std;
+
+class PagedLODCounter : public vsg::Visitor
+{
+public:
+    size_t count = 0;
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::PagedLOD& plod) override
+    {
+        count++;
+        plod.traverse(*this);
+    }
+};
+
+int main(int, char **)
+{
+    QTemporaryDir dir;
+    CHECK(dir.isValid());
+
+    TileSettings settings;
+    settings.enabled = true;
+    settings.maxTriangles = 1000;
+    settings.directory = dir.filePath("tiles").toStdString();
+    auto key = settings.key();
+    settings.maxTriangles = 2000;
+    CHECK(settings.key() != key);
+
+    // A model that fits in a tile isn't tiled
+    auto small = gridScene(dir, 10);
+    CHECK(small && !convertToTiles(*small, "small", settings));
+    CHECK(!readTiles("small", settings, {}));
+
+    auto scene = gridScene(dir, 64);
+    CHECK(scene);
+    if (!scene)
+        return checkResult();
+
+    // A canceled conversion leaves no database
+    std::atomic<bool> canceled{true};
+    CHECK(!convertToTiles(*gridScene(dir, 64), "canceled", settings, &canceled));
+    CHECK(!readTiles("canceled", settings, {}));
+
+    CHECK(convertToTiles(*scene, "grid", settings));
+    auto root = readTiles("grid", settings, {});
+    CHECK(root);
+    if (!root)
+        return checkResult();
+
+    double tileBytes = 0.0;
+    CHECK(root->getValue("tileBytes", tileBytes) && tileBytes > 0.0);
+
+    // The tiles are paged from their files
+    PagedLODCounter counter;
+    root->accept(counter);
+    CHECK(counter.count > 0);
+    auto files = QDir(QString::fromStdString(settings.directory) + "/grid")
+        .entryList({"*.vsgb"}, QDir::Files);
+    CHECK(files.contains("root.vsgb"));
+    CHECK(files.size() > 8192 / 2000);
+    for (auto& file : files)
+        CHECK(!file.endsWith(".tmp.vsgb"));
+
+    return checkResult();
+}
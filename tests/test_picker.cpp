@@ -0,0 +1,69 @@
+//======================================================================
+//  test_picker.cpp - Test of the collection of the meshes to pick on
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "testmeshes.h"
+#include "picker.h"
+#include "lodgenerator.h"
+
+using namespace std;
+
+// Whether the ray from start towards end hits the bvh of node, at z
+static bool pickAt(vsg::Node& node, const vsg::dvec3& start, const vsg::dvec3& end, double z)
+{
+    TriangleBVH bvh;
+    TriangleBVH::Hit hit;
+    return buildPickBVH(collectPickMeshes(node), bvh)
+        && bvh.intersect(start, end - start, hit)
+        && std::fabs(hit.point.z - z) < 1e-6;
+}
+
+int main(int, char **)
+{
+    QTemporaryDir dir;
+    CHECK(dir.isValid());
+    auto scene = gridScene(dir, 16);
+    auto sg = scene.cast<vsg::StateGroup>();
+    CHECK(sg && sg->children.size() == 1);
+    if (!sg || sg->children.size() != 1)
+        return checkResult();
+
+    auto transform = vsg::MatrixTransform::create(vsg::translate(0.0, 0.0, 2.0));
+    transform->addChild(sg);
+    vsg::dvec3 start(0.3, 0.6, 10.0), end(0.3, 0.6, -10.0);
+
+    auto meshes = collectPickMeshes(*transform);
+    CHECK(meshes.size() == 1);
+    CHECK(meshes.size() == 1 && meshes[0].indexCount == 16 * 16 * 6);
+    CHECK(pickAt(*transform, start, end, 2.0));
+
+    // The mesh is still picked after the generator has replaced it by
+    // its levels of detail
+    auto vid = sg->children[0].cast<vsg::VertexIndexDraw>();
+    CHECK(vid);
+    auto lodNode = vid ? createLODNode(*vid) : vsg::ref_ptr<vsg::Node>();
+    CHECK(lodNode);
+    if (!lodNode)
+        return checkResult();
+    sg->children[0] = lodNode;
+    CHECK(findDraws(*transform).empty());
+
+    meshes = collectPickMeshes(*transform);
+    CHECK(meshes.size() == 1);
+    CHECK(meshes.size() == 1 && meshes[0].indexCount == 16 * 16 * 6
+          && meshes[0].positions.get() == vid->arrays[0]->data.get());
+    CHECK(pickAt(*transform, start, end, 2.0));
+
+    // Meshes of other topologies aren't picked
+    auto pointScene = vsg::StateGroup::create();
+    auto pipeline = vsg::GraphicsPipeline::create();
+    pipeline->pipelineStates.push_back(vsg::InputAssemblyState::create(VK_PRIMITIVE_TOPOLOGY_POINT_LIST));
+    pointScene->add(vsg::BindGraphicsPipeline::create(pipeline));
+    pointScene->addChild(lodNode);
+    CHECK(collectPickMeshes(*pointScene).empty());
+
+    return checkResult();
+}
@@ -0,0 +1,79 @@
+//======================================================================
+//  test_quantize.cpp - Test of the quantized vertex formats
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "testmeshes.h"
+#include "quantize.h"
+#include "bounds.h"
+#include <cmath>
+
+using namespace std;
+
+int main(int, char **)
+{
+    // Unit vectors spread over the sphere survive the octahedral
+    // encoding, in both hemispheres and on the axes
+    const int numNormals = 10000;
+    const double golden = M_PI * (3.0 - std::sqrt(5.0));
+    double minDot = 1.0;
+    for (int i = 0; i < numNormals; i++)
+    {
+        double z = 1.0 - 2.0 * (i + 0.5) / numNormals;
+        double r = std::sqrt(1.0 - z * z);
+        vsg::vec3 n(float(r * std::cos(golden * i)), float(r * std::sin(golden * i)), float(z));
+        minDot = std::min(minDot, double(vsg::dot(octDecode(octEncode(n)), n)));
+    }
+    CHECK(minDot > 0.99999);
+    for (auto& n : {vsg::vec3(1, 0, 0), vsg::vec3(-1, 0, 0), vsg::vec3(0, 1, 0),
+                    vsg::vec3(0, -1, 0), vsg::vec3(0, 0, 1), vsg::vec3(0, 0, -1)})
+        CHECK(vsg::dot(octDecode(octEncode(n)), n) > 0.99999f);
+
+    // The positions of a mesh are quantized relative to its bounds,
+    // and the transform above it scales them back
+    QTemporaryDir dir;
+    CHECK(dir.isValid());
+    auto scene = gridScene(dir, 16);
+    CHECK(scene);
+    if (!scene)
+        return checkResult();
+    auto original = findDraws(*scene);
+    CHECK(original.size() == 1);
+    auto positions = original.empty() ? vsg::ref_ptr<vsg::vec3Array>()
+        : original[0]->arrays[0]->data.cast<vsg::vec3Array>();
+    CHECK(positions);
+
+    auto stats = quantizeVertices(*scene);
+    CHECK(stats.numDraws == 1);
+    CHECK(stats.numSkipped == 0);
+    CHECK(stats.bytesAfter < stats.bytesBefore);
+
+    vsg::ref_ptr<vsg::MatrixTransform> transform;
+    if (auto sg = scene.cast<vsg::StateGroup>(); sg && sg->children.size() == 1)
+        transform = sg->children[0].cast<vsg::MatrixTransform>();
+    CHECK(transform);
+    if (transform && positions)
+    {
+        auto draws = findDraws(*transform);
+        auto quantized = draws.size() == 1 ? draws[0]->arrays[0]->data.cast<vsg::usvec4Array>()
+            : vsg::ref_ptr<vsg::usvec4Array>();
+        CHECK(quantized && quantized->size() == positions->size());
+        double maxError = 0.0;
+        for (size_t i = 0; quantized && i < quantized->size(); i++)
+        {
+            auto& q = quantized->at(i);
+            auto p = transform->matrix * vsg::dvec3(q.x / 65535.0, q.y / 65535.0, q.z / 65535.0);
+            maxError = std::max(maxError, vsg::length(p - vsg::dvec3(positions->at(i))));
+        }
+        CHECK(maxError < 1e-4);
+
+        // The bounds are stored, as they can't be computed any more
+        vsg::dbox bounds;
+        CHECK(findBounds(*transform, bounds));
+        CHECK(vsg::length(bounds.max - vsg::dvec3(1, 1, 0)) < 1e-5);
+    }
+
+    return checkResult();
+}
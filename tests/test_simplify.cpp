@@ -0,0 +1,89 @@
+//======================================================================
+//  test_simplify.cpp - Test of the quadric error simplification
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "simplify.h"
+#include <cmath>
+#include <set>
+
+using namespace std;
+
+// A grid of n by n quads in the unit square with a bump in the middle
+static void bumpMesh(int n, vector<vsg::vec3>& vertices, vector<uint32_t>& indices)
+{
+    for (int y = 0; y <= n; y++)
+    {
+        for (int x = 0; x <= n; x++)
+        {
+            float u = float(x) / n - 0.5f, v = float(y) / n - 0.5f;
+            vertices.push_back(vsg::vec3(u + 0.5f, v + 0.5f, 0.2f * std::exp(-20.0f * (u*u + v*v))));
+        }
+    }
+    for (int y = 0; y < n; y++)
+    {
+        for (int x = 0; x < n; x++)
+        {
+            uint32_t v = uint32_t(y * (n + 1) + x);
+            indices.insert(indices.end(), {v, v + 1, v + uint32_t(n) + 2,
+                                           v, v + uint32_t(n) + 2, v + uint32_t(n) + 1});
+        }
+    }
+}
+
+int main(int, char **)
+{
+    const int n = 32;
+    vector<vsg::vec3> vertices;
+    vector<uint32_t> indices;
+    bumpMesh(n, vertices, indices);
+    size_t numTriangles = indices.size() / 3;
+
+    vector<uint32_t> result;
+    CHECK(simplifyMesh(vertices.data(), vertices.size(), indices, numTriangles / 4, result));
+
+    // About the target, of valid and nondegenerate triangles
+    CHECK(result.size() % 3 == 0);
+    CHECK(result.size() / 3 <= numTriangles / 4 + numTriangles / 20);
+    CHECK(result.size() / 3 >= numTriangles / 8);
+    bool valid = true;
+    for (size_t t = 0; t + 2 < result.size(); t += 3)
+    {
+        valid &= result[t] < vertices.size() && result[t+1] < vertices.size()
+            && result[t+2] < vertices.size();
+        valid &= result[t] != result[t+1] && result[t+1] != result[t+2] && result[t] != result[t+2];
+    }
+    CHECK(valid);
+
+    // The border is kept, so there are no cracks against neighbours
+    set<uint32_t> used(result.begin(), result.end());
+    for (uint32_t v = 0; v < vertices.size(); v++)
+    {
+        auto& p = vertices[v];
+        if (p.x == 0.0f || p.x == 1.0f || p.y == 0.0f || p.y == 1.0f)
+            CHECK(used.count(v));
+    }
+
+    // The orientation of the triangles is kept
+    bool upwards = true;
+    for (size_t t = 0; t + 2 < result.size(); t += 3)
+    {
+        auto normal = vsg::cross(vertices[result[t+1]] - vertices[result[t]],
+                                 vertices[result[t+2]] - vertices[result[t]]);
+        upwards &= normal.z > 0.0f;
+    }
+    CHECK(upwards);
+
+    // A target above the number of triangles keeps all of them
+    CHECK(simplifyMesh(vertices.data(), vertices.size(), indices, numTriangles * 2, result));
+    CHECK(result.size() == indices.size());
+
+    // A canceled simplification returns false
+    std::atomic<bool> canceled{true};
+    CHECK(!simplifyMesh(vertices.data(), vertices.size(), indices, numTriangles / 4, result,
+                        &canceled));
+
+    return checkResult();
+}
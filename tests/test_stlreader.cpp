@@ -0,0 +1,101 @@
+//======================================================================
+//  test_stlreader.cpp - Test of the parsing and welding of STL files
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#include "check.h"
+#include "testmeshes.h"
+#include <cmath>
+
+using namespace std;
+
+// Two facets of a unit square that share its diagonal
+static const vector<vsg::vec3> square = {
+    {0, 0, 0}, {1, 0, 0}, {1, 1, 0},
+    {0, 0, 0}, {1, 1, 0}, {0, 1, 0}
+};
+
+static void checkSquare(vsg::ref_ptr<vsg::Node> node)
+{
+    CHECK(node);
+    if (!node)
+        return;
+
+    bool zUp = false;
+    CHECK(node->getValue("z_up", zUp) && zUp);
+
+    auto draws = findDraws(*node);
+    CHECK(draws.size() == 1);
+    if (draws.size() != 1)
+        return;
+
+    // The corners of the shared edge are welded
+    auto positions = draws[0]->arrays[0]->data.cast<vsg::vec3Array>();
+    auto indices = drawIndices(*draws[0]);
+    CHECK(positions && positions->size() == 4);
+    CHECK(indices.size() == 6);
+    CHECK(draws[0]->indexCount == 6);
+    if (!positions || indices.size() != 6)
+        return;
+    for (size_t i = 0; i < indices.size(); i++)
+        CHECK(indices[i] < positions->size() && positions->at(indices[i]) == square[i]);
+
+    // A flat mesh has the normal of its plane
+    auto normals = draws[0]->arrays[1]->data.cast<vsg::vec3Array>();
+    CHECK(normals && normals->size() == 4);
+    if (normals)
+        for (auto& n : *normals)
+            CHECK(std::fabs(n.z - 1.0f) < 1e-5f);
+}
+
+int main(int, char **)
+{
+    QTemporaryDir dir;
+    CHECK(dir.isValid());
+
+    auto binary = dir.filePath("square.stl").toStdString();
+    CHECK(writeBinarySTL(binary, square));
+    checkSquare(readSTL(binary));
+
+    auto ascii = dir.filePath("ascii.stl").toStdString();
+    FILE *fh = fopen(ascii.c_str(), "w");
+    CHECK(fh);
+    if (fh)
+    {
+        fprintf(fh, "solid square\n");
+        for (size_t i = 0; i < square.size(); i += 3)
+        {
+            fprintf(fh, "  facet normal 0 0 1\n    outer loop\n");
+            for (size_t j = i; j < i + 3; j++)
+                fprintf(fh, "      vertex %g %g %g\n", square[j].x, square[j].y, square[j].z);
+            fprintf(fh, "    endloop\n  endfacet\n");
+        }
+        fprintf(fh, "endsolid square\n");
+        fclose(fh);
+    }
+    checkSquare(readSTL(ascii));
+
+    // A binary file whose header starts with "solid" is still binary
+    auto solid = dir.filePath("solid.stl").toStdString();
+    CHECK(writeBinarySTL(solid, square));
+    fh = fopen(solid.c_str(), "r+b");
+    if (fh)
+    {
+        fwrite("solid", 1, 5, fh);
+        fclose(fh);
+    }
+    checkSquare(readSTL(solid));
+
+    // Other files aren't read
+    CHECK(!STLReader::create()->read(dir.filePath("square.obj").toStdString()));
+    CHECK(!readSTL(dir.filePath("missing.stl").toStdString()));
+
+    // The cache key depends on the crease angle
+    auto reader = STLReader::create();
+    auto key = reader->key();
+    reader->creaseAngle = 45.0;
+    CHECK(reader->key() != key);
+
+    return checkResult();
+}
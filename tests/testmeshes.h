@@ -0,0 +1,134 @@
+//======================================================================
+//  testmeshes.h - Meshes and scenes for the unit tests
+//
+//  Dov Grobgeld <dov.grobgeld@gmail.com>
+//  2026-10-16 Fri
+//----------------------------------------------------------------------
+#ifndef TESTMESHES_H
+#define TESTMESHES_H
+
+#include <vsg/all.h>
+#include <QDir>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "stlreader.h"
+
+// A flat grid of n by n quads in the unit square, two triangles each,
+// as (n+1)^2 vertices and their indices
+inline void gridMesh(int n, std::vector<vsg::vec3>& vertices, std::vector<uint32_t>& indices)
+{
+    vertices.clear();
+    indices.clear();
+    for (int y = 0; y <= n; y++)
+        for (int x = 0; x <= n; x++)
+            vertices.push_back(vsg::vec3(float(x) / n, float(y) / n, 0.0f));
+    for (int y = 0; y < n; y++)
+    {
+        for (int x = 0; x < n; x++)
+        {
+            uint32_t v = uint32_t(y * (n + 1) + x);
+            indices.insert(indices.end(), {v, v + 1, v + uint32_t(n) + 2,
+                                           v, v + uint32_t(n) + 2, v + uint32_t(n) + 1});
+        }
+    }
+}
+
+// The corners of the triangles of indices, optionally in a random
+// order of the triangles
+inline std::vector<vsg::vec3> triangleCorners(const std::vector<vsg::vec3>& vertices,
+                                              const std::vector<uint32_t>& indices,
+                                              bool shuffle = false)
+{
+    std::vector<size_t> order(indices.size() / 3);
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    if (shuffle)
+        std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+    std::vector<vsg::vec3> corners;
+    for (auto t : order)
+        for (int i = 0; i < 3; i++)
+            corners.push_back(vertices[indices[t * 3 + i]]);
+    return corners;
+}
+
+inline bool writeBinarySTL(const std::string& filename, const std::vector<vsg::vec3>& corners)
+{
+    FILE *fh = fopen(filename.c_str(), "wb");
+    if (!fh)
+        return false;
+    char header[80] = {};
+    uint32_t numFacets = uint32_t(corners.size() / 3);
+    fwrite(header, 1, sizeof(header), fh);
+    fwrite(&numFacets, sizeof(numFacets), 1, fh);
+    for (size_t i = 0; i < corners.size(); i += 3)
+    {
+        float normal[3] = {0.0f, 0.0f, 1.0f};
+        uint16_t attributes = 0;
+        fwrite(normal, sizeof(normal), 1, fh);
+        fwrite(&corners[i], sizeof(vsg::vec3), 3, fh);
+        fwrite(&attributes, sizeof(attributes), 1, fh);
+    }
+    return fclose(fh) == 0;
+}
+
+inline vsg::ref_ptr<vsg::Node> readSTL(const std::string& filename)
+{
+    return STLReader::create()->read(filename).cast<vsg::Node>();
+}
+
+// A scene of the grid as the STL reader makes it, i.e. a state group
+// with a triangle list pipeline above an indexed draw
+inline vsg::ref_ptr<vsg::Node> gridScene(const QTemporaryDir& dir, int n, bool shuffle = false)
+{
+    std::vector<vsg::vec3> vertices;
+    std::vector<uint32_t> indices;
+    gridMesh(n, vertices, indices);
+    auto filename = dir.filePath(QString("grid%1.stl").arg(n)).toStdString();
+    if (!writeBinarySTL(filename, triangleCorners(vertices, indices, shuffle)))
+        return {};
+    return readSTL(filename);
+}
+
+// The indexed draws of a scene
+class DrawCollector : public vsg::Inherit<vsg::Visitor, DrawCollector>
+{
+public:
+    std::vector<vsg::ref_ptr<vsg::VertexIndexDraw>> draws;
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        draws.push_back(vsg::ref_ptr<vsg::VertexIndexDraw>(&vid));
+    }
+};
+
+inline std::vector<vsg::ref_ptr<vsg::VertexIndexDraw>> findDraws(vsg::Node& node)
+{
+    auto collector = DrawCollector::create();
+    node.accept(*collector);
+    return collector->draws;
+}
+
+// The indices of an indexed draw, whatever their type
+inline std::vector<uint32_t> drawIndices(const vsg::VertexIndexDraw& vid)
+{
+    std::vector<uint32_t> indices;
+    auto data = vid.indices->data;
+    if (auto ui = data.cast<vsg::uintArray>())
+        indices.assign(ui->begin(), ui->end());
+    else if (auto us = data.cast<vsg::ushortArray>())
+        indices.assign(us->begin(), us->end());
+    return indices;
+}
+
+#endif /* TESTMESHES */